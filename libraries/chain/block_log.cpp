@@ -1,17 +1,155 @@
 #include <algorithm>
-#include <fstream>
+#include <cstring>
+#include <atomic>
 #include <golos/chain/block_log.hpp>
+#include <golos/chain/compressed_block_log.hpp>
 #include <golos/protocol/exceptions.hpp>
-#include <boost/iostreams/device/mapped_file.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/thread/shared_mutex.hpp>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 namespace golos { namespace chain {
     namespace detail {
         using read_write_mutex = boost::shared_mutex;
         using read_lock = boost::shared_lock<read_write_mutex>;
         using write_lock = boost::unique_lock<read_write_mutex>;
-        static constexpr boost::iostreams::stream_offset min_valid_file_size = sizeof(uint64_t);
+        static constexpr uint64_t min_valid_file_size = sizeof(uint64_t);
+
+        /**
+         * Read-only mapping of a file, which reserves address space beyond the end of file.
+         * The file grows by writes to its descriptor, and new data becomes visible through the same mapping,
+         * so the mapping is replaced only when the file outgrows the reserve.
+         * Block views keep the mapping alive after it is replaced.
+         */
+        class mapped_region final {
+        public:
+            mapped_region(int fd, uint64_t capacity)
+                    : _capacity(capacity) {
+                auto* ptr = ::mmap(nullptr, _capacity, PROT_READ, MAP_SHARED, fd, 0);
+                FC_ASSERT(ptr != MAP_FAILED, "Failed to map block log file", ("errno", errno));
+                _data = static_cast<const char*>(ptr);
+            }
+
+            ~mapped_region() {
+                ::munmap(const_cast<char*>(_data), _capacity);
+            }
+
+            const char* data() const {
+                return _data;
+            }
+
+            uint64_t capacity() const {
+                return _capacity;
+            }
+
+        private:
+            const char* _data = nullptr;
+            uint64_t _capacity = 0;
+        };
+
+        using mapped_region_ptr = std::shared_ptr<const mapped_region>;
+
+        class mapped_log_file final {
+        public:
+            explicit mapped_log_file(uint64_t reserve_step)
+                    : _reserve_step(reserve_step) {
+            }
+
+            ~mapped_log_file() {
+                close();
+            }
+
+            void open(const std::string& path) {
+                close();
+
+                _fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+                FC_ASSERT(_fd >= 0, "Failed to open ${path}", ("path", path)("errno", errno));
+
+                struct stat st;
+                FC_ASSERT(::fstat(_fd, &st) == 0, "Failed to get size of ${path}", ("path", path)("errno", errno));
+                _size = st.st_size;
+                _synced = true;
+                remap();
+            }
+
+            void close() {
+                if (_fd >= 0) {
+                    sync();
+                    ::close(_fd);
+                    _fd = -1;
+                }
+                _region.reset();
+                _size = 0;
+            }
+
+            bool is_open() const {
+                return _fd >= 0;
+            }
+
+            /**
+             * Size of data, the file which has less than one position marker is treated as empty.
+             */
+            uint64_t size() const {
+                if (_size < min_valid_file_size) {
+                    return 0;
+                }
+                return _size;
+            }
+
+            const char* data() const {
+                return _region->data();
+            }
+
+            const mapped_region_ptr& region() const {
+                return _region;
+            }
+
+            void write(uint64_t pos, const char* data, std::size_t size) {
+                while (size > 0) {
+                    auto written = ::pwrite(_fd, data, size, pos);
+                    if (written < 0 && errno == EINTR) {
+                        continue;
+                    }
+                    FC_ASSERT(written > 0, "Failed to write to block log", ("pos", pos)("errno", errno));
+                    data += written;
+                    pos += written;
+                    size -= written;
+                }
+                _size = std::max(_size, pos);
+                _synced = false;
+                if (_size > _region->capacity()) {
+                    remap();
+                }
+            }
+
+            void truncate(uint64_t size) {
+                FC_ASSERT(::ftruncate(_fd, size) == 0, "Failed to truncate block log", ("size", size)("errno", errno));
+                _size = size;
+                _synced = false;
+            }
+
+            void sync() {
+                if (!_synced.exchange(true) && _fd >= 0) {
+                    ::fdatasync(_fd);
+                }
+            }
+
+        private:
+            void remap() {
+                auto capacity = (_size / _reserve_step + 2) * _reserve_step;
+                _region = std::make_shared<mapped_region>(_fd, capacity);
+            }
+
+            const uint64_t _reserve_step;
+            int _fd = -1;
+            uint64_t _size = 0;
+            std::atomic<bool> _synced{true};
+            mapped_region_ptr _region;
+        };
 
         class block_log_impl {
         public:
@@ -20,72 +158,65 @@ namespace golos { namespace chain {
 
             std::string block_path;
             std::string index_path;
-            boost::iostreams::mapped_file block_mapped_file;
-            boost::iostreams::mapped_file index_mapped_file;
+            mapped_log_file block_file{uint64_t(1) << 30};
+            mapped_log_file index_file{uint64_t(64) << 20};
             read_write_mutex mutex;
 
+            // blocks [1, archived_block_num] are stored in the compressed block log,
+            // the block log and its index start from the next block.
+            // Archive is read-only, readers take it and decompress blocks without lock of block log.
+            std::shared_ptr<compressed_block_log> archive = std::make_shared<compressed_block_log>();
+            uint32_t archived_block_num = 0;
+            uint32_t archive_cache_size = compressed_block_log::default_cache_size;
+
             bool has_block_records() const {
-                auto size = block_mapped_file.size();
-                return (size > min_valid_file_size);
+                return (block_file.size() > min_valid_file_size);
             }
 
             bool has_index_records() const {
-                auto size = index_mapped_file.size();
-                return (size >= min_valid_file_size);
+                return (index_file.size() >= min_valid_file_size);
             }
 
-            std::size_t get_mapped_size(const boost::iostreams::mapped_file& mapped_file) const {
-                auto size = mapped_file.size();
-                if (size < min_valid_file_size) {
-                    return 0;
-                }
-                return size;
-            }
-
-            uint64_t get_uint64(const boost::iostreams::mapped_file& mapped_file, std::size_t pos) const {
+            uint64_t get_uint64(const mapped_log_file& file, uint64_t pos) const {
                 uint64_t value;
-                auto file_size = get_mapped_size(mapped_file);
+                auto file_size = file.size();
                 GOLOS_CHECK_DATABASE(pos + sizeof(value) <= file_size,
                         database_corrupted::reading_data_beyond_end_of_file,
                         "Reading data beyond end of file",
                         ("pos", pos)("size", sizeof(value))("file_size", file_size));
 
-                auto* ptr = mapped_file.data() + pos;
-                value = *reinterpret_cast<uint64_t*>(ptr);
+                std::memcpy(&value, file.data() + pos, sizeof(value));
                 return value;
             }
 
-            uint64_t get_last_uint64(const boost::iostreams::mapped_file& mapped_file) const {
-                uint64_t value;
-                auto file_size = get_mapped_size(mapped_file);
-                GOLOS_CHECK_DATABASE(sizeof(value) <= file_size,
+            uint64_t get_last_uint64(const mapped_log_file& file) const {
+                auto file_size = file.size();
+                GOLOS_CHECK_DATABASE(sizeof(uint64_t) <= file_size,
                         database_corrupted::reading_data_beyond_end_of_file,
                         "Reading data beyond end of file",
-                        ("size", sizeof(value))("file_size", file_size));
+                        ("size", sizeof(uint64_t))("file_size", file_size));
 
-                auto* ptr = mapped_file.data() + file_size - sizeof(value);
-                value = *reinterpret_cast<uint64_t*>(ptr);
-                return value;
+                return get_uint64(file, file_size - sizeof(uint64_t));
             }
 
             uint64_t get_block_pos(uint32_t block_num) const {
                 if (head.valid() &&
                     block_num <= protocol::block_header::num_from_id(head_id) &&
-                    block_num > 0
+                    block_num > archived_block_num
                 ) {
-                    return get_uint64(index_mapped_file, sizeof(uint64_t) * (block_num - 1));
+                    return get_uint64(index_file, sizeof(uint64_t) * (block_num - archived_block_num - 1));
                 }
                 return block_log::npos;
             }
 
             uint64_t read_block(uint64_t pos, signed_block& block) const {
-                const auto file_size = get_mapped_size(block_mapped_file);
+                const auto file_size = block_file.size();
                 GOLOS_CHECK_DATABASE(pos < file_size,
                         database_corrupted::reading_data_beyond_end_of_file,
                         "Reading data beyond end of file",
                         ("pos", pos)("file_size", file_size));
 
-                const auto* ptr = block_mapped_file.data() + pos;
+                const auto* ptr = block_file.data() + pos;
                 const auto available_size = file_size - pos;
                 const auto max_block_size = std::min<std::size_t>(available_size, STEEMIT_MAX_BLOCK_SIZE);
 
@@ -93,7 +224,7 @@ namespace golos { namespace chain {
                 fc::raw::unpack(ds, block);
 
                 const auto end_pos = pos + ds.tellp();
-                const auto block_pos = get_uint64(block_mapped_file, end_pos);
+                const auto block_pos = get_uint64(block_file, end_pos);
                 GOLOS_CHECK_DATABASE(block_pos == pos,
                         database_corrupted::wrong_position_marker_was_read,
                         "Wrong position makers was read (read ${block_pos}, expected ${expected})",
@@ -102,59 +233,90 @@ namespace golos { namespace chain {
                 return end_pos + sizeof(uint64_t);
             }
 
-            signed_block read_head() const {
-                auto pos = get_last_uint64(block_mapped_file);
-                signed_block block;
-                read_block(pos, block);
-                return block;
-            }
+            block_view read_block_view(uint32_t block_num) const {
+                if (block_num <= archived_block_num) {
+                    return archive->read_block_view(block_num);
+                }
 
-            void create_nonexist_file(const std::string& path) const {
-                if (!boost::filesystem::is_regular_file(path) || boost::filesystem::file_size(path) == 0) {
-                    std::ofstream stream(path, std::ios::out|std::ios::binary);
-                    stream << '\0';
-                    stream.close();
+                const auto pos = get_block_pos(block_num);
+                if (pos == block_log::npos) {
+                    return block_view();
                 }
-            }
 
-            void open_block_mapped_file() {
-                create_nonexist_file(block_path);
-                block_mapped_file.open(block_path, boost::iostreams::mapped_file::readwrite);
+                // size of the packed block is known from the position of the next block, so it isn't unpacked
+                const auto end_pos = (block_num < protocol::block_header::num_from_id(head_id))
+                    ? get_block_pos(block_num + 1)
+                    : block_file.size();
+                GOLOS_CHECK_DATABASE(pos + sizeof(uint64_t) < end_pos && end_pos <= block_file.size(),
+                        database_corrupted::reading_data_beyond_end_of_file,
+                        "Reading data beyond end of file",
+                        ("pos", pos)("end_pos", end_pos)("file_size", block_file.size()));
+
+                const auto marker_pos = end_pos - sizeof(uint64_t);
+                const auto block_pos = get_uint64(block_file, marker_pos);
+                GOLOS_CHECK_DATABASE(block_pos == pos,
+                        database_corrupted::wrong_position_marker_was_read,
+                        "Wrong position makers was read (read ${block_pos}, expected ${expected})",
+                        ("block_pos", block_pos)("expected", pos));
+
+                return block_view(block_file.region(), block_file.data() + pos, marker_pos - pos);
             }
 
-            void open_index_mapped_file() {
-                create_nonexist_file(index_path);
-                index_mapped_file.open(index_path, boost::iostreams::mapped_file::readwrite);
+            signed_block read_head() const {
+                if (!has_block_records() && archived_block_num) {
+                    return *archive->read_block_by_num(archived_block_num);
+                }
+                auto pos = get_last_uint64(block_file);
+                signed_block block;
+                read_block(pos, block);
+                return block;
             }
 
             void construct_index() {
                 ilog("Reconstructing Block Log Index...");
-                index_mapped_file.close();
-                boost::filesystem::remove_all(index_path);
-                open_index_mapped_file();
-                index_mapped_file.resize(head->block_num() * sizeof(uint64_t));
+
+                // positions are written by batches, so memory doesn't depend on the number of blocks
+                static constexpr std::size_t batch_size = 64 * 1024;
+                std::vector<uint64_t> positions;
+                positions.reserve(batch_size);
+
+                index_file.truncate(0);
+                uint64_t index_pos = 0;
+                auto write_positions = [&]() {
+                    const auto size = positions.size() * sizeof(uint64_t);
+                    index_file.write(index_pos, reinterpret_cast<const char*>(positions.data()), size);
+                    index_pos += size;
+                    positions.clear();
+                };
 
                 uint64_t pos = 0;
-                uint64_t end_pos = get_last_uint64(block_mapped_file);
-                auto* idx_ptr = index_mapped_file.data();
+                uint64_t end_pos = get_last_uint64(block_file);
                 signed_block tmp_block;
 
                 while (pos <= end_pos) {
-                    *reinterpret_cast<uint64_t*>(idx_ptr) = pos;
+                    positions.push_back(pos);
+                    if (positions.size() == batch_size) {
+                        write_positions();
+                    }
                     pos = read_block(pos, tmp_block);
-                    idx_ptr += sizeof(pos);
                 }
+                write_positions();
             }
 
             void open(const fc::path& file) { try {
-                block_mapped_file.close();
-                index_mapped_file.close();
+                block_file.close();
+                index_file.close();
+
+                archive = std::make_shared<compressed_block_log>();
+                archive->set_cache_size(archive_cache_size);
+                archive->open(file);
+                archived_block_num = archive->last_block_num();
 
                 block_path = file.string();
                 index_path = boost::filesystem::path(file.string() + ".index").string();
 
-                open_block_mapped_file();
-                open_index_mapped_file();
+                block_file.open(block_path);
+                index_file.open(index_path);
 
                 /* On startup of the block log, there are several states the log file and the index file can be
                  * in relation to each other.
@@ -183,8 +345,8 @@ namespace golos { namespace chain {
                     if (has_index_records()) {
                         ilog("Index is nonempty");
 
-                        auto block_pos = get_last_uint64(block_mapped_file);
-                        auto index_pos = get_last_uint64(index_mapped_file);
+                        auto block_pos = get_last_uint64(block_file);
+                        auto index_pos = get_last_uint64(index_file);
 
                         if (block_pos != index_pos) {
                             ilog("block_pos != index_pos, close and reopen index_stream");
@@ -196,52 +358,86 @@ namespace golos { namespace chain {
                     }
                 } else if (has_index_records()) {
                     ilog("Index is nonempty, remove and recreate it");
-                    index_mapped_file.close();
-                    block_mapped_file.close();
-
-                    boost::filesystem::remove_all(block_path);
-                    boost::filesystem::remove_all(index_path);
+                    block_file.truncate(0);
+                    index_file.truncate(0);
+                }
 
-                    open_block_mapped_file();
-                    open_index_mapped_file();
+                if (!head.valid() && archived_block_num) {
+                    ilog("Log is empty, head is the last block of compressed log");
+                    head = read_head();
+                    head_id = head->id();
                 }
             } FC_LOG_AND_RETHROW() }
 
-            uint64_t append(const signed_block& b, const std::vector<char>& data) { try {
-                const auto index_pos = get_mapped_size(index_mapped_file);
+            uint64_t append(const signed_block& b, std::vector<char>& data) { try {
+                const auto index_pos = index_file.size();
 
-                GOLOS_CHECK_DATABASE(index_pos == sizeof(uint64_t) * (b.block_num() - 1),
+                GOLOS_CHECK_DATABASE(index_pos == sizeof(uint64_t) * (b.block_num() - archived_block_num - 1),
                     database_corrupted::append_index_file_at_wrong_position,
                     "Append to index file occuring at wrong position.",
                     ("position", index_pos)
-                    ("expected", (b.block_num() - 1) * sizeof(uint64_t)));
+                    ("expected", (b.block_num() - archived_block_num - 1) * sizeof(uint64_t)));
 
-                uint64_t block_pos = get_mapped_size(block_mapped_file);
+                const uint64_t block_pos = block_file.size();
 
-                block_mapped_file.resize(block_pos + data.size() + sizeof(block_pos));
-                auto* ptr = block_mapped_file.data() + block_pos;
-                std::memcpy(ptr, data.data(), data.size());
-                ptr += data.size();
-                *reinterpret_cast<uint64_t*>(ptr) = block_pos;
-
-                index_mapped_file.resize(index_pos + sizeof(index_pos));
-                ptr = index_mapped_file.data() + index_pos;
-                *reinterpret_cast<uint64_t*>(ptr) = block_pos;
+                // block and its position marker are written by one call, files grow without remapping
+                data.resize(data.size() + sizeof(block_pos));
+                std::memcpy(data.data() + data.size() - sizeof(block_pos), &block_pos, sizeof(block_pos));
+                block_file.write(block_pos, data.data(), data.size());
+                index_file.write(index_pos, reinterpret_cast<const char*>(&block_pos), sizeof(block_pos));
 
                 head = b;
                 head_id = b.id();
                 return block_pos;
             } FC_LOG_AND_RETHROW() }
 
+            void flush() {
+                block_file.sync();
+                index_file.sync();
+            }
+
             void close() {
-                block_mapped_file.close();
-                index_mapped_file.close();
+                block_file.close();
+                index_file.close();
+                // archive is closed when the last reader releases it
+                archive = std::make_shared<compressed_block_log>();
+                archived_block_num = 0;
                 head.reset();
                 head_id = block_id_type();
             }
         };
     }
 
+    block_view::block_view(std::shared_ptr<const void> holder, const char* data, std::size_t size)
+            : _holder(std::move(holder)),
+              _data(data),
+              _size(size) {
+    }
+
+    signed_block_header block_view::header() const {
+        FC_ASSERT(valid(), "Block view is empty");
+        signed_block_header result;
+        fc::datastream<const char*> ds(_data, _size);
+        fc::raw::unpack(ds, result);
+        return result;
+    }
+
+    block_id_type block_view::id() const {
+        return header().id();
+    }
+
+    uint32_t block_view::block_num() const {
+        return header().block_num();
+    }
+
+    signed_block block_view::unpack() const {
+        FC_ASSERT(valid(), "Block view is empty");
+        signed_block result;
+        fc::datastream<const char*> ds(_data, _size);
+        fc::raw::unpack(ds, result);
+        return result;
+    }
+
     block_log::block_log()
             : my(std::make_unique<detail::block_log_impl>()) {
     }
@@ -262,7 +458,7 @@ namespace golos { namespace chain {
 
     bool block_log::is_open() const {
         detail::read_lock lock(my->mutex);
-        return my->block_mapped_file.is_open();
+        return my->block_file.is_open();
     }
 
     uint64_t block_log::append(const signed_block& block) { try {
@@ -272,7 +468,9 @@ namespace golos { namespace chain {
     } FC_LOG_AND_RETHROW() }
 
     void block_log::flush() {
-        // it isn't needed, because all data is already in page cache
+        // appended data is already visible to readers from page cache, sync makes it durable
+        detail::read_lock lock(my->mutex);
+        my->flush();
     }
 
     std::pair<signed_block, uint64_t> block_log::read_block(uint64_t pos) const {
@@ -283,12 +481,10 @@ namespace golos { namespace chain {
     }
 
     optional<signed_block> block_log::read_block_by_num(uint32_t block_num) const { try {
-        detail::read_lock lock(my->mutex);
         optional<signed_block> result;
-        uint64_t pos = my->get_block_pos(block_num);
-        if (pos != npos) {
-            signed_block block;
-            my->read_block(pos, block);
+        auto view = read_block_view(block_num);
+        if (view.valid()) {
+            auto block = view.unpack();
             GOLOS_CHECK_DATABASE(block.block_num() == block_num,
                 database_corrupted::wrong_block_num_was_read,
                 "Wrong block was read from block log (read ${block_num}, expected ${expected}).",
@@ -298,11 +494,35 @@ namespace golos { namespace chain {
         return result;
     } FC_LOG_AND_RETHROW() }
 
+    block_view block_log::read_block_view(uint32_t block_num) const { try {
+        std::shared_ptr<compressed_block_log> archive;
+        {
+            detail::read_lock lock(my->mutex);
+            if (block_num > my->archived_block_num) {
+                return my->read_block_view(block_num);
+            }
+            archive = my->archive;
+        }
+        // decompression of chunk doesn't hold lock, so append() doesn't wait for it
+        return archive->read_block_view(block_num);
+    } FC_LOG_AND_RETHROW() }
+
     uint64_t block_log::get_block_pos(uint32_t block_num) const {
         detail::read_lock lock(my->mutex);
         return my->get_block_pos(block_num);
     }
 
+    void block_log::set_archive_cache_size(uint32_t chunks) {
+        detail::write_lock lock(my->mutex);
+        my->archive_cache_size = chunks;
+        my->archive->set_cache_size(chunks);
+    }
+
+    uint32_t block_log::archived_block_num() const {
+        detail::read_lock lock(my->mutex);
+        return my->archived_block_num;
+    }
+
     signed_block block_log::read_head() const {
         detail::read_lock lock(my->mutex);
         return my->read_head();
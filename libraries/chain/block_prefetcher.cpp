@@ -0,0 +1,148 @@
+#include <golos/chain/block_prefetcher.hpp>
+#include <golos/chain/database_exceptions.hpp>
+
+namespace golos { namespace chain {
+
+    block_prefetcher::block_prefetcher(
+        const block_log& log, uint32_t from_block_num, uint32_t last_block_num, uint32_t threads, uint32_t queue_size
+    ) : _log(log),
+        _last_block_num(last_block_num),
+        _threads(threads),
+        _queue_size(std::max<uint32_t>(queue_size, 1)),
+        _ring(_queue_size),
+        _next_to_decode(from_block_num),
+        _next_to_take(from_block_num) {
+    }
+
+    block_prefetcher::~block_prefetcher() {
+        stop();
+    }
+
+    void block_prefetcher::start() {
+        for (uint32_t i = 0; i < _threads; ++i) {
+            _decoders.emplace_back([this]() {
+                decoder_loop();
+            });
+        }
+    }
+
+    void block_prefetcher::stop() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopped = true;
+        }
+        _decoded_cond.notify_all();
+        _taken_cond.notify_all();
+
+        for (auto& t : _decoders) {
+            if (t.joinable()) {
+                t.join();
+            }
+        }
+        _decoders.clear();
+    }
+
+    prefetched_block_ptr block_prefetcher::decode(const block_log& log, uint32_t block_num) {
+        auto block = log.read_block_by_num(block_num);
+        GOLOS_CHECK_DATABASE(block.valid(),
+            database_corrupted::wrong_block_num_was_read,
+            "Block ${block_num} is absent in block log",
+            ("block_num", block_num));
+
+        auto result = std::make_shared<prefetched_block>();
+        result->block = std::move(*block);
+
+        const auto& trxs = result->block.transactions;
+        result->trx_ids.reserve(trxs.size());
+        result->trx_sizes.reserve(trxs.size());
+        for (const auto& trx : trxs) {
+            result->trx_ids.push_back(trx.id());
+            result->trx_sizes.push_back(fc::raw::pack_size(trx));
+        }
+        return result;
+    }
+
+    void block_prefetcher::decoder_loop() {
+        while (true) {
+            uint32_t block_num;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                auto start_wait = fc::time_point::now();
+                _taken_cond.wait(lock, [&]() {
+                    return _stopped || _next_to_decode > _last_block_num ||
+                        _next_to_decode < _next_to_take + _queue_size;
+                });
+                _decoders_wait += (fc::time_point::now() - start_wait).count();
+
+                if (_stopped || _next_to_decode > _last_block_num) {
+                    return;
+                }
+                block_num = _next_to_decode++;
+            }
+
+            slot result;
+            result.block_num = block_num;
+
+            auto start_decode = fc::time_point::now();
+            try {
+                result.data = decode(_log, block_num);
+            } catch (...) {
+                result.error = std::current_exception();
+            }
+            _decode_time += (fc::time_point::now() - start_decode).count();
+            ++_decoded_blocks;
+
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _ring[block_num % _queue_size] = std::move(result);
+            }
+            _decoded_cond.notify_all();
+        }
+    }
+
+    prefetched_block_ptr block_prefetcher::next() {
+        if (_threads == 0) {
+            auto start_decode = fc::time_point::now();
+            auto result = decode(_log, _next_to_take++);
+            _decode_time += (fc::time_point::now() - start_decode).count();
+            ++_decoded_blocks;
+            return result;
+        }
+
+        slot result;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            auto& s = _ring[_next_to_take % _queue_size];
+
+            auto start_wait = fc::time_point::now();
+            _decoded_cond.wait(lock, [&]() {
+                return _stopped || (s.block_num == _next_to_take && (s.data || s.error));
+            });
+            _apply_wait += (fc::time_point::now() - start_wait).count();
+
+            FC_ASSERT(!_stopped, "Block prefetcher is stopped before block ${block_num} was read",
+                ("block_num", _next_to_take));
+
+            result = std::move(s);
+            s = slot();
+            ++_next_to_take;
+        }
+        _taken_cond.notify_all();
+
+        if (result.error) {
+            std::rethrow_exception(result.error);
+        }
+        return result.data;
+    }
+
+    block_prefetcher::stats block_prefetcher::get_stats() const {
+        stats result;
+        std::lock_guard<std::mutex> lock(_mutex);
+        result.decoded_blocks = _decoded_blocks;
+        result.decode_time = fc::microseconds(_decode_time);
+        result.decoders_wait = fc::microseconds(_decoders_wait);
+        result.apply_wait = fc::microseconds(_apply_wait);
+        return result;
+    }
+
+} } // golos::chain
@@ -0,0 +1,153 @@
+#include <golos/chain/block_profiler.hpp>
+#include <golos/protocol/operations.hpp>
+
+#include <fc/log/logger.hpp>
+
+#include <algorithm>
+#include <sstream>
+
+namespace golos { namespace chain {
+
+    namespace {
+        struct operation_name_visitor {
+            using result_type = std::string;
+
+            template <typename T>
+            std::string operator()(const T&) const {
+                std::string name = fc::get_typename<T>::name();
+                auto pos = name.rfind("::");
+                return pos == std::string::npos ? name : name.substr(pos + 2);
+            }
+        };
+
+        void sort_by_time(std::vector<std::pair<std::string, uint64_t>>& items) {
+            std::stable_sort(items.begin(), items.end(), [](const auto& a, const auto& b) {
+                return a.second > b.second;
+            });
+        }
+    }
+
+    void profile_histogram::add(uint64_t us) {
+        if (buckets.empty()) {
+            buckets.resize(bucket_count);
+        }
+        ++count;
+        total_us += us;
+        max_us = std::max(max_us, us);
+
+        uint32_t bucket = 0;
+        while (bucket + 1 < bucket_count && us >= (uint64_t(1) << bucket)) {
+            ++bucket;
+        }
+        ++buckets[bucket];
+    }
+
+    void block_profiler::begin_block(uint32_t block_num) {
+        _in_block = _enabled;
+        if (!_in_block) {
+            return;
+        }
+        _block_num = block_num;
+        _block_steps.clear();
+        _block_operations.clear();
+        _block_start = fc::time_point::now();
+    }
+
+    void block_profiler::abort_block() {
+        _in_block = false;
+    }
+
+    const std::string& block_profiler::operation_name(int64_t which) {
+        if (_operation_names.empty()) {
+            protocol::operation op;
+            _operation_names.resize(op.count());
+            for (int64_t i = 0; i < op.count(); ++i) {
+                op.set_which(i);
+                _operation_names[i] = op.visit(operation_name_visitor());
+            }
+        }
+        return _operation_names.at(which);
+    }
+
+    bool block_profiler::end_block() {
+        if (!_in_block) {
+            return false;
+        }
+        _in_block = false;
+
+        block_apply_profile profile;
+        profile.block_num = _block_num;
+        profile.time_us = (fc::time_point::now() - _block_start).count();
+
+        bool is_slow = _slow_block_threshold.count() > 0 && profile.time_us > uint64_t(_slow_block_threshold.count());
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            ++_stats.blocks;
+            _stats.block.add(profile.time_us);
+            if (is_slow) {
+                ++_stats.slow_blocks;
+            }
+
+            profile.steps.reserve(_block_steps.size());
+            for (const auto& step : _block_steps) {
+                profile.steps.emplace_back(step.first, step.second);
+                _stats.steps[step.first].add(step.second);
+            }
+
+            std::map<int64_t, uint64_t> evaluators;
+            for (const auto& op : _block_operations) {
+                evaluators[op.first] += op.second;
+                _stats.evaluators[operation_name(op.first)].add(op.second);
+            }
+            for (const auto& e : evaluators) {
+                profile.evaluators.emplace_back(operation_name(e.first), e.second);
+            }
+
+            _last_block = profile;
+        }
+
+        if (is_slow) {
+            log_slow_block(profile);
+        }
+        return true;
+    }
+
+    void block_profiler::log_slow_block(const block_apply_profile& profile) const {
+        constexpr size_t max_items = 10;
+
+        auto steps = profile.steps;
+        auto evaluators = profile.evaluators;
+        sort_by_time(steps);
+        sort_by_time(evaluators);
+
+        std::ostringstream out;
+        for (size_t i = 0; i < steps.size() && i < max_items; ++i) {
+            out << " " << steps[i].first << "=" << steps[i].second << "us";
+        }
+        out << ";";
+        for (size_t i = 0; i < evaluators.size() && i < max_items; ++i) {
+            out << " " << evaluators[i].first << "=" << evaluators[i].second << "us";
+        }
+
+        wlog("Block ${n} is applied in ${t} ms:${s}", ("n", profile.block_num)("t", profile.time_us / 1000)("s", out.str()));
+    }
+
+    block_apply_profile block_profiler::last_block() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _last_block;
+    }
+
+    block_profiler_stats block_profiler::get_stats() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _stats;
+    }
+
+    void block_profiler::reset() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stats = block_profiler_stats();
+        _last_block = block_apply_profile();
+    }
+
+} } // golos::chain
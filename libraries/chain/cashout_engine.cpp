@@ -0,0 +1,86 @@
+#include <golos/chain/cashout_engine.hpp>
+#include <golos/chain/curation_info.hpp>
+
+#include <future>
+
+namespace golos { namespace chain {
+
+    cashout_engine::cashout_engine() {
+    }
+
+    cashout_engine::~cashout_engine() {
+        stop();
+    }
+
+    void cashout_engine::start(uint32_t threads) {
+        stop();
+
+        if (!threads) {
+            return;
+        }
+
+        _ios.reset();
+        _work = std::make_unique<boost::asio::io_service::work>(_ios);
+        for (uint32_t i = 0; i < threads; ++i) {
+            _workers.emplace_back([this]() {
+                _ios.run();
+            });
+        }
+    }
+
+    void cashout_engine::stop() {
+        _work.reset();
+        _ios.stop();
+        for (auto& t : _workers) {
+            if (t.joinable()) {
+                t.join();
+            }
+        }
+        _workers.clear();
+    }
+
+    std::vector<cashout_engine::curation_info_ptr> cashout_engine::prepare(
+        database& db, const std::vector<const comment_object*>& comments
+    ) {
+        const auto count = comments.size();
+        const auto threads = _workers.size();
+
+        std::vector<curation_info_ptr> result(count);
+        if (!threads || count < 2) {
+            return result;
+        }
+
+        const auto chunks = std::min(threads, count);
+        const auto chunk_size = (count + chunks - 1) / chunks;
+
+        std::vector<std::future<void>> waits;
+        waits.reserve(chunks);
+
+        for (size_t i = 0; i < chunks; ++i) {
+            auto task = std::make_shared<std::packaged_task<void()>>([&, i]() {
+                auto begin = i * chunk_size;
+                auto end = std::min(begin + chunk_size, count);
+                for (auto j = begin; j < end; ++j) {
+                    if (comments[j]->net_rshares > 0) {
+                        result[j] = std::make_unique<comment_curation_info>(db, *comments[j], false);
+                    }
+                }
+            });
+            waits.push_back(task->get_future());
+            _ios.post([task]() {
+                (*task)();
+            });
+        }
+
+        // tasks refer to local data, so all of them should be finished before a rethrow
+        for (auto& w : waits) {
+            w.wait();
+        }
+        for (auto& w : waits) {
+            w.get();
+        }
+
+        return result;
+    }
+
+} } // golos::chain
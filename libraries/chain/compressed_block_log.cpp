@@ -0,0 +1,385 @@
+#include <golos/chain/compressed_block_log.hpp>
+#include <golos/chain/block_log.hpp>
+#include <golos/protocol/exceptions.hpp>
+
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/copy.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+#include <future>
+#include <list>
+#include <map>
+#include <mutex>
+
+namespace golos { namespace chain {
+    namespace detail {
+        namespace bio = boost::iostreams;
+
+        static constexpr uint32_t archive_magic = 0x5a4c4f47; // "GOLZ"
+        static constexpr uint32_t archive_version = 2;
+
+        struct archive_header {
+            uint32_t magic = archive_magic;
+            uint32_t version = archive_version;
+            uint32_t blocks_per_chunk = 0;
+            uint32_t reserved = 0;
+        };
+
+        struct archive_index_header {
+            uint32_t magic = archive_magic;
+            uint32_t version = archive_version;
+            uint32_t block_count = 0;
+            uint32_t chunk_count = 0;
+        };
+
+        struct chunk_entry {
+            uint64_t file_pos = 0;
+            uint32_t compressed_size = 0;
+            uint32_t decompressed_size = 0;
+        };
+
+        struct block_entry {
+            uint32_t chunk = 0;
+            uint32_t offset = 0;
+        };
+
+        static_assert(sizeof(archive_header) == 16, "Unexpected size of archive header");
+        static_assert(sizeof(archive_index_header) == 16, "Unexpected size of archive index header");
+        static_assert(sizeof(chunk_entry) == 16, "Unexpected size of chunk entry");
+        static_assert(sizeof(block_entry) == 8, "Unexpected size of block entry");
+
+        using chunk_ptr = std::shared_ptr<const std::vector<char>>;
+
+        class compressed_block_log_impl {
+        public:
+            bio::mapped_file_source archive_file;
+            bio::mapped_file_source index_file;
+
+            archive_index_header header;
+            const chunk_entry* chunks = nullptr;
+            const block_entry* blocks = nullptr;
+
+            // decompressed chunks in LRU order, most recently used are in front
+            mutable std::mutex cache_mutex;
+            mutable std::list<std::pair<uint32_t, chunk_ptr>> cache;
+            uint32_t cache_size = compressed_block_log::default_cache_size;
+
+            // chunks which are being decompressed, readers of the same chunk wait for the first one,
+            // different chunks are decompressed in parallel
+            mutable std::map<uint32_t, std::shared_future<chunk_ptr>> loading;
+
+            void open(const fc::path& file) {
+                close();
+
+                auto archive_path = compressed_block_log::archive_path(file);
+                auto index_path = compressed_block_log::index_path(file);
+                if (!boost::filesystem::is_regular_file(archive_path.string())) {
+                    return;
+                }
+
+                GOLOS_CHECK_DATABASE(boost::filesystem::is_regular_file(index_path.string()),
+                    database_corrupted::wrong_compressed_block_log,
+                    "Index of compressed block log doesn't exist",
+                    ("path", index_path.string()));
+
+                archive_file.open(archive_path.string());
+                index_file.open(index_path.string());
+
+                GOLOS_CHECK_DATABASE(archive_file.size() >= sizeof(archive_header),
+                    database_corrupted::reading_data_beyond_end_of_file,
+                    "Compressed block log is too small",
+                    ("file_size", archive_file.size()));
+
+                const auto* archive_hdr = reinterpret_cast<const archive_header*>(archive_file.data());
+                GOLOS_CHECK_DATABASE(archive_hdr->magic == archive_magic && archive_hdr->version == archive_version,
+                    database_corrupted::wrong_compressed_block_log,
+                    "Unsupported format of compressed block log",
+                    ("magic", archive_hdr->magic)("version", archive_hdr->version));
+
+                GOLOS_CHECK_DATABASE(index_file.size() >= sizeof(archive_index_header),
+                    database_corrupted::reading_data_beyond_end_of_file,
+                    "Index of compressed block log is too small",
+                    ("file_size", index_file.size()));
+
+                header = *reinterpret_cast<const archive_index_header*>(index_file.data());
+                GOLOS_CHECK_DATABASE(header.magic == archive_magic && header.version == archive_version,
+                    database_corrupted::wrong_compressed_block_log,
+                    "Unsupported format of compressed block log index",
+                    ("magic", header.magic)("version", header.version));
+
+                const auto expected_size = sizeof(archive_index_header) +
+                    sizeof(chunk_entry) * header.chunk_count +
+                    sizeof(block_entry) * header.block_count;
+                GOLOS_CHECK_DATABASE(index_file.size() == expected_size,
+                    database_corrupted::wrong_compressed_block_log,
+                    "Wrong size of compressed block log index",
+                    ("file_size", index_file.size())("expected", expected_size));
+
+                chunks = reinterpret_cast<const chunk_entry*>(index_file.data() + sizeof(archive_index_header));
+                blocks = reinterpret_cast<const block_entry*>(chunks + header.chunk_count);
+
+                ilog("Compressed block log contains ${blocks} blocks in ${chunks} chunks",
+                    ("blocks", header.block_count)("chunks", header.chunk_count));
+            }
+
+            void close() {
+                archive_file.close();
+                index_file.close();
+                header = archive_index_header();
+                chunks = nullptr;
+                blocks = nullptr;
+
+                std::lock_guard<std::mutex> lock(cache_mutex);
+                cache.clear();
+            }
+
+            // cache_mutex should be locked
+            chunk_ptr find_chunk(uint32_t chunk_num) const {
+                for (auto itr = cache.begin(); itr != cache.end(); ++itr) {
+                    if (itr->first == chunk_num) {
+                        cache.splice(cache.begin(), cache, itr);
+                        return itr->second;
+                    }
+                }
+                return chunk_ptr();
+            }
+
+            chunk_ptr decompress_chunk(uint32_t chunk_num) const {
+                const auto& entry = chunks[chunk_num];
+                GOLOS_CHECK_DATABASE(entry.file_pos + entry.compressed_size <= archive_file.size(),
+                    database_corrupted::reading_data_beyond_end_of_file,
+                    "Reading data beyond end of file",
+                    ("pos", entry.file_pos)("size", entry.compressed_size)("file_size", archive_file.size()));
+
+                auto data = std::make_shared<std::vector<char>>();
+                data->reserve(entry.decompressed_size);
+
+                bio::filtering_istream in;
+                in.push(bio::zlib_decompressor());
+                in.push(bio::array_source(archive_file.data() + entry.file_pos, entry.compressed_size));
+                bio::copy(in, bio::back_inserter(*data));
+
+                GOLOS_CHECK_DATABASE(data->size() == entry.decompressed_size,
+                    database_corrupted::wrong_compressed_block_log,
+                    "Wrong size of decompressed chunk",
+                    ("chunk", chunk_num)("size", data->size())("expected", entry.decompressed_size));
+
+                return data;
+            }
+
+            chunk_ptr get_chunk(uint32_t chunk_num) const {
+                std::promise<chunk_ptr> promise;
+                {
+                    std::unique_lock<std::mutex> lock(cache_mutex);
+                    auto result = find_chunk(chunk_num);
+                    if (result) {
+                        return result;
+                    }
+
+                    auto itr = loading.find(chunk_num);
+                    if (itr != loading.end()) {
+                        auto future = itr->second;
+                        lock.unlock();
+                        return future.get();
+                    }
+                    loading.emplace(chunk_num, promise.get_future().share());
+                }
+
+                chunk_ptr result;
+                try {
+                    result = decompress_chunk(chunk_num);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(cache_mutex);
+                    loading.erase(chunk_num);
+                    promise.set_exception(std::current_exception());
+                    throw;
+                }
+
+                std::lock_guard<std::mutex> lock(cache_mutex);
+                loading.erase(chunk_num);
+                cache.emplace_front(chunk_num, result);
+                while (cache.size() > std::max<uint32_t>(cache_size, 1)) {
+                    cache.pop_back();
+                }
+                promise.set_value(result);
+                return result;
+            }
+
+            block_view read_block_view(uint32_t block_num) const {
+                if (block_num == 0 || block_num > header.block_count) {
+                    return block_view();
+                }
+
+                const auto& entry = blocks[block_num - 1];
+                GOLOS_CHECK_DATABASE(entry.chunk < header.chunk_count,
+                    database_corrupted::wrong_compressed_block_log,
+                    "Wrong chunk in index of compressed block log",
+                    ("block_num", block_num)("chunk", entry.chunk)("chunk_count", header.chunk_count));
+
+                auto chunk = get_chunk(entry.chunk);
+
+                // block ends where the next block of the same chunk starts
+                std::size_t end = chunk->size();
+                if (block_num < header.block_count && blocks[block_num].chunk == entry.chunk) {
+                    end = blocks[block_num].offset;
+                }
+                GOLOS_CHECK_DATABASE(entry.offset < end && end <= chunk->size(),
+                    database_corrupted::reading_data_beyond_end_of_file,
+                    "Reading data beyond end of chunk",
+                    ("pos", entry.offset)("end", end)("chunk_size", chunk->size()));
+
+                const auto* data = chunk->data() + entry.offset;
+                return block_view(std::move(chunk), data, end - entry.offset);
+            }
+
+            optional<signed_block> read_block_by_num(uint32_t block_num) const {
+                optional<signed_block> result;
+                auto view = read_block_view(block_num);
+                if (!view.valid()) {
+                    return result;
+                }
+
+                auto block = view.unpack();
+                GOLOS_CHECK_DATABASE(block.block_num() == block_num,
+                    database_corrupted::wrong_block_num_was_read,
+                    "Wrong block was read from compressed block log (read ${block_num}, expected ${expected}).",
+                    ("block_num", block.block_num())("expected", block_num));
+
+                result = std::move(block);
+                return result;
+            }
+        };
+
+        template <typename T>
+        void write_pod(std::ofstream& stream, const T& value) {
+            stream.write(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+    }
+
+    compressed_block_log::compressed_block_log()
+            : my(std::make_unique<detail::compressed_block_log_impl>()) {
+    }
+
+    compressed_block_log::~compressed_block_log() {
+    }
+
+    void compressed_block_log::open(const fc::path& block_log_file) { try {
+        my->open(block_log_file);
+    } FC_LOG_AND_RETHROW() }
+
+    void compressed_block_log::close() {
+        my->close();
+    }
+
+    bool compressed_block_log::is_open() const {
+        return my->archive_file.is_open();
+    }
+
+    uint32_t compressed_block_log::last_block_num() const {
+        return my->header.block_count;
+    }
+
+    optional<signed_block> compressed_block_log::read_block_by_num(uint32_t block_num) const { try {
+        return my->read_block_by_num(block_num);
+    } FC_LOG_AND_RETHROW() }
+
+    block_view compressed_block_log::read_block_view(uint32_t block_num) const { try {
+        return my->read_block_view(block_num);
+    } FC_LOG_AND_RETHROW() }
+
+    void compressed_block_log::set_cache_size(uint32_t chunks) {
+        std::lock_guard<std::mutex> lock(my->cache_mutex);
+        my->cache_size = chunks;
+    }
+
+    fc::path compressed_block_log::archive_path(const fc::path& block_log_file) {
+        return fc::path(block_log_file.string() + ".z");
+    }
+
+    fc::path compressed_block_log::index_path(const fc::path& block_log_file) {
+        return fc::path(block_log_file.string() + ".z.index");
+    }
+
+    void compressed_block_log::write(
+        const block_log& log, uint32_t last_block_num,
+        const fc::path& block_log_file, uint32_t blocks_per_chunk
+    ) { try {
+        namespace bio = boost::iostreams;
+
+        FC_ASSERT(blocks_per_chunk > 0, "Chunk should contain at least one block");
+        FC_ASSERT(log.head() && log.head()->block_num() >= last_block_num,
+            "Block log doesn't contain blocks up to ${last_block_num}", ("last_block_num", last_block_num));
+
+        const auto archive_file = archive_path(block_log_file).string();
+        const auto index_file = index_path(block_log_file).string();
+        const auto archive_tmp = archive_file + ".tmp";
+        const auto index_tmp = index_file + ".tmp";
+
+        std::vector<detail::chunk_entry> chunks;
+        std::vector<detail::block_entry> blocks;
+        blocks.reserve(last_block_num);
+
+        std::ofstream archive(archive_tmp, std::ios::out | std::ios::binary | std::ios::trunc);
+        detail::archive_header header;
+        header.blocks_per_chunk = blocks_per_chunk;
+        detail::write_pod(archive, header);
+
+        uint64_t file_pos = sizeof(header);
+        std::vector<char> chunk_data;
+        std::vector<char> compressed;
+
+        for (uint32_t first = 1; first <= last_block_num; first += blocks_per_chunk) {
+            const auto last = std::min<uint64_t>(uint64_t(first) + blocks_per_chunk - 1, last_block_num);
+            const auto chunk_num = static_cast<uint32_t>(chunks.size());
+
+            chunk_data.clear();
+            for (uint32_t block_num = first; block_num <= last; ++block_num) {
+                auto block = log.read_block_by_num(block_num);
+                FC_ASSERT(block.valid(), "Block ${block_num} doesn't exist in block log", ("block_num", block_num));
+
+                blocks.push_back({chunk_num, static_cast<uint32_t>(chunk_data.size())});
+                auto data = fc::raw::pack(*block);
+                chunk_data.insert(chunk_data.end(), data.begin(), data.end());
+            }
+
+            compressed.clear();
+            {
+                bio::filtering_ostream out;
+                out.push(bio::zlib_compressor(bio::zlib::best_compression));
+                out.push(bio::back_inserter(compressed));
+                out.write(chunk_data.data(), chunk_data.size());
+            }
+
+            archive.write(compressed.data(), compressed.size());
+            chunks.push_back({file_pos, static_cast<uint32_t>(compressed.size()),
+                static_cast<uint32_t>(chunk_data.size())});
+            file_pos += compressed.size();
+
+            if (chunk_num % 1000 == 0) {
+                ilog("Compressed ${block_num} of ${last_block_num} blocks (${size} bytes)",
+                    ("block_num", last)("last_block_num", last_block_num)("size", file_pos));
+            }
+        }
+        archive.close();
+        FC_ASSERT(archive, "Failed to write compressed block log ${path}", ("path", archive_tmp));
+
+        std::ofstream index(index_tmp, std::ios::out | std::ios::binary | std::ios::trunc);
+        detail::archive_index_header index_header;
+        index_header.block_count = last_block_num;
+        index_header.chunk_count = static_cast<uint32_t>(chunks.size());
+        detail::write_pod(index, index_header);
+        index.write(reinterpret_cast<const char*>(chunks.data()), sizeof(detail::chunk_entry) * chunks.size());
+        index.write(reinterpret_cast<const char*>(blocks.data()), sizeof(detail::block_entry) * blocks.size());
+        index.close();
+        FC_ASSERT(index, "Failed to write index of compressed block log ${path}", ("path", index_tmp));
+
+        boost::filesystem::rename(archive_tmp, archive_file);
+        boost::filesystem::rename(index_tmp, index_file);
+    } FC_LOG_AND_RETHROW() }
+
+} } // golos::chain
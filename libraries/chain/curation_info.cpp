@@ -161,11 +161,7 @@ namespace golos { namespace chain {
     : comment(comment) {
         calculate_weight_helper helper{db, comment};
         curve = helper.detect_curation_curve();
-        const auto& cbl = db.get_comment_bill(comment.id);
-        if (cbl.min_golos_power_to_curate != 0) {
-            const auto& v_share_price = db.get_dynamic_global_properties().get_vesting_share_price();
-            min_vesting_shares_to_curate = asset(cbl.min_golos_power_to_curate, STEEM_SYMBOL) * v_share_price;
-        }
+        update_min_vesting_shares(db);
 
         if (comment.last_payout != fc::time_point_sec() && !full_list) {
             return;
@@ -198,4 +194,12 @@ namespace golos { namespace chain {
         });
     }
 
+    void comment_curation_info::update_min_vesting_shares(const database& db) {
+        const auto& cbl = db.get_comment_bill(comment.id);
+        if (cbl.min_golos_power_to_curate != 0) {
+            const auto& v_share_price = db.get_dynamic_global_properties().get_vesting_share_price();
+            min_vesting_shares_to_curate = asset(cbl.min_golos_power_to_curate, STEEM_SYMBOL) * v_share_price;
+        }
+    }
+
 } } // namespace golos::chain
\ No newline at end of file
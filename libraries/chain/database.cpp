@@ -6,7 +6,9 @@
 #include <golos/protocol/steem_operations.hpp>
 
 #include <golos/chain/block_summary_object.hpp>
+#include <golos/chain/block_prefetcher.hpp>
 #include <golos/chain/compound.hpp>
+#include <golos/chain/compressed_block_log.hpp>
 #include <golos/chain/custom_operation_interpreter.hpp>
 #include <golos/chain/database.hpp>
 #include <golos/chain/database_exceptions.hpp>
@@ -204,6 +206,14 @@ namespace golos { namespace chain {
                 auto end = fc::time_point::now();
                 wlog("Done opening database, elapsed time ${t} sec", ("t", double((end - start).count()) / 1000000.0));
 
+                if (chainbase_flags & chainbase::database::read_write && !_snapshot_to_load.empty()) {
+                    with_strong_write_lock([&]() {
+                        load_snapshot(_snapshot_to_load);
+                    });
+                    // state isn't loaded again, if it is wiped and opened for replay
+                    _snapshot_to_load = fc::path();
+                }
+
                 if (chainbase_flags & chainbase::database::read_write && _init_block_log) {
                     start = fc::time_point::now();
                     wlog("Start opening block log. Please wait, don't break application...");
@@ -287,30 +297,78 @@ namespace golos { namespace chain {
                     auto cur_block_num = from_block_num;
                     auto last_block_num = _block_log.head()->block_num();
                     auto last_block_pos = _block_log.get_block_pos(last_block_num);
+                    // blocks from the compressed block log have no positions, so progress is measured in blocks
+                    bool progress_by_pos = from_block_num > _block_log.archived_block_num();
                     int last_reindex_percent = 0;
 
+                    block_prefetcher prefetcher(_block_log, from_block_num, last_block_num,
+                        _replay_decode_threads, std::max<uint32_t>(_replay_decode_threads, 1) * 128);
+                    prefetcher.start();
+
+                    fc::microseconds apply_time;
+                    auto last_report = start;
+                    auto last_report_stats = prefetcher.get_stats();
+                    fc::microseconds last_report_apply_time;
+                    uint32_t last_report_block_num = cur_block_num;
+
+                    auto apply_prefetched = [&](const prefetched_block_ptr& prefetched) {
+                        auto apply_start = fc::time_point::now();
+                        _prefetched_block = prefetched.get();
+                        try {
+                            apply_block(prefetched->block, skip_flags);
+                        } catch (...) {
+                            _prefetched_block = nullptr;
+                            throw;
+                        }
+                        _prefetched_block = nullptr;
+                        apply_time += fc::time_point::now() - apply_start;
+                    };
+
+                    auto seconds = [](const fc::microseconds& t) {
+                        return double(t.count()) / 1000000.0;
+                    };
+
                     set_reserved_memory(1024*1024*1024); // protect from memory fragmentations ...
                     while (cur_block_num < last_block_num) {
                         if (signal_guard::get_is_interrupted()) {
                             return;
                         }
 
-                        auto end = fc::time_point::now();
-                        auto cur_block_pos = _block_log.get_block_pos(cur_block_num);
-                        auto cur_block = *_block_log.read_block_by_num(cur_block_num);
+                        auto cur_block = prefetcher.next();
 
-                        auto reindex_percent = cur_block_pos * 100 / last_block_pos;
+                        auto reindex_percent = progress_by_pos
+                            ? _block_log.get_block_pos(cur_block_num) * 100 / last_block_pos
+                            : uint64_t(cur_block_num) * 100 / last_block_num;
                         if (reindex_percent - last_reindex_percent >= 1) {
+                            auto now = fc::time_point::now();
+                            auto stats = prefetcher.get_stats();
+                            auto period = std::max(seconds(now - last_report), 0.001);
+                            auto blocks = cur_block_num - last_report_block_num;
+                            auto decoded = stats.decoded_blocks - last_report_stats.decoded_blocks;
+                            auto decode_time = seconds(stats.decode_time - last_report_stats.decode_time);
+                            auto applying_time = seconds(apply_time - last_report_apply_time);
+
                             std::cerr
                                 << "   " << reindex_percent << "%   "
                                 << cur_block_num << " of " << last_block_num
-                                << "   ("  << (free_memory() / (1024 * 1024)) << "M free"
-                                << ", elapsed " << double((end - start).count()) / 1000000.0 << " sec)\n";
+                                << "   (decode: " << uint64_t(decoded / period) << " blk/s"
+                                << ", " << (decoded ? decode_time * 1000 / decoded : 0) << " ms/blk"
+                                << " in " << prefetcher.threads() << " threads"
+                                << "; apply: " << uint64_t(blocks / period) << " blk/s"
+                                << ", " << (blocks ? applying_time * 1000 / blocks : 0) << " ms/blk"
+                                << "; apply waited " << seconds(stats.apply_wait - last_report_stats.apply_wait) << " sec"
+                                << ", decoders waited " << seconds(stats.decoders_wait - last_report_stats.decoders_wait) << " sec"
+                                << "; " << (free_memory() / (1024 * 1024)) << "M free"
+                                << ", elapsed " << seconds(now - start) << " sec)\n";
 
                             last_reindex_percent = reindex_percent;
+                            last_report = now;
+                            last_report_stats = stats;
+                            last_report_apply_time = apply_time;
+                            last_report_block_num = cur_block_num;
                         }
 
-                        apply_block(cur_block, skip_flags);
+                        apply_prefetched(cur_block);
 
                         if (cur_block_num % 1000 == 0) {
                             set_revision(head_block_num());
@@ -320,10 +378,15 @@ namespace golos { namespace chain {
                         cur_block_num++;
                     }
 
-                    auto cur_block = *_block_log.read_block_by_num(cur_block_num);
-                    apply_block(cur_block, skip_flags);
+                    apply_prefetched(prefetcher.next());
                     set_reserved_memory(0);
                     set_revision(head_block_num());
+
+                    auto stats = prefetcher.get_stats();
+                    ilog("Replay stages: decoded ${d} blocks in ${dt} sec (${threads} threads), applied in ${at} sec, "
+                        "apply waited for decoders ${aw} sec, decoders waited for apply ${dw} sec",
+                        ("d", stats.decoded_blocks)("dt", seconds(stats.decode_time))("threads", prefetcher.threads())
+                        ("at", seconds(apply_time))("aw", seconds(stats.apply_wait))("dw", seconds(stats.decoders_wait)));
                 });
 
                 set_reindexing(false);
@@ -357,10 +420,26 @@ namespace golos { namespace chain {
             _block_num_check_free_memory = value;
         }
 
+        void database::set_replay_decode_threads(uint32_t value) {
+            _replay_decode_threads = value;
+        }
+
+        void database::set_signature_recovery_threads(uint32_t value) {
+            _signature_recovery.start(value);
+        }
+
+        void database::set_cashout_threads(uint32_t value) {
+            _cashout_engine.start(value);
+        }
+
         void database::set_init_block_log(bool init_block_log) {
             _init_block_log = init_block_log;
         }
 
+        void database::set_compressed_block_log_cache_size(uint32_t chunks) {
+            _block_log.set_archive_cache_size(chunks);
+        }
+
         void database::set_store_account_metadata(store_metadata_modes store_account_metadata) {
             _store_account_metadata = store_account_metadata;
         }
@@ -483,6 +562,8 @@ namespace golos { namespace chain {
             if (include_blocks) {
                 fc::remove_all(data_dir / "block_log");
                 fc::remove_all(data_dir / "block_log.index");
+                fc::remove_all(compressed_block_log::archive_path(data_dir / "block_log"));
+                fc::remove_all(compressed_block_log::index_path(data_dir / "block_log"));
             }
         }
 
@@ -600,6 +681,7 @@ namespace golos { namespace chain {
                 auto &index = get_index<transaction_index>().indices().get<by_trx_id>();
                 auto itr = index.find(trx_id);
                 FC_ASSERT(itr != index.end());
+                FC_ASSERT(!itr->packed_trx.empty(), "Bodies of recent transactions are not stored");
                 signed_transaction trx;
                 fc::raw::unpack(itr->packed_trx, trx);
                 return trx;;
@@ -1257,6 +1339,28 @@ namespace golos { namespace chain {
             return skip;
         }
 
+        void database::recover_signatures(const signed_block& b, uint32_t skip) {
+            const uint32_t signature_steps = skip_witness_signature | skip_transaction_signatures;
+            if ((skip & signature_steps) == signature_steps) {
+                return;
+            }
+
+            // signatures of blocks before last checkpoint aren't checked
+            if (_checkpoints.size() && _checkpoints.rbegin()->first >= b.block_num()) {
+                return;
+            }
+
+            _signature_recovery.recover(b, STEEMIT_CHAIN_ID);
+        }
+
+        void database::recover_signatures(const signed_transaction& trx, uint32_t skip) {
+            if (skip & (skip_transaction_signatures | skip_authority_check)) {
+                return;
+            }
+
+            _signature_recovery.recover(trx, STEEMIT_CHAIN_ID);
+        }
+
         void database::_validate_block(const signed_block& new_block, uint32_t skip) {
             uint32_t new_block_num = new_block.block_num();
 
@@ -1660,6 +1764,10 @@ namespace golos { namespace chain {
             _enable_plugins_on_push_transaction = value;
         }
 
+        void database::set_store_recent_transactions(bool value) {
+            _store_recent_transactions = value;
+        }
+
         void database::notify_pre_apply_operation(operation_notification &note) {
             note.trx_id = _current_trx_id;
             note.block = _current_block_num;
@@ -2028,6 +2136,9 @@ namespace golos { namespace chain {
             } FC_CAPTURE_AND_RETHROW((acc.name)) };
 
             if (has_hardfork(STEEMIT_HARDFORK_0_27)) {
+                // Since HF27 accounts are processed in order of by_proved index, and result depends on order:
+                //   returning of delegations changes effective vesting shares of other accounts.
+                // This order can't be restored without walking the index, so it stays a full walk of not frozen accounts.
                 const auto& idx = get_index<account_index, by_proved>();
                 auto itr = idx.begin();
                 for (; itr != idx.end() && !itr->frozen; ++itr) {
@@ -2035,9 +2146,11 @@ namespace golos { namespace chain {
                     process_acc(*itr);
                 }
             } else {
+                // Accounts are ordered by deadline of idleness, so only idle accounts are visited.
+                // There are no frozen accounts before HF27.
                 const auto& idx = get_index<account_index, by_last_active_operation>();
-                auto itr = idx.lower_bound(old_time);
-                for (; itr != idx.end(); ++itr) {
+                auto itr = idx.lower_bound(std::make_tuple(false, old_time));
+                for (; itr != idx.end() && !itr->frozen; ++itr) {
                     process_acc(*itr);
                 }
             }
@@ -3186,7 +3299,7 @@ namespace golos { namespace chain {
             } FC_CAPTURE_AND_RETHROW()
         }
 
-        void database::cashout_comment_helper(const comment_object &comment) {
+        void database::cashout_comment_helper(const comment_object &comment, comment_curation_info* prepared_info) {
             protocol::curation_curve curve = comment.curation_reward_curve;
             try {
                 const comment_bill_object* cblo = nullptr;
@@ -3223,7 +3336,14 @@ namespace golos { namespace chain {
 
                         share_type total_curator = 0;
 
-                        comment_curation_info curation_info(*this, comment, false);
+                        std::unique_ptr<comment_curation_info> own_info;
+                        if (prepared_info) {
+                            prepared_info->update_min_vesting_shares(*this);
+                        } else {
+                            own_info = std::make_unique<comment_curation_info>(*this, comment, false);
+                            prepared_info = own_info.get();
+                        }
+                        const auto& curation_info = *prepared_info;
                         curve = curation_info.curve;
                         author_tokens += pay_curators(curation_info, curation_tokens, total_curator);
 
@@ -3348,18 +3468,29 @@ namespace golos { namespace chain {
             const bool has_hardfork_0_17__431 = has_hardfork(STEEMIT_HARDFORK_0_17__431);
             const auto block_time = head_block_time();
 
+            if (has_hardfork_0_17__431) {
+                // payout of comment moves only it out of the range, so all due comments can be taken at once
+                //   in the same order as they are paid one by one from the head of index
+                std::vector<const comment_object*> comments;
+                for (auto itr = cidx.begin(); itr != cidx.end() && itr->cashout_time <= block_time; ++itr) {
+                    comments.push_back(&*itr);
+                }
+
+                auto infos = _cashout_engine.prepare(*this, comments);
+                for (size_t i = 0; i < comments.size(); ++i) {
+                    cashout_comment_helper(*comments[i], infos[i].get());
+                }
+                return;
+            }
+
             auto current = cidx.begin();
             while (current != cidx.end() && current->cashout_time <= block_time) {
-                if (has_hardfork_0_17__431) {
-                    cashout_comment_helper(*current);
-                } else {
-                    auto itr = com_by_root.lower_bound(current->root_comment);
-                    while (itr != com_by_root.end() && itr->root_comment == current->root_comment) {
-                        const auto &comment = *itr;
-                        ++itr;
-                        cashout_comment_helper(comment);
-                        ++count;
-                    }
+                auto itr = com_by_root.lower_bound(current->root_comment);
+                while (itr != com_by_root.end() && itr->root_comment == current->root_comment) {
+                    const auto &comment = *itr;
+                    ++itr;
+                    cashout_comment_helper(comment);
+                    ++count;
                 }
                 current = cidx.begin();
             }
@@ -4676,6 +4807,7 @@ namespace golos { namespace chain {
                 };
 
                 try {
+                    // keys are taken from signature_cache if they were recovered before
                     trx.verify_authority(chain_id, get_active, get_owner, get_posting, STEEMIT_MAX_SIG_CHECK_DEPTH);
                 }
                 catch (protocol::tx_missing_active_auth &e) {
@@ -4827,13 +4959,17 @@ namespace golos { namespace chain {
             } FC_CAPTURE_AND_RETHROW((next_block))
         }
 
+#define GOLOS_PROFILE_STEP(name, call) { block_profiler::step_timer _step_timer(_profiler, name); call; }
+
         void database::_apply_block(const signed_block &next_block, uint32_t skip) {
             try {
                 uint32_t next_block_num = next_block.block_num();
                 const auto &gprops = get_dynamic_global_properties();
                 //block_id_type next_block_id = next_block.id();
 
-                _validate_block(next_block, skip);
+                block_profiler::block_timer block_timer(_profiler, next_block_num);
+
+                GOLOS_PROFILE_STEP("validate_block", _validate_block(next_block, skip));
 
                 const witness_object &signing_witness = validate_block_header(skip, next_block);
 
@@ -4841,6 +4977,8 @@ namespace golos { namespace chain {
                 _current_trx_in_block = 0;
                 _current_virtual_op = 0;
 
+                STEEMIT_TRY_NOTIFY(applying_block, next_block);
+
                 /// modify current witness so transaction evaluators can know who included the transaction,
                 /// this is mostly for POW operations which must pay the current_witness
                 modify(gprops, [&](dynamic_global_property_object &dgp) {
@@ -4861,85 +4999,95 @@ namespace golos { namespace chain {
                     );
                 }
 
-                for (const auto &trx : next_block.transactions) {
-                    /* We do not need to push the undo state for each transaction
-                     * because they either all apply and are valid or the
-                     * entire block fails to apply.  We only need an "undo" state
-                     * for transactions when validating broadcast transactions or
-                     * when building a block.
-                     */
-                    apply_transaction(trx, skip);
-                    ++_current_trx_in_block;
+                {
+                    block_profiler::step_timer _step_timer(_profiler, "apply_transactions");
+                    for (const auto &trx : next_block.transactions) {
+                        /* We do not need to push the undo state for each transaction
+                         * because they either all apply and are valid or the
+                         * entire block fails to apply.  We only need an "undo" state
+                         * for transactions when validating broadcast transactions or
+                         * when building a block.
+                         */
+                        apply_transaction(trx, skip);
+                        ++_current_trx_in_block;
+                    }
                 }
 
                 _current_trx_in_block = -1;
                 _current_op_in_trx = 0;
                 _current_virtual_op = 0;
 
-                update_global_dynamic_data(next_block, skip);
-                update_signing_witness(signing_witness, next_block);
+                GOLOS_PROFILE_STEP("update_global_dynamic_data", update_global_dynamic_data(next_block, skip));
+                GOLOS_PROFILE_STEP("update_signing_witness", update_signing_witness(signing_witness, next_block));
 
-                update_last_irreversible_block(skip);
+                GOLOS_PROFILE_STEP("update_last_irreversible_block", update_last_irreversible_block(skip));
 
-                create_block_summary(next_block);
+                GOLOS_PROFILE_STEP("create_block_summary", create_block_summary(next_block));
 
-                clear_expired_proposals();
-                clear_expired_transactions();
-                clear_expired_orders();
-                clear_expired_delegations();
+                GOLOS_PROFILE_STEP("clear_expired_proposals", clear_expired_proposals());
+                GOLOS_PROFILE_STEP("clear_expired_transactions", clear_expired_transactions());
+                GOLOS_PROFILE_STEP("clear_expired_orders", clear_expired_orders());
+                GOLOS_PROFILE_STEP("clear_expired_delegations", clear_expired_delegations());
 
-                check_witness_idleness();
-                update_witness_schedule();
+                GOLOS_PROFILE_STEP("check_witness_idleness", check_witness_idleness());
+                GOLOS_PROFILE_STEP("update_witness_schedule", update_witness_schedule());
 
-                update_median_feed();
-                update_virtual_supply();
+                GOLOS_PROFILE_STEP("update_median_feed", update_median_feed());
+                GOLOS_PROFILE_STEP("update_virtual_supply", update_virtual_supply());
 
-                clear_null_account_balance();
-                process_funds();
-                process_accumulative_distributions();
-                auto_claim_accumulatives();
-                process_conversions();
-                process_sbd_debt_conversions();
-                process_comment_cashout();
-                process_worker_votes();
-                process_worker_cashout();
-                check_account_idleness();
-                check_claim_idleness();
-                process_events();
-                process_vesting_withdrawals();
-                process_savings_withdraws();
-                pay_liquidity_reward();
-                update_virtual_supply();
+                GOLOS_PROFILE_STEP("clear_null_account_balance", clear_null_account_balance());
+                GOLOS_PROFILE_STEP("process_funds", process_funds());
+                GOLOS_PROFILE_STEP("process_accumulative_distributions", process_accumulative_distributions());
+                GOLOS_PROFILE_STEP("auto_claim_accumulatives", auto_claim_accumulatives());
+                GOLOS_PROFILE_STEP("process_conversions", process_conversions());
+                GOLOS_PROFILE_STEP("process_sbd_debt_conversions", process_sbd_debt_conversions());
+                GOLOS_PROFILE_STEP("process_comment_cashout", process_comment_cashout());
+                GOLOS_PROFILE_STEP("process_worker_votes", process_worker_votes());
+                GOLOS_PROFILE_STEP("process_worker_cashout", process_worker_cashout());
+                GOLOS_PROFILE_STEP("check_account_idleness", check_account_idleness());
+                GOLOS_PROFILE_STEP("check_claim_idleness", check_claim_idleness());
+                GOLOS_PROFILE_STEP("process_events", process_events());
+                GOLOS_PROFILE_STEP("process_vesting_withdrawals", process_vesting_withdrawals());
+                GOLOS_PROFILE_STEP("process_savings_withdraws", process_savings_withdraws());
+                GOLOS_PROFILE_STEP("pay_liquidity_reward", pay_liquidity_reward());
+                GOLOS_PROFILE_STEP("update_virtual_supply", update_virtual_supply());
 
-                account_recovery_processing();
-                expire_escrow_ratification();
-                process_decline_voting_rights();
+                GOLOS_PROFILE_STEP("account_recovery_processing", account_recovery_processing());
+                GOLOS_PROFILE_STEP("expire_escrow_ratification", expire_escrow_ratification());
+                GOLOS_PROFILE_STEP("process_decline_voting_rights", process_decline_voting_rights());
 
-                process_hardforks();
+                GOLOS_PROFILE_STEP("process_hardforks", process_hardforks());
 
-                process_account_freezing();
+                GOLOS_PROFILE_STEP("process_account_freezing", process_account_freezing());
 
-                process_gbg_payments();
+                GOLOS_PROFILE_STEP("process_gbg_payments", process_gbg_payments());
 
-                process_paid_subscribers();
+                GOLOS_PROFILE_STEP("process_paid_subscribers", process_paid_subscribers());
 
-                process_nft_bets();
+                GOLOS_PROFILE_STEP("process_nft_bets", process_nft_bets());
 
                 // notify observers that the block has been applied
-                notify_applied_block(next_block);
+                GOLOS_PROFILE_STEP("notify_applied_block", notify_applied_block(next_block));
 
                 process_transit_to_cyberway(next_block, skip);
 
-                notify_changed_objects();
+                GOLOS_PROFILE_STEP("notify_changed_objects", notify_changed_objects());
 
                 if (has_hardfork(STEEMIT_HARDFORK_0_30)) {
                     hf_actions hf_act(*this);
                     hf_act.fix_vesting_withdrawals();
                 }
 
+                if (block_timer.end()) {
+                    STEEMIT_TRY_NOTIFY(applied_block_profile, _profiler.last_block());
+                }
+
+                STEEMIT_TRY_NOTIFY(applied_block_changes, next_block);
             } FC_CAPTURE_LOG_AND_RETHROW((next_block.block_num()))
         }
 
+#undef GOLOS_PROFILE_STEP
+
         void database::process_header_extensions(const signed_block &next_block) {
             auto itr = next_block.extensions.begin();
 
@@ -5080,11 +5228,16 @@ namespace golos { namespace chain {
 
         void database::_apply_transaction(const signed_transaction &trx, uint32_t skip) {
             try {
-                _current_trx_id = trx.id();
+                // during replay id and size of transaction are calculated by the block_prefetcher
+                const bool is_prefetched = _prefetched_block != nullptr &&
+                    _current_trx_in_block < _prefetched_block->trx_ids.size() &&
+                    &trx == &_prefetched_block->block.transactions[_current_trx_in_block];
+
+                auto trx_id = is_prefetched ? _prefetched_block->trx_ids[_current_trx_in_block] : trx.id();
+                _current_trx_id = trx_id;
                 _current_virtual_op = 0;
 
                 auto &trx_idx = get_index<transaction_index>();
-                auto trx_id = trx.id();
                 // idump((trx_id)(skip&skip_transaction_dupe_check));
                 if (!(skip & skip_transaction_dupe_check) &&
                           trx_idx.indices().get<by_trx_id>().find(trx_id) != trx_idx.indices().get<by_trx_id>().end()) {
@@ -5098,7 +5251,7 @@ namespace golos { namespace chain {
                 vector<authority> other;
                 trx.get_required_authorities(required, required, required, other);
 
-                auto trx_size = fc::raw::pack_size(trx);
+                auto trx_size = is_prefetched ? _prefetched_block->trx_sizes[_current_trx_in_block] : fc::raw::pack_size(trx);
 
                 const auto& props = get_dynamic_global_properties();
 
@@ -5131,7 +5284,9 @@ namespace golos { namespace chain {
                     create<transaction_object>([&](transaction_object &transaction) {
                         transaction.trx_id = trx_id;
                         transaction.expiration = trx.expiration;
-                        fc::raw::pack(transaction.packed_trx, trx);
+                        if (_store_recent_transactions) {
+                            fc::raw::pack(transaction.packed_trx, trx);
+                        }
                     });
                 }
 
@@ -5163,7 +5318,10 @@ namespace golos { namespace chain {
                 note.virtual_op = _current_virtual_op;
             }
             notify_pre_apply_operation(note);
-            _my->_evaluator_registry.get_evaluator(op).apply(op);
+            {
+                block_profiler::operation_timer timer(_profiler, op.which());
+                _my->_evaluator_registry.get_evaluator(op).apply(op);
+            }
             notify_post_apply_operation(note);
         }
 
@@ -5176,7 +5334,7 @@ namespace golos { namespace chain {
                 const witness_object &witness = get_witness(next_block.witness);
 
                 if (!(skip & skip_witness_signature))
-                    FC_ASSERT(next_block.validate_signee(witness.signing_key));
+                    FC_ASSERT(_signature_recovery.get_signee(next_block) == witness.signing_key);
 
                 if (!(skip & skip_witness_schedule_check)) {
                     uint32_t slot_num = get_slot_at_time(next_block.timestamp);
@@ -5466,7 +5624,10 @@ namespace golos { namespace chain {
                             log_head_num++;
                         }
 
-                        _block_log.flush();
+                        // blocks of syncing node can be downloaded again, so only recent ones are synced to disk
+                        if (head_block_time() + fc::minutes(1) >= fc::time_point::now()) {
+                            _block_log.flush();
+                        }
                     }
                 }
 
@@ -447,12 +447,15 @@ typedef multi_index_container<
                         account_object,
                         member<account_object, time_point_sec, &account_object::next_vesting_withdrawal>,
                         member<account_object, account_id_type, &account_object::id>>>,
+                // Not frozen accounts go first, so idleness check visits only accounts with passed deadline
                 ordered_unique<tag<by_last_active_operation>,
                     composite_key<
                         account_object,
+                        member<account_object, bool, &account_object::frozen>,
                         member<account_object, time_point_sec, &account_object::last_active_operation>,
                         member<account_object, account_id_type, &account_object::id>>,
                     composite_key_compare<
+                        std::less<bool>,
                         std::greater<time_point_sec>,
                         std::less<account_id_type>>>,
                 ordered_unique<tag<by_last_claim>,
@@ -766,6 +769,7 @@ FC_REFLECT((golos::chain::account_object),
     (created)(mined)
     (owner_challenged)(active_challenged)(last_owner_proved)(last_active_proved)(recovery_account)(last_account_recovery)(reset_account)
     (comment_count)(lifetime_vote_count)(post_count)(sponsor_count)(referral_count)(can_vote)(voting_power)(last_vote_time)(reputation)
+    (posts_capacity)(comments_capacity)(voting_capacity)(negrep_posting_capacity)
     (balance)
     (savings_balance)
     (accumulative_balance)
@@ -795,6 +799,9 @@ FC_REFLECT((golos::chain::account_authority_object),
 )
 CHAINBASE_SET_INDEX_TYPE(golos::chain::account_authority_object, golos::chain::account_authority_index)
 
+FC_REFLECT((golos::chain::account_freeze_object),
+        (id)(account)(owner)(active)(posting)(hardfork)(frozen)
+)
 CHAINBASE_SET_INDEX_TYPE(golos::chain::account_freeze_object, golos::chain::account_freeze_index)
 
 FC_REFLECT((golos::chain::account_bandwidth_object),
@@ -804,7 +811,7 @@ CHAINBASE_SET_INDEX_TYPE(golos::chain::account_bandwidth_object, golos::chain::a
 FC_REFLECT((golos::chain::account_metadata_object), (id)(account)(json_metadata))
 CHAINBASE_SET_INDEX_TYPE(golos::chain::account_metadata_object, golos::chain::account_metadata_index)
 
-FC_REFLECT((golos::chain::vesting_delegation_object), (id)(delegator)(delegatee)(vesting_shares)(interest_rate)(min_delegation_time)(is_emission))
+FC_REFLECT((golos::chain::vesting_delegation_object), (id)(delegator)(delegatee)(vesting_shares)(interest_rate)(payout_strategy)(min_delegation_time)(is_emission))
 CHAINBASE_SET_INDEX_TYPE(golos::chain::vesting_delegation_object, golos::chain::vesting_delegation_index)
 
 FC_REFLECT((golos::chain::vesting_delegation_expiration_object),
@@ -10,6 +10,45 @@ namespace golos {
 
         namespace detail { class block_log_impl; }
 
+        /**
+         * Packed bytes of a block stored in the block log, they are read without unpacking of the block.
+         * View keeps alive the memory it points to, so it stays valid after the block log grows or is closed.
+         */
+        class block_view {
+        public:
+            block_view() = default;
+
+            block_view(std::shared_ptr<const void> holder, const char* data, std::size_t size);
+
+            bool valid() const {
+                return _data != nullptr;
+            }
+
+            const char* data() const {
+                return _data;
+            }
+
+            std::size_t size() const {
+                return _size;
+            }
+
+            /**
+             * Unpacks only the header of block.
+             */
+            signed_block_header header() const;
+
+            block_id_type id() const;
+
+            uint32_t block_num() const;
+
+            signed_block unpack() const;
+
+        private:
+            std::shared_ptr<const void> _holder;
+            const char* _data = nullptr;
+            std::size_t _size = 0;
+        };
+
         /* The block log is an external append only log of the blocks. Blocks should only be written
          * to the log after they irreverisble as the log is append only. The log is a doubly linked
          * list of blocks. There is a secondary index file of only block positions that enables O(1)
@@ -33,6 +72,10 @@ namespace golos {
          *
          * The main file is the only file that needs to persist. The index file can be reconstructed during a
          * linear scan of the main file.
+         *
+         * Old blocks can be moved to the compressed block log (see compressed_block_log). In this case the main
+         * file and the index start from the block next to the last archived one, and the archived blocks are
+         * read by number from the compressed block log. They don't have positions in the main file.
          */
 
         class block_log {
@@ -49,17 +92,35 @@ namespace golos {
 
             uint64_t append(const signed_block& b);
 
+            /**
+             * Makes appended blocks durable, they are visible to readers before it.
+             */
             void flush();
 
             std::pair<signed_block, uint64_t> read_block(uint64_t file_pos) const;
 
             optional <signed_block> read_block_by_num(uint32_t block_num) const;
 
+            /**
+             * Return packed block without unpacking it, or empty view if block does not exist.
+             */
+            block_view read_block_view(uint32_t block_num) const;
+
             /**
              * Return offset of block in file, or block_log::npos if it does not exist.
              */
             uint64_t get_block_pos(uint32_t block_num) const;
 
+            /**
+             * Return number of last block stored in the compressed block log, or 0 if there is no such log.
+             */
+            uint32_t archived_block_num() const;
+
+            /**
+             * Sets number of decompressed chunks of the compressed block log which are kept in memory.
+             */
+            void set_archive_cache_size(uint32_t chunks);
+
             signed_block read_head() const;
 
             const optional <signed_block>& head() const;
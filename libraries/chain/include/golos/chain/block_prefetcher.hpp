@@ -0,0 +1,94 @@
+#pragma once
+
+#include <golos/chain/block_log.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace golos { namespace chain {
+
+        /**
+         * Block read from block_log with data which can be calculated without access to the state.
+         */
+        struct prefetched_block {
+            signed_block block;
+            std::vector<transaction_id_type> trx_ids;
+            std::vector<uint32_t> trx_sizes;
+        };
+
+        using prefetched_block_ptr = std::shared_ptr<const prefetched_block>;
+
+        /**
+         * Reads, unpacks and pre-processes blocks from block_log ahead of the replay.
+         *
+         * Decoder threads take block numbers in order and store results to a bounded ring,
+         * the apply thread receives them via next() strictly in order of block numbers.
+         * With zero decoder threads blocks are decoded in the calling thread.
+         */
+        class block_prefetcher final {
+        public:
+            struct stats {
+                uint32_t decoded_blocks = 0;
+                fc::microseconds decode_time;     ///< summary time of decoding in all threads
+                fc::microseconds decoders_wait;   ///< summary time while decoders waited for free slots
+                fc::microseconds apply_wait;      ///< time while apply thread waited for decoded blocks
+            };
+
+            block_prefetcher(const block_log& log, uint32_t from_block_num, uint32_t last_block_num,
+                uint32_t threads, uint32_t queue_size);
+
+            ~block_prefetcher();
+
+            void start();
+
+            void stop();
+
+            /**
+             * Returns next block in order, waits for decoders if it isn't ready yet.
+             * Rethrows exception if decoding of the block failed.
+             */
+            prefetched_block_ptr next();
+
+            stats get_stats() const;
+
+            uint32_t threads() const {
+                return _threads;
+            }
+
+            static prefetched_block_ptr decode(const block_log& log, uint32_t block_num);
+
+        private:
+            struct slot {
+                uint32_t block_num = 0;
+                prefetched_block_ptr data;
+                std::exception_ptr error;
+            };
+
+            void decoder_loop();
+
+            const block_log& _log;
+            const uint32_t _last_block_num;
+            const uint32_t _threads;
+            const uint32_t _queue_size;
+
+            std::vector<slot> _ring;
+            std::vector<std::thread> _decoders;
+
+            mutable std::mutex _mutex;
+            std::condition_variable _decoded_cond;
+            std::condition_variable _taken_cond;
+
+            uint32_t _next_to_decode;
+            uint32_t _next_to_take;
+            bool _stopped = false;
+
+            std::atomic<int64_t> _decode_time{0};
+            std::atomic<int64_t> _decoders_wait{0};
+            std::atomic<uint32_t> _decoded_blocks{0};
+            int64_t _apply_wait = 0;
+        };
+
+} } // golos::chain
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <fc/reflect/reflect.hpp>
+#include <fc/time.hpp>
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace golos { namespace chain {
+
+        /**
+         * Histogram of durations. Bucket N counts durations less than 2^N microseconds,
+         * the last bucket counts all longer durations.
+         */
+        struct profile_histogram {
+            static constexpr uint32_t bucket_count = 24;
+
+            uint64_t count = 0;
+            uint64_t total_us = 0;
+            uint64_t max_us = 0;
+            std::vector<uint64_t> buckets;
+
+            void add(uint64_t us);
+        };
+
+        /**
+         * Timings of the last applied block.
+         */
+        struct block_apply_profile {
+            uint32_t block_num = 0;
+            uint64_t time_us = 0;
+            std::vector<std::pair<std::string, uint64_t>> steps;      ///< pairs of step name and time
+            std::vector<std::pair<std::string, uint64_t>> evaluators; ///< pairs of operation name and summary time
+        };
+
+        /**
+         * Timings of all profiled blocks.
+         */
+        struct block_profiler_stats {
+            uint32_t blocks = 0;
+            uint32_t slow_blocks = 0;
+            profile_histogram block;
+            std::map<std::string, profile_histogram> steps;
+            std::map<std::string, profile_histogram> evaluators; ///< time of each operation
+        };
+
+        /**
+         * Measures time of steps of block applying and of evaluators.
+         *
+         * The apply thread stores timings of the current block without locking, they are added to histograms
+         * at the end of block. When profiling is disabled, timers only check a flag.
+         */
+        class block_profiler final {
+        public:
+            /**
+             * Drops timings of block if it is failed to apply
+             */
+            class block_timer final {
+            public:
+                block_timer(block_profiler& profiler, uint32_t block_num)
+                    : _profiler(profiler) {
+                    _profiler.begin_block(block_num);
+                }
+
+                ~block_timer() {
+                    _profiler.abort_block();
+                }
+
+                bool end() {
+                    return _profiler.end_block();
+                }
+
+            private:
+                block_profiler& _profiler;
+            };
+
+            class step_timer final {
+            public:
+                step_timer(block_profiler& profiler, const char* name)
+                    : _profiler(profiler), _name(name) {
+                    if (_profiler._in_block) {
+                        _start = fc::time_point::now();
+                    }
+                }
+
+                ~step_timer() {
+                    if (_profiler._in_block) {
+                        _profiler.add_step(_name, (fc::time_point::now() - _start).count());
+                    }
+                }
+
+            private:
+                block_profiler& _profiler;
+                const char* _name;
+                fc::time_point _start;
+            };
+
+            class operation_timer final {
+            public:
+                operation_timer(block_profiler& profiler, int64_t which)
+                    : _profiler(profiler), _which(which) {
+                    if (_profiler._in_block) {
+                        _start = fc::time_point::now();
+                    }
+                }
+
+                ~operation_timer() {
+                    if (_profiler._in_block) {
+                        _profiler.add_operation(_which, (fc::time_point::now() - _start).count());
+                    }
+                }
+
+            private:
+                block_profiler& _profiler;
+                int64_t _which;
+                fc::time_point _start;
+            };
+
+            void enable(bool value) {
+                _enabled = value;
+            }
+
+            bool enabled() const {
+                return _enabled;
+            }
+
+            /**
+             * Blocks applied longer than threshold are logged with their timings, 0 - do not log
+             */
+            void set_slow_block_threshold(fc::microseconds value) {
+                _slow_block_threshold = value;
+            }
+
+            void begin_block(uint32_t block_num);
+
+            /**
+             * Adds timings of block to histograms, returns true if block is profiled
+             */
+            bool end_block();
+
+            /**
+             * Drops timings of block which is failed to apply
+             */
+            void abort_block();
+
+            block_apply_profile last_block() const;
+
+            block_profiler_stats get_stats() const;
+
+            void reset();
+
+        private:
+            void add_step(const char* name, int64_t us) {
+                _block_steps.emplace_back(name, us);
+            }
+
+            void add_operation(int64_t which, int64_t us) {
+                _block_operations.emplace_back(which, us);
+            }
+
+            const std::string& operation_name(int64_t which);
+
+            void log_slow_block(const block_apply_profile& profile) const;
+
+            bool _enabled = false;
+            bool _in_block = false;
+            fc::microseconds _slow_block_threshold;
+
+            uint32_t _block_num = 0;
+            fc::time_point _block_start;
+            std::vector<std::pair<const char*, int64_t>> _block_steps;
+            std::vector<std::pair<int64_t, int64_t>> _block_operations;
+
+            mutable std::mutex _mutex;
+            std::vector<std::string> _operation_names;
+            block_apply_profile _last_block;
+            block_profiler_stats _stats;
+        };
+
+} } // golos::chain
+
+FC_REFLECT((golos::chain::profile_histogram), (count)(total_us)(max_us)(buckets))
+FC_REFLECT((golos::chain::block_apply_profile), (block_num)(time_us)(steps)(evaluators))
+FC_REFLECT((golos::chain::block_profiler_stats), (blocks)(slow_blocks)(block)(steps)(evaluators))
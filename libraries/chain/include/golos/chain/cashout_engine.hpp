@@ -0,0 +1,51 @@
+#pragma once
+
+#include <boost/asio/io_service.hpp>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace golos { namespace chain {
+
+        class database;
+
+        class comment_object;
+
+        struct comment_curation_info;
+
+        /**
+         * Prepares cashout of comments which are paid in the same block.
+         *
+         * Building of the curation info (walk on votes, calculation of their weights and sorting) reads only
+         *   objects of the comment and its votes, which are not changed by payouts of other comments. So it is
+         *   performed for all comments of block by worker threads before the payouts, while the apply thread waits.
+         *   Rewards depend on the reward fund and on balances changed by the previous payouts, so they are paid
+         *   sequentially in the order of the by_cashout_time index.
+         * With zero worker threads nothing is prepared, and the curation info is built on payout of comment.
+         */
+        class cashout_engine final {
+        public:
+            using curation_info_ptr = std::unique_ptr<comment_curation_info>;
+
+            cashout_engine();
+
+            ~cashout_engine();
+
+            void start(uint32_t threads);
+
+            void stop();
+
+            /**
+             * Returns curation info for each comment with positive rshares, or nullptr if it isn't prepared.
+             * Waits until workers build all infos.
+             */
+            std::vector<curation_info_ptr> prepare(database& db, const std::vector<const comment_object*>& comments);
+
+        private:
+            boost::asio::io_service _ios;
+            std::unique_ptr<boost::asio::io_service::work> _work;
+            std::vector<std::thread> _workers;
+        };
+
+} } // golos::chain
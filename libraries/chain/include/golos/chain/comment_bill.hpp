@@ -54,4 +54,10 @@ using comment_bill_index = multi_index_container<
 
 }}
 
+FC_REFLECT((golos::chain::comment_bill),
+    (max_accepted_payout)(percent_steem_dollars)(allow_curation_rewards)(min_golos_power_to_curate)
+    (curation_rewards_percent)(auction_window_reward_destination)(auction_window_size))
+
+FC_REFLECT((golos::chain::comment_bill_object), (id)(comment)(bill)(beneficiaries))
+
 CHAINBASE_SET_INDEX_TYPE(golos::chain::comment_bill_object, golos::chain::comment_bill_index)
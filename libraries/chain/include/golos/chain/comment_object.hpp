@@ -281,6 +281,22 @@ namespace golos {
 
 FC_REFLECT_ENUM(golos::chain::comment_mode, (not_set)(first_payout)(second_payout)(archived))
 
+FC_REFLECT((golos::chain::comment_object),
+    (id)(parent_author)(parent_hashlink)(author)(hashlink)(parent_permlink_size)(created)(last_payout)
+    (depth)(children)(net_rshares)(abs_rshares)(vote_rshares)(children_abs_rshares)(cashout_time)(max_cashout_time)
+    (reward_weight)(net_votes)(total_votes)(root_comment)(mode)(curation_reward_curve)(allow_votes))
+
+FC_REFLECT((golos::chain::comment_app_object), (id)(app))
+
+FC_REFLECT((golos::chain::comment_extras_object),
+    (id)(author)(hashlink)(permlink)(parent_permlink)(app_id)(has_worker_request)(children_rshares2)(decrypt_fee))
+
+FC_REFLECT((golos::chain::delegator_vote_interest_rate), (account)(interest_rate)(payout_strategy))
+
+FC_REFLECT((golos::chain::comment_vote_object),
+    (id)(voter)(comment)(orig_rshares)(rshares)(vote_percent)(auction_time)(last_update)(num_changes)
+    (delegator_vote_interest_rates))
+
 CHAINBASE_SET_INDEX_TYPE(golos::chain::comment_object, golos::chain::comment_index)
 
 CHAINBASE_SET_INDEX_TYPE(golos::chain::comment_app_object, golos::chain::comment_app_index)
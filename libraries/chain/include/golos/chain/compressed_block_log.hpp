@@ -0,0 +1,82 @@
+#pragma once
+
+#include <golos/chain/block_log.hpp>
+
+namespace golos {
+    namespace chain {
+
+        using namespace golos::protocol;
+
+        namespace detail { class compressed_block_log_impl; }
+
+        /* The compressed block log (v2) is a read-only archive of irreversible blocks, which is placed near to
+         * the block log and has the same name with the ".z" suffix. Blocks are grouped into chunks,
+         * each chunk is compressed independently, so any block can be read by decompressing only its chunk.
+         *
+         * +--------+-------------------+-------------------+-----+
+         * | Header | Compressed chunk 1| Compressed chunk 2| ... |
+         * +--------+-------------------+-------------------+-----+
+         *
+         * A decompressed chunk is a sequence of packed blocks without position markers.
+         *
+         * The index file (".z.index" suffix) contains a header, a table of chunks (file offset, compressed and
+         * decompressed sizes) and a table of blocks (chunk number and offset in decompressed chunk).
+         * Seek to header + 16 * chunks_count + 8 * (block_num - 1) to find the position of block.
+         *
+         * The archive contains blocks from 1 to last_block_num(), the block log continues it
+         * from the next block. Blocks are moved to the archive by the compress_block_log tool.
+         */
+
+        class compressed_block_log {
+        public:
+            compressed_block_log();
+
+            ~compressed_block_log();
+
+            /**
+             * Opens archive for the block log file if archive exists.
+             */
+            void open(const fc::path& block_log_file);
+
+            void close();
+
+            bool is_open() const;
+
+            /**
+             * Returns number of last block in archive, or 0 if archive is empty or isn't opened.
+             */
+            uint32_t last_block_num() const;
+
+            optional<signed_block> read_block_by_num(uint32_t block_num) const;
+
+            /**
+             * Returns packed block from decompressed chunk, the view keeps the chunk alive.
+             */
+            block_view read_block_view(uint32_t block_num) const;
+
+            /**
+             * Sets number of decompressed chunks which are kept in memory, at least one chunk is kept.
+             */
+            void set_cache_size(uint32_t chunks);
+
+            static fc::path archive_path(const fc::path& block_log_file);
+
+            static fc::path index_path(const fc::path& block_log_file);
+
+            /**
+             * Writes blocks [1, last_block_num] from the log to the archive for the output block log file.
+             */
+            static void write(
+                const block_log& log, uint32_t last_block_num,
+                const fc::path& block_log_file, uint32_t blocks_per_chunk);
+
+            static const uint32_t default_blocks_per_chunk = 256;
+
+            static const uint32_t default_cache_size = 8;
+
+        private:
+            std::unique_ptr<detail::compressed_block_log_impl> my;
+        };
+
+    }
+}
@@ -26,6 +26,12 @@ namespace golos { namespace chain {
         comment_curation_info(const comment_curation_info&) = delete;
 
         comment_curation_info(database& db, const comment_object&, bool);
+
+        /**
+         * Recalculates min_vesting_shares_to_curate by the current vesting share price.
+         * It is required if the info is built before payouts of other comments of the block.
+         */
+        void update_min_vesting_shares(const database& db);
     }; // struct comment_curation_info
 
 } } // namespace golos::chain
\ No newline at end of file
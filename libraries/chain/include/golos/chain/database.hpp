@@ -9,6 +9,9 @@
 #include <golos/chain/comment_bill.hpp>
 #include <golos/chain/fork_database.hpp>
 #include <golos/chain/block_log.hpp>
+#include <golos/chain/signature_recovery.hpp>
+#include <golos/chain/cashout_engine.hpp>
+#include <golos/chain/block_profiler.hpp>
 #include <golos/chain/hardfork.hpp>
 #include <golos/protocol/protocol.hpp>
 
@@ -35,6 +38,10 @@ namespace golos { namespace chain {
 
         struct comment_curation_info;
 
+        struct prefetched_block;
+
+        class snapshot_index;
+
         /**
          *   @class database
          *   @brief tracks the blockchain state in an extensible manner
@@ -132,12 +139,41 @@ namespace golos { namespace chain {
             void set_min_free_shared_memory_size(size_t);
             void set_inc_shared_memory_size(size_t);
             void set_block_num_check_free_size(uint32_t);
+            void set_replay_decode_threads(uint32_t);
+            void set_signature_recovery_threads(uint32_t);
+            void set_cashout_threads(uint32_t);
             void check_free_memory(bool skip_print, uint32_t current_block_num);
 
             void set_skip_virtual_ops();
 
             void set_init_block_log(bool init_block_log);
 
+            void set_compressed_block_log_cache_size(uint32_t chunks);
+
+            //////////////////// snapshot.cpp ////////////////////
+
+            void set_snapshot_threads(uint32_t);
+
+            /**
+             * Sets snapshot which is loaded into the empty state on open() instead of creating genesis
+             */
+            void set_snapshot_to_load(const fc::path& path);
+
+            /**
+             * Registers index which is written to and loaded from snapshots
+             */
+            void add_snapshot_index(std::unique_ptr<snapshot_index> index);
+
+            /**
+             * Writes objects of all snapshot indexes at the head block, which should be irreversible
+             */
+            void write_snapshot(const fc::path& path);
+
+            /**
+             * Loads objects of all snapshot indexes into the empty state, head block of state becomes the snapshot block
+             */
+            void load_snapshot(const fc::path& path);
+
             void set_store_account_metadata(store_metadata_modes store_account_metadata);
             void set_accounts_to_store_metadata(const std::vector<std::string>& accounts_to_store_metadata);
             bool store_metadata_for_account(const std::string& name) const;
@@ -370,10 +406,35 @@ namespace golos { namespace chain {
 
             uint32_t validate_block(const signed_block &b, uint32_t skip = skip_nothing);
 
+            /**
+             * Recovers public keys of block and transaction signatures before pushing them to database.
+             * It doesn't require any lock of database, and recovered keys are used on validation of authorities.
+             */
+            void recover_signatures(const signed_block &b, uint32_t skip = skip_nothing);
+
+            void recover_signatures(const signed_transaction &trx, uint32_t skip = skip_nothing);
+
             bool push_block(const signed_block &b, uint32_t skip = skip_nothing);
 
             void enable_plugins_on_push_transaction(bool);
 
+            /**
+             * Store packed transactions in the deduplication index to return them by get_recent_transaction().
+             * Without them the index keeps only ids and expirations, which reduces writes to shared memory and undo.
+             */
+            void set_store_recent_transactions(bool);
+
+            /**
+             * Timings of steps of block applying and of evaluators, it is disabled by default.
+             */
+            block_profiler& profiler() {
+                return _profiler;
+            }
+
+            const block_profiler& profiler() const {
+                return _profiler;
+            }
+
             void push_transaction(const signed_transaction &trx, uint32_t skip = skip_nothing);
 
             void _maybe_warn_multiple_production(uint32_t height) const;
@@ -462,6 +523,12 @@ namespace golos { namespace chain {
              */
             fc::signal<void(const signed_block &)> applied_block;
 
+            /**
+             * This signal is emitted when applying of block begins, operations notified after it and before
+             * applied_block belong to the block. If applying fails, applied_block isn't emitted.
+             */
+            fc::signal<void(const signed_block &)> applying_block;
+
             /**
              * This signal is emitted any time a new transaction is added to the pending
              * block state.
@@ -479,6 +546,17 @@ namespace golos { namespace chain {
              */
             fc::signal<void(const uint32_t, const uint32_t)> transit_to_cyberway;
 
+            /**
+             * This signal is emitted at the end of applying of block when profiler is enabled.
+             */
+            fc::signal<void(const block_apply_profile &)> applied_block_profile;
+
+            /**
+             * This signal is emitted at the very end of applying of block, when the undo session of block
+             * contains all changes made by block (applied_block is emitted before some of them).
+             */
+            fc::signal<void(const signed_block &)> applied_block_changes;
+
             /**
              *  Emitted After a block has been applied and committed.  The callback
              *  should not yield and should execute quickly.
@@ -604,7 +682,10 @@ namespace golos { namespace chain {
 
             share_type pay_curators(const comment_curation_info& c, share_type max_rewards, share_type& actual_rewards);
 
-            void cashout_comment_helper(const comment_object &comment);
+            /**
+             * Pays rewards of comment. If curation info is not prepared by the cashout engine, it is built here.
+             */
+            void cashout_comment_helper(const comment_object &comment, comment_curation_info* prepared_info = nullptr);
 
             void process_comment_cashout();
 
@@ -824,6 +905,12 @@ namespace golos { namespace chain {
 
             block_log _block_log;
 
+            signature_recovery _signature_recovery;
+
+            cashout_engine _cashout_engine;
+
+            block_profiler _profiler;
+
             // this function needs access to _plugin_index_signal
             template<typename MultiIndexType>
             friend void add_plugin_index(database &db);
@@ -850,12 +937,20 @@ namespace golos { namespace chain {
 
             uint32_t _block_num_check_free_memory = 1000;
 
+            uint32_t _replay_decode_threads = 0;
+            const prefetched_block* _prefetched_block = nullptr; ///< block which is being applied during replay
+
             uint32_t _clear_votes_block = 0;
             bool _skip_virtual_ops = false;
             bool _enable_plugins_on_push_transaction = true;
+            bool _store_recent_transactions = true;
 
             bool _init_block_log = true;
 
+            std::map<uint16_t, std::unique_ptr<snapshot_index>> _snapshot_indexes;
+            fc::path _snapshot_to_load;
+            uint32_t _snapshot_threads = 0;
+
             store_metadata_modes _store_account_metadata = store_metadata_for_all;
             std::vector<std::string> _accounts_to_store_metadata;
 
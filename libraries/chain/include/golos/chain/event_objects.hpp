@@ -33,6 +33,8 @@ namespace golos { namespace chain {
 
 } } // golos::chain
 
+FC_REFLECT((golos::chain::event_object), (id)(serialized_op))
+
 CHAINBASE_SET_INDEX_TYPE(
     golos::chain::event_object,
     golos::chain::event_index);
@@ -177,6 +177,7 @@ FC_REFLECT((golos::chain::dynamic_global_property_object),
                 (total_vesting_fund_steem)
                 (total_vesting_shares)
                 (accumulative_balance)
+                (accumulative_remainder)
                 (total_reward_fund_steem)
                 (total_reward_shares2)
                 (sbd_interest_rate)
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <golos/chain/database.hpp>
+#include <golos/chain/snapshot.hpp>
 
 namespace golos {
     namespace chain {
@@ -10,9 +11,18 @@ namespace golos {
             db.add_index<MultiIndexType>();
         }
 
+        /**
+         * Registers index to be written to state snapshots, all fields of its objects should be reflected
+         */
+        template<typename MultiIndexType>
+        void add_snapshot_index(database &db) {
+            db.add_snapshot_index(std::make_unique<snapshot_index_impl<MultiIndexType>>());
+        }
+
         template<typename MultiIndexType>
         void add_core_index(database &db) {
             _add_index_impl<MultiIndexType>(db);
+            add_snapshot_index<MultiIndexType>(db);
         }
 
         template<typename MultiIndexType>
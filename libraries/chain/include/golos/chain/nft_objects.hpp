@@ -342,6 +342,24 @@ namespace golos { namespace chain {
     >;
 } } // golos::chain
 
+FC_REFLECT((golos::chain::nft_collection_object),
+    (id)(creator)(name)(json_metadata)(created)(token_count)(max_token_count)(last_token_id)
+    (last_buy_price)(buy_order_count)(sell_order_count)(auction_count)(market_depth)(market_asks)(market_volume)
+)
+
+FC_REFLECT((golos::chain::nft_object),
+    (id)(creator)(name)(owner)(token_id)(burnt)(title)(image)(issue_cost)(last_buy_price)(json_metadata)
+    (issued)(last_update)(selling)(auction_min_price)(auction_expiration)
+)
+
+FC_REFLECT((golos::chain::nft_order_object),
+    (id)(creator)(name)(token_id)(owner)(order_id)(price)(selling)(holds)(created)
+)
+
+FC_REFLECT((golos::chain::nft_bet_object),
+    (id)(creator)(name)(token_id)(owner)(price)(created)
+)
+
 CHAINBASE_SET_INDEX_TYPE(
     golos::chain::nft_collection_object,
     golos::chain::nft_collection_index);
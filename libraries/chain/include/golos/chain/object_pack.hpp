@@ -0,0 +1,210 @@
+#pragma once
+
+#include <golos/chain/steem_object_types.hpp>
+#include <golos/chain/shared_authority.hpp>
+
+#include <fc/io/raw.hpp>
+
+#include <boost/interprocess/containers/deque.hpp>
+#include <boost/interprocess/containers/flat_set.hpp>
+#include <boost/interprocess/containers/vector.hpp>
+
+namespace golos { namespace chain { namespace object_pack {
+
+    /**
+     * Binary serialization of objects from shared memory by their reflected fields.
+     *
+     * Containers of shared memory are packed as their heap analogues, so objects can be unpacked in other process.
+     * They are unpacked into existing object, which has allocators of shared memory, so it should be called
+     * from the constructor or the modifier of object.
+     * fc::raw can't be extended by overloads declared after <fc/io/raw.hpp>, so fields are visited by own visitor.
+     */
+
+    template<typename Stream, typename T>
+    void pack(Stream& s, const T& v);
+
+    template<typename Stream, typename T>
+    void pack(Stream& s, const chainbase::object_id<T>& v);
+
+    template<typename Stream>
+    void pack(Stream& s, const shared_string& v);
+
+    template<typename Stream>
+    void pack(Stream& s, const shared_authority& v);
+
+    template<typename Stream, typename T>
+    void pack(Stream& s, const bip::vector<T, allocator<T>>& v);
+
+    template<typename Stream, typename T>
+    void pack(Stream& s, const bip::deque<T, allocator<T>>& v);
+
+    template<typename Stream, typename T, typename C>
+    void pack(Stream& s, const bip::flat_set<T, C, allocator<T>>& v);
+
+    template<typename Stream, typename T>
+    void unpack(Stream& s, T& v);
+
+    template<typename Stream, typename T>
+    void unpack(Stream& s, chainbase::object_id<T>& v);
+
+    template<typename Stream>
+    void unpack(Stream& s, shared_string& v);
+
+    template<typename Stream>
+    void unpack(Stream& s, shared_authority& v);
+
+    template<typename Stream, typename T>
+    void unpack(Stream& s, bip::vector<T, allocator<T>>& v);
+
+    template<typename Stream, typename T>
+    void unpack(Stream& s, bip::deque<T, allocator<T>>& v);
+
+    template<typename Stream, typename T, typename C>
+    void unpack(Stream& s, bip::flat_set<T, C, allocator<T>>& v);
+
+    template<typename Stream, typename Class>
+    struct pack_visitor final {
+        Stream& s;
+        const Class& obj;
+
+        template<typename Member, class C, Member (C::*member)>
+        void operator()(const char*) const {
+            object_pack::pack(s, obj.*member);
+        }
+    };
+
+    template<typename Stream, typename Class>
+    struct unpack_visitor final {
+        Stream& s;
+        Class& obj;
+
+        template<typename Member, class C, Member (C::*member)>
+        void operator()(const char*) const {
+            object_pack::unpack(s, obj.*member);
+        }
+    };
+
+    template<typename Stream, typename T>
+    void pack(Stream& s, const T& v) {
+        fc::raw::pack(s, v);
+    }
+
+    template<typename Stream, typename T>
+    void pack(Stream& s, const chainbase::object_id<T>& v) {
+        fc::raw::pack(s, v._id);
+    }
+
+    template<typename Stream>
+    void pack(Stream& s, const shared_string& v) {
+        fc::raw::pack(s, to_string(v));
+    }
+
+    template<typename Stream>
+    void pack(Stream& s, const shared_authority& v) {
+        fc::raw::pack(s, protocol::authority(v));
+    }
+
+    template<typename Stream, typename Container>
+    void pack_container(Stream& s, const Container& v) {
+        fc::raw::pack(s, fc::unsigned_int((uint32_t)v.size()));
+        for (const auto& item : v) {
+            object_pack::pack(s, item);
+        }
+    }
+
+    template<typename Stream, typename T>
+    void pack(Stream& s, const bip::vector<T, allocator<T>>& v) {
+        pack_container(s, v);
+    }
+
+    template<typename Stream, typename T>
+    void pack(Stream& s, const bip::deque<T, allocator<T>>& v) {
+        pack_container(s, v);
+    }
+
+    template<typename Stream, typename T, typename C>
+    void pack(Stream& s, const bip::flat_set<T, C, allocator<T>>& v) {
+        pack_container(s, v);
+    }
+
+    template<typename Stream, typename T>
+    void unpack(Stream& s, T& v) {
+        fc::raw::unpack(s, v);
+    }
+
+    template<typename Stream, typename T>
+    void unpack(Stream& s, chainbase::object_id<T>& v) {
+        fc::raw::unpack(s, v._id);
+    }
+
+    template<typename Stream>
+    void unpack(Stream& s, shared_string& v) {
+        std::string str;
+        fc::raw::unpack(s, str);
+        from_string(v, str);
+    }
+
+    template<typename Stream>
+    void unpack(Stream& s, shared_authority& v) {
+        protocol::authority a;
+        fc::raw::unpack(s, a);
+        v = a;
+    }
+
+    template<typename Stream, typename Container, typename Add>
+    void unpack_container(Stream& s, Container& v, Add&& add) {
+        fc::unsigned_int size;
+        fc::raw::unpack(s, size);
+        v.clear();
+        for (uint32_t i = 0; i < size.value; ++i) {
+            typename Container::value_type item;
+            object_pack::unpack(s, item);
+            add(std::move(item));
+        }
+    }
+
+    template<typename Stream, typename T>
+    void unpack(Stream& s, bip::vector<T, allocator<T>>& v) {
+        unpack_container(s, v, [&](T&& item) { v.push_back(std::move(item)); });
+    }
+
+    template<typename Stream, typename T>
+    void unpack(Stream& s, bip::deque<T, allocator<T>>& v) {
+        unpack_container(s, v, [&](T&& item) { v.push_back(std::move(item)); });
+    }
+
+    template<typename Stream, typename T, typename C>
+    void unpack(Stream& s, bip::flat_set<T, C, allocator<T>>& v) {
+        unpack_container(s, v, [&](T&& item) { v.insert(std::move(item)); });
+    }
+
+    template<typename Stream, typename T>
+    void pack_object(Stream& s, const T& obj) {
+        fc::reflector<T>::visit(pack_visitor<Stream, T>{s, obj});
+    }
+
+    template<typename Stream, typename T>
+    void unpack_object(Stream& s, T& obj) {
+        fc::reflector<T>::visit(unpack_visitor<Stream, T>{s, obj});
+    }
+
+    template<typename T>
+    std::vector<char> pack_object(const T& obj) {
+        fc::datastream<size_t> ps;
+        pack_object(ps, obj);
+
+        std::vector<char> result(ps.tellp());
+        if (!result.empty()) {
+            fc::datastream<char*> ds(result.data(), result.size());
+            pack_object(ds, obj);
+        }
+        return result;
+    }
+
+    template<typename T>
+    void unpack_object(const std::vector<char>& data, T& obj) {
+        fc::datastream<const char*> ds(data.data(), data.size());
+        unpack_object(ds, obj);
+    }
+
+} } } // golos::chain::object_pack
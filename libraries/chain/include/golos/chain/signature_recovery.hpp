@@ -0,0 +1,59 @@
+#pragma once
+
+#include <golos/protocol/block.hpp>
+#include <golos/protocol/signature_cache.hpp>
+
+#include <boost/asio/io_service.hpp>
+
+#include <thread>
+
+namespace golos { namespace chain {
+
+        using golos::protocol::digest_type;
+        using golos::protocol::signature_type;
+        using golos::protocol::public_key_type;
+        using golos::protocol::signed_block;
+        using golos::protocol::signed_block_header;
+        using golos::protocol::signed_transaction;
+        using golos::protocol::chain_id_type;
+
+        /**
+         * Recovers public keys from signatures of blocks and transactions before they are pushed to database.
+         *
+         * Recovery is performed by worker threads without any lock of database. Recovered keys are stored
+         *   to the signature_cache and are found there on validation of block header and transaction authorities,
+         *   so only walk on authorities is performed under the write lock.
+         * With zero worker threads keys are recovered in the calling thread.
+         */
+        class signature_recovery final {
+        public:
+            signature_recovery();
+
+            ~signature_recovery();
+
+            void start(uint32_t threads);
+
+            void stop();
+
+            /**
+             * Recovers keys of the block signature and of all signatures of its transactions.
+             * Waits until workers recover all keys.
+             */
+            void recover(const signed_block& block, const chain_id_type& chain_id);
+
+            void recover(const signed_transaction& trx, const chain_id_type& chain_id);
+
+            /**
+             * Returns key which was used to sign block, uses pre-recovered key if it exists.
+             */
+            public_key_type get_signee(const signed_block_header& header) const;
+
+        private:
+            void recover_range(const signed_block& block, size_t begin, size_t end, const chain_id_type& chain_id) const;
+
+            boost::asio::io_service _ios;
+            std::unique_ptr<boost::asio::io_service::work> _work;
+            std::vector<std::thread> _workers;
+        };
+
+} } // golos::chain
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <golos/chain/database.hpp>
+#include <golos/chain/database_exceptions.hpp>
+#include <golos/chain/object_pack.hpp>
+
+#include <fc/crypto/sha256.hpp>
+
+#include <boost/mpl/size.hpp>
+
+#include <istream>
+#include <ostream>
+#include <type_traits>
+
+namespace golos { namespace chain {
+
+    /**
+     * State snapshot is a file with objects of all snapshot indexes at some irreversible block:
+     *   - snapshot_header;
+     *   - snapshot_section and its objects, for each index.
+     * Headers are prefixed by their size. Object is stored as its id, size of its data and its reflected fields
+     * packed by object_pack. Sections are independent, so they are written and loaded in parallel.
+     */
+    struct snapshot_header {
+        static constexpr uint64_t magic_value = 0x50414e534f4c4f47; // "GOLOSNAP"
+        static constexpr uint32_t current_version = 1;
+
+        uint64_t magic = magic_value;
+        uint32_t version = current_version;
+        chain_id_type chain_id;
+        uint32_t block_num = 0;
+        block_id_type block_id;
+        uint32_t section_count = 0;
+    };
+
+    struct snapshot_section {
+        uint16_t type_id = 0;
+        std::string name;
+        int64_t next_id = 0;   ///< id of the next created object
+        uint64_t count = 0;    ///< number of objects
+        uint64_t size = 0;     ///< size of stored objects in bytes
+        fc::sha256 checksum;   ///< of stored objects
+    };
+
+    /**
+     * chainbase doesn't expose the next id of index, it is taken from an empty undo session,
+     * so a write access to the database is required.
+     */
+    template <typename MultiIndexType>
+    int64_t get_next_id(chainbase::generic_index<MultiIndexType>& index) {
+        auto session = index.start_undo_session(true);
+        return index.stack().back().old_next_id._id;
+    }
+
+    /**
+     * chainbase has no setter of the next id, but undo of session restores the next id saved by session,
+     * so it is replaced in an empty session which is undone then.
+     */
+    template <typename MultiIndexType>
+    void set_next_id(chainbase::generic_index<MultiIndexType>& index, int64_t next_id) {
+        using undo_state_type = typename std::decay<decltype(index.stack().back())>::type;
+        using id_type = typename MultiIndexType::value_type::id_type;
+
+        auto session = index.start_undo_session(true);
+        const_cast<undo_state_type&>(index.stack().back()).old_next_id = id_type(next_id);
+        session.undo();
+    }
+
+    class snapshot_index {
+    public:
+        virtual ~snapshot_index() = default;
+
+        virtual uint16_t type_id() const = 0;
+
+        virtual std::string name() const = 0;
+
+        /**
+         * Write access to the database is required, see get_next_id()
+         */
+        virtual int64_t next_id(database& db) const = 0;
+
+        /**
+         * Writes objects in the order of their ids, fills count, size and checksum of section.
+         */
+        virtual void write(const database& db, std::ostream& out, snapshot_section& section) const = 0;
+
+        /**
+         * Approximate size of shared memory required for objects of section.
+         */
+        virtual uint64_t memory_size(const snapshot_section& section) const = 0;
+
+        /**
+         * Creates objects of section in the empty index, throws snapshot_exception if their checksum doesn't match.
+         */
+        virtual void load(database& db, std::istream& in, const snapshot_section& section) const = 0;
+    };
+
+    template <typename MultiIndexType>
+    class snapshot_index_impl final : public snapshot_index {
+    public:
+        using object_type = typename MultiIndexType::value_type;
+        using id_type = typename object_type::id_type;
+
+        uint16_t type_id() const override {
+            return object_type::type_id;
+        }
+
+        std::string name() const override {
+            return fc::get_typename<object_type>::name();
+        }
+
+        int64_t next_id(database& db) const override {
+            return get_next_id(db.get_mutable_index<MultiIndexType>());
+        }
+
+        void write(const database& db, std::ostream& out, snapshot_section& section) const override {
+            fc::sha256::encoder enc;
+            auto put = [&](const char* data, uint32_t size) {
+                out.write(data, size);
+                enc.write(data, size);
+                section.size += size;
+            };
+
+            for (const auto& o : db.get_index<MultiIndexType>().indices()) {
+                auto data = object_pack::pack_object(o);
+                int64_t id = o.id._id;
+                uint32_t size = data.size();
+                put((const char*)&id, sizeof(id));
+                put((const char*)&size, sizeof(size));
+                put(data.data(), size);
+                ++section.count;
+            }
+            section.checksum = enc.result();
+        }
+
+        uint64_t memory_size(const snapshot_section& section) const override {
+            // each ordered index adds a node with 3 pointers
+            constexpr auto index_count = boost::mpl::size<typename MultiIndexType::index_type_list>::value;
+            return section.count * (sizeof(object_type) + index_count * 3 * sizeof(void*)) + section.size;
+        }
+
+        void load(database& db, std::istream& in, const snapshot_section& section) const override {
+            auto& index = db.get_mutable_index<MultiIndexType>();
+            GOLOS_ASSERT(index.indices().empty(), snapshot_exception,
+                "Index ${name} isn't empty, state should be wiped before loading snapshot", ("name", section.name));
+
+            fc::sha256::encoder enc;
+            auto get = [&](char* data, uint32_t size) {
+                in.read(data, size);
+                GOLOS_ASSERT(in.good(), snapshot_exception, "Section ${name} is truncated", ("name", section.name));
+                enc.write(data, size);
+            };
+
+            std::vector<char> data;
+            int64_t id = 0;
+            for (uint64_t i = 0; i < section.count; ++i) {
+                uint32_t size = 0;
+                get((char*)&id, sizeof(id));
+                get((char*)&size, sizeof(size));
+                data.resize(size);
+                get(data.data(), size);
+                create(index, data, id);
+            }
+
+            GOLOS_ASSERT(enc.result() == section.checksum, snapshot_exception,
+                "Checksum of section ${name} doesn't match", ("name", section.name));
+
+            // objects are created with their own ids, so the next id of index is equal to their count
+            if (section.next_id > int64_t(section.count)) {
+                set_next_id(index, section.next_id);
+            }
+        }
+
+    private:
+        using generic_index = chainbase::generic_index<MultiIndexType>;
+
+        static const object_type& create(generic_index& index, const std::vector<char>& data, int64_t id) {
+            return index.emplace([&](object_type& o) {
+                object_pack::unpack_object(data, o);
+                o.id = id_type(id);
+            });
+        }
+    };
+
+} } // golos::chain
+
+FC_REFLECT((golos::chain::snapshot_header), (magic)(version)(chain_id)(block_num)(block_id)(section_count))
+FC_REFLECT((golos::chain::snapshot_section), (type_id)(name)(next_id)(count)(size)(checksum))
@@ -660,7 +660,7 @@ namespace golos {
 
 
 FC_REFLECT((golos::chain::limit_order_object),
-        (id)(created)(expiration)(seller)(orderid)(for_sale)(sell_price))
+        (id)(created)(expiration)(seller)(orderid)(for_sale)(symbol)(sell_price))
 CHAINBASE_SET_INDEX_TYPE(golos::chain::limit_order_object, golos::chain::limit_order_index)
 
 FC_REFLECT((golos::chain::feed_history_object),
@@ -694,12 +694,19 @@ FC_REFLECT((golos::chain::decline_voting_rights_request_object),
         (id)(account)(effective_date))
 CHAINBASE_SET_INDEX_TYPE(golos::chain::decline_voting_rights_request_object, golos::chain::decline_voting_rights_request_index)
 
+FC_REFLECT((golos::chain::donate_object),
+        (id)(app)(version)(target))
 CHAINBASE_SET_INDEX_TYPE(golos::chain::donate_object, golos::chain::donate_index)
 
+FC_REFLECT((golos::chain::asset_object),
+        (id)(creator)(max_supply)(supply)(allow_fee)(allow_override_transfer)(created)(modified)(marketed)
+        (symbols_whitelist)(fee_percent)(json_metadata))
 CHAINBASE_SET_INDEX_TYPE(golos::chain::asset_object, golos::chain::asset_index)
 
 FC_REFLECT((golos::chain::market_pair_object),
         (base_depth)(quote_depth))
 CHAINBASE_SET_INDEX_TYPE(golos::chain::market_pair_object, golos::chain::market_pair_index)
 
+FC_REFLECT((golos::chain::fix_me_object),
+        (id)(account))
 CHAINBASE_SET_INDEX_TYPE(golos::chain::fix_me_object, golos::chain::fix_me_index)
@@ -15,6 +15,10 @@ namespace golos {
          * The purpose of this object is to enable the detection of duplicate transactions. When a transaction is included
          * in a block a transaction_object is added. At the end of block processing all transaction_objects that have
          * expired can be removed from the index.
+         *
+         * Detection of duplicates requires only trx_id and expiration. The packed transaction is stored only
+         * for database::get_recent_transaction() if it is enabled by database::set_store_recent_transactions(),
+         * otherwise packed_trx is empty.
          */
         class transaction_object
                 : public object<transaction_object_type, transaction_object> {
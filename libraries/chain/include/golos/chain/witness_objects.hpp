@@ -278,6 +278,8 @@ FC_REFLECT(
     (top19_weight)(timeshare_weight)(miner_weight)(witness_pay_normalization_factor)
     (median_props)(majority_version))
 
+FC_REFLECT((golos::chain::witness_vote_object), (id)(witness)(account)(rshares))
+
 CHAINBASE_SET_INDEX_TYPE(golos::chain::witness_vote_object, golos::chain::witness_vote_index)
 
 CHAINBASE_SET_INDEX_TYPE(golos::chain::witness_schedule_object, golos::chain::witness_schedule_index)
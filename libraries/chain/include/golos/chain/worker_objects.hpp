@@ -109,6 +109,11 @@ namespace golos { namespace chain {
 
 } } // golos::chain
 
+FC_REFLECT((golos::chain::worker_request_object),
+    (id)(post)(worker)(state)(required_amount_min)(required_amount_max)(vest_reward)(duration)(created)
+    (vote_end_time)(stake_rshares)(stake_total)(remaining_payment)
+)
+
 CHAINBASE_SET_INDEX_TYPE(
     golos::chain::worker_request_object,
     golos::chain::worker_request_index);
@@ -118,5 +123,5 @@ CHAINBASE_SET_INDEX_TYPE(
     golos::chain::worker_request_vote_index);
 
 FC_REFLECT((golos::chain::worker_request_vote_object),
-    (voter)(vote_percent)(rshares)(stake)
+    (voter)(vote_percent)(rshares)(stake)(post)
 )
@@ -0,0 +1,116 @@
+#include <golos/chain/signature_recovery.hpp>
+
+#include <future>
+
+namespace golos { namespace chain {
+
+    signature_recovery::signature_recovery() {
+    }
+
+    signature_recovery::~signature_recovery() {
+        stop();
+    }
+
+    void signature_recovery::start(uint32_t threads) {
+        stop();
+
+        if (!threads) {
+            return;
+        }
+
+        _ios.reset();
+        _work = std::make_unique<boost::asio::io_service::work>(_ios);
+        for (uint32_t i = 0; i < threads; ++i) {
+            _workers.emplace_back([this]() {
+                _ios.run();
+            });
+        }
+    }
+
+    void signature_recovery::stop() {
+        _work.reset();
+        _ios.stop();
+        for (auto& t : _workers) {
+            if (t.joinable()) {
+                t.join();
+            }
+        }
+        _workers.clear();
+    }
+
+    void signature_recovery::recover_range(
+        const signed_block& block, size_t begin, size_t end, const chain_id_type& chain_id
+    ) const {
+        auto& cache = protocol::signature_cache::instance();
+        for (auto i = begin; i < end; ++i) {
+            const auto& trx = block.transactions[i];
+            auto digest = trx.sig_digest(chain_id);
+            for (const auto& sig : trx.signatures) {
+                try {
+                    cache.recover(digest, sig);
+                } catch (...) {
+                    // bad signature will be reported on validation of transaction
+                }
+            }
+        }
+    }
+
+    void signature_recovery::recover(const signed_block& block, const chain_id_type& chain_id) {
+        const auto trx_count = block.transactions.size();
+        const auto threads = _workers.size();
+
+        if (!threads || trx_count < 2) {
+            recover_range(block, 0, trx_count, chain_id);
+        } else {
+            const auto chunks = std::min(threads, trx_count);
+            const auto chunk_size = (trx_count + chunks - 1) / chunks;
+
+            std::vector<std::future<void>> waits;
+            waits.reserve(chunks);
+
+            for (size_t i = 0; i < chunks; ++i) {
+                auto task = std::make_shared<std::packaged_task<void()>>([&, i]() {
+                    auto begin = i * chunk_size;
+                    auto end = std::min(begin + chunk_size, trx_count);
+                    recover_range(block, begin, end, chain_id);
+                });
+                waits.push_back(task->get_future());
+                _ios.post([task]() {
+                    (*task)();
+                });
+            }
+
+            // tasks refer to local data, so all of them should be finished before a rethrow
+            for (auto& w : waits) {
+                w.wait();
+            }
+            for (auto& w : waits) {
+                w.get();
+            }
+        }
+
+        // block signature is recovered after transactions to not delay workers
+        try {
+            get_signee(block);
+        } catch (...) {
+            // bad signature will be reported on validation of block header
+        }
+    }
+
+    void signature_recovery::recover(const signed_transaction& trx, const chain_id_type& chain_id) {
+        auto& cache = protocol::signature_cache::instance();
+        auto digest = trx.sig_digest(chain_id);
+        for (const auto& sig : trx.signatures) {
+            try {
+                cache.recover(digest, sig);
+            } catch (...) {
+                // bad signature will be reported on validation of transaction
+            }
+        }
+    }
+
+    public_key_type signature_recovery::get_signee(const signed_block_header& header) const {
+        return protocol::signature_cache::instance().recover(header.digest(), header.witness_signature);
+    }
+
+} } // golos::chain
@@ -0,0 +1,232 @@
+#include <golos/chain/snapshot.hpp>
+
+#include <boost/filesystem/fstream.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+namespace golos { namespace chain {
+
+    namespace bfs = boost::filesystem;
+
+    namespace {
+
+        const uint32_t max_header_size = 1024 * 1024;
+
+        template <typename T>
+        void write_header(std::ostream& out, const T& header) {
+            auto data = fc::raw::pack(header);
+            uint32_t size = data.size();
+            out.write((const char*)&size, sizeof(size));
+            out.write(data.data(), data.size());
+        }
+
+        template <typename T>
+        T read_header(std::istream& in) {
+            uint32_t size = 0;
+            in.read((char*)&size, sizeof(size));
+            GOLOS_ASSERT(in.good() && size <= max_header_size, snapshot_exception, "File isn't a state snapshot");
+
+            std::vector<char> data(size);
+            in.read(data.data(), size);
+            GOLOS_ASSERT(in.good(), snapshot_exception, "Snapshot is truncated");
+            return fc::raw::unpack<T>(data);
+        }
+
+        /**
+         * Calls task for each of count items in the calling thread and in threads - 1 additional threads,
+         * the first exception is rethrown after all threads are stopped.
+         */
+        template <typename Task>
+        void run_parallel(size_t count, uint32_t threads, Task&& task) {
+            std::atomic<size_t> next{0};
+            std::exception_ptr error;
+            std::mutex error_mutex;
+
+            auto worker = [&]() {
+                for (auto i = next++; i < count; i = next++) {
+                    try {
+                        task(i);
+                    } catch (...) {
+                        std::lock_guard<std::mutex> lock(error_mutex);
+                        if (!error) {
+                            error = std::current_exception();
+                        }
+                        next = count;
+                    }
+                }
+            };
+
+            std::vector<std::thread> pool;
+            for (size_t t = 1; t < std::min<size_t>(threads, count); ++t) {
+                pool.emplace_back(worker);
+            }
+            worker();
+            for (auto& t : pool) {
+                t.join();
+            }
+
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+
+        double seconds_since(const fc::time_point& start) {
+            return double((fc::time_point::now() - start).count()) / 1000000.0;
+        }
+
+    } // anonymous namespace
+
+    void database::set_snapshot_threads(uint32_t threads) {
+        _snapshot_threads = threads;
+    }
+
+    void database::set_snapshot_to_load(const fc::path& path) {
+        _snapshot_to_load = path;
+    }
+
+    void database::add_snapshot_index(std::unique_ptr<snapshot_index> index) {
+        auto type_id = index->type_id();
+        _snapshot_indexes[type_id] = std::move(index);
+    }
+
+    void database::write_snapshot(const fc::path& path) { try {
+        auto start = fc::time_point::now();
+        wlog("Writing state snapshot of block ${n} to ${p}...", ("n", head_block_num())("p", path.string()));
+
+        for (auto itr = index_list_begin(), end = index_list_end(); itr != end; ++itr) {
+            if (!_snapshot_indexes.count((*itr)->type_id()) && (*itr)->size()) {
+                wlog("Index ${name} with ${n} objects isn't written to snapshot, it isn't registered",
+                    ("name", (*itr)->name())("n", (*itr)->size()));
+            }
+        }
+
+        snapshot_header header;
+        header.chain_id = get_chain_id();
+        header.block_num = head_block_num();
+        header.block_id = head_block_id();
+        header.section_count = _snapshot_indexes.size();
+
+        std::vector<const snapshot_index*> indexes;
+        std::vector<snapshot_section> sections;
+        for (const auto& item : _snapshot_indexes) {
+            snapshot_section section;
+            section.type_id = item.first;
+            section.name = item.second->name();
+            section.next_id = item.second->next_id(*this);
+            indexes.push_back(item.second.get());
+            sections.push_back(std::move(section));
+        }
+
+        auto part_path = [&](size_t i) {
+            return bfs::path(path.string() + ".part" + std::to_string(i));
+        };
+
+        run_parallel(indexes.size(), _snapshot_threads, [&](size_t i) {
+            bfs::ofstream out(part_path(i), std::ios::out | std::ios::binary | std::ios::trunc);
+            out.exceptions(std::ios::failbit | std::ios::badbit);
+            indexes[i]->write(*this, out, sections[i]);
+        });
+
+        bfs::ofstream out(path, std::ios::out | std::ios::binary | std::ios::trunc);
+        out.exceptions(std::ios::failbit | std::ios::badbit);
+        write_header(out, header);
+        for (size_t i = 0; i < sections.size(); ++i) {
+            write_header(out, sections[i]);
+            if (sections[i].count) {
+                bfs::ifstream in(part_path(i), std::ios::in | std::ios::binary);
+                out << in.rdbuf();
+            }
+            bfs::remove(part_path(i));
+            ilog("Index ${name}: ${n} objects, ${s} bytes",
+                ("name", sections[i].name)("n", sections[i].count)("s", sections[i].size));
+        }
+        out.close();
+
+        wlog("Done writing state snapshot, elapsed time ${t} sec", ("t", seconds_since(start)));
+    } FC_CAPTURE_AND_RETHROW((path)) }
+
+    void database::load_snapshot(const fc::path& path) { try {
+        auto start = fc::time_point::now();
+        wlog("Loading state snapshot from ${p}...", ("p", path.string()));
+
+        bfs::ifstream in(path, std::ios::in | std::ios::binary);
+        GOLOS_ASSERT(in.is_open(), snapshot_exception, "Can't open snapshot ${p}", ("p", path.string()));
+
+        auto header = read_header<snapshot_header>(in);
+        GOLOS_ASSERT(header.magic == snapshot_header::magic_value, snapshot_exception, "File isn't a state snapshot");
+        GOLOS_ASSERT(header.version == snapshot_header::current_version, snapshot_exception,
+            "Unsupported version ${v} of snapshot, expected ${e}",
+            ("v", header.version)("e", snapshot_header::current_version));
+        GOLOS_ASSERT(header.chain_id == get_chain_id(), snapshot_exception,
+            "Snapshot is made for other chain ${id}", ("id", header.chain_id));
+
+        // plugins which don't store own objects in snapshots (follow, tags, market_history...) would start from the empty state
+        for (auto itr = index_list_begin(), end = index_list_end(); itr != end; ++itr) {
+            GOLOS_ASSERT(_snapshot_indexes.count((*itr)->type_id()), snapshot_exception,
+                "Index ${name} isn't stored in snapshots, disable plugin which adds it to load snapshot",
+                ("name", (*itr)->name()));
+        }
+
+        std::vector<const snapshot_index*> indexes;
+        std::vector<snapshot_section> sections;
+        std::vector<std::streamoff> offsets;
+        uint64_t memory = 0;
+        for (uint32_t i = 0; i < header.section_count; ++i) {
+            auto section = read_header<snapshot_section>(in);
+            auto itr = _snapshot_indexes.find(section.type_id);
+            GOLOS_ASSERT(itr != _snapshot_indexes.end() || !section.count, snapshot_exception,
+                "Index ${name} of snapshot isn't registered, enable plugin which adds it", ("name", section.name));
+
+            auto offset = in.tellg();
+            in.seekg(section.size, std::ios::cur);
+            if (itr != _snapshot_indexes.end()) {
+                memory += itr->second->memory_size(section);
+                offsets.push_back(offset);
+                indexes.push_back(itr->second.get());
+                sections.push_back(std::move(section));
+            }
+        }
+        GOLOS_ASSERT(in.good(), snapshot_exception, "Snapshot is truncated");
+
+        for (const auto& item : _snapshot_indexes) {
+            auto itr = std::find_if(sections.begin(), sections.end(), [&](const auto& s) {
+                return s.type_id == item.first;
+            });
+            if (itr == sections.end()) {
+                wlog("Index ${name} isn't in snapshot, it remains empty", ("name", item.second->name()));
+            }
+        }
+
+        // shared memory can't be resized while objects are being created in other threads
+        uint64_t free_mem = free_memory();
+        if (free_mem < memory + _min_free_shared_memory_size) {
+            if (_inc_shared_memory_size) {
+                auto inc = memory + _min_free_shared_memory_size - free_mem;
+                inc = (inc / _inc_shared_memory_size + 1) * _inc_shared_memory_size;
+                wlog("Increasing shared memory by ${m}M to load snapshot", ("m", inc / (1024 * 1024)));
+                resize(max_memory() + inc);
+            } else {
+                wlog("Snapshot can require about ${m}M of shared memory, but only ${f}M are free",
+                    ("m", memory / (1024 * 1024))("f", free_mem / (1024 * 1024)));
+            }
+        }
+
+        run_parallel(indexes.size(), _snapshot_threads, [&](size_t i) {
+            bfs::ifstream section_in(path, std::ios::in | std::ios::binary);
+            section_in.seekg(offsets[i]);
+            indexes[i]->load(*this, section_in, sections[i]);
+        });
+
+        GOLOS_ASSERT(head_block_num() == header.block_num && head_block_id() == header.block_id, snapshot_exception,
+            "Head block ${id} of loaded state doesn't match snapshot block ${sid}",
+            ("id", head_block_id())("sid", header.block_id));
+        set_revision(head_block_num());
+
+        wlog("Done loading state snapshot of block ${n}, elapsed time ${t} sec",
+            ("n", header.block_num)("t", seconds_since(start)));
+    } FC_CAPTURE_AND_RETHROW((path)) }
+
+} } // golos::chain
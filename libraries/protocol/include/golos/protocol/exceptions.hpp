@@ -393,6 +393,7 @@ namespace golos {
             wrong_position_marker_was_read,
             append_index_file_at_wrong_position,
             reading_data_beyond_end_of_file,
+            wrong_compressed_block_log,
         };
     };
 
@@ -662,4 +663,5 @@ FC_REFLECT_ENUM(golos::database_corrupted::error_types,
         (wrong_position_marker_was_read)
         (append_index_file_at_wrong_position)
         (reading_data_beyond_end_of_file)
+        (wrong_compressed_block_log)
 );
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <golos/protocol/types.hpp>
+
+#include <array>
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace golos { namespace protocol {
+
+        /**
+         * Bounded LRU cache of public keys recovered from signatures.
+         *
+         * The same transaction is verified on receiving from p2p or API, on validation of a block and
+         *   on applying of the block, so its keys are recovered only once.
+         * Cache is split to shards with own locks to be used concurrently from many threads.
+         */
+        class signature_cache final {
+        public:
+            struct stats {
+                uint64_t hits = 0;
+                uint64_t misses = 0;
+                uint64_t size = 0;
+            };
+
+            static signature_cache& instance();
+
+            /**
+             * Sets maximum number of stored keys, 0 disables cache.
+             */
+            void set_capacity(size_t capacity);
+
+            size_t capacity() const;
+
+            /**
+             * Returns key which was used to make signature of digest.
+             * @throws if key cannot be recovered from signature
+             */
+            public_key_type recover(const digest_type& digest, const signature_type& signature);
+
+            stats get_stats() const;
+
+            void clear();
+
+        private:
+            signature_cache();
+
+            using key_type = std::pair<digest_type, signature_type>;
+
+            struct key_hash {
+                size_t operator()(const key_type& key) const;
+            };
+
+            struct shard {
+                using lru_list = std::list<std::pair<key_type, public_key_type>>;
+
+                mutable std::mutex mutex;
+                lru_list items;
+                std::unordered_map<key_type, lru_list::iterator, key_hash> index;
+            };
+
+            static constexpr size_t shard_count = 16;
+
+            shard& get_shard(const key_type& key);
+
+            std::array<shard, shard_count> _shards;
+            std::atomic<size_t> _shard_capacity;
+
+            std::atomic<uint64_t> _hits{0};
+            std::atomic<uint64_t> _misses{0};
+        };
+
+} } // golos::protocol
@@ -0,0 +1,99 @@
+#include <golos/protocol/signature_cache.hpp>
+
+#include <cstring>
+
+namespace golos { namespace protocol {
+
+    static constexpr size_t default_signature_cache_capacity = 50000;
+
+    signature_cache::signature_cache()
+            : _shard_capacity(default_signature_cache_capacity / shard_count) {
+    }
+
+    signature_cache& signature_cache::instance() {
+        static signature_cache cache;
+        return cache;
+    }
+
+    size_t signature_cache::key_hash::operator()(const key_type& key) const {
+        // digest is a sha256 and signature contains random r-value, so their bits are already well mixed
+        uint64_t sig_bits;
+        std::memcpy(&sig_bits, key.second.begin() + 1, sizeof(sig_bits));
+        return size_t(key.first._hash[0] ^ sig_bits);
+    }
+
+    signature_cache::shard& signature_cache::get_shard(const key_type& key) {
+        // signatures of the same digest (multisig transaction) are spread to different shards
+        uint64_t sig_bits;
+        std::memcpy(&sig_bits, key.second.begin() + 1 + sizeof(sig_bits), sizeof(sig_bits));
+        return _shards[(key.first._hash[1] ^ sig_bits) % shard_count];
+    }
+
+    void signature_cache::set_capacity(size_t capacity) {
+        _shard_capacity = (capacity + shard_count - 1) / shard_count;
+        if (!capacity) {
+            clear();
+        }
+    }
+
+    size_t signature_cache::capacity() const {
+        return _shard_capacity * shard_count;
+    }
+
+    public_key_type signature_cache::recover(const digest_type& digest, const signature_type& signature) {
+        const size_t shard_capacity = _shard_capacity;
+        if (!shard_capacity) {
+            return fc::ecc::public_key(signature, digest);
+        }
+
+        key_type key(digest, signature);
+        auto& s = get_shard(key);
+
+        {
+            std::lock_guard<std::mutex> lock(s.mutex);
+            auto itr = s.index.find(key);
+            if (itr != s.index.end()) {
+                s.items.splice(s.items.begin(), s.items, itr->second);
+                ++_hits;
+                return itr->second->second;
+            }
+        }
+
+        ++_misses;
+
+        // recovery is heavy, so it is done without lock, concurrent recovery of the same key is harmless
+        public_key_type result = fc::ecc::public_key(signature, digest);
+
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if (s.index.find(key) == s.index.end()) {
+            s.items.emplace_front(key, result);
+            s.index.emplace(std::move(key), s.items.begin());
+
+            while (s.items.size() > shard_capacity) {
+                s.index.erase(s.items.back().first);
+                s.items.pop_back();
+            }
+        }
+        return result;
+    }
+
+    signature_cache::stats signature_cache::get_stats() const {
+        stats result;
+        result.hits = _hits;
+        result.misses = _misses;
+        for (const auto& s : _shards) {
+            std::lock_guard<std::mutex> lock(s.mutex);
+            result.size += s.items.size();
+        }
+        return result;
+    }
+
+    void signature_cache::clear() {
+        for (auto& s : _shards) {
+            std::lock_guard<std::mutex> lock(s.mutex);
+            s.index.clear();
+            s.items.clear();
+        }
+    }
+
+} } // golos::protocol
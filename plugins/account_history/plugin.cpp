@@ -42,17 +42,21 @@ if (options.count(name)) { \
     };
 
     using golos::plugins::operation_history::donate_meta;
+    using golos::plugins::operation_history::history_store;
+    using golos::plugins::operation_history::stored_account_operation;
 
     struct operation_visitor final {
         operation_visitor(
             golos::chain::database& db,
             const golos::chain::operation_notification& op_note,
             std::string op_account,
-            operation_direction dir)
+            operation_direction dir,
+            const history_store* store)
             : db(db),
               note(op_note),
               account(op_account),
-              dir(dir) {
+              dir(dir),
+              store(store) {
         }
 
         using result_type = void;
@@ -61,6 +65,7 @@ if (options.count(name)) { \
         const golos::chain::operation_notification& note;
         std::string account;
         operation_direction dir;
+        const history_store* store;
 
         void write_operation(std::string json_metadata = "{}") const {
             const auto& idx = db.get_index<account_history_index>().indices().get<by_account>();
@@ -70,6 +75,9 @@ if (options.count(name)) { \
             if (itr != idx.end() && itr->account == account) {
                 sequence = itr->sequence + 1;
             }
+            if (store) {
+                sequence = std::max(sequence, store->account_history_size(account));
+            }
 
             db.create<account_history_object>([&](account_history_object& history) {
                 history.block = note.block;
@@ -135,22 +143,86 @@ if (options.count(name)) { \
                 if (!tracked_accounts.size() ||
                     (itr != tracked_accounts.end() && itr->first <= item.first && item.first <= itr->second)
                 ) {
-                    note.op.visit(operation_visitor(db, note, item.first, item.second));
+                    note.op.visit(operation_visitor(db, note, item.first, item.second, store));
                 }
             }
         }
 
+        void move_to_store(uint32_t block_num) {
+            const auto& idx = db.get_index<account_history_index>().indices().get<by_location>();
+
+            // popping of block restores entries which were already moved to store
+            for (auto itr = idx.begin(); itr != idx.end() && itr->block < block_num;) {
+                const auto& obj = *itr;
+                ++itr;
+                db.remove(obj);
+            }
+
+            std::vector<const account_history_object*> entries;
+            for (auto itr = idx.lower_bound(block_num); itr != idx.end() && itr->block == block_num; ++itr) {
+                entries.push_back(&*itr);
+            }
+            std::sort(entries.begin(), entries.end(), [](const account_history_object* l, const account_history_object* r) {
+                return std::tie(l->account, l->sequence) < std::tie(r->account, r->sequence);
+            });
+
+            for (auto obj : entries) {
+                stored_account_operation entry;
+                entry.account = obj->account;
+                entry.sequence = obj->sequence;
+                entry.op_tag = obj->op_tag;
+                entry.dir = obj->dir;
+                entry.op = obj->op._id;
+                entry.json_metadata = to_string(obj->json_metadata);
+                store->append_account_operation(entry);
+            }
+            for (auto obj : entries) {
+                db.remove(*obj);
+            }
+        }
+
         ///////////////////////////////////////////////////////
         // API
+        applied_operation get_operation(operation_history::operation_id_type id) const {
+            auto obj = db.find<operation_history::operation_object, by_id>(id);
+            if (obj) {
+                return applied_operation(*obj);
+            }
+            FC_ASSERT(store, "Operation is missing", ("id", id));
+            auto stored = store->get_operation(id._id);
+            FC_ASSERT(stored.valid(), "Operation is missing in history store", ("id", id));
+            return applied_operation(*stored);
+        }
+
+        uint32_t stored_history_size(const std::string& account) const {
+            return store && store->is_open() ? store->account_history_size(account) : 0;
+        }
+
+        // older entries of account history are in the history store
+        void fetch_from_store(
+            const std::string& account, uint32_t from, uint32_t limit,
+            const history_store::account_filter& filter, history_operations& result
+        ) {
+            if (result.size() >= limit || !stored_history_size(account)) {
+                return;
+            }
+            for (auto& entry : store->get_account_history(account, from, limit - result.size(), filter)) {
+                auto& op = result[entry.sequence];
+                op = get_operation(operation_history::operation_id_type(entry.op));
+                op.json_metadata = std::move(entry.json_metadata);
+            }
+        }
+
         history_operations fetch_unfiltered(string account, uint32_t from, uint32_t limit) {
             history_operations result;
+            const auto stored = stored_history_size(account);
             const auto& idx = db.get_index<account_history_index>().indices().get<by_account>();
             auto itr = idx.lower_bound(std::make_tuple(account, from));
-            auto end = idx.upper_bound(std::make_tuple(account, std::max(int64_t(0), int64_t(itr->sequence) - limit + 1)));
-            for (; itr != end; ++itr) {
-                result[itr->sequence] = db.get(itr->op);
+            for (; itr != idx.end() && itr->account == account && itr->sequence >= stored && result.size() < limit; ++itr) {
+                result[itr->sequence] = get_operation(itr->op);
                 result[itr->sequence].json_metadata = to_string(itr->json_metadata);
             }
+            fetch_from_store(account, from, limit, history_store::account_filter(), result);
             return result;
         }
 
@@ -242,10 +314,14 @@ if (options.count(name)) { \
             }
 
             history_operations result;
+            const auto stored = stored_history_size(account);
             while (!itrs.empty() && result.size() < limit) {
                 auto itr = itrs.top().itr;
                 itrs.pop();
-                result[itr->sequence] = db.get(itr->op);
+                if (itr->sequence < stored) {
+                    break;
+                }
+                result[itr->sequence] = get_operation(itr->op);
                 result[itr->sequence].json_metadata = to_string(itr->json_metadata);
                 auto o = itr->op_tag;
                 auto d = itr->dir;
@@ -253,6 +329,14 @@ if (options.count(name)) { \
                 if (next.itr != end && next.itr->op_tag == o && next.itr->dir == d)
                     itrs.push(next);
             }
+
+            fetch_from_store(account, from, limit, [&](uint8_t o, uint8_t d) {
+                if (!select_ops.count(o)) {
+                    return false;
+                }
+                return operation_direction::any == dir || d == dir ||
+                    (d == operation_direction::dual && (dir == sender || dir == receiver));
+            }, result);
             return result;
         }
 
@@ -261,6 +345,7 @@ if (options.count(name)) { \
         fc::flat_map<std::string, std::string> tracked_accounts;
         golos::chain::database& db;
         uint32_t history_blocks = UINT32_MAX;
+        history_store* store = nullptr;
     };
 
     static plugin::plugin_impl* myimpl;
@@ -819,6 +904,17 @@ if (options.count(name)) { \
 
         add_plugin_index<account_history_index>(pimpl->db);
 
+        auto& operation_history = appbase::app().get_plugin<operation_history::plugin>();
+        pimpl->store = operation_history.get_history_store();
+        if (pimpl->store) {
+            operation_history.on_block_moved_to_store([&](uint32_t block_num) {
+                pimpl->move_to_store(block_num);
+            });
+        } else {
+            // sequences of entries continue the history store, so it is stored only without it
+            add_snapshot_index<account_history_index>(pimpl->db);
+        }
+
         using pairstring = std::pair<std::string, std::string>;
         fc::flat_map<std::string, std::string> ranges;
         LOAD_VALUE_SET(options, "track-account-range", ranges, pairstring);
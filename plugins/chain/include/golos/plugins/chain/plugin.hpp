@@ -6,6 +6,7 @@
 #include <golos/protocol/block.hpp>
 #include <golos/chain/database.hpp>
 #include <golos/plugins/json_rpc/plugin.hpp>
+#include <golos/plugins/chain/state_snapshot.hpp>
 
 #include <boost/signals2.hpp>
 
@@ -43,6 +44,14 @@ namespace golos { namespace plugins { namespace chain {
 
                 void accept_transaction(const protocol::signed_transaction &trx);
 
+                /**
+                 * Read-only node doesn't accept blocks and transactions, its state is changed by other means
+                 * (by state replication). p2p and block production are disabled on it.
+                 */
+                void set_read_only(bool read_only);
+
+                bool is_read_only() const;
+
                 bool block_is_on_preferred_chain(const protocol::block_id_type &block_id);
 
                 void check_time_in_block(const protocol::signed_block &block);
@@ -82,6 +91,27 @@ namespace golos { namespace plugins { namespace chain {
                     return db().chain_status();
                 }
 
+                /**
+                 * Registers part of state snapshots, should be called on initialization of plugin.
+                 * Builder is called after applying of each block, it should copy only objects of chain state.
+                 */
+                template <typename T>
+                void add_snapshot_part(std::function<T(const golos::chain::database&)> builder) {
+                    snapshots().add_part<T>(std::move(builder));
+                }
+
+                /**
+                 * Returns state after applying of block with number block_num (0 - head block) without locking
+                 * of database. Returns nullptr if snapshots are disabled or snapshot of block is not kept.
+                 */
+                state_snapshot_ptr get_snapshot(uint32_t block_num = 0) const {
+                    return snapshots().get(block_num);
+                }
+
+                state_snapshots& snapshots();
+
+                const state_snapshots& snapshots() const;
+
                 // Exposed for backwards compatibility. In the future, plugins should manage their own internal database
                 golos::chain::database &db();
 
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <golos/protocol/types.hpp>
+#include <golos/chain/database.hpp>
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <typeindex>
+
+namespace golos { namespace plugins { namespace chain {
+
+    /**
+     * Immutable copy of a part of the chain state after applying of block.
+     *
+     * Snapshot contains parts which are registered by plugins with plugin::add_snapshot_part(). They are built
+     *   by the thread which applies block, while it holds the write lock, so all parts are consistent with each other.
+     *   API threads read them without any lock of database, so they don't delay the applying of blocks.
+     */
+    class state_snapshot final {
+    public:
+        uint32_t block_num = 0;
+        protocol::block_id_type block_id;
+        fc::time_point_sec block_time;
+
+        /**
+         * Returns the part of type T, or nullptr if it isn't registered.
+         */
+        template <typename T>
+        std::shared_ptr<const T> get() const {
+            auto itr = _parts.find(std::type_index(typeid(T)));
+            if (itr == _parts.end()) {
+                return nullptr;
+            }
+            return std::static_pointer_cast<const T>(itr->second);
+        }
+
+    private:
+        friend class state_snapshots;
+
+        std::map<std::type_index, std::shared_ptr<const void>> _parts;
+    };
+
+    using state_snapshot_ptr = std::shared_ptr<const state_snapshot>;
+
+    /**
+     * Snapshots of the last applied blocks.
+     *
+     * Snapshots of blocks which are popped on switching to other fork are replaced by snapshots of blocks
+     *   of the new fork, so block_id should be checked if it is important.
+     */
+    class state_snapshots final {
+    public:
+        using builder_type = std::function<std::shared_ptr<const void>(const golos::chain::database&)>;
+
+        /**
+         * Number of kept snapshots, 0 - snapshots are disabled
+         */
+        void set_depth(uint32_t depth) {
+            _depth = depth;
+        }
+
+        uint32_t depth() const {
+            return _depth;
+        }
+
+        template <typename T>
+        void add_part(std::function<T(const golos::chain::database&)> builder) {
+            _builders.emplace(std::type_index(typeid(T)), [builder](const golos::chain::database& db) {
+                return std::static_pointer_cast<const void>(std::make_shared<const T>(builder(db)));
+            });
+        }
+
+        /**
+         * Builds snapshot of the current state, should be called by the thread which applies blocks
+         */
+        void publish(const golos::chain::database& db);
+
+        /**
+         * Returns snapshot of block with number block_num, or of the head block if block_num is 0.
+         * Returns nullptr if snapshot isn't kept.
+         */
+        state_snapshot_ptr get(uint32_t block_num = 0) const;
+
+        void clear();
+
+    private:
+        uint32_t _depth = 0;
+        std::map<std::type_index, builder_type> _builders;
+
+        mutable std::mutex _mutex;
+        std::deque<state_snapshot_ptr> _snapshots;
+    };
+
+} } } // golos::plugins::chain
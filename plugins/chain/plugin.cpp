@@ -1,8 +1,10 @@
 #include <golos/plugins/chain/plugin.hpp>
+#include <golos/chain/compressed_block_log.hpp>
 #include <golos/chain/database_exceptions.hpp>
 #include <golos/chain/comment_object.hpp>
 #include <golos/chain/worker_objects.hpp>
 #include <golos/protocol/protocol.hpp>
+#include <golos/protocol/signature_cache.hpp>
 #include <golos/protocol/types.hpp>
 
 #include <fc/io/json.hpp>
@@ -52,15 +54,36 @@ namespace golos { namespace plugins { namespace chain {
         uint32_t clear_votes_before_block = 0;
         uint32_t clear_votes_older_n_blocks = 0xFFFFFFFF;
         bool enable_plugins_on_push_transaction;
+        bool store_recent_transactions = true;
+
+        bool block_apply_profile = false;
+        uint32_t block_apply_slow_threshold = 0;
+
+        state_snapshots snapshots;
 
         uint32_t block_num_check_free_size = 0;
 
+        uint32_t replay_decode_threads = 2;
+
+        uint32_t compressed_block_log_cache_size = golos::chain::compressed_block_log::default_cache_size;
+
+        uint32_t signature_recovery_threads = 2;
+        uint32_t cashout_threads = 2;
+
+        bfs::path snapshot_write_path;
+        bfs::path snapshot_load_path;
+        uint32_t snapshot_threads = 4;
+
+        size_t signature_cache_size = 50000;
+
         bool skip_virtual_ops = false;
 
         golos::chain::database db;
 
         bool single_write_thread = false;
 
+        bool read_only = false;
+
         golos::chain::database::store_metadata_modes store_account_metadata;
         std::vector<std::string> accounts_to_store_metadata;
         bool store_asset_metadata = true;
@@ -168,6 +191,8 @@ namespace golos { namespace plugins { namespace chain {
     }
 
     bool plugin::impl::accept_block(const protocol::signed_block& block, bool currently_syncing, uint32_t skip) {
+        GOLOS_ASSERT(!read_only, golos::unsupported_operation, "Node is read-only, it doesn't accept blocks");
+
         if (currently_syncing && block.block_num() % 10000 == 0) {
             ilog("Syncing Blockchain --- Got block: #${n} time: ${t} producer: ${p}",
                 ("t", block.timestamp)("n", block.block_num())("p", block.witness));
@@ -175,6 +200,9 @@ namespace golos { namespace plugins { namespace chain {
 
         check_time_in_block(block);
 
+        // recover keys before database is locked, so only authorities are checked under the lock
+        db.recover_signatures(block, skip);
+
         skip = db.validate_block(block, skip);
 
         if (single_write_thread) {
@@ -220,6 +248,10 @@ namespace golos { namespace plugins { namespace chain {
     };
 
     void plugin::impl::accept_transaction(const protocol::signed_transaction& trx) {
+        GOLOS_ASSERT(!read_only, golos::unsupported_operation, "Node is read-only, it doesn't accept transactions");
+
+        db.recover_signatures(trx);
+
         uint32_t skip = db.validate_transaction(trx, db.skip_apply_transaction);
 
         if (single_write_thread) {
@@ -254,6 +286,14 @@ namespace golos { namespace plugins { namespace chain {
         return my->db;
     }
 
+    state_snapshots& plugin::snapshots() {
+        return my->snapshots;
+    }
+
+    const state_snapshots& plugin::snapshots() const {
+        return my->snapshots;
+    }
+
     void plugin::set_program_options(bpo::options_description& cli, bpo::options_description& cfg) {
         cfg.add_options()
             (
@@ -306,6 +346,19 @@ namespace golos { namespace plugins { namespace chain {
             ) (
                 "enable-plugins-on-push-transaction", bpo::value<bool>()->default_value(true),
                 "enable calling of plugins for operations on push_transaction"
+            ) (
+                "store-recent-transactions", bpo::value<bool>()->default_value(true),
+                "store packed transactions until their expiration to serve them to p2p peers, "
+                "otherwise only their ids are stored for the detection of duplicates"
+            ) (
+                "block-apply-profile", bpo::value<bool>()->default_value(false),
+                "collect timings of block applying steps and of evaluators"
+            ) (
+                "block-apply-slow-threshold", bpo::value<uint32_t>()->default_value(0),
+                "log blocks which are applied longer than this number of milliseconds with their timings, 0 = do not log"
+            ) (
+                "state-snapshot-depth", bpo::value<uint32_t>()->default_value(20),
+                "number of last blocks which states are kept for API requests without locking of database, 0 = disable"
             ) (
                 "replay-if-corrupted", bpo::bool_switch()->default_value(true),
                 "replay all blocks if shared memory is corrupted"
@@ -343,6 +396,29 @@ namespace golos { namespace plugins { namespace chain {
             ) (
                 "validate-during-replay", bpo::bool_switch()->default_value(false),
                 "Validate signatures from blocklog"
+            ) (
+                "replay-decode-threads", bpo::value<uint32_t>()->default_value(2),
+                "Number of threads which read and unpack blocks from block log ahead of replay. "
+                "0 = read blocks in the replay thread"
+            ) (
+                "compressed-block-log-cache-size",
+                bpo::value<uint32_t>()->default_value(golos::chain::compressed_block_log::default_cache_size),
+                "Number of decompressed chunks of the compressed block log (block_log.z) which are kept in memory"
+            ) (
+                "signature-recovery-threads", bpo::value<uint32_t>()->default_value(2),
+                "Number of threads which recover public keys from signatures of incoming blocks before locking of database. "
+                "0 = recover keys in the thread which pushes block"
+            ) (
+                "cashout-threads", bpo::value<uint32_t>()->default_value(2),
+                "Number of threads which prepare curation rewards of comments paid in the same block. "
+                "0 = prepare rewards in the thread which applies block"
+            ) (
+                "snapshot-threads", bpo::value<uint32_t>()->default_value(4),
+                "Number of threads which write and load indexes of state snapshot. 0 = use the thread which opens database"
+            ) (
+                "signature-cache-size", bpo::value<size_t>()->default_value(50000),
+                "Number of public keys recovered from signatures which are cached to not recover them again "
+                "on receiving, validation and applying of transaction. 0 = disable cache"
             );
         //  Do not use bool_switch() in cfg!
         cli.add_options()
@@ -355,6 +431,15 @@ namespace golos { namespace plugins { namespace chain {
             ) (
                 "resync-blockchain", bpo::bool_switch()->default_value(false),
                 "clear chain database and block log"
+            ) (
+                "snapshot-write", bpo::value<std::string>(),
+                "write state snapshot to the file (abs path or relative to application data dir) after opening "
+                "of database, the node continues to work"
+            ) (
+                "snapshot-load", bpo::value<std::string>(),
+                "clear chain database and load state from the snapshot file (abs path or relative to application data dir), "
+                "blocks after the snapshot are replayed from block log; plugins which keep own objects in database "
+                "(follow, tags, market_history...) should be disabled, their objects aren't stored in snapshots"
             ) (
                 "check-locks", bpo::bool_switch()->default_value(false),
                 "Check correctness of chainbase locking"
@@ -369,6 +454,9 @@ namespace golos { namespace plugins { namespace chain {
 
         my->db.applied_block.connect([&](const protocol::signed_block& b) {
             my->on_block(b);
+            if (!my->db.is_reindexing()) {
+                my->snapshots.publish(my->db);
+            }
         });
 
         my->db.transit_to_cyberway.connect([&](const uint32_t n, uint32_t skip) {
@@ -401,6 +489,11 @@ namespace golos { namespace plugins { namespace chain {
         my->single_write_thread = options.at("single-write-thread").as<bool>();
 
         my->enable_plugins_on_push_transaction = options.at("enable-plugins-on-push-transaction").as<bool>();
+        my->store_recent_transactions = options.at("store-recent-transactions").as<bool>();
+
+        my->block_apply_profile = options.at("block-apply-profile").as<bool>();
+        my->block_apply_slow_threshold = options.at("block-apply-slow-threshold").as<uint32_t>();
+        my->snapshots.set_depth(options.at("state-snapshot-depth").as<uint32_t>());
 
         my->shared_memory_size = fc::parse_size(options.at("shared-file-size").as<std::string>());
         my->inc_shared_memory_size = fc::parse_size(options.at("inc-shared-file-size").as<std::string>());
@@ -420,6 +513,23 @@ namespace golos { namespace plugins { namespace chain {
         my->check_locks = options.at("check-locks").as<bool>();
         my->validate_invariants = options.at("validate-database-invariants").as<bool>();
         my->validate_during_replay = options.at("validate-during-replay").as<bool>();
+        my->replay_decode_threads = options.at("replay-decode-threads").as<uint32_t>();
+        my->compressed_block_log_cache_size = options.at("compressed-block-log-cache-size").as<uint32_t>();
+        my->signature_recovery_threads = options.at("signature-recovery-threads").as<uint32_t>();
+        my->cashout_threads = options.at("cashout-threads").as<uint32_t>();
+        my->signature_cache_size = options.at("signature-cache-size").as<size_t>();
+        my->snapshot_threads = options.at("snapshot-threads").as<uint32_t>();
+
+        auto data_path = [](const std::string& s) {
+            auto p = bfs::path(s);
+            return p.is_relative() ? appbase::app().data_dir() / p : p;
+        };
+        if (options.count("snapshot-write")) {
+            my->snapshot_write_path = data_path(options.at("snapshot-write").as<std::string>());
+        }
+        if (options.count("snapshot-load")) {
+            my->snapshot_load_path = data_path(options.at("snapshot-load").as<std::string>());
+        }
 
         bool serialize = options.count("serialize-state") > 0;
         if (serialize) {
@@ -530,7 +640,25 @@ namespace golos { namespace plugins { namespace chain {
             my->db.set_block_num_check_free_size(my->block_num_check_free_size);
         }
 
+        my->db.set_replay_decode_threads(my->replay_decode_threads);
+        my->db.set_compressed_block_log_cache_size(my->compressed_block_log_cache_size);
+        my->db.set_signature_recovery_threads(my->signature_recovery_threads);
+        my->db.set_cashout_threads(my->cashout_threads);
+        my->db.set_snapshot_threads(my->snapshot_threads);
+        protocol::signature_cache::instance().set_capacity(my->signature_cache_size);
+
         my->db.enable_plugins_on_push_transaction(my->enable_plugins_on_push_transaction);
+        my->db.set_store_recent_transactions(my->store_recent_transactions);
+
+        // slow blocks can be logged only with their timings
+        my->db.profiler().enable(my->block_apply_profile || my->block_apply_slow_threshold);
+        my->db.profiler().set_slow_block_threshold(fc::milliseconds(my->block_apply_slow_threshold));
+
+        if (!my->snapshot_load_path.empty()) {
+            wlog("Loading of state snapshot requested: deleting shared memory");
+            my->db.wipe(data_dir, my->shared_memory_dir, false);
+            my->db.set_snapshot_to_load(my->snapshot_load_path);
+        }
 
         try {
             ilog("Opening shared memory from ${path}", ("path", my->shared_memory_dir.generic_string()));
@@ -542,6 +670,9 @@ namespace golos { namespace plugins { namespace chain {
                 my->replay_db(data_dir, my->force_replay);
             }
         } catch (const golos::chain::database_revision_exception&) {
+            if (!my->snapshot_load_path.empty()) {
+                throw; // replay from genesis would discard the requested snapshot
+            }
             if (my->replay_if_corrupted) {
                 wlog("Error opening database, attempting to replay blockchain.");
                 my->force_replay |= my->db.revision() >= my->db.head_block_num();
@@ -557,6 +688,9 @@ namespace golos { namespace plugins { namespace chain {
                 return;
             }
         } catch (...) {
+            if (!my->snapshot_load_path.empty()) {
+                throw; // replay from genesis would discard the requested snapshot
+            }
             if (my->replay_if_corrupted) {
                 wlog("Error opening database, attempting to replay blockchain.");
                 try {
@@ -572,6 +706,15 @@ namespace golos { namespace plugins { namespace chain {
             }
         }
 
+        if (!my->snapshot_write_path.empty()) {
+            // state of opened database is at the last irreversible block
+            my->db.with_strong_write_lock([&]() {
+                my->db.write_snapshot(my->snapshot_write_path);
+            });
+        }
+
+        my->snapshots.publish(my->db);
+
         ilog("Started on blockchain with ${n} blocks", ("n", my->db.head_block_num()));
         on_sync();
     }
@@ -590,6 +733,14 @@ namespace golos { namespace plugins { namespace chain {
         my->accept_transaction(trx);
     }
 
+    void plugin::set_read_only(bool read_only) {
+        my->read_only = read_only;
+    }
+
+    bool plugin::is_read_only() const {
+        return my->read_only;
+    }
+
     bool plugin::block_is_on_preferred_chain(const protocol::block_id_type& block_id) {
         // If it's not known, it's not preferred.
         if (!db().is_known_block(block_id)) {
@@ -118,6 +118,14 @@ void pack(S& s, const golos::chain::savings_withdraw_object& w) {
     fc::raw::pack(s, w.complete);
 }
 
+// rshares of witness_vote_object aren't stored
+template<typename S>
+void pack(S& s, const golos::chain::witness_vote_object& v) {
+    fc::raw::pack(s, v.id);
+    fc::raw::pack(s, v.witness);
+    fc::raw::pack(s, v.account);
+}
+
 }} // fc::raw
 
 namespace fc {
@@ -359,22 +367,5 @@ void plugin::state_serializer::serialize(golos::chain::database &db_, const bfs:
 
 }}} // golos::plugins::chain
 
-// remove reflect of comment_object and serialize it manually
-/*
-FC_REFLECT((golos::chain::comment_object),
-    (id)(parent_author)(parent_permlink)(author)(permlink)(mode)    // consensus part
-    (created)(last_payout)(depth)(children)
-    (children_rshares2)(net_rshares)(abs_rshares)(vote_rshares)(children_abs_rshares)(cashout_time)(max_cashout_time)
-    (reward_weight)(net_votes)(total_votes)(root_comment)
-    (curation_reward_curve)(auction_window_reward_destination)(auction_window_size)(max_accepted_payout)
-    (percent_steem_dollars)(allow_votes)(allow_curation_rewards)(curation_rewards_percent)
-    (beneficiaries));*/
-
-// missing reflections
-FC_REFLECT((golos::chain::delegator_vote_interest_rate), (account)(interest_rate)(payout_strategy));
-
-FC_REFLECT((golos::chain::comment_vote_object),
-    (id)(voter)(comment)(orig_rshares)(rshares)(vote_percent)(auction_time)(last_update)(num_changes)
-    (delegator_vote_interest_rates))
-
-FC_REFLECT((golos::chain::witness_vote_object), (id)(witness)(account));
+// comment_object, savings_withdraw_object and witness_vote_object are reflected with all fields in chain headers
+// (for state snapshots), their packers above store only the part needed for CyberWay
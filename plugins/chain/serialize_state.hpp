@@ -12,6 +12,7 @@ namespace golos { namespace chain {
     struct shared_authority;
     class comment_object;
     class savings_withdraw_object;
+    class witness_vote_object;
 }}
 namespace golos { namespace protocol {
     struct beneficiary_route_type;
@@ -22,6 +23,7 @@ namespace fc { namespace raw {
 
 template<typename S> void pack(S&, const golos::chain::comment_object&);
 template<typename S> void pack(S&, const golos::chain::savings_withdraw_object&);
+template<typename S> void pack(S&, const golos::chain::witness_vote_object&);
 template<typename S> void pack(S&, const golos::chain::account_name_type&);
 template<typename S> void pack(S&, const golos::chain::shared_authority&);
 template<typename S> void pack(S&, const golos::protocol::beneficiary_route_type&);
@@ -0,0 +1,54 @@
+#include <golos/plugins/chain/state_snapshot.hpp>
+
+namespace golos { namespace plugins { namespace chain {
+
+    void state_snapshots::publish(const golos::chain::database& db) {
+        if (!_depth) {
+            return;
+        }
+
+        auto snapshot = std::make_shared<state_snapshot>();
+        snapshot->block_num = db.head_block_num();
+        snapshot->block_id = db.head_block_id();
+        snapshot->block_time = db.head_block_time();
+        for (const auto& b : _builders) {
+            snapshot->_parts.emplace(b.first, b.second(db));
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        // blocks of the switched out fork
+        while (!_snapshots.empty() && _snapshots.back()->block_num >= snapshot->block_num) {
+            _snapshots.pop_back();
+        }
+        _snapshots.push_back(std::move(snapshot));
+        while (_snapshots.size() > _depth) {
+            _snapshots.pop_front();
+        }
+    }
+
+    state_snapshot_ptr state_snapshots::get(uint32_t block_num) const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_snapshots.empty()) {
+            return nullptr;
+        }
+        if (!block_num) {
+            return _snapshots.back();
+        }
+
+        for (auto itr = _snapshots.rbegin(); itr != _snapshots.rend(); ++itr) {
+            if ((*itr)->block_num == block_num) {
+                return *itr;
+            }
+            if ((*itr)->block_num < block_num) {
+                break;
+            }
+        }
+        return nullptr;
+    }
+
+    void state_snapshots::clear() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _snapshots.clear();
+    }
+
+} } } // golos::plugins::chain
@@ -1,4 +1,5 @@
 #include <golos/plugins/database_api/plugin.hpp>
+#include <golos/plugins/database_api/block_notification_hub.hpp>
 #include <golos/plugins/database_api/api_objects/account_query.hpp>
 #include <golos/plugins/database_api/api_objects/asset_api_sort.hpp>
 #include <golos/plugins/json_rpc/plugin.hpp>
@@ -17,29 +18,19 @@
 
 namespace golos { namespace plugins { namespace database_api {
 
-using golos::api::annotated_signed_block;
 using golos::api::block_operations;
 using golos::api::callback_info;
 
-using block_applied_callback_info = callback_info<const signed_block&>;
-using block_applied_callback = block_applied_callback_info::callback_t;
 using pending_tx_callback_info = callback_info<const signed_transaction&>;
 using pending_tx_callback = pending_tx_callback_info::callback_t;
 
 
-struct virtual_operations {
-    virtual_operations(uint32_t block_num, block_operations ops): block_num(block_num), operations(ops) {
-    };
-
-    uint32_t block_num;
-    block_operations operations;
-};
-
-enum block_applied_callback_result_type {
-    block       = 0,        // send signed blocks
-    header      = 1,        // send only block headers
-    virtual_ops = 2,        // send only virtual operations
-    full        = 3         // send signed block + virtual operations
+/**
+ * Hardfork versions kept in state snapshots
+ */
+struct hardfork_state {
+    hardfork_version current;
+    scheduled_hardfork next;
 };
 
 
@@ -49,13 +40,19 @@ public:
     ~api_impl();
 
     void startup() {
+        _block_hub.start();
+    }
+
+    void shutdown() {
+        _block_hub.stop();
     }
 
     // Subscriptions
-    void set_block_applied_callback(block_applied_callback cb);
+    void set_block_applied_callback(block_applied_callback_result_type type, block_notification_hub::subscriber_ptr msg);
     void set_pending_tx_callback(pending_tx_callback cb);
-    void clear_outdated_callbacks(bool clear_blocks);
+    void clear_outdated_callbacks();
     void op_applied_callback(const operation_notification& o);
+    void block_applied_callback(const signed_block& block);
 
     // Blocks and transactions
     optional<timed_block_header> get_block_header(uint32_t block_num) const;
@@ -88,21 +85,36 @@ public:
         return _db;
     }
 
+    /**
+     * Returns part of state snapshot of block, or nullptr if snapshots are disabled and block_num is 0
+     */
+    template <typename T>
+    std::shared_ptr<const T> get_snapshot_part(uint32_t block_num) const {
+        auto snapshot = _chain.get_snapshot(block_num);
+        if (!snapshot) {
+            GOLOS_CHECK_PARAM(block_num,
+                GOLOS_CHECK_VALUE(block_num == 0, "State of block ${n} is not kept", ("n", block_num)));
+            return nullptr;
+        }
+        return snapshot->get<T>();
+    }
+
+    void add_snapshot_parts();
+
     // Callbacks
-    block_applied_callback_info::cont active_block_applied_callback;
-    block_applied_callback_info::cont free_block_applied_callback;
     pending_tx_callback_info::cont active_pending_tx_callback;
     pending_tx_callback_info::cont free_pending_tx_callback;
 
-    block_operations& get_block_vops() {
-        return _block_virtual_ops;
-    }
-
 private:
+    chain::plugin& _chain;
     golos::chain::database& _db;
 
     uint32_t _block_virtual_ops_block_num = 0;
     block_operations _block_virtual_ops;
+
+    // blocks which are queued for subscribers while the hub thread renders and sends the previous ones
+    static constexpr size_t max_queued_blocks = 64;
+    block_notification_hub _block_hub{max_queued_blocks};
 };
 
 
@@ -118,7 +130,9 @@ plugin::plugin()  {
 plugin::~plugin() {
 }
 
-plugin::api_impl::api_impl() : _db(appbase::app().get_plugin<chain::plugin>().db()) {
+plugin::api_impl::api_impl()
+    : _chain(appbase::app().get_plugin<chain::plugin>()),
+      _db(_chain.db()) {
     wlog("creating database plugin ${x}", ("x", int64_t(this)));
 }
 
@@ -182,32 +196,13 @@ DEFINE_API(plugin, set_block_applied_callback) {
         ilog("Bad argument (${a}) passed to set_block_applied_callback, using default", ("a",arg));
     }
 
-    // Delegate connection handlers to callback
-    msg_pack_transfer transfer(args);
-
-    my->database().with_weak_read_lock([&]{
-        my->set_block_applied_callback([this,type,msg = transfer.msg()](const signed_block& block) {
-            fc::variant r;
-            switch (type) {
-                case block_applied_callback_result_type::block:
-                    r = fc::variant(block);
-                    break;
-                case header:
-                    r = fc::variant(block_header(block));
-                    break;
-                case virtual_ops:
-                    r = fc::variant(virtual_operations(block.block_num(), my->get_block_vops()));
-                    break;
-                case full:
-                    r = fc::variant(annotated_signed_block(block, my->get_block_vops()));
-                    break;
-                default:
-                    break;
-            }
-            msg->unsafe_result(r);
-        });
-    });
+    if (type < block_applied_callback_result_type::block || type > block_applied_callback_result_type::full) {
+        type = block_applied_callback_result_type::block;
+    }
 
+    // Delegate connection handlers to the hub
+    msg_pack_transfer transfer(args);
+    my->set_block_applied_callback(type, transfer.msg());
     transfer.complete();
 
     return {};
@@ -225,11 +220,10 @@ DEFINE_API(plugin, set_pending_transaction_callback) {
     return {};
 }
 
-void plugin::api_impl::set_block_applied_callback(block_applied_callback callback) {
-    auto info_ptr = std::make_shared<block_applied_callback_info>();
-    active_block_applied_callback.push_back(info_ptr);
-    info_ptr->it = std::prev(active_block_applied_callback.end());
-    info_ptr->connect(database().applied_block, free_block_applied_callback, callback);
+void plugin::api_impl::set_block_applied_callback(
+    block_applied_callback_result_type type, block_notification_hub::subscriber_ptr msg
+) {
+    _block_hub.subscribe(type, std::move(msg));
 }
 
 void plugin::api_impl::set_pending_tx_callback(pending_tx_callback callback) {
@@ -239,18 +233,11 @@ void plugin::api_impl::set_pending_tx_callback(pending_tx_callback callback) {
     info_ptr->connect(database().on_pending_transaction, free_pending_tx_callback, callback);
 }
 
-void plugin::api_impl::clear_outdated_callbacks(bool clear_blocks) {
-    auto clear_bad = [&](auto& free_list, auto& active_list) {
-        for (auto& info: free_list) {
-            active_list.erase(info->it);
-        }
-        free_list.clear();
-    };
-    if (clear_blocks) {
-        clear_bad(free_block_applied_callback, active_block_applied_callback);
-    } else {
-        clear_bad(free_pending_tx_callback, active_pending_tx_callback);
+void plugin::api_impl::clear_outdated_callbacks() {
+    for (auto& info: free_pending_tx_callback) {
+        active_pending_tx_callback.erase(info->it);
     }
+    free_pending_tx_callback.clear();
 }
 
 void plugin::api_impl::op_applied_callback(const operation_notification& o) {
@@ -263,6 +250,12 @@ void plugin::api_impl::op_applied_callback(const operation_notification& o) {
     }
 }
 
+void plugin::api_impl::block_applied_callback(const signed_block& block) {
+    // block without virtual operations doesn't reset operations of the previous block
+    static const block_operations no_vops;
+    _block_hub.notify(block, _block_virtual_ops_block_num == block.block_num() ? _block_virtual_ops : no_vops);
+}
+
 //////////////////////////////////////////////////////////////////////
 //                                                                  //
 // Globals                                                          //
@@ -281,14 +274,26 @@ fc::variant_object plugin::api_impl::get_config() const {
 }
 
 DEFINE_API(plugin, get_dynamic_global_properties) {
-    PLUGIN_API_VALIDATE_ARGS();
+    PLUGIN_API_VALIDATE_ARGS(
+        (uint32_t, block_num, 0)
+    );
+    auto props = my->get_snapshot_part<dynamic_global_property_api_object>(block_num);
+    if (props) {
+        return *props;
+    }
     return my->database().with_weak_read_lock([&]() {
         return my->get_dynamic_global_properties();
     });
 }
 
 DEFINE_API(plugin, get_chain_properties) {
-    PLUGIN_API_VALIDATE_ARGS();
+    PLUGIN_API_VALIDATE_ARGS(
+        (uint32_t, block_num, 0)
+    );
+    auto props = my->get_snapshot_part<chain_api_properties>(block_num);
+    if (props) {
+        return *props;
+    }
     return my->database().with_weak_read_lock([&]() {
         return chain_api_properties(my->database().get_witness_schedule_object().median_props, my->database());
     });
@@ -298,22 +303,45 @@ dynamic_global_property_api_object plugin::api_impl::get_dynamic_global_properti
     return dynamic_global_property_api_object(database().get(dynamic_global_property_object::id_type()), database());
 }
 
+hardfork_state get_hardfork_state(const golos::chain::database& db) {
+    hardfork_state result;
+    const auto& hpo = db.get(hardfork_property_object::id_type());
+    result.current = hpo.current_hardfork_version;
+    result.next.hf_version = hpo.next_hardfork;
+    result.next.live_time = hpo.next_hardfork_time;
+    return result;
+}
+
 DEFINE_API(plugin, get_hardfork_version) {
     PLUGIN_API_VALIDATE_ARGS();
+    auto hfs = my->get_snapshot_part<hardfork_state>(0);
+    if (hfs) {
+        return hfs->current;
+    }
     return my->database().with_weak_read_lock([&]() {
-        return my->database().get(hardfork_property_object::id_type()).current_hardfork_version;
+        return get_hardfork_state(my->database()).current;
     });
 }
 
 DEFINE_API(plugin, get_next_scheduled_hardfork) {
     PLUGIN_API_VALIDATE_ARGS();
+    auto hfs = my->get_snapshot_part<hardfork_state>(0);
+    if (hfs) {
+        return hfs->next;
+    }
     return my->database().with_weak_read_lock([&]() {
-        scheduled_hardfork shf;
-        const auto &hpo = my->database().get(hardfork_property_object::id_type());
-        shf.hf_version = hpo.next_hardfork;
-        shf.live_time = hpo.next_hardfork_time;
-        return shf;
+        return get_hardfork_state(my->database()).next;
+    });
+}
+
+void plugin::api_impl::add_snapshot_parts() {
+    _chain.add_snapshot_part<dynamic_global_property_api_object>([](const golos::chain::database& db) {
+        return dynamic_global_property_api_object(db.get_dynamic_global_properties(), db);
+    });
+    _chain.add_snapshot_part<chain_api_properties>([](const golos::chain::database& db) {
+        return chain_api_properties(db.get_witness_schedule_object().median_props, db);
     });
+    _chain.add_snapshot_part<hardfork_state>(get_hardfork_state);
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -893,6 +921,12 @@ DEFINE_API(plugin, get_database_info) {
     return info;
 }
 
+DEFINE_API(plugin, get_block_apply_profile) {
+    PLUGIN_API_VALIDATE_ARGS();
+    // profiler has own lock
+    return my->database().profiler().get_stats();
+}
+
 std::vector<proposal_api_object> plugin::api_impl::get_proposed_transactions(
     const std::string& a, uint32_t from, uint32_t limit
 ) const {
@@ -1176,15 +1210,16 @@ void plugin::plugin_initialize(const boost::program_options::variables_map& opti
     my = std::make_unique<api_impl>();
     JSON_RPC_REGISTER_API(plugin_name)
     auto& db = my->database();
-    db.applied_block.connect([&](const signed_block&) {
-        my->clear_outdated_callbacks(true);
+    db.applied_block.connect([&](const signed_block& block) {
+        my->block_applied_callback(block);
     });
     db.on_pending_transaction.connect([&](const signed_transaction& tx) {
-        my->clear_outdated_callbacks(false);
+        my->clear_outdated_callbacks();
     });
     db.pre_apply_operation.connect([&](const operation_notification& o) {
         my->op_applied_callback(o);
     });
+    my->add_snapshot_parts();
     ilog("database_api plugin: plugin_initialize() end");
 }
 
@@ -1192,8 +1227,8 @@ void plugin::plugin_startup() {
     my->startup();
 }
 
-} } } // golos::plugins::database_api
+void plugin::plugin_shutdown() {
+    my->shutdown();
+}
 
-FC_REFLECT((golos::plugins::database_api::virtual_operations), (block_num)(operations))
-FC_REFLECT_ENUM(golos::plugins::database_api::block_applied_callback_result_type,
-    (block)(header)(virtual_ops)(full))
+} } } // golos::plugins::database_api
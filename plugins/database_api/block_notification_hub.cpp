@@ -0,0 +1,169 @@
+#include <golos/plugins/database_api/block_notification_hub.hpp>
+
+#include <fc/io/json.hpp>
+
+#include <algorithm>
+
+namespace golos { namespace plugins { namespace database_api {
+
+using golos::api::annotated_signed_block;
+using golos::protocol::block_header;
+
+block_notification_hub::block_notification_hub(size_t max_queued_blocks)
+    : _max_queued_blocks(std::max<size_t>(max_queued_blocks, 1)) {
+    _type_counts.fill(0);
+}
+
+block_notification_hub::~block_notification_hub() {
+    stop();
+}
+
+void block_notification_hub::start() {
+    _thread = std::thread([this]() {
+        run();
+    });
+}
+
+void block_notification_hub::stop() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopped = true;
+    }
+    _cond.notify_all();
+
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+void block_notification_hub::subscribe(block_applied_callback_result_type type, subscriber_ptr msg) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _subscribers.push_back({type, std::move(msg)});
+    ++_type_counts[type];
+}
+
+void block_notification_hub::notify(const signed_block& block, const block_operations& vops) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_subscribers.empty()) {
+        return;
+    }
+
+    notification n;
+    n.block = std::make_shared<signed_block>(block);
+    if (_type_counts[virtual_ops] || _type_counts[full]) {
+        n.vops = vops;
+    }
+
+    if (_queue.size() >= _max_queued_blocks) {
+        wlog("Block ${n} isn't sent to subscribers, they are too slow", ("n", _queue.front().block->block_num()));
+        _queue.pop_front();
+    }
+    _queue.push_back(std::move(n));
+    _cond.notify_one();
+}
+
+void block_notification_hub::run() {
+    while (true) {
+        notification n;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _cond.wait(lock, [&]() {
+                return _stopped || !_queue.empty();
+            });
+            if (_stopped) {
+                return;
+            }
+            n = std::move(_queue.front());
+            _queue.pop_front();
+        }
+
+        try {
+            deliver(n);
+        } catch (const fc::exception& e) {
+            elog("Failed to send block ${n} to subscribers: ${e}",
+                ("n", n.block->block_num())("e", e.to_detail_string()));
+        } catch (const std::exception& e) {
+            elog("Failed to send block ${n} to subscribers: ${e}", ("n", n.block->block_num())("e", e.what()));
+        } catch (...) {
+            elog("Failed to send block ${n} to subscribers: unknown exception", ("n", n.block->block_num()));
+        }
+    }
+}
+
+void block_notification_hub::deliver(const notification& n) {
+    std::vector<subscriber> subscribers;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        subscribers = _subscribers;
+    }
+
+    // each type is rendered only if it has subscribers,
+    // if rendering fails, its subscribers skip the block, but aren't dropped
+    std::array<std::string, type_count> results;
+    std::array<bool, type_count> rendered;
+    std::array<bool, type_count> render_failed;
+    rendered.fill(false);
+    render_failed.fill(false);
+
+    std::vector<json_rpc::msg_pack*> failed;
+    for (auto& s : subscribers) {
+        if (!rendered[s.type]) {
+            rendered[s.type] = true;
+            try {
+                results[s.type] = render(s.type, n);
+            } catch (const fc::exception& e) {
+                render_failed[s.type] = true;
+                elog("Failed to render block ${n} for subscribers: ${e}",
+                    ("n", n.block->block_num())("e", e.to_detail_string()));
+            } catch (const std::exception& e) {
+                render_failed[s.type] = true;
+                elog("Failed to render block ${n} for subscribers: ${e}", ("n", n.block->block_num())("e", e.what()));
+            } catch (...) {
+                render_failed[s.type] = true;
+                elog("Failed to render block ${n} for subscribers: unknown exception", ("n", n.block->block_num()));
+            }
+        }
+        if (render_failed[s.type]) {
+            continue;
+        }
+        try {
+            s.msg->unsafe_json_result(results[s.type]);
+        } catch (...) {
+            failed.push_back(s.msg.get());
+        }
+    }
+
+    if (!failed.empty()) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto itr = std::stable_partition(_subscribers.begin(), _subscribers.end(), [&](const subscriber& s) {
+            return std::find(failed.begin(), failed.end(), s.msg.get()) == failed.end();
+        });
+        for (auto i = itr; i != _subscribers.end(); ++i) {
+            --_type_counts[i->type];
+        }
+        _subscribers.erase(itr, _subscribers.end());
+    }
+}
+
+std::string block_notification_hub::render(block_applied_callback_result_type type, const notification& n) {
+    fc::variant r;
+    switch (type) {
+        case block_applied_callback_result_type::block:
+            r = fc::variant(*n.block);
+            break;
+        case header:
+            r = fc::variant(block_header(*n.block));
+            break;
+        case virtual_ops:
+            r = fc::variant(virtual_operations(n.block->block_num(), n.vops));
+            break;
+        case full:
+            r = fc::variant(annotated_signed_block(*n.block, n.vops));
+            break;
+        default:
+            break;
+    }
+    return fc::json::to_string(r);
+}
+
+} } } // golos::plugins::database_api
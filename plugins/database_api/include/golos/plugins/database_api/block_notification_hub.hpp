@@ -0,0 +1,92 @@
+#pragma once
+
+#include <golos/plugins/json_rpc/utility.hpp>
+#include <golos/api/block_objects.hpp>
+
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace golos { namespace plugins { namespace database_api {
+
+using golos::api::block_operations;
+using golos::protocol::signed_block;
+
+enum block_applied_callback_result_type {
+    block       = 0,        // send signed blocks
+    header      = 1,        // send only block headers
+    virtual_ops = 2,        // send only virtual operations
+    full        = 3         // send signed block + virtual operations
+};
+
+struct virtual_operations {
+    virtual_operations(uint32_t block_num, block_operations ops): block_num(block_num), operations(ops) {
+    };
+
+    uint32_t block_num;
+    block_operations operations;
+};
+
+/**
+ * Delivers applied blocks to subscribers of set_block_applied_callback.
+ *
+ * The applied_block handler only copies block and its virtual operations to the queue,
+ * the hub thread renders each type of result to JSON at most once per block and sends it to all its subscribers.
+ * Subscribers which can't receive results (closed connection or too many unsent responses) are removed.
+ * If the hub thread falls behind, the oldest blocks are skipped instead of stalling the apply thread.
+ */
+class block_notification_hub final {
+public:
+    using subscriber_ptr = std::shared_ptr<json_rpc::msg_pack>;
+
+    block_notification_hub(size_t max_queued_blocks);
+
+    ~block_notification_hub();
+
+    void start();
+
+    void stop();
+
+    void subscribe(block_applied_callback_result_type type, subscriber_ptr msg);
+
+    void notify(const signed_block& block, const block_operations& vops);
+
+private:
+    static constexpr size_t type_count = 4;
+
+    struct notification {
+        std::shared_ptr<const signed_block> block;
+        block_operations vops;
+    };
+
+    struct subscriber {
+        block_applied_callback_result_type type;
+        subscriber_ptr msg;
+    };
+
+    void run();
+
+    void deliver(const notification& n);
+
+    static std::string render(block_applied_callback_result_type type, const notification& n);
+
+    const size_t _max_queued_blocks;
+
+    std::mutex _mutex;
+    std::condition_variable _cond;
+    std::deque<notification> _queue;
+    std::vector<subscriber> _subscribers;
+    std::array<uint32_t, type_count> _type_counts;
+    bool _stopped = false;
+
+    std::thread _thread;
+};
+
+} } } // golos::plugins::database_api
+
+FC_REFLECT((golos::plugins::database_api::virtual_operations), (block_num)(operations))
+FC_REFLECT_ENUM(golos::plugins::database_api::block_applied_callback_result_type,
+    (block)(header)(virtual_ops)(full))
@@ -124,6 +124,7 @@ DEFINE_API_ARGS(get_potential_signatures,         msg_pack, std::set<public_key_
 DEFINE_API_ARGS(verify_authority,                 msg_pack, bool)
 DEFINE_API_ARGS(verify_account_authority,         msg_pack, bool)
 DEFINE_API_ARGS(get_database_info,                msg_pack, database_info)
+DEFINE_API_ARGS(get_block_apply_profile,          msg_pack, block_profiler_stats)
 DEFINE_API_ARGS(get_proposed_transactions,        msg_pack, std::vector<proposal_api_object>)
 DEFINE_API_ARGS(get_invite,                       msg_pack, optional<invite_api_object>)
 DEFINE_API_ARGS(get_assets,                       msg_pack, std::vector<asset_api_object>)
@@ -154,7 +155,7 @@ public:
     void set_program_options(boost::program_options::options_description& cli, boost::program_options::options_description& cfg) override{}
     void plugin_initialize(const boost::program_options::variables_map& options) override;
     void plugin_startup() override;
-    void plugin_shutdown() override{}
+    void plugin_shutdown() override;
 
     plugin();
     ~plugin();
@@ -206,9 +207,14 @@ public:
 
         /**
          * @brief Retrieve the current @ref dynamic_global_property_object
+         * @param block_num (optional) number of one of the last blocks (see state-snapshot-depth) to get its state
          */
         (get_dynamic_global_properties)
 
+        /**
+         * @brief Retrieve median chain properties
+         * @param block_num (optional) number of one of the last blocks (see state-snapshot-depth) to get its state
+         */
         (get_chain_properties)
 
         (get_hardfork_version)
@@ -319,6 +325,12 @@ public:
 
         (get_database_info)
 
+        /**
+         * @brief Timings of block applying steps and of evaluators
+         * @return histograms of durations in microseconds, they are empty if block-apply-profile is disabled
+         */
+        (get_block_apply_profile)
+
         (get_proposed_transactions)
 
         (get_invite)
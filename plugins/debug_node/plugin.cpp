@@ -347,17 +347,16 @@ uint32_t plugin::plugin_impl::debug_push_blocks(
         }
 
         for( uint32_t i=0; i<count; i++ ) {
-            //fc::optional< chain::signed_block > block = log.read_block( log.get_block_pos( first_block + i ) );
-            uint64_t block_pos = log.get_block_pos( first_block + i );
-            if( block_pos == golos::chain::block_log::npos ) {
+            // read by number, because blocks from the compressed block log have no positions
+            if( !log.head() || first_block + i > log.head()->block_num() ) {
                 wlog( "Block database ${fn} only contained ${i} of ${n} requested blocks", ("i", i)("n", count)("fn", src_filename) );
                 return i ;
             }
 
-            decltype( log.read_block(0) ) result;
+            fc::optional< golos::chain::signed_block > result;
 
             try {
-                result = log.read_block( block_pos );
+                result = log.read_block_by_num( first_block + i );
             }
             catch( const fc::exception& e ) {
                 elog( "Could not read block ${i} of ${n}", ("i", i)("n", count) );
@@ -365,10 +364,10 @@ uint32_t plugin::plugin_impl::debug_push_blocks(
             }
 
             try{
-                database().push_block( result.first, skip_flags );
+                database().push_block( *result, skip_flags );
             }
             catch( const fc::exception& e ) {
-                elog( "Got exception pushing block ${bn} : ${bid} (${i} of ${n})", ("bn", result.first.block_num())("bid", result.first.id())("i", i)("n", count) );
+                elog( "Got exception pushing block ${bn} : ${bid} (${i} of ${n})", ("bn", result->block_num())("bid", result->id())("i", i)("n", count) );
                 elog( "Exception backtrace: ${bt}", ("bt", e.to_detail_string()) );
             }
         }
@@ -0,0 +1,464 @@
+#include <golos/plugins/elastic_search/elastic_search_exporter.hpp>
+#include <golos/protocol/config.hpp>
+
+#include <fc/crypto/base64.hpp>
+#include <fc/io/json.hpp>
+#include <fc/log/logger.hpp>
+#include <fc/network/ip.hpp>
+#include <fc/network/url.hpp>
+#include <fc/utf8.hpp>
+
+#include <boost/locale/encoding_utf.hpp>
+#include <diff_match_patch.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+namespace golos { namespace plugins { namespace elastic_search {
+
+using boost::locale::conv::utf_to_utf;
+
+namespace {
+    std::wstring utf8_to_wstring(const std::string& str) {
+        return utf_to_utf<wchar_t>(str.c_str(), str.c_str() + str.size());
+    }
+
+    std::string wstring_to_utf8(const std::wstring& str) {
+        return utf_to_utf<char>(str.c_str(), str.c_str() + str.size());
+    }
+
+    constexpr uint32_t max_retry_delay_sec = 30;
+}
+
+elastic_search_exporter::elastic_search_exporter(
+    const std::string& url, const std::string& login, const std::string& password,
+    uint32_t queue_size, uint64_t bulk_size, const fc::path& cursor_file)
+        : _url(url), _login(login), _password(password),
+          _queue_size(std::max(queue_size, uint32_t(1))), _bulk_size(bulk_size), _cursor_file(cursor_file) {
+    _cursor = read_cursor();
+    _buffered_block = _cursor;
+}
+
+elastic_search_exporter::~elastic_search_exporter() {
+    stop();
+}
+
+uint32_t elastic_search_exporter::cursor() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _cursor;
+}
+
+void elastic_search_exporter::start() {
+    if (!_thread.joinable()) {
+        _thread = std::thread([this]() {
+            run();
+        });
+    }
+}
+
+void elastic_search_exporter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _queue_cv.notify_all();
+    _space_cv.notify_all();
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+void elastic_search_exporter::push(export_batch batch) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (_queue.size() >= _queue_size) {
+        wlog("Elastic search export queue is full, waiting for export of block ${b}", ("b", _queue.front().last_block));
+        _space_cv.wait(lock, [&]() {
+            return _stopping || _queue.size() < _queue_size;
+        });
+    }
+    if (_stopping) {
+        return;
+    }
+    _queue.push_back(std::move(batch));
+    lock.unlock();
+    _queue_cv.notify_one();
+}
+
+void elastic_search_exporter::run() {
+    while (true) {
+        export_batch batch;
+        bool has_more = false;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _queue_cv.wait(lock, [&]() {
+                return _stopping || !_queue.empty();
+            });
+            if (_queue.empty()) {
+                break;
+            }
+            batch = std::move(_queue.front());
+            _queue.pop_front();
+            has_more = !_queue.empty();
+        }
+        _space_cv.notify_one();
+
+        if (_failed) {
+            // cursor isn't moved after failure, so blocks are exported again after replay
+            continue;
+        }
+
+        for (const auto& op : batch.operations) {
+            try {
+                apply(op);
+            } catch (const fc::exception& e) {
+                wlog("Cannot export ${id} to elastic search: ${e}", ("id", op.id)("e", e.to_detail_string()));
+            } catch (const std::exception& e) {
+                wlog("Cannot export ${id} to elastic search: ${e}", ("id", op.id)("e", e.what()));
+            }
+        }
+        _buffered_block = batch.last_block;
+
+        if (!has_more || _buffer_bytes >= _bulk_size) {
+            flush();
+        }
+    }
+    flush();
+}
+
+void elastic_search_exporter::connect() {
+    auto fc_url = fc::url(_url);
+    auto host_port = *fc_url.host() + (fc_url.port() ? ":" + std::to_string(*fc_url.port()) : "");
+    auto ep = fc::ip::endpoint::from_string(host_port);
+    _conn = std::make_unique<fc::http::connection>();
+    _conn->connect_to(ep);
+}
+
+fc::http::headers elastic_search_exporter::get_es_headers() const {
+    fc::http::headers headers;
+    std::string authorization;
+    if (_login.size()) {
+        authorization += _login + ":";
+    }
+    if (_password.size()) {
+        authorization += _password;
+    }
+    if (authorization.size()) {
+        headers.emplace_back("Authorization", "Basic " + fc::base64_encode(authorization));
+    }
+    return headers;
+}
+
+bool elastic_search_exporter::wait_retry(uint32_t attempt) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _queue_cv.wait_for(lock, std::chrono::seconds(std::min(attempt + 1, max_retry_delay_sec)), [&]() {
+        return _stopping;
+    });
+    return !_stopping;
+}
+
+fc::http::reply elastic_search_exporter::request(const std::string& method, const std::string& url, const std::string& body) {
+    // Elastic search is unavailable: retry until it is back, queue of blocks grows meanwhile
+    for (uint32_t attempt = 0; ; ++attempt) {
+        try {
+            if (!_conn) {
+                connect();
+            }
+            return _conn->request(method, url, body, get_es_headers());
+        } catch (const fc::exception& e) {
+            _conn.reset();
+            wlog("Elastic search request ${m} ${u} failed: ${e}", ("m", method)("u", url)("e", e.to_string()));
+            if (!wait_retry(attempt)) {
+                throw;
+            }
+        }
+    }
+}
+
+bool elastic_search_exporter::find_in_es(const std::string& id, fc::variant_object& res) {
+    auto reply0 = request("GET", _url + "/blog/post/" + id + "?pretty", "");
+    auto reply_body = std::string(reply0.body.data(), reply0.body.size());
+    if (reply0.status == fc::http::reply::status_code::OK) {
+        auto reply = fc::json::from_string(reply_body);
+        if (reply["found"].as_bool()) {
+            res = reply["_source"].get_object();
+            return true;
+        }
+    }
+    res = fc::variant_object();
+    return false;
+}
+
+bool elastic_search_exporter::find_post(const std::string& id, fc::mutable_variant_object& found) {
+    auto found_buf = _buffer.find(id);
+    fc::variant_object found_es;
+    if (found_buf != _buffer.end()) {
+        found = found_buf->second;
+        return true;
+    } else if (find_in_es(id, found_es)) {
+        found = fc::mutable_variant_object(found_es);
+        return true;
+    }
+    return false;
+}
+
+void elastic_search_exporter::store(es_buffer_type& buf, const std::string& id, fc::mutable_variant_object doc) {
+    auto size = fc::json::to_string(doc).size() + id.size();
+    auto& old_size = _buffer_sizes[id];
+    _buffer_bytes = _buffer_bytes - old_size + size;
+    old_size = size;
+    buf[id] = std::move(doc);
+}
+
+void elastic_search_exporter::apply(const export_operation& op) {
+    switch (op.type) {
+        case export_operation_type::comment:
+            apply_comment(op);
+            break;
+        case export_operation_type::comment_reward:
+            apply_comment_reward(op);
+            break;
+        case export_operation_type::donate:
+            apply_donate(op);
+            break;
+    }
+}
+
+void elastic_search_exporter::save_version(const export_operation& op, const fc::mutable_variant_object* prev_ptr) {
+    if (!op.version) {
+        return;
+    }
+
+    auto vid = op.id + "," + std::to_string(op.version);
+
+    fc::mutable_variant_object prev_doc;
+    if (prev_ptr == nullptr || !prev_ptr->size()) {
+        if (find_post(op.id, prev_doc)) {
+            prev_ptr = &prev_doc;
+        } else { // post not exists because of some mistake in elastic node maintenance
+            return;
+        }
+    }
+
+    fc::mutable_variant_object doc;
+    const auto& prev = *prev_ptr;
+    auto itr = prev.find("body_patch");
+    if (itr != prev.end()) {
+        doc["is_patch"] = true;
+        doc["body"] = itr->value();
+    } else {
+        doc["body"] = prev["body"];
+    }
+    auto lu_itr = prev.find("last_update");
+    if (lu_itr != prev.end()) {
+        doc["time"] = lu_itr->value();
+    } else {
+        doc["time"] = op.created;
+    }
+    doc["v"] = op.version;
+    doc["post"] = op.id;
+
+    store(_buffer_versions, vid, std::move(doc));
+}
+
+void elastic_search_exporter::apply_comment(const export_operation& op) {
+    fc::mutable_variant_object doc;
+
+    bool has_patch = false;
+    std::string body = op.body;
+    try {
+        diff_match_patch<std::wstring> dmp;
+        auto patch = dmp.patch_fromText(utf8_to_wstring(body));
+        if (patch.size()) {
+            find_post(op.id, doc);
+
+            std::string base_body;
+            if (!op.just_created && doc.size()) {
+                base_body = doc["body"].as_string();
+            }
+            auto result = dmp.patch_apply(patch, utf8_to_wstring(base_body));
+            auto patched_body = wstring_to_utf8(result.first);
+            if (!fc::is_utf8(patched_body)) {
+                body = fc::prune_invalid_utf8(patched_body);
+            } else {
+                body = patched_body;
+            }
+            has_patch = op.track_versions;
+        }
+    } catch (...) {
+    }
+
+    if (op.track_versions) {
+        save_version(op, &doc);
+    }
+
+    for (const auto& field : op.fields) {
+        doc[field.key()] = field.value();
+    }
+    doc["body"] = body;
+    if (has_patch) {
+        doc["body_patch"] = op.body;
+    }
+
+    store(_buffer, op.id, std::move(doc));
+}
+
+void elastic_search_exporter::apply_comment_reward(const export_operation& op) {
+    fc::mutable_variant_object doc;
+    if (!find_post(op.id, doc)) {
+        return;
+    }
+
+    for (const auto& field : op.fields) {
+        doc[field.key()] = field.value();
+    }
+
+    store(_buffer, op.id, std::move(doc));
+}
+
+void elastic_search_exporter::apply_donate(const export_operation& op) {
+    fc::mutable_variant_object doc;
+    find_post(op.id, doc);
+
+    if (op.donate.symbol == STEEM_SYMBOL) {
+        auto donates = op.donate;
+        auto itr = doc.find("donates");
+        if (itr != doc.end()) {
+            donates += itr->value().as<asset>();
+        }
+        doc["donates"] = donates;
+    } else {
+        auto donates_uia = (op.donate.amount / op.donate.precision());
+        auto itr = doc.find("donates_uia");
+        if (itr != doc.end()) {
+            donates_uia += itr->value().as<golos::protocol::share_type>();
+        }
+        doc["donates_uia"] = donates_uia;
+    }
+
+    for (const auto& field : op.fields) {
+        doc[field.key()] = field.value();
+    }
+
+    store(_buffer, op.id, std::move(doc));
+}
+
+std::string elastic_search_exporter::make_bulk(
+    const std::string& _index, const std::string& _type, const es_buffer_type& buf
+) const {
+    std::string bulk;
+    for (auto& obj : buf) {
+        fc::mutable_variant_object idx;
+        idx["_index"] = _index;
+        idx["_type"] = _type;
+        idx["_id"] = obj.first;
+        fc::mutable_variant_object idx2;
+        idx2["index"] = idx;
+        bulk += fc::json::to_string(idx2) + "\r\n";
+        bulk += fc::json::to_string(obj.second) + "\r\n";
+    }
+    return bulk;
+}
+
+void elastic_search_exporter::write_bulk(const std::string& _index, const std::string& bulk) {
+    if (bulk.empty()) {
+        return;
+    }
+
+    // documents are indexed with their ids, so the whole bulk can be sent again
+    for (uint32_t attempt = 0; ; ++attempt) {
+        //headers.emplace_back("Content-Type", "application/json"); // already set - hardcoded
+        auto reply = request("POST", _url + "/" + _index + "/_bulk", bulk);
+        auto reply_body = std::string(reply.body.data(), reply.body.size());
+
+        bool transient = is_transient(reply.status);
+        if (reply.status >= 200 && reply.status < 300) {
+            auto result = fc::json::from_string(reply_body).get_object();
+            if (!result.contains("errors") || !result["errors"].as_bool()) {
+                return;
+            }
+
+            // request is accepted, but some items are failed
+            transient = true;
+            for (const auto& item : result["items"].get_array()) {
+                const auto& action = item.get_object().begin()->value().get_object();
+                auto status = action["status"].as_int64();
+                if (status >= 300 && !is_transient(status)) {
+                    transient = false;
+                    reply_body = fc::json::to_string(action);
+                    break;
+                }
+            }
+        }
+
+        if (!transient) {
+            FC_THROW("Elastic search rejected bulk to ${i}, status: ${s}, ${b}",
+                ("i", _index)("s", reply.status)("b", reply_body));
+        }
+
+        wlog("Elastic search bulk to ${i} is failed, status: ${s}, retrying...", ("i", _index)("s", reply.status));
+        if (!wait_retry(attempt)) {
+            FC_THROW("Elastic search bulk to ${i} is not written on stop", ("i", _index));
+        }
+    }
+}
+
+bool elastic_search_exporter::is_transient(int64_t status) {
+    // too many requests or server error
+    return status == 429 || status >= 500;
+}
+
+void elastic_search_exporter::flush() {
+    if (_failed) {
+        return;
+    }
+
+    try {
+        // versions refer to posts, so posts are written first
+        write_bulk("blog", make_bulk("blog", "post", _buffer));
+        write_bulk("blog_versions", make_bulk("blog_versions", "version", _buffer_versions));
+    } catch (const fc::exception& e) {
+        // On stop, when elastic search is unavailable, or when it rejects documents.
+        // Buffers and cursor are kept, following blocks aren't exported.
+        _failed = true;
+        elog("Blocks after ${b} are not exported to elastic search, replay is required to export them: ${e}",
+            ("b", cursor())("e", e.to_string()));
+        return;
+    }
+
+    _buffer.clear();
+    _buffer_versions.clear();
+    _buffer_sizes.clear();
+    _buffer_bytes = 0;
+
+    if (_buffered_block != cursor()) {
+        write_cursor(_buffered_block);
+    }
+}
+
+uint32_t elastic_search_exporter::read_cursor() const {
+    uint32_t block_num = 0;
+    if (fc::exists(_cursor_file)) {
+        std::ifstream file(_cursor_file.string());
+        file >> block_num;
+    }
+    return block_num;
+}
+
+void elastic_search_exporter::write_cursor(uint32_t block_num) {
+    auto tmp_file = _cursor_file.string() + ".tmp";
+    {
+        std::ofstream file(tmp_file, std::ios::out | std::ios::trunc);
+        file << block_num;
+        if (!file) {
+            elog("Cannot write elastic search cursor to ${f}", ("f", tmp_file));
+            return;
+        }
+    }
+    fc::rename(tmp_file, _cursor_file);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _cursor = block_num;
+}
+
+} } } // golos::plugins::elastic_search
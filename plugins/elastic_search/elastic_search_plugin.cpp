@@ -4,6 +4,9 @@
 #include <golos/protocol/block.hpp>
 #include <golos/chain/operation_notification.hpp>
 
+#include <iterator>
+#include <map>
+
 namespace golos { namespace plugins { namespace elastic_search {
 
 using golos::protocol::signed_block;
@@ -11,22 +14,68 @@ using golos::protocol::signed_block;
 class elastic_search_plugin::elastic_search_plugin_impl final {
 public:
     elastic_search_plugin_impl(const std::string& url, const std::string& login, const std::string& password,
-        uint16_t versions_depth, fc::time_point_sec skip_comments_before)
+        uint16_t versions_depth, fc::time_point_sec skip_comments_before,
+        uint32_t queue_size, uint64_t bulk_size, const fc::path& cursor_file)
             : _db(appbase::app().get_plugin<golos::plugins::chain::plugin>().db()),
-            writer(url, login, password, _db, versions_depth, skip_comments_before) {
+            versions_depth(versions_depth), skip_comments_before(skip_comments_before),
+            exporter(url, login, password, queue_size, bulk_size, cursor_file) {
+        last_block = exporter.cursor();
+        if (last_block) {
+            ilog("Elastic search is exported up to block ${b}", ("b", last_block));
+        }
     }
 
     ~elastic_search_plugin_impl() {
     }
 
+    void on_block_start(const signed_block& block) {
+        current_block = block.block_num();
+
+        // block can be applied again after fork or failure, operations of its previous version
+        // and of popped blocks are removed
+        blocks.erase(blocks.lower_bound(current_block), blocks.end());
+    }
+
     void on_operation(const operation_notification& note) {
-        if (!_db.is_generating() && !_db.is_producing()) {
-            note.op.visit(writer);
+        // only operations of block are exported, not ones of pending transactions, which are applied before
+        // the block and are re-applied after it
+        if (!current_block || note.block != current_block || note.block <= last_block
+            || _db.is_generating() || _db.is_producing()) {
+            return;
         }
+        elastic_search_state_writer writer(_db, versions_depth, skip_comments_before, blocks[note.block]);
+        note.op.visit(writer);
+    }
+
+    void on_block(const signed_block& block) {
+        current_block = 0;
+
+        const auto lib = _db.last_non_undoable_block_num();
+        if (lib <= last_block) {
+            return;
+        }
+
+        export_batch batch;
+        batch.last_block = lib;
+        auto end = blocks.upper_bound(lib);
+        for (auto itr = blocks.begin(); itr != end; ++itr) {
+            std::move(itr->second.begin(), itr->second.end(), std::back_inserter(batch.operations));
+        }
+        blocks.erase(blocks.begin(), end);
+        last_block = lib;
+
+        exporter.push(std::move(batch));
     }
 
     database& _db;
-    elastic_search_state_writer writer;
+    uint16_t versions_depth;
+    fc::time_point_sec skip_comments_before;
+
+    std::map<uint32_t, std::vector<export_operation>> blocks; ///< operations of reversible blocks
+    uint32_t current_block = 0; ///< block which is applied now, 0 - between blocks
+    uint32_t last_block = 0; ///< last block passed to exporter
+
+    elastic_search_exporter exporter;
 };
 
 elastic_search_plugin::elastic_search_plugin() = default;
@@ -54,6 +103,12 @@ void elastic_search_plugin::set_program_options(bpo::options_description& cli, b
     ) (
         "elastic-search-skip-comments-before", bpo::value<string>()->default_value("2019-01-01T00:00:00"),
         "Do not track version history (excl. first version) for comments/posts before this date. Saves disk space"
+    ) (
+        "elastic-search-queue-size", bpo::value<uint32_t>()->default_value(1000),
+        "Max number of irreversible block batches waiting for export. Block applying waits when the queue is full"
+    ) (
+        "elastic-search-bulk-size", bpo::value<uint64_t>()->default_value(5120),
+        "Size of bulk request to Elastic Search in KB"
     );
 }
 
@@ -76,11 +131,24 @@ void elastic_search_plugin::plugin_initialize(const bpo::variables_map &options)
             elog("Cannot parse elastic-search-skip-comments-before - use proper format, example: 2019-01-01T00:00:00");
         }
 
-        my = std::make_unique<elastic_search_plugin::elastic_search_plugin_impl>(uri_str, login, password, versions_depth, skb);
+        auto queue_size = options.at("elastic-search-queue-size").as<uint32_t>();
+        auto bulk_size = options.at("elastic-search-bulk-size").as<uint64_t>() * 1024;
 
+        my = std::make_unique<elastic_search_plugin::elastic_search_plugin_impl>(uri_str, login, password, versions_depth, skb,
+            queue_size, bulk_size, appbase::app().data_dir() / "elastic_search.cursor");
+
+        my->_db.applying_block.connect([&](const signed_block& block) {
+            my->on_block_start(block);
+        });
         my->_db.post_apply_operation.connect([&](const operation_notification& note) {
             my->on_operation(note);
         });
+        my->_db.applied_block.connect([&](const signed_block& block) {
+            my->on_block(block);
+        });
+
+        // replay is done by chain plugin before startup of this plugin
+        my->exporter.start();
     } else {
         ilog("Elastic search plugin configured, but no elastic-search-uri specified. Plugin disabled.");
     }
@@ -92,6 +160,9 @@ void elastic_search_plugin::plugin_startup() {
 
 void elastic_search_plugin::plugin_shutdown() {
     ilog("Shutting down elastic search plugin");
+    if (my) {
+        my->exporter.stop();
+    }
 }
 
 } } } // golos::plugins::elastic_search
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <golos/protocol/asset.hpp>
+
+#include <fc/filesystem.hpp>
+#include <fc/variant_object.hpp>
+#include <fc/network/http/connection.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace golos { namespace plugins { namespace elastic_search {
+
+using golos::protocol::asset;
+
+using es_buffer_type = std::map<std::string, fc::mutable_variant_object>;
+
+enum class export_operation_type: uint8_t {
+    comment,
+    comment_reward,
+    donate
+};
+
+/**
+ * Operation which updates post document. It keeps all data which are taken from the chain state,
+ * so it can be exported after the state is changed by following blocks.
+ */
+struct export_operation final {
+    export_operation_type type = export_operation_type::comment;
+    std::string id;                 ///< id of post document
+    fc::mutable_variant_object fields; ///< fields of document which replace old ones
+
+    std::string body;               ///< comment: body or patch of body from operation
+    bool just_created = false;      ///< comment: post has no edits
+    bool track_versions = false;    ///< comment: save patch and version of body
+    uint16_t version = 0;           ///< comment: number of version to save, 0 - do not save
+    fc::time_point_sec created;     ///< comment: creation time of post
+
+    asset donate;                   ///< donate: amount of donate
+};
+
+/**
+ * Operations of irreversible blocks from (previous batch, last_block]
+ */
+struct export_batch final {
+    uint32_t last_block = 0;
+    std::vector<export_operation> operations;
+};
+
+/**
+ * Exports post documents to Elastic Search from a dedicated thread.
+ *
+ * The chain thread pushes batches of irreversible blocks to a bounded queue, it waits only when the queue is full.
+ * The exporter thread reads previous documents from Elastic Search, builds new ones and sends them in bulk requests
+ * of about bulk_size bytes. After each successful bulk request the number of the last exported block is saved
+ * to the cursor file, so the export can be continued from it after a replay.
+ */
+class elastic_search_exporter final {
+public:
+    elastic_search_exporter(
+        const std::string& url, const std::string& login, const std::string& password,
+        uint32_t queue_size, uint64_t bulk_size, const fc::path& cursor_file);
+
+    ~elastic_search_exporter();
+
+    /**
+     * Returns number of the last block which is exported to Elastic Search.
+     */
+    uint32_t cursor() const;
+
+    void start();
+
+    /**
+     * Exports all queued batches and stops the thread.
+     */
+    void stop();
+
+    /**
+     * Adds batch to the queue, waits while the queue is full.
+     */
+    void push(export_batch batch);
+
+private:
+    void run();
+
+    void connect();
+
+    fc::http::headers get_es_headers() const;
+
+    fc::http::reply request(const std::string& method, const std::string& url, const std::string& body);
+
+    bool wait_retry(uint32_t attempt);
+
+    bool find_in_es(const std::string& id, fc::variant_object& res);
+
+    bool find_post(const std::string& id, fc::mutable_variant_object& found);
+
+    void store(es_buffer_type& buf, const std::string& id, fc::mutable_variant_object doc);
+
+    void apply(const export_operation& op);
+
+    void apply_comment(const export_operation& op);
+
+    void apply_comment_reward(const export_operation& op);
+
+    void apply_donate(const export_operation& op);
+
+    void save_version(const export_operation& op, const fc::mutable_variant_object* prev_ptr);
+
+    std::string make_bulk(const std::string& _index, const std::string& _type, const es_buffer_type& buf) const;
+
+    /**
+     * Retries while Elastic Search is overloaded or unavailable, throws if it rejects documents or on stop.
+     */
+    void write_bulk(const std::string& _index, const std::string& bulk);
+
+    static bool is_transient(int64_t status);
+
+    void flush();
+
+    uint32_t read_cursor() const;
+
+    void write_cursor(uint32_t block_num);
+
+    std::string _url;
+    std::string _login;
+    std::string _password;
+    uint32_t _queue_size;
+    uint64_t _bulk_size;
+    fc::path _cursor_file;
+
+    std::unique_ptr<fc::http::connection> _conn;
+    es_buffer_type _buffer;
+    es_buffer_type _buffer_versions;
+    std::map<std::string, uint64_t> _buffer_sizes;
+    uint64_t _buffer_bytes = 0;
+    uint32_t _buffered_block = 0;
+    bool _failed = false;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _queue_cv;
+    std::condition_variable _space_cv;
+    std::deque<export_batch> _queue;
+    uint32_t _cursor = 0;
+    bool _stopping = false;
+    std::thread _thread;
+};
+
+} } } // golos::plugins::elastic_search
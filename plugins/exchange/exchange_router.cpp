@@ -0,0 +1,822 @@
+#include <golos/plugins/exchange/exchange_router.hpp>
+
+#include <fc/io/json.hpp>
+
+#include <algorithm>
+#include <queue>
+#include <set>
+
+namespace golos { namespace plugins { namespace exchange {
+
+    using golos::chain::asset_index;
+    using golos::chain::limit_order_index;
+
+    namespace {
+
+        using symbol_set = boost::container::flat_set<asset_symbol_type>;
+        using path_type = std::vector<asset_symbol_type>;
+
+        // bounds are calculated in double, so they are compared with this relative error
+        const double bound_precision = 1e-9;
+
+        // pair which isn't near assets of search can change bounds of its chains,
+        //   so found paths are used for limited number of blocks
+        const uint32_t cache_max_age = 20;
+
+        asset subtract_fee(asset& a, uint16_t fee_pct) {
+            auto fee = asset((fc::uint128_t(a.amount.value) * fee_pct / STEEMIT_100_PERCENT).to_uint64(),
+                a.symbol);
+            // for HF 25 fix
+            if (fee_pct && fee.amount.value == 0 && a.amount.value > 0) {
+                fee.amount.value = 1;
+            }
+            a -= fee;
+            return fee;
+        }
+
+        // sells par through orders which sell receive asset for par
+        exchange_step sell_step(asset par, asset_symbol_type receive, const ex_orders& orders, uint16_t fee_pct) {
+            auto step = exchange_step::from_sell(par);
+            step.receive = asset(0, receive);
+            if (fee_pct) {
+                step.fee_pct = fee_pct;
+            }
+
+            for (const auto& o : orders) {
+                if (!par.amount.value) {
+                    break;
+                }
+                if (&o == &orders.front()) {
+                    step.best_price = o.sell_price;
+                }
+                step.limit_price = o.sell_price;
+
+                auto o_par = std::min(par, o.amount_to_receive());
+                auto r = o_par * o.sell_price;
+                par -= o_par;
+
+                if (fee_pct) {
+                    step.add_fee(subtract_fee(r, fee_pct));
+                }
+                step.receive += r;
+            }
+
+            if (par.amount.value) {
+                step.remain = par;
+            }
+            return step;
+        }
+
+        // buys par through orders which sell par for sell asset
+        exchange_step buy_step(asset par, asset_symbol_type sell, const ex_orders& orders, uint16_t fee_pct) {
+            auto step = exchange_step::from_receive(asset(0, par.symbol));
+            step.sell = asset(0, sell);
+            if (fee_pct) {
+                step.fee_pct = fee_pct;
+            }
+
+            for (const auto& o : orders) {
+                if (!par.amount.value) {
+                    break;
+                }
+                if (&o == &orders.front()) {
+                    step.best_price = ~o.sell_price;
+                }
+                step.limit_price = ~o.sell_price;
+
+                auto ord_orig = o.amount_for_sale();
+                auto ord = ord_orig;
+
+                auto fee = asset((fc::uint128_t(ord.amount.value) * fee_pct / STEEMIT_100_PERCENT).to_uint64(),
+                    ord.symbol);
+                if (fee_pct && fee.amount.value == 0) { // for HF 25 fix
+                    fee.amount.value = 1;
+                }
+                ord -= fee;
+
+                if (par >= ord) {
+                    step.receive += ord;
+                    step.add_fee(fee);
+                    par -= ord;
+                    step.add_res(ord_orig, o.sell_price);
+                } else {
+                    auto am_pct = STEEMIT_100_PERCENT - fee_pct;
+                    if (!am_pct) {
+                        continue;
+                    }
+                    step.receive += par;
+
+                    auto am = asset((fc::uint128_t(par.amount.value) * STEEMIT_100_PERCENT / am_pct).to_uint64(),
+                        par.symbol);
+                    if (fee_pct && am == par) { // for HF 25 fix
+                        am += asset(1, am.symbol);
+                    }
+
+                    step.add_fee(am - par);
+
+                    par -= par;
+
+                    step.add_res(am, o.sell_price);
+                }
+            }
+
+            if (par.amount.value) {
+                step.remain = par;
+            }
+            return step;
+        }
+
+        // part of par which is exchanged by step
+        double step_coverage(const exchange_step& step) {
+            if (!step.remain || !step.remain->amount.value) {
+                return 1;
+            }
+            auto remain = double(step.remain->amount.value);
+            // sell step has the whole par, buy step has the received part of it
+            auto par = double(step.param().amount.value) + (step.is_buy ? remain : 0);
+            return par > 0 ? (par - remain) / par : 0;
+        }
+
+        class ex_search final {
+        public:
+            ex_search(const ex_graph& graph, const exchange_query& query, const ex_router_options& options,
+                const ex_stat& stat)
+                : _graph(graph), _query(query), _options(options), _stat(stat),
+                  _is_buy(query.direction == exchange_direction::buy) {
+                for (const auto& a : graph.assets) {
+                    if (query.hidden_assets.count(a.second.symbol_name)) {
+                        _hidden.insert(a.first);
+                    }
+                }
+            }
+
+            /**
+             * Finds the best chains
+             */
+            void search() {
+                _symbols.insert(_query.amount.symbol);
+                _symbols.insert(_query.sym2);
+
+                calc_bounds();
+
+                auto root_bound = _bounds.back().find(_query.amount.symbol);
+                if (root_bound == _bounds.back().end()) {
+                    return;
+                }
+
+                ex_node root;
+                root.symbol = _query.amount.symbol;
+                root.amount = _query.amount;
+                _nodes.push_back(root);
+
+                // chains which can exchange the whole amount are continued first
+                auto cmp = [&](const node_ref& l, const node_ref& r) {
+                    auto l_remain = _nodes[l.second].has_remain;
+                    auto r_remain = _nodes[r.second].has_remain;
+                    if (l_remain != r_remain) {
+                        return l_remain;
+                    }
+                    return better(r.first, l.first);
+                };
+                std::priority_queue<node_ref, std::vector<node_ref>, decltype(cmp)> queue(cmp);
+                queue.emplace(_query.amount.amount.value * root_bound->second, 0);
+
+                while (!queue.empty()) {
+                    auto top = queue.top();
+                    queue.pop();
+                    // other chains in queue aren't better
+                    if (!can_reach(top.first, _nodes[top.second].has_remain)) {
+                        break;
+                    }
+                    expand(top.second, [&](double bound, int32_t node) {
+                        queue.emplace(bound, node);
+                    });
+                }
+            }
+
+            /**
+             * Simulates chain by path which is found before
+             */
+            void simulate(const path_type& path) {
+                std::vector<exchange_step> steps;
+                auto par = _query.amount;
+                bool has_remain = false;
+                double coverage = 1;
+                for (size_t i = 1; i < path.size(); ++i) {
+                    check_timeout();
+                    auto step = make_step(path[i - 1], par, path[i]);
+                    if (!step.valid() || !step->res().amount.value) {
+                        return;
+                    }
+                    has_remain = has_remain || !!step->remain;
+                    coverage *= step_coverage(*step);
+                    par = step->res();
+                    steps.push_back(*step);
+                }
+                if (!steps.empty()) {
+                    add_chain(std::move(steps), has_remain, coverage, path);
+                }
+            }
+
+            /**
+             * The best chains and chains with one step
+             */
+            std::vector<ex_chain> chains(std::vector<path_type>& paths) {
+                std::stable_sort(_found.begin(), _found.end(), [&](const found_chain& l, const found_chain& r) {
+                    if (l.chain.has_remain != r.chain.has_remain) {
+                        return r.chain.has_remain;
+                    }
+                    return better(l.value, r.value);
+                });
+
+                std::vector<ex_chain> result;
+                for (size_t i = 0; i < _found.size(); ++i) {
+                    if (i < _options.max_chains || _found[i].chain.size() == 1) {
+                        result.push_back(std::move(_found[i].chain));
+                        paths.push_back(std::move(_found[i].path));
+                    }
+                }
+                return result;
+            }
+
+            const symbol_set& symbols() const {
+                return _symbols;
+            }
+
+        private:
+            struct ex_node final {
+                int32_t parent = -1;    ///< -1 for the first asset
+                asset_symbol_type symbol;
+                asset amount{0, asset::min_symbol()};   ///< to exchange on the next step
+                uint16_t hops = 0;
+                bool has_remain = false;
+                double coverage = 1;    ///< part of the amount of query which is exchanged
+                exchange_step step;     ///< step to symbol, isn't used for the first asset
+            };
+
+            struct found_chain final {
+                double value;   ///< result for the whole amount of query, by effective price for partial chain
+                ex_chain chain;
+                path_type path;
+            };
+
+            using node_ref = std::pair<double, int32_t>; ///< (bound, node)
+
+            bool better(double l, double r) const {
+                return _is_buy ? l < r : l > r;
+            }
+
+            // chain with bound can be better than the worst of max_chains found complete chains.
+            // Partial chain goes after complete ones, and its bound isn't valid: the next steps can fill
+            //   even less of the amount, so result of partial chain can be better than bound.
+            bool can_reach(double bound, bool has_remain) const {
+                if (_values.size() < _options.max_chains) {
+                    return true;
+                }
+                if (has_remain) {
+                    return false;
+                }
+                if (_is_buy) {
+                    return bound * (1 - bound_precision) < *_values.rbegin();
+                }
+                return bound * (1 + bound_precision) > *_values.begin();
+            }
+
+            void check_timeout() const {
+                if (_stat.msec() > _options.timeout) {
+                    throw ex_timeout_exception();
+                }
+            }
+
+            uint16_t fee_pct(asset_symbol_type symbol) const {
+                auto a = _graph.find_asset(symbol);
+                return a ? a->fee_pct : 0;
+            }
+
+            // sell: result of exchange of 1 asset to the target asset, can't be more
+            // buy: price of 1 asset in the target asset, can't be less
+            // _bounds[n] contains bounds of chains of n steps and less
+            void calc_bounds() {
+                _bounds.resize(_options.max_hops + 1);
+                _bounds[0][_query.sym2] = 1;
+
+                for (size_t n = 1; n < _bounds.size(); ++n) {
+                    _bounds[n] = _bounds[n - 1];
+                    for (const auto& p : _graph.pairs) {
+                        auto from = _is_buy ? p.first.first : p.first.second;
+                        auto to = _is_buy ? p.first.second : p.first.first;
+                        if (_hidden.count(to)) {
+                            continue;
+                        }
+                        auto to_bound = _bounds[n - 1].find(to);
+                        if (to_bound == _bounds[n - 1].end()) {
+                            continue;
+                        }
+
+                        const auto& best = p.second->front().sell_price;
+                        auto rate = _is_buy
+                            ? double(best.quote.amount.value) / best.base.amount.value
+                            : double(best.base.amount.value) / best.quote.amount.value;
+                        auto bound = rate * to_bound->second;
+
+                        auto itr = _bounds[n].find(from);
+                        if (itr == _bounds[n].end()) {
+                            _bounds[n].emplace(from, bound);
+                        } else if (better(bound, itr->second)) {
+                            itr->second = bound;
+                        }
+                    }
+                }
+            }
+
+            bool in_path(int32_t node, asset_symbol_type symbol) const {
+                for (; node >= 0; node = _nodes[node].parent) {
+                    if (_nodes[node].symbol == symbol) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            fc::optional<exchange_step> make_step(asset_symbol_type from, const asset& par, asset_symbol_type to) const {
+                fc::optional<exchange_step> result;
+                if (_is_buy) {
+                    auto orders = _graph.find(from, to);
+                    if (orders) {
+                        result = buy_step(par, to, *orders, fee_pct(from));
+                    }
+                } else {
+                    auto orders = _graph.find(to, from);
+                    if (orders) {
+                        result = sell_step(par, to, *orders, fee_pct(to));
+                    }
+                }
+                return result;
+            }
+
+            template <typename Push>
+            void expand(int32_t node, Push&& push) {
+                // _nodes can be reallocated on push
+                const auto symbol = _nodes[node].symbol;
+                const auto amount = _nodes[node].amount;
+                const auto hops = _nodes[node].hops + 1;
+                const auto has_remain = _nodes[node].has_remain;
+                const auto coverage = _nodes[node].coverage;
+                const auto remaining = _options.max_hops - hops;
+
+                const auto& next = _is_buy ? _graph.quotes : _graph.bases;
+                auto next_itr = next.find(symbol);
+                if (next_itr == next.end()) {
+                    return;
+                }
+
+                for (auto to : next_itr->second) {
+                    check_timeout();
+
+                    if (_hidden.count(to) || in_path(node, to)) {
+                        continue;
+                    }
+                    _symbols.insert(to);
+
+                    bool is_target = (to == _query.sym2);
+                    double rate = 0;
+                    if (!is_target) {
+                        if (remaining <= 0) {
+                            continue;
+                        }
+                        auto itr = _bounds[remaining].find(to);
+                        if (itr == _bounds[remaining].end()) {
+                            continue;
+                        }
+                        rate = itr->second;
+                    }
+
+                    auto step = make_step(symbol, amount, to);
+                    if (!step.valid() || !step->res().amount.value) {
+                        continue;
+                    }
+
+                    auto child_remain = has_remain || !!step->remain;
+                    auto child_coverage = coverage * step_coverage(*step);
+                    if (is_target) {
+                        complete(node, *step, child_remain, child_coverage);
+                        continue;
+                    }
+
+                    auto bound = step->res().amount.value * rate;
+                    if (!can_reach(bound, child_remain)) {
+                        continue;
+                    }
+
+                    ex_node child;
+                    child.parent = node;
+                    child.symbol = to;
+                    child.amount = step->res();
+                    child.hops = hops;
+                    child.has_remain = child_remain;
+                    child.coverage = child_coverage;
+                    child.step = std::move(*step);
+                    _nodes.push_back(std::move(child));
+                    push(bound, int32_t(_nodes.size() - 1));
+                }
+            }
+
+            void complete(int32_t node, const exchange_step& last, bool has_remain, double coverage) {
+                std::vector<exchange_step> steps;
+                path_type path;
+                steps.push_back(last);
+                path.push_back(last.res().symbol);
+                for (; node >= 0; node = _nodes[node].parent) {
+                    if (_nodes[node].parent >= 0) {
+                        steps.push_back(_nodes[node].step);
+                    }
+                    path.push_back(_nodes[node].symbol);
+                }
+                std::reverse(steps.begin(), steps.end());
+                std::reverse(path.begin(), path.end());
+                add_chain(std::move(steps), has_remain, coverage, std::move(path));
+            }
+
+            void add_chain(std::vector<exchange_step> steps, bool has_remain, double coverage, path_type path) {
+                ex_chain chain;
+                chain.steps = std::move(steps);
+                chain.has_remain = has_remain;
+
+                if (!!_query.min_to_receive
+                        && _query.min_to_receive->ignore_chain(_is_buy, chain.param(), chain.res(), chain.size() == 1)) {
+                    return;
+                }
+                if (_is_buy) {
+                    chain.reverse();
+                }
+                auto policy = chain.size() == 1 ? _query.remain.direct : _query.remain.multi;
+                if (chain.has_remain && policy == exchange_remain_policy::ignore) {
+                    return;
+                }
+
+                double value = chain.res().amount.value;
+                if (chain.has_remain) {
+                    // buy pays less and sell receives less than for the whole amount, so they are compared by price
+                    if (coverage <= 0) {
+                        return;
+                    }
+                    value /= coverage;
+                } else {
+                    _values.insert(value);
+                    if (_values.size() > _options.max_chains) {
+                        _values.erase(_is_buy ? std::prev(_values.end()) : _values.begin());
+                    }
+                }
+                _found.push_back({value, std::move(chain), std::move(path)});
+            }
+
+            const ex_graph& _graph;
+            const exchange_query& _query;
+            const ex_router_options& _options;
+            const ex_stat& _stat;
+            const bool _is_buy;
+
+            symbol_set _hidden;
+            std::vector<std::map<asset_symbol_type, double>> _bounds;
+            std::vector<ex_node> _nodes;
+
+            std::vector<found_chain> _found;
+            std::multiset<double> _values;  ///< results of the best found complete chains
+            symbol_set _symbols;            ///< assets considered by search
+        };
+
+        ex_chain fix_receive(const ex_graph& graph, const ex_chain& chain, const ex_stat& stat, uint32_t timeout) {
+            ex_chain result;
+            result.reversed = true;
+
+            asset par(0, asset::min_symbol());
+
+            bool rev = chain.reversed;
+            int64_t size = chain.size();
+            int64_t first = rev ? 0 : size - 1;
+            int64_t i = first;
+            int64_t last = rev ? size - 1 : 0;
+            while (rev ? (i <= last) : (i >= last)) {
+                const auto& st = chain[i];
+
+                if (i == first) {
+                    par = st.sell;
+                }
+
+                auto step = exchange_step::from_sell(par);
+                step.receive = asset(0, st.receive.symbol);
+                if (!!st.fee_pct) step.fee_pct = st.fee_pct;
+
+                auto orders = graph.find(st.receive.symbol, par.symbol);
+                if (orders) {
+                    for (const auto& o : *orders) {
+                        if (par.amount.value <= 0) {
+                            break;
+                        }
+                        if (stat.msec() > timeout) throw ex_timeout_exception();
+
+                        if (!step.best_price.base.amount.value) {
+                            step.best_price = ~o.sell_price;
+                        }
+                        step.limit_price = ~o.sell_price;
+
+                        auto sell = std::min(par, o.amount_to_receive());
+
+                        auto r = sell * o.sell_price;
+                        par -= sell;
+
+                        if (!!step.fee_pct) {
+                            auto fee = subtract_fee(r, *step.fee_pct);
+                            step.add_fee(fee);
+                        }
+                        step.receive += r;
+                    }
+                }
+
+                if (!step.receive.amount.value && i != last) {
+                    result.steps.clear();
+                    return result;
+                }
+
+                step.is_buy = true;
+                result.push_back(step);
+
+                par = step.receive;
+
+                rev ? i++ : i--;
+            }
+
+            return result;
+        }
+
+        asset_map load_assets(const database& db) {
+            asset_map assets;
+            assets[STEEM_SYMBOL] = asset_info("GOLOS");
+            assets[SBD_SYMBOL] = asset_info("GBG");
+            for (const auto& a : db.get_index<asset_index>().indices()) {
+                assets[a.symbol()] = asset_info(a);
+            }
+            return assets;
+        }
+
+        ex_pair get_pair(const limit_order_object& o) {
+            return std::make_pair(o.sell_price.base.symbol, o.sell_price.quote.symbol);
+        }
+
+    } // anonymous namespace
+
+    const ex_orders* ex_graph::find(asset_symbol_type base, asset_symbol_type quote) const {
+        auto itr = pairs.find(std::make_pair(base, quote));
+        return itr != pairs.end() ? itr->second.get() : nullptr;
+    }
+
+    const asset_info* ex_graph::find_asset(asset_symbol_type symbol) const {
+        auto itr = assets.find(symbol);
+        return itr != assets.end() ? &itr->second : nullptr;
+    }
+
+    void ex_graph::add_order(const price& sell_price, share_type for_sale) {
+        auto& orders = pairs[std::make_pair(sell_price.base.symbol, sell_price.quote.symbol)];
+        auto copy = orders ? std::make_shared<ex_orders>(*orders) : std::make_shared<ex_orders>();
+        copy->push_back({sell_price, for_sale});
+        orders = std::move(copy);
+    }
+
+    void ex_graph::index() {
+        quotes.clear();
+        bases.clear();
+        for (const auto& p : pairs) {
+            quotes[p.first.first].push_back(p.first.second);
+            bases[p.first.second].push_back(p.first.first);
+        }
+    }
+
+    exchange_router::exchange_router(ex_router_options options)
+        : _options(std::move(options)) {
+    }
+
+    ex_graph_ptr exchange_router::build(const database& db) {
+        auto graph = std::make_shared<ex_graph>();
+        graph->block_num = db.head_block_num();
+        graph->block_id = db.head_block_id();
+        graph->assets = load_assets(db);
+
+        std::shared_ptr<ex_orders> orders;
+        ex_pair pair;
+        for (const auto& o : db.get_index<limit_order_index, by_price>()) {
+            if (!orders || get_pair(o) != pair) {
+                pair = get_pair(o);
+                orders = std::make_shared<ex_orders>();
+                graph->pairs.emplace(pair, orders);
+            }
+            orders->push_back({o.sell_price, o.for_sale});
+        }
+
+        graph->index();
+        return graph;
+    }
+
+    void exchange_router::set_graph(ex_graph_ptr graph) {
+        auto block_num = graph ? graph->block_num : 0;
+        auto block_id = graph ? graph->block_id : block_id_type();
+        std::atomic_store(&_graph, std::move(graph));
+        invalidate(block_num, block_id, nullptr);
+    }
+
+    void exchange_router::update(const database& db, const signed_block& block) {
+        if (db.is_reindexing()) {
+            if (graph()) {
+                set_graph(nullptr);
+            }
+            return;
+        }
+
+        auto prev = graph();
+        const auto& stack = db.get_index<limit_order_index>().stack();
+        bool has_session = !stack.empty() && stack.back().revision == db.revision();
+        if (!prev || prev->block_id != block.previous || !has_session) {
+            set_graph(build(db));
+            return;
+        }
+
+        const auto& undo = stack.back();
+        std::set<ex_pair> changed;
+        for (const auto& item : undo.old_values) {
+            changed.insert(get_pair(item.second));
+        }
+        for (const auto& item : undo.removed_values) {
+            changed.insert(get_pair(item.second));
+        }
+        for (const auto& id : undo.new_ids) {
+            changed.insert(get_pair(db.get<limit_order_object>(id)));
+        }
+
+        const auto& asset_stack = db.get_index<asset_index>().stack();
+        bool assets_changed = !asset_stack.empty() && (!asset_stack.back().new_ids.empty() ||
+            !asset_stack.back().old_values.empty() || !asset_stack.back().removed_values.empty());
+
+        auto graph = std::make_shared<ex_graph>(*prev);
+        graph->block_num = block.block_num();
+        graph->block_id = db.head_block_id();
+
+        symbol_set symbols;
+        const auto& idx = db.get_index<limit_order_index, by_price>();
+        for (const auto& pair : changed) {
+            symbols.insert(pair.first);
+            symbols.insert(pair.second);
+
+            auto orders = std::make_shared<ex_orders>();
+            auto itr = idx.lower_bound(price::max(pair.first, pair.second));
+            for (; itr != idx.end() && get_pair(*itr) == pair; ++itr) {
+                orders->push_back({itr->sell_price, itr->for_sale});
+            }
+            if (orders->empty()) {
+                graph->pairs.erase(pair);
+            } else {
+                graph->pairs[pair] = std::move(orders);
+            }
+        }
+        if (!changed.empty()) {
+            graph->index();
+        }
+        if (assets_changed) {
+            graph->assets = load_assets(db);
+        }
+
+        auto block_num = graph->block_num;
+        auto block_id = graph->block_id;
+        std::atomic_store(&_graph, ex_graph_ptr(std::move(graph)));
+        invalidate(block_num, block_id, assets_changed ? nullptr : &symbols);
+    }
+
+    ex_result exchange_router::find(const exchange_query& query, const ex_graph& graph, const ex_stat& stat) const {
+        ex_result result;
+        bool is_buy = query.direction == exchange_direction::buy;
+
+        ex_search search(graph, query, _options, stat);
+        auto key = make_key(query);
+        std::vector<path_type> paths;
+        try {
+            if (_options.cache_size && get_cached(key, paths)) {
+                result.cached = true;
+                for (const auto& path : paths) {
+                    search.simulate(path);
+                }
+            } else {
+                search.search();
+            }
+        } catch (const ex_timeout_exception&) {
+            result.timeout = true;
+        }
+
+        std::vector<path_type> found_paths;
+        result.chains = search.chains(found_paths);
+        if (_options.cache_size && !result.cached && !result.timeout) {
+            put_cached({key, graph.block_num, graph.block_id, std::move(found_paths), search.symbols()});
+        }
+
+        if (is_buy && query.excess_protect == exchange_excess_protect::fix_input) {
+            std::vector<ex_chain> new_chains;
+            try {
+                for (const auto& c : result.chains) {
+                    auto c2 = fix_receive(graph, c, stat, _options.timeout);
+                    c2.has_remain = c.has_remain;
+                    if (c2.steps.size()) {
+                        if (!!query.min_to_receive
+                                && query.min_to_receive->ignore_chain(c2.is_buy(), c2.param(), c2.res(), c2.size() == 1)) {
+                            continue;
+                        }
+                        new_chains.push_back(c2);
+                    }
+                }
+            } catch (const ex_timeout_exception&) {
+                result.timeout = true;
+            }
+            result.chains = std::move(new_chains);
+        }
+
+        // partial chains keep the order of search, which compares them by the whole amount
+        std::stable_sort(result.chains.begin(), result.chains.end(), [&](const ex_chain& a, const ex_chain& b) {
+            if (a.has_remain || b.has_remain) {
+                return !a.has_remain && b.has_remain;
+            }
+            if (is_buy) return a.get_price() < b.get_price();
+            return a.get_price() > b.get_price();
+        });
+
+        return result;
+    }
+
+    exchange_router::cache_key exchange_router::make_key(const exchange_query& query) {
+        uint8_t bucket = 0;
+        for (auto v = query.amount.amount.value; v > 1; v >>= 1) {
+            ++bucket;
+        }
+
+        // filters of chains change set of found paths
+        auto filters = fc::json::to_string(fc::mutable_variant_object()
+            ("remain", query.remain)
+            ("min_to_receive", query.min_to_receive)
+            ("hidden_assets", query.hidden_assets));
+
+        return cache_key(query.direction, query.amount.symbol, query.sym2, bucket, std::move(filters));
+    }
+
+    bool exchange_router::get_cached(const cache_key& key, std::vector<path_type>& paths) const {
+        std::lock_guard<std::mutex> lock(_cache_mutex);
+        auto itr = _cache_index.find(key);
+        if (itr == _cache_index.end()) {
+            return false;
+        }
+        _cache.splice(_cache.begin(), _cache, itr->second);
+        paths = itr->second->paths;
+        return true;
+    }
+
+    void exchange_router::put_cached(cache_entry entry) const {
+        std::lock_guard<std::mutex> lock(_cache_mutex);
+        // graph is changed since search
+        if (entry.block_id != _cache_block_id) {
+            return;
+        }
+
+        auto itr = _cache_index.find(entry.key);
+        if (itr != _cache_index.end()) {
+            _cache.erase(itr->second);
+            _cache_index.erase(itr);
+        }
+
+        _cache.push_front(std::move(entry));
+        _cache_index.emplace(_cache.front().key, _cache.begin());
+
+        while (_cache.size() > _options.cache_size) {
+            _cache_index.erase(_cache.back().key);
+            _cache.pop_back();
+        }
+    }
+
+    void exchange_router::invalidate(uint32_t block_num, const block_id_type& block_id, const symbol_set* symbols) {
+        std::lock_guard<std::mutex> lock(_cache_mutex);
+        _cache_block_id = block_id;
+
+        if (!symbols) {
+            _cache.clear();
+            _cache_index.clear();
+            return;
+        }
+
+        for (auto itr = _cache.begin(); itr != _cache.end();) {
+            bool affected = itr->block_num + cache_max_age <= block_num ||
+                std::any_of(itr->symbols.begin(), itr->symbols.end(), [&](asset_symbol_type s) {
+                    return symbols->count(s) != 0;
+                });
+            if (affected) {
+                _cache_index.erase(itr->key);
+                itr = _cache.erase(itr);
+            } else {
+                ++itr;
+            }
+        }
+    }
+
+} } } // golos::plugins::exchange
@@ -93,7 +93,7 @@ namespace golos {
                 }
             };
 
-            void exchange_min_to_receive::validate(const exchange_query& query) const {
+            inline void exchange_min_to_receive::validate(const exchange_query& query) const {
                 #define VALIDATE_AMOUNT(FIELD) \
                     if (FIELD.amount.value != 0) { \
                         GOLOS_CHECK_VALUE_GT(FIELD.amount.value, 0); \
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <golos/plugins/exchange/exchange_queries.hpp>
+#include <golos/plugins/exchange/exchange_types.hpp>
+
+#include <boost/container/flat_set.hpp>
+
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+namespace golos { namespace plugins { namespace exchange {
+
+    using golos::protocol::block_id_type;
+    using golos::protocol::signed_block;
+
+    /**
+     * Open order as it is used by search
+     */
+    struct ex_order final {
+        price sell_price;
+        share_type for_sale;
+
+        asset amount_for_sale() const {
+            return asset(for_sale, sell_price.base.symbol);
+        }
+
+        asset amount_to_receive() const {
+            return amount_for_sale() * sell_price;
+        }
+    };
+
+    /**
+     * Orders which sell base asset for quote asset, in the order of by_price index: the best price goes first
+     */
+    using ex_orders = std::vector<ex_order>;
+    using ex_orders_ptr = std::shared_ptr<const ex_orders>;
+    using ex_pair = std::pair<asset_symbol_type, asset_symbol_type>; ///< (base, quote)
+
+    /**
+     * Liquidity graph: open orders of all pairs after applying of block. Graph is immutable,
+     *   pairs which aren't changed by block are shared with the graph of the previous block.
+     */
+    struct ex_graph final {
+        uint32_t block_num = 0;
+        block_id_type block_id;
+        asset_map assets;
+        std::map<ex_pair, ex_orders_ptr> pairs;
+        std::map<asset_symbol_type, std::vector<asset_symbol_type>> quotes; ///< by base
+        std::map<asset_symbol_type, std::vector<asset_symbol_type>> bases;  ///< by quote
+
+        const ex_orders* find(asset_symbol_type base, asset_symbol_type quote) const;
+
+        const asset_info* find_asset(asset_symbol_type symbol) const;
+
+        /**
+         * Adds order to the end of pair, it is used to fill graph not from database
+         */
+        void add_order(const price& sell_price, share_type for_sale);
+
+        /**
+         * Should be called after changing of pairs
+         */
+        void index();
+    };
+
+    using ex_graph_ptr = std::shared_ptr<const ex_graph>;
+
+    struct ex_router_options final {
+        uint16_t max_hops = 4;          ///< max number of steps in chain
+        uint16_t max_chains = 20;       ///< number of the best chains which are returned
+        uint32_t timeout = SEARCH_TIMEOUT;  ///< msec
+        uint32_t cache_size = 1000;     ///< number of cached queries, 0 disables cache
+    };
+
+    struct ex_result final {
+        std::vector<ex_chain> chains;   ///< sorted, the best goes first
+        bool timeout = false;
+        bool cached = false;
+    };
+
+    /**
+     * Finds chains to exchange asset to another one.
+     *
+     * Search is best-first: partial chain with the best bound of result is continued first,
+     *   chain is dropped when its bound is worse than the result of max_chains already found chains.
+     *   Bound is the product of the best prices of pairs up to the target asset, with the limit of steps.
+     *   Chains which can't exchange the whole amount go after chains which can, and are compared by their result
+     *   divided by the exchanged part of amount. Partial fill makes bound invalid, so partial chains are dropped
+     *   only when max_chains complete chains are found.
+     *
+     * Paths found for query are cached by (direction, assets, power of 2 of amount, filters).
+     *   Cached paths are simulated with the amount of query on the current graph, so result is always exact.
+     *   Cache entry is dropped when block changes a pair with asset considered by its search,
+     *   and after few blocks, because far pairs can change bounds.
+     *
+     * Graph is updated by the thread which applies block, search reads graph without lock of database.
+     */
+    class exchange_router final {
+    public:
+        explicit exchange_router(ex_router_options options = ex_router_options());
+
+        /**
+         * Should be called when the undo session contains all changes of block.
+         */
+        void update(const database& db, const signed_block& block);
+
+        /**
+         * Returns nullptr if graph isn't built yet (on reindex and before the first block)
+         */
+        ex_graph_ptr graph() const {
+            return std::atomic_load(&_graph);
+        }
+
+        void set_graph(ex_graph_ptr graph);
+
+        static ex_graph_ptr build(const database& db);
+
+        /**
+         * Query should be validated
+         */
+        ex_result find(const exchange_query& query, const ex_graph& graph, const ex_stat& stat) const;
+
+        const ex_router_options& options() const {
+            return _options;
+        }
+
+    private:
+        using path_type = std::vector<asset_symbol_type>;
+        using cache_key = std::tuple<exchange_direction, asset_symbol_type, asset_symbol_type, uint8_t, std::string>;
+
+        struct cache_entry final {
+            cache_key key;
+            uint32_t block_num;
+            block_id_type block_id;
+            std::vector<path_type> paths;
+            boost::container::flat_set<asset_symbol_type> symbols;
+        };
+
+        using cache_list = std::list<cache_entry>;
+
+        static cache_key make_key(const exchange_query& query);
+
+        bool get_cached(const cache_key& key, std::vector<path_type>& paths) const;
+
+        void put_cached(cache_entry entry) const;
+
+        void invalidate(uint32_t block_num, const block_id_type& block_id,
+            const boost::container::flat_set<asset_symbol_type>* symbols);
+
+        const ex_router_options _options;
+
+        ex_graph_ptr _graph;
+
+        mutable std::mutex _cache_mutex;
+        mutable cache_list _cache;      ///< the last used goes first
+        mutable std::map<cache_key, cache_list::iterator> _cache_index;
+        block_id_type _cache_block_id;  ///< entries found on other graphs aren't put
+    };
+
+} } } // golos::plugins::exchange
@@ -191,7 +191,7 @@ namespace fc {
     using namespace std;
     using golos::protocol::price;
 
-    void to_variant(const golos::plugins::exchange::ex_chain &var, fc::variant &vo) {
+    inline void to_variant(const golos::plugins::exchange::ex_chain &var, fc::variant &vo) {
         fc::mutable_variant_object res;
         res["res"] = var.res();
 
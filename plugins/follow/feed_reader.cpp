@@ -0,0 +1,217 @@
+#include <golos/plugins/follow/feed_reader.hpp>
+
+#include <algorithm>
+#include <tuple>
+
+namespace golos { namespace plugins { namespace follow {
+
+    using golos::chain::to_string;
+
+    feed_reader::feed_reader(const database& db, account_name_type account, uint32_t start_entry_id)
+        : _db(db),
+          _account(account) {
+        const auto& feed_idx = db.get_index<feed_index, by_feed>();
+        _feed_itr = feed_idx.lower_bound(std::make_tuple(account, start_entry_id));
+        _feed_end = feed_idx.end();
+
+        if (start_entry_id != uint32_t(~0) && has_feed_entries()) {
+            _has_start = true;
+            _start_time = feed_time(*_feed_itr);
+            _start_comment = _feed_itr->comment;
+        }
+
+        init_blogs();
+    }
+
+    feed_reader::feed_reader(const database& db, account_name_type account,
+        time_point_sec start_time, comment_object::id_type start_comment
+    )
+        : _db(db),
+          _account(account),
+          _has_start(true),
+          _filter_feed(true),
+          _start_time(start_time),
+          _start_comment(start_comment) {
+        const auto& feed_idx = db.get_index<feed_index, by_feed>();
+        _feed_itr = feed_idx.lower_bound(account);
+        _feed_end = feed_idx.end();
+
+        init_blogs();
+    }
+
+    void feed_reader::init_blogs() {
+        // authors are taken from accounts which aren't fanned out, there are few of them
+        const auto& stats_idx = _db.get_index<follow_count_index, by_feed_from_blog>();
+        const auto& follow_idx = _db.get_index<follow_index, by_follower_following>();
+        const auto& blog_idx = _db.get_index<blog_index, by_blog>();
+        _blog_end = blog_idx.end();
+
+        for (auto itr = stats_idx.begin(); itr != stats_idx.end() && itr->feed_from_blog; ++itr) {
+            auto follow = follow_idx.find(std::make_tuple(_account, itr->account));
+            if (follow == follow_idx.end() || !(follow->what & (1 << blog))) {
+                continue;
+            }
+            _blogs.push_back({itr->account, blog_idx.lower_bound(itr->account), {}});
+        }
+    }
+
+    bool feed_reader::has_feed_entries() const {
+        return _feed_itr != _feed_end && _feed_itr->account == _account;
+    }
+
+    bool feed_reader::is_valid(const blog_stream& s) const {
+        return s.itr != _blog_end && s.itr->account == s.author;
+    }
+
+    bool feed_reader::is_after_start(const entry& e) const {
+        return _has_start && std::tie(e.time, e.comment) > std::tie(_start_time, _start_comment);
+    }
+
+    bool feed_reader::is_read_from_other_blog(const blog_stream& s, const blog_object& b, time_point_sec time) const {
+        const auto& blog_idx = _db.get_index<blog_index, by_comment>();
+        for (const auto& other : _blogs) {
+            if (other.author == s.author) {
+                continue;
+            }
+            auto itr = blog_idx.find(std::make_tuple(b.comment, other.author));
+            if (itr == blog_idx.end()) {
+                continue;
+            }
+            auto other_time = blog_time(*itr);
+            if (other_time > time || (other_time == time && other.author > s.author)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void feed_reader::finish_pending(pending_entries& pending) const {
+        // the next entry is taken from the back
+        std::sort(pending.begin(), pending.end(), [](const entry& l, const entry& r) {
+            return l.comment < r.comment;
+        });
+    }
+
+    void feed_reader::fill_feed() {
+        while (_feed_pending.empty() && has_feed_entries()) {
+            auto time = feed_time(*_feed_itr);
+            for (; has_feed_entries() && feed_time(*_feed_itr) == time; ++_feed_itr) {
+                entry e;
+                e.feed = &*_feed_itr;
+                e.comment = _feed_itr->comment;
+                e.time = time;
+                e.entry_id = _feed_itr->account_feed_id;
+                if (!_filter_feed || !is_after_start(e)) {
+                    _feed_pending.push_back(e);
+                }
+            }
+            finish_pending(_feed_pending);
+        }
+    }
+
+    void feed_reader::fill_blog(blog_stream& s) {
+        const auto& comment_idx = _db.get_index<feed_index, by_comment>();
+        while (s.pending.empty() && is_valid(s)) {
+            auto time = blog_time(*s.itr);
+            for (; is_valid(s) && blog_time(*s.itr) == time; ++s.itr) {
+                entry e;
+                e.blog = &*s.itr;
+                e.comment = s.itr->comment;
+                e.time = time;
+                if (is_after_start(e)) {
+                    continue;
+                }
+                // post was fanned out before author got many followers, or it is reblogged by other read author
+                if (comment_idx.find(std::make_tuple(e.comment, _account)) != comment_idx.end() ||
+                    is_read_from_other_blog(s, *e.blog, time)
+                ) {
+                    continue;
+                }
+                s.pending.push_back(e);
+            }
+            finish_pending(s.pending);
+        }
+    }
+
+    time_point_sec feed_reader::feed_time(const feed_object& f) const {
+        if (f.first_reblogged_by != account_name_type()) {
+            return f.first_reblogged_on;
+        }
+        return _db.get(f.comment).created;
+    }
+
+    time_point_sec feed_reader::blog_time(const blog_object& b) const {
+        const auto& comment = _db.get(b.comment);
+        if (comment.author != b.account) {
+            return b.reblogged_on;
+        }
+        return comment.created;
+    }
+
+    bool feed_reader::next(entry& e) {
+        pending_entries* best = nullptr;
+        for (auto& s : _blogs) {
+            fill_blog(s);
+            if (s.pending.empty()) {
+                continue;
+            }
+            const auto& b = s.pending.back();
+            if (best == nullptr || std::tie(b.time, b.comment) > std::tie(best->back().time, best->back().comment)) {
+                best = &s.pending;
+            }
+        }
+
+        fill_feed();
+        if (!_feed_pending.empty()) {
+            const auto& f = _feed_pending.back();
+            if (best == nullptr || std::tie(f.time, f.comment) > std::tie(best->back().time, best->back().comment)) {
+                best = &_feed_pending;
+            }
+        }
+
+        if (best == nullptr) {
+            return false;
+        }
+
+        e = best->back();
+        best->pop_back();
+        if (e.blog) {
+            fill_feed();
+            e.entry_id = _feed_pending.empty() ? 0 : _feed_pending.back().entry_id;
+        }
+        return true;
+    }
+
+    feed_reblogs get_feed_reblogs(const database& db, const feed_reader::entry& e) {
+        feed_reblogs result;
+        const auto& blog_idx = db.get_index<blog_index, by_comment>();
+        auto add = [&](const blog_object& b) {
+            result.reblogged_by.push_back(b.account);
+            result.entries.emplace_back(
+                b.account,
+                to_string(b.reblog_title),
+                to_string(b.reblog_body),
+                to_string(b.reblog_json_metadata)
+            );
+        };
+
+        if (e.feed && e.feed->first_reblogged_by != account_name_type()) {
+            const auto& f = *e.feed;
+            result.reblogged_by.reserve(f.reblogged_by.size());
+            result.entries.reserve(f.reblogged_by.size());
+            for (const auto& a : f.reblogged_by) {
+                // reblog can be deleted
+                auto blog_itr = blog_idx.find(std::make_tuple(f.comment, a));
+                if (blog_itr != blog_idx.end()) {
+                    add(*blog_itr);
+                }
+            }
+            result.first_reblogged_on = f.first_reblogged_on;
+        } else if (e.blog && e.blog->account != db.get(e.comment).author) {
+            add(*e.blog);
+            result.first_reblogged_on = e.blog->reblogged_on;
+        }
+        return result;
+    }
+
+} } } // golos::plugins::follow
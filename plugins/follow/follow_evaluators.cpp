@@ -30,6 +30,26 @@ namespace golos {
                 }
             }
 
+            bool skip_feed_fanout(database& db, plugin& plugin, account_name_type author) {
+                auto threshold = plugin.feed_fanout_threshold();
+                if (!threshold) {
+                    return false;
+                }
+
+                const auto* stats = db.find<follow_count_object, by_account>(author);
+                if (stats == nullptr || stats->follower_count <= threshold) {
+                    return false;
+                }
+
+                // feeds keep reading the blog even if author loses followers, because its previous posts aren't in them
+                if (!stats->feed_from_blog) {
+                    db.modify(*stats, [&](follow_count_object& s) {
+                        s.feed_from_blog = true;
+                    });
+                }
+                return true;
+            }
+
             void follow_evaluator::do_apply(const follow_operation& o) {
                 try {
                     static map<string, follow_type> follow_type_map = []() {
@@ -174,6 +194,10 @@ namespace golos {
 
                     save_blog_stats(db(), o.account, c.author, 1);
 
+                    if (skip_feed_fanout(db(), *_plugin, o.account)) {
+                        return;
+                    }
+
                     const auto& feed_idx = db().get_index<feed_index>().indices().get<by_feed>();
                     const auto& comment_idx = db().get_index<feed_index>().indices().get<by_comment>();
                     const auto& idx = db().get_index<follow_index>().indices().get<by_following_follower>();
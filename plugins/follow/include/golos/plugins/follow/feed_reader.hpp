@@ -0,0 +1,118 @@
+#pragma once
+
+#include <golos/plugins/follow/follow_forward.hpp>
+#include <golos/plugins/follow/follow_objects.hpp>
+#include <golos/chain/database.hpp>
+#include <golos/api/reblog_entry.hpp>
+
+#include <vector>
+
+namespace golos { namespace plugins { namespace follow {
+
+    using golos::chain::database;
+    using protocol::time_point_sec;
+
+    /**
+     * Reads feed of account from the newest entries: its feed_objects merged with blogs of followed authors,
+     * whose posts and reblogs aren't fanned out to feeds (see follow-feed-fanout-threshold).
+     *
+     * Entries are ordered by (time of post or reblog, comment id), the newest go first.
+     * Blog entry is skipped if its post is in feed_objects of account, or if it is in blog of other read author
+     * with the newer time (on equal times, the author with the greater name is kept), so the same post is returned
+     * once and at the same position on any page.
+     *
+     * Page is continued by the time and the comment of its last entry, the entry with them goes first.
+     * Paging by entry_id is kept for the feeds without blog entries: blog entry has entry_id
+     * of the next feed entry or 0 if there are no more feed entries, blog entries newer than the start feed entry
+     * are skipped.
+     */
+    class feed_reader final {
+    public:
+        struct entry {
+            const feed_object* feed = nullptr;
+            const blog_object* blog = nullptr;
+            comment_object::id_type comment;
+            time_point_sec time;
+            uint32_t entry_id = 0;
+        };
+
+        /**
+         * Reads from the newest entry, or from the feed entry with start_entry_id
+         */
+        feed_reader(const database& db, account_name_type account, uint32_t start_entry_id = ~0);
+
+        /**
+         * Reads from the entry with start_time and start_comment or from the next older one
+         */
+        feed_reader(const database& db, account_name_type account,
+            time_point_sec start_time, comment_object::id_type start_comment);
+
+        /**
+         * Returns false after the last entry
+         */
+        bool next(entry& e);
+
+    private:
+        using feed_iterator = feed_index::index<by_feed>::type::const_iterator;
+        using blog_iterator = blog_index::index<by_blog>::type::const_iterator;
+
+        /**
+         * Entries of stream which have the same time, sorted by comment, so the next entry is the last one.
+         * Feed and blog iterators go by ids of entries, which can differ from the order of comments on equal times.
+         */
+        using pending_entries = std::vector<entry>;
+
+        struct blog_stream {
+            account_name_type author;
+            blog_iterator itr;
+            pending_entries pending;
+        };
+
+        void init_blogs();
+
+        bool is_valid(const blog_stream& s) const;
+
+        bool has_feed_entries() const;
+
+        bool is_after_start(const entry& e) const;
+
+        bool is_read_from_other_blog(const blog_stream& s, const blog_object& b, time_point_sec time) const;
+
+        void fill_feed();
+
+        void fill_blog(blog_stream& s);
+
+        void finish_pending(pending_entries& pending) const;
+
+        time_point_sec feed_time(const feed_object& f) const;
+
+        time_point_sec blog_time(const blog_object& b) const;
+
+        const database& _db;
+        const account_name_type _account;
+
+        feed_iterator _feed_itr;
+        feed_iterator _feed_end;
+        pending_entries _feed_pending;
+        blog_iterator _blog_end;
+        std::vector<blog_stream> _blogs;
+
+        bool _has_start = false;
+        bool _filter_feed = false;  ///< start is applied to feed entries too, not only to blog entries
+        time_point_sec _start_time;
+        comment_object::id_type _start_comment;
+    };
+
+    /**
+     * Reblogs of feed entry in the order of reblogs: feed entry has reblogs of followed accounts,
+     * blog entry is a reblog if the blogger isn't author of post.
+     */
+    struct feed_reblogs final {
+        std::vector<account_name_type> reblogged_by;
+        std::vector<golos::api::reblog_entry> entries;
+        time_point_sec first_reblogged_on;
+    };
+
+    feed_reblogs get_feed_reblogs(const database& db, const feed_reader::entry& e);
+
+} } } // golos::plugins::follow
@@ -21,6 +21,8 @@ namespace golos {
                 std::vector<reblog_entry> reblog_entries;
                 time_point_sec reblog_on;
                 uint32_t entry_id = 0;
+                time_point_sec feed_time; ///< with comment_id, it is the start of the next page
+                comment_object::id_type comment_id;
             };
 
             struct comment_feed_entry {
@@ -29,6 +31,8 @@ namespace golos {
                 std::vector<reblog_entry> reblog_entries;
                 time_point_sec reblog_on;
                 uint32_t entry_id = 0;
+                time_point_sec feed_time; ///< with comment_id, it is the start of the next page
+                comment_object::id_type comment_id;
             };
 
             struct blog_entry {
@@ -97,9 +101,11 @@ namespace golos {
             using blog_authors_r = std::vector<std::pair<std::string, uint32_t>>;
         }}}
 
-FC_REFLECT((golos::plugins::follow::feed_entry), (author)(permlink)(hashlink)(reblog_by)(reblog_entries)(reblog_on)(entry_id));
+FC_REFLECT((golos::plugins::follow::feed_entry), (author)(permlink)(hashlink)(reblog_by)(reblog_entries)(reblog_on)(entry_id)
+    (feed_time)(comment_id));
 
-FC_REFLECT((golos::plugins::follow::comment_feed_entry), (comment)(reblog_by)(reblog_entries)(reblog_on)(entry_id));
+FC_REFLECT((golos::plugins::follow::comment_feed_entry), (comment)(reblog_by)(reblog_entries)(reblog_on)(entry_id)
+    (feed_time)(comment_id));
 
 FC_REFLECT((golos::plugins::follow::blog_entry), (author)(permlink)(hashlink)(blog)(reblog_on)(entry_id)
     (reblog_title)(reblog_body)(reblog_json_metadata));
@@ -11,6 +11,13 @@ namespace golos {
             using golos::chain::evaluator;
             using golos::chain::database;
 
+            /**
+             * Returns true if posts and reblogs of author aren't fanned out to feeds of its followers,
+             * because it has more followers than follow-feed-fanout-threshold.
+             * Since then feeds of followers read them from the blog of author (see feed_reader).
+             */
+            bool skip_feed_fanout(database& db, plugin& plugin, account_name_type author);
+
             class follow_evaluator : public golos::chain::evaluator_impl<follow_evaluator, follow_plugin_operation> {
             public:
                 typedef follow_operation operation_type;
@@ -130,6 +130,9 @@ namespace golos {
                 account_name_type account;
                 uint32_t follower_count = 0;
                 uint32_t following_count = 0;
+
+                /// posts and reblogs of account aren't fanned out to feeds, they are read from its blog
+                bool feed_from_blog = false;
             };
 
             typedef object_id<follow_count_object> follow_count_id_type;
@@ -209,6 +212,7 @@ namespace golos {
 
             struct by_followers;
             struct by_following;
+            struct by_feed_from_blog;
 
             typedef multi_index_container<follow_count_object, indexed_by<ordered_unique<tag<by_id>,
                     member<follow_count_object, follow_count_id_type, &follow_count_object::id>>,
@@ -221,7 +225,11 @@ namespace golos {
                     ordered_unique<tag<by_following>, composite_key<follow_count_object,
                             member<follow_count_object, uint32_t, &follow_count_object::following_count>,
                             member<follow_count_object, follow_count_id_type, &follow_count_object::id> >,
-                            composite_key_compare<std::greater<uint32_t>, std::less<follow_count_id_type>>> >,
+                            composite_key_compare<std::greater<uint32_t>, std::less<follow_count_id_type>>>,
+                    ordered_unique<tag<by_feed_from_blog>, composite_key<follow_count_object,
+                            member<follow_count_object, bool, &follow_count_object::feed_from_blog>,
+                            member<follow_count_object, account_name_type, &follow_count_object::account> >,
+                            composite_key_compare<std::greater<bool>, std::less<account_name_type>>> >,
                     allocator<follow_count_object> > follow_count_index;
 
         }
@@ -240,7 +248,8 @@ CHAINBASE_SET_INDEX_TYPE(golos::plugins::follow::feed_object, golos::plugins::fo
 FC_REFLECT((golos::plugins::follow::blog_object), (id)(account)(comment)(reblogged_on)(blog_feed_id))
 CHAINBASE_SET_INDEX_TYPE(golos::plugins::follow::blog_object, golos::plugins::follow::blog_index)
 
-FC_REFLECT((golos::plugins::follow::follow_count_object), (id)(account)(follower_count)(following_count))
+FC_REFLECT((golos::plugins::follow::follow_count_object),
+           (id)(account)(follower_count)(following_count)(feed_from_blog))
 CHAINBASE_SET_INDEX_TYPE(golos::plugins::follow::follow_count_object, golos::plugins::follow::follow_count_index)
 
 FC_REFLECT((golos::plugins::follow::blog_author_stats_object), (id)(blogger)(guest)(count))
@@ -74,6 +74,8 @@ namespace golos { namespace plugins { namespace follow {
 
         uint32_t max_feed_size();
 
+        uint32_t feed_fanout_threshold();
+
         uint16_t max_mentions_count();
 
         const std::regex& mention_regex();
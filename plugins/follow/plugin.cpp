@@ -1,6 +1,7 @@
 #include <golos/plugins/follow/follow_objects.hpp>
 #include <golos/plugins/follow/follow_operations.hpp>
 #include <golos/plugins/follow/follow_evaluators.hpp>
+#include <golos/plugins/follow/feed_reader.hpp>
 #include <golos/protocol/config.hpp>
 #include <golos/protocol/exceptions.hpp>
 #include <golos/chain/database.hpp>
@@ -197,7 +198,8 @@ namespace golos {
                         const auto& comment_idx = _db.get_index<feed_index, by_comment>();
                         const auto& feed_idx = _db.get_index<feed_index, by_feed>();
 
-                        auto itr = idx.find(op.author);
+                        // posts of authors with many followers are read by feeds from their blogs
+                        auto itr = skip_feed_fanout(_db, _plugin, op.author) ? idx.end() : idx.find(op.author);
                         for (; itr != idx.end() && itr->following == op.author; ++itr) {
                             if (itr->what & (1 << blog)) {
                                 auto* foll = _db.find_account(itr->follower);
@@ -394,13 +396,35 @@ namespace golos {
                         uint32_t start_entry_id = 0,
                         uint32_t limit = 500,
                         const std::set<std::string>* filter_tag_masks = nullptr,
-                        opt_prefs prefs = opt_prefs());
+                        opt_prefs prefs = opt_prefs(),
+                        time_point_sec start_time = time_point_sec(),
+                        comment_object::id_type start_comment_id = comment_object::id_type());
 
                 std::vector<comment_feed_entry> get_feed(
                         account_name_type account,
                         uint32_t start_entry_id = 0,
                         uint32_t limit = 500,
-                        const std::set<std::string>* filter_tag_masks = nullptr);
+                        const std::set<std::string>* filter_tag_masks = nullptr,
+                        time_point_sec start_time = time_point_sec(),
+                        comment_object::id_type start_comment_id = comment_object::id_type());
+
+                /**
+                 * Page starts at the entry with start_time and start_comment_id,
+                 *   if start_time isn't set, it starts at the feed entry with entry_id (0 - the newest)
+                 */
+                std::unique_ptr<feed_reader> make_feed_reader(
+                        account_name_type account,
+                        uint32_t entry_id,
+                        time_point_sec start_time,
+                        comment_object::id_type start_comment_id);
+
+                template<typename Entry>
+                void fill_reblogs(Entry& entry, const feed_reader::entry& itr) {
+                    auto reblogs = get_feed_reblogs(database(), itr);
+                    entry.reblog_by.assign(reblogs.reblogged_by.begin(), reblogs.reblogged_by.end());
+                    entry.reblog_entries = std::move(reblogs.entries);
+                    entry.reblog_on = reblogs.first_reblogged_on;
+                }
 
                 std::vector<blog_entry> get_blog_entries(
                         account_name_type account,
@@ -430,6 +454,8 @@ namespace golos {
 
                 uint32_t max_feed_size_ = 500;
 
+                uint32_t feed_fanout_threshold_ = 0;
+
                 uint16_t max_mentions_count_ = 30;
 
                 std::shared_ptr<generic_custom_operation_interpreter<
@@ -449,6 +475,10 @@ namespace golos {
                 cfg.add_options() (
                     "follow-max-feed-size", boost::program_options::value<uint32_t>()->default_value(500),
                     "Set the maximum size of cached feed for an account"
+                ) (
+                    "follow-feed-fanout-threshold", boost::program_options::value<uint32_t>()->default_value(0),
+                    "Posts and reblogs of accounts with more followers aren't copied to feeds of followers, "
+                    "feeds read them from blogs of these accounts. Changing requires replay. 0 = copy to all feeds"
                 ) (
                     "max-comment-mentions-count", boost::program_options::value<uint16_t>()->default_value(30),
                     "Set the maximum of @ mentions in comment or post, to be processed"
@@ -478,6 +508,7 @@ namespace golos {
                         uint32_t feed_size = options["follow-max-feed-size"].as<uint32_t>();
                         pimpl->max_feed_size_ = feed_size;
                     }
+                    pimpl->feed_fanout_threshold_ = options["follow-feed-fanout-threshold"].as<uint32_t>();
                     if (options.count("max-comment-mentions-count")) {
                         pimpl->max_mentions_count_ = options["max-comment-mentions-count"].as<uint16_t>();
                     }
@@ -493,6 +524,10 @@ namespace golos {
                 return pimpl->max_feed_size_;
             }
 
+            uint32_t plugin::feed_fanout_threshold() {
+                return pimpl->feed_fanout_threshold_;
+            }
+
             uint16_t plugin::max_mentions_count() {
                 return pimpl->max_mentions_count_;
             }
@@ -594,22 +629,20 @@ namespace golos {
                     uint32_t entry_id,
                     uint32_t limit,
                     const std::set<std::string>* filter_tag_masks,
-                    opt_prefs prefs) {
+                    opt_prefs prefs,
+                    time_point_sec start_time,
+                    comment_object::id_type start_comment_id) {
                 GOLOS_CHECK_LIMIT_PARAM(limit, 500);
 
-                if (entry_id == 0) {
-                    entry_id = ~0;
-                }
-
                 std::vector<feed_entry> result;
                 result.reserve(limit);
 
                 const auto& db = database();
-                const auto& feed_idx = db.get_index<feed_index, by_feed>();
-                auto itr = feed_idx.lower_bound(std::make_tuple(account, entry_id));
+                auto reader = make_feed_reader(account, entry_id, start_time, start_comment_id);
+                feed_reader::entry itr;
 
-                for (; itr != feed_idx.end() && itr->account == account && result.size() < limit; ++itr) {
-                    const auto& comment = db.get(itr->comment);
+                while (result.size() < limit && reader->next(itr)) {
+                    const auto& comment = db.get(itr.comment);
                     const auto* extras = db.find_extras(comment.author, comment.hashlink);
                     if (!extras) continue;
                     auto app = get_comment_app_by_id(db, extras->app_id);
@@ -619,23 +652,10 @@ namespace golos {
                     entry.author = comment.author;
                     entry.hashlink = comment.hashlink;
                     entry.permlink = to_string(extras->permlink);
-                    entry.entry_id = itr->account_feed_id;
-                    if (itr->first_reblogged_by != account_name_type()) {
-                        entry.reblog_by.reserve(itr->reblogged_by.size());
-                        entry.reblog_entries.reserve(itr->reblogged_by.size());
-                        for (const auto& a : itr->reblogged_by) {
-                            entry.reblog_by.push_back(a);
-                            const auto& blog_idx = db.get_index<blog_index, by_comment>();
-                            auto blog_itr = blog_idx.find(std::make_tuple(itr->comment, a));
-                            entry.reblog_entries.emplace_back(
-                                a,
-                                to_string(blog_itr->reblog_title),
-                                to_string(blog_itr->reblog_body),
-                                to_string(blog_itr->reblog_json_metadata)
-                            );
-                        }
-                        entry.reblog_on = itr->first_reblogged_on;
-                    }
+                    entry.entry_id = itr.entry_id;
+                    entry.feed_time = itr.time;
+                    entry.comment_id = itr.comment;
+                    fill_reblogs(entry, itr);
                     result.push_back(entry);
                 }
 
@@ -646,48 +666,47 @@ namespace golos {
                     account_name_type account,
                     uint32_t entry_id,
                     uint32_t limit,
-                    const std::set<std::string>* filter_tag_masks) {
+                    const std::set<std::string>* filter_tag_masks,
+                    time_point_sec start_time,
+                    comment_object::id_type start_comment_id) {
                 GOLOS_CHECK_LIMIT_PARAM(limit, 500);
 
-                if (entry_id == 0) {
-                    entry_id = ~0;
-                }
-
                 std::vector<comment_feed_entry> result;
                 result.reserve(limit);
 
                 const auto& db = database();
-                const auto& feed_idx = db.get_index<feed_index, by_feed>();
-                auto itr = feed_idx.lower_bound(std::make_tuple(account, entry_id));
+                auto reader = make_feed_reader(account, entry_id, start_time, start_comment_id);
+                feed_reader::entry itr;
 
-                for (; itr != feed_idx.end() && itr->account == account && result.size() < limit; ++itr) {
-                    const auto& comment = db.get(itr->comment);
+                while (result.size() < limit && reader->next(itr)) {
+                    const auto& comment = db.get(itr.comment);
                     comment_feed_entry entry;
                     entry.comment = helper->create_comment_api_object(comment);
                     if (category_matches_masks(entry.comment.category, filter_tag_masks)) continue;
-                    entry.entry_id = itr->account_feed_id;
-                    if (itr->first_reblogged_by != account_name_type()) {
-                        entry.reblog_by.reserve(itr->reblogged_by.size());
-                        entry.reblog_entries.reserve(itr->reblogged_by.size());
-                        for (const auto& a : itr->reblogged_by) {
-                            entry.reblog_by.push_back(a);
-                            const auto& blog_idx = db.get_index<blog_index, by_comment>();
-                            auto blog_itr = blog_idx.find(std::make_tuple(itr->comment, a));
-                            entry.reblog_entries.emplace_back(
-                                a,
-                                to_string(blog_itr->reblog_title),
-                                to_string(blog_itr->reblog_body),
-                                to_string(blog_itr->reblog_json_metadata)
-                            );
-                        }
-                        entry.reblog_on = itr->first_reblogged_on;
-                    }
+                    entry.entry_id = itr.entry_id;
+                    entry.feed_time = itr.time;
+                    entry.comment_id = itr.comment;
+                    fill_reblogs(entry, itr);
                     result.push_back(entry);
                 }
 
                 return result;
             }
 
+            std::unique_ptr<feed_reader> plugin::impl::make_feed_reader(
+                    account_name_type account,
+                    uint32_t entry_id,
+                    time_point_sec start_time,
+                    comment_object::id_type start_comment_id) {
+                if (start_time != time_point_sec()) {
+                    return std::make_unique<feed_reader>(database(), account, start_time, start_comment_id);
+                }
+                if (entry_id == 0) {
+                    entry_id = ~0;
+                }
+                return std::make_unique<feed_reader>(database(), account, entry_id);
+            }
+
             std::vector<blog_entry> plugin::impl::get_blog_entries(
                     account_name_type account,
                     uint32_t entry_id,
@@ -855,9 +874,12 @@ namespace golos {
                     (uint32_t,              limit, 500)
                     (std::set<std::string>, filter_tag_masks, std::set<std::string>())
                     (opt_prefs, prefs, opt_prefs())
+                    (time_point_sec,          start_time, time_point_sec())
+                    (comment_object::id_type, start_comment_id, comment_object::id_type())
                 )
                 return pimpl->database().with_weak_read_lock([&]() {
-                    return pimpl->get_feed_entries(account, entry_id, limit, &filter_tag_masks, prefs);
+                    return pimpl->get_feed_entries(account, entry_id, limit, &filter_tag_masks, prefs,
+                        start_time, start_comment_id);
                 });
             }
 
@@ -867,9 +889,11 @@ namespace golos {
                     (uint32_t,              entry_id, 0)
                     (uint32_t,              limit, 500)
                     (std::set<std::string>, filter_tag_masks, std::set<std::string>())
+                    (time_point_sec,          start_time, time_point_sec())
+                    (comment_object::id_type, start_comment_id, comment_object::id_type())
                 )
                 return pimpl->database().with_weak_read_lock([&]() {
-                    return pimpl->get_feed(account, entry_id, limit, &filter_tag_masks);
+                    return pimpl->get_feed(account, entry_id, limit, &filter_tag_masks, start_time, start_comment_id);
                 });
             }
 
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <fc/crypto/sha256.hpp>
+#include <fc/io/raw.hpp>
+#include <fc/io/raw_variant.hpp>
+#include <fc/optional.hpp>
+#include <fc/variant.hpp>
+#include <fc/variant_object.hpp>
+
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Binary frames of websocket endpoint are processed as binary RPC calls.
+ *
+ * Request and response are packed by fc::raw. Method is addressed by its id,
+ * which is the hash of its canonical name "api.method" (see binary_method_id), so it doesn't depend
+ * on the set of APIs enabled on node. Response echoes the name of called method.
+ * Arguments are the same as of JSON-RPC call, result is packed by fc::raw from the return type of method,
+ * so the client unpacks it to the same reflected type.
+ */
+
+namespace golos { namespace plugins { namespace json_rpc {
+
+    /**
+     * First 4 bytes of sha256 of "api.method", as little-endian number
+     */
+    inline uint32_t binary_method_id(const std::string& name) {
+        auto hash = fc::sha256::hash(name);
+        auto data = reinterpret_cast<const unsigned char*>(hash.data());
+        return uint32_t(data[0]) | (uint32_t(data[1]) << 8) | (uint32_t(data[2]) << 16) | (uint32_t(data[3]) << 24);
+    }
+
+    struct binary_rpc_request final {
+        uint64_t id = 0;
+        uint32_t method_id = 0;
+        fc::variants args;
+    };
+
+    struct binary_rpc_error final {
+        int32_t code = 0;
+        std::string message;
+        fc::optional<std::string> data;     ///< serialized to JSON
+    };
+
+    struct binary_rpc_response final {
+        uint64_t id = 0;
+        std::string method;                         ///< "api.method", empty if method isn't found
+        fc::optional<std::vector<char>> result;     ///< packed by fc::raw
+        fc::optional<std::string> json_result;      ///< result of method without binary binding, or of callback
+        fc::optional<binary_rpc_error> error;
+    };
+
+    /**
+     * Results which fc::raw can't pack by their type, they are packed as fc::variant.
+     */
+    template <typename T>
+    struct binary_rpc_as_variant: std::false_type {
+    };
+
+    template <>
+    struct binary_rpc_as_variant<fc::mutable_variant_object>: std::true_type {
+    };
+
+    template <typename T>
+    std::vector<char> pack_binary_result(const T& value, std::false_type) {
+        return fc::raw::pack(value);
+    }
+
+    template <typename T>
+    std::vector<char> pack_binary_result(const T& value, std::true_type) {
+        return fc::raw::pack(fc::variant(value));
+    }
+
+    template <typename T>
+    std::vector<char> pack_binary_result(const T& value) {
+        return pack_binary_result(value, binary_rpc_as_variant<T>());
+    }
+
+} } } // golos::plugins::json_rpc
+
+FC_REFLECT((golos::plugins::json_rpc::binary_rpc_request), (id)(method_id)(args))
+FC_REFLECT((golos::plugins::json_rpc::binary_rpc_error), (code)(message)(data))
+FC_REFLECT((golos::plugins::json_rpc::binary_rpc_response), (id)(method)(result)(json_result)(error))
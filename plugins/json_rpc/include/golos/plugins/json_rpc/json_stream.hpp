@@ -0,0 +1,258 @@
+#pragma once
+
+#include <golos/protocol/types.hpp>
+#include <golos/protocol/version.hpp>
+#include <golos/protocol/uint128lh_t.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/optional.hpp>
+#include <fc/reflect/reflect.hpp>
+#include <fc/reflect/variant.hpp>
+#include <fc/safe.hpp>
+#include <fc/variant.hpp>
+
+#include <boost/container/flat_map.hpp>
+#include <boost/container/flat_set.hpp>
+
+#include <map>
+#include <set>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace golos { namespace plugins { namespace json_rpc {
+
+    /**
+     * Reflected types which have own to_variant(), json_stream writes them through fc::variant.
+     */
+    template <typename T>
+    struct json_stream_as_variant: std::false_type {
+    };
+
+    template <typename T>
+    struct json_stream_as_variant<fc::safe<T>>: std::true_type {
+    };
+
+    template <>
+    struct json_stream_as_variant<fc::uint128lh_t>: std::true_type {
+    };
+
+    template <>
+    struct json_stream_as_variant<golos::protocol::public_key_type>: std::true_type {
+    };
+
+    template <>
+    struct json_stream_as_variant<golos::protocol::extended_public_key_type>: std::true_type {
+    };
+
+    template <>
+    struct json_stream_as_variant<golos::protocol::extended_private_key_type>: std::true_type {
+    };
+
+    template <>
+    struct json_stream_as_variant<golos::protocol::version>: std::true_type {
+    };
+
+    template <>
+    struct json_stream_as_variant<golos::protocol::hardfork_version>: std::true_type {
+    };
+
+    /**
+     * Writes JSON of API results directly to a string buffer.
+     *
+     * Reflected structs, containers and small integers are written without building of fc::variant tree,
+     * other values (strings, assets, operations, ...) are written through fc::variant,
+     * so the output is the same as of fc::json::to_string(fc::variant(value)).
+     */
+    class json_stream final {
+    public:
+        explicit json_stream(std::string& out)
+            : _out(out) {
+        }
+
+        void write_raw(const std::string& json) {
+            _out.append(json);
+        }
+
+        void write_raw(const char* json) {
+            _out.append(json);
+        }
+
+        template <typename T>
+        void write(const T& value) {
+            write_value(value, value_tag<T>());
+        }
+
+        template <typename T>
+        void write(const fc::optional<T>& value) {
+            if (value.valid()) {
+                write(*value);
+            } else {
+                _out.append("null");
+            }
+        }
+
+        template <typename A, typename B>
+        void write(const std::pair<A, B>& value) {
+            _out.push_back('[');
+            write(value.first);
+            _out.push_back(',');
+            write(value.second);
+            _out.push_back(']');
+        }
+
+        // fc writes vector<char> as hex string
+        void write(const std::vector<char>& value) {
+            write_variant(fc::variant(value));
+        }
+
+        template <typename T, typename A>
+        void write(const std::vector<T, A>& value) {
+            write_array(value);
+        }
+
+        template <typename T, typename C, typename A>
+        void write(const std::set<T, C, A>& value) {
+            write_array(value);
+        }
+
+        template <typename T, typename C, typename A>
+        void write(const boost::container::flat_set<T, C, A>& value) {
+            write_array(value);
+        }
+
+        // fc writes maps as arrays of pairs
+        template <typename K, typename V, typename C, typename A>
+        void write(const std::map<K, V, C, A>& value) {
+            write_array(value);
+        }
+
+        template <typename K, typename V, typename C, typename A>
+        void write(const boost::container::flat_map<K, V, C, A>& value) {
+            write_array(value);
+        }
+
+        template <typename K, typename V, typename H, typename E, typename A>
+        void write(const std::unordered_map<K, V, H, E, A>& value) {
+            write_array(value);
+        }
+
+        void write(const fc::variant& value) {
+            write_variant(value);
+        }
+
+    private:
+        struct variant_tag {};
+        struct bool_tag {};
+        struct integer_tag {};
+        struct object_tag {};
+
+        template <typename T>
+        using is_small_integer = std::integral_constant<bool,
+            std::is_integral<T>::value && !std::is_same<T, bool>::value &&
+            !std::is_same<T, char>::value && sizeof(T) <= sizeof(uint32_t)>;
+
+        template <typename T>
+        using is_object = std::integral_constant<bool,
+            fc::reflector<T>::is_defined::value && !fc::reflector<T>::is_enum::value &&
+            !json_stream_as_variant<T>::value>;
+
+        template <typename T>
+        using value_tag = typename std::conditional<std::is_same<T, bool>::value, bool_tag,
+            typename std::conditional<is_small_integer<T>::value, integer_tag,
+                typename std::conditional<is_object<T>::value, object_tag, variant_tag>::type>::type>::type;
+
+        template <typename T>
+        class member_visitor final {
+        public:
+            member_visitor(json_stream& stream, const T& value)
+                : _stream(stream), _value(value) {
+            }
+
+            template <typename Member, class Class, Member (Class::*member)>
+            void operator()(const char* name) const {
+                add(name, _value.*member);
+            }
+
+        private:
+            // fc skips members with empty optionals
+            template <typename M>
+            void add(const char* name, const fc::optional<M>& value) const {
+                if (value.valid()) {
+                    add(name, *value);
+                }
+            }
+
+            template <typename M>
+            void add(const char* name, const M& value) const {
+                if (!_first) {
+                    _stream._out.push_back(',');
+                }
+                _first = false;
+                _stream._out.push_back('"');
+                _stream._out.append(name);
+                _stream._out.append("\":");
+                _stream.write(value);
+            }
+
+            json_stream& _stream;
+            const T& _value;
+            mutable bool _first = true;
+        };
+
+        template <typename T>
+        void write_value(const T& value, bool_tag) {
+            _out.append(value ? "true" : "false");
+        }
+
+        template <typename T>
+        void write_value(const T& value, integer_tag) {
+            _out.append(std::to_string(value));
+        }
+
+        template <typename T>
+        void write_value(const T& value, object_tag) {
+            _out.push_back('{');
+            fc::reflector<T>::visit(member_visitor<T>(*this, value));
+            _out.push_back('}');
+        }
+
+        template <typename T>
+        void write_value(const T& value, variant_tag) {
+            write_variant(fc::variant(value));
+        }
+
+        template <typename Container>
+        void write_array(const Container& value) {
+            _out.push_back('[');
+            bool first = true;
+            for (const auto& item : value) {
+                if (!first) {
+                    _out.push_back(',');
+                }
+                first = false;
+                write(item);
+            }
+            _out.push_back(']');
+        }
+
+        void write_variant(const fc::variant& value) {
+            _out.append(fc::json::to_string(value));
+        }
+
+        std::string& _out;
+    };
+
+    /**
+     * Returns JSON of value, it is the same as fc::json::to_string(fc::variant(value)).
+     */
+    template <typename T>
+    std::string to_json_string(const T& value) {
+        std::string result;
+        json_stream(result).write(value);
+        return result;
+    }
+
+} } } // golos::plugins::json_rpc
@@ -2,6 +2,8 @@
 
 #include <appbase/application.hpp>
 #include <golos/plugins/json_rpc/utility.hpp>
+#include <golos/plugins/json_rpc/json_stream.hpp>
+#include <golos/plugins/json_rpc/binary_rpc.hpp>
 #include <fc/variant.hpp>
 #include <fc/io/json.hpp>
 #include <fc/reflect/variant.hpp>
@@ -56,6 +58,7 @@
 #define SERVER_MISSING_AUTHORITY     (-32004)   // tx_missing_authority
 #define SERVER_INVALID_OPERATION     (-32005)   // tx_invalid_operation (client must check inner exception)
 #define SERVER_INVALID_TRANSACTION   (-32006)   // transaction_exception
+#define SERVER_OVERLOADED            (-32007)   // too many calls to API, see rpc-api-limit
 
 namespace golos {
     namespace plugins {
@@ -68,8 +71,18 @@ namespace golos {
              * to names.
              *
              * Arguments: Variant object of propert arg type
+             * Returns: result serialized to JSON
              */
-            using api_method = std::function<fc::variant(msg_pack &)>;
+            using api_method = std::function<std::string(msg_pack &)>;
+
+            /**
+             * @brief Internal type used to bind api methods
+             * to ids of binary calls.
+             *
+             * Arguments: the same as of api_method
+             * Returns: result packed by fc::raw
+             */
+            using api_binary_method = std::function<std::vector<char>(msg_pack &)>;
 
             /**
              * @brief An API, containing APIs and Methods
@@ -85,9 +98,27 @@ namespace golos {
                 fc::variant ret;
             };
 
+            /**
+             * State of admission control of API, it is returned by json_rpc.get_api_limits
+             */
+            struct api_limit_state {
+                std::string api;
+                uint32_t concurrency = 0;   ///< maximal number of concurrent calls
+                uint32_t queue_size = 0;    ///< maximal number of waiting calls
+                uint32_t running = 0;
+                uint32_t queued = 0;
+                uint64_t rejected = 0;      ///< number of calls rejected since start
+            };
+
             class plugin final : public appbase::plugin<plugin> {
             public:
-                using response_handler_type = std::function<void (const std::string &)>;
+                // handler can take the response buffer by swapping it.
+                // Notification is a result sent to subscriber, not a response to call, it can be refused by throwing
+                //   websocketpp::exception, then the subscriber is removed.
+                using response_handler_type = std::function<void (std::string &data, bool is_notification)>;
+
+                // runs task, it is used to dispatch calls from batch request concurrently
+                using executor_type = std::function<void (std::function<void ()>)>;
 
                 plugin();
 
@@ -110,9 +141,19 @@ namespace golos {
                 void plugin_shutdown() override;
 
                 void add_api_method(const string &api_name, const string &method_name,
-                                    const api_method &api/*, const api_method_signature& sig */);
+                                    const api_method &api/*, const api_method_signature& sig */,
+                                    const api_binary_method &binary_api = api_binary_method());
+
+                /**
+                 * Calls of batch request are processed by executor, if it is not set, they are processed
+                 * one by one in the current thread.
+                 */
+                void call(const string &body, response_handler_type, executor_type executor = executor_type());
 
-                void call(const string &body, response_handler_type);
+                /**
+                 * Processes binary_rpc_request packed by fc::raw, passes binary_rpc_response packed by fc::raw.
+                 */
+                void call_binary(const string &body, response_handler_type);
 
             private:
                 class impl;
@@ -131,8 +172,11 @@ namespace golos {
                     void operator()(Plugin &plugin, const std::string &method_name, Method method, Args *args,
                                     Ret *ret) {
                         _json_rpc_plugin.add_api_method(_api_name, method_name,
-                                                        [&plugin, method](msg_pack &args) -> fc::variant {
-                                                            return fc::variant((plugin.*method)(args));
+                                                        [&plugin, method](msg_pack &args) -> std::string {
+                                                            return to_json_string((plugin.*method)(args));
+                                                        },
+                                                        [&plugin, method](msg_pack &args) -> std::vector<char> {
+                                                            return pack_binary_result((plugin.*method)(args));
                                                         });
                         /*api_method_signature{ fc::variant( Args() ), fc::variant( Ret() ) }*/ //);
                     }
@@ -147,3 +191,4 @@ namespace golos {
 } // steem::plugins::json_rpc
 
 FC_REFLECT((golos::plugins::json_rpc::api_method_signature), (args)(ret))
+FC_REFLECT((golos::plugins::json_rpc::api_limit_state), (api)(concurrency)(queue_size)(running)(queued)(rejected))
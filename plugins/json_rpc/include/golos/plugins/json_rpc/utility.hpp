@@ -72,8 +72,17 @@ namespace golos { namespace plugins { namespace json_rpc {
                 // Pass result to remote connection
                 void result(fc::optional<fc::variant> result);
 
+                // Pass notification to subscriber, errors of sending are passed to caller, which removes subscriber
                 void unsafe_result(fc::optional<fc::variant> result);
 
+                // Pass result which is already serialized to JSON
+                void json_result(std::string result);
+
+                void unsafe_json_result(std::string result);
+
+                // Pass result which is already packed by fc::raw, it is sent only in response to binary call
+                void raw_result(std::vector<char> result);
+
                 fc::optional<fc::variant> result() const;
 
                 // Pass error to remote connection
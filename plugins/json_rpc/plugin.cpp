@@ -5,6 +5,13 @@
 
 #include <boost/algorithm/string.hpp>
 
+#include <boost/lexical_cast.hpp>
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+
 #include <fc/log/logger_config.hpp>
 #include <fc/exception/exception.hpp>
 #include <thirdparty/fc/vendor/websocketpp/websocketpp/error.hpp>
@@ -31,16 +38,85 @@ namespace golos {
 
             struct json_rpc_response {
                 std::string jsonrpc = "2.0";
-                fc::optional<fc::variant> result;
+                fc::optional<std::string> result;   // serialized to JSON
                 fc::optional<json_rpc_error> error;
                 fc::variant id;
+                fc::optional<std::vector<char>> raw_result;   // packed by fc::raw, only for binary calls
+                bool notification = false;  // result sent to subscriber, isn't serialized
             };
 
+            // writes members in the same order as fc::json::to_string() of reflected struct
+            std::string to_json_string(const json_rpc_response &response) {
+                std::string out;
+                out.reserve((response.result.valid() ? response.result->size() : 0) + 64);
+
+                json_stream stream(out);
+                stream.write_raw("{\"jsonrpc\":");
+                stream.write(response.jsonrpc);
+                if (response.result.valid()) {
+                    stream.write_raw(",\"result\":");
+                    stream.write_raw(*response.result);
+                }
+                if (response.error.valid()) {
+                    const auto &error = *response.error;
+                    stream.write_raw(",\"error\":{\"code\":");
+                    stream.write(error.code);
+                    stream.write_raw(",\"message\":");
+                    stream.write(error.message);
+                    if (error.data.valid()) {
+                        stream.write_raw(",\"data\":");
+                        stream.write(*error.data);
+                    }
+                    stream.write_raw("}");
+                }
+                stream.write_raw(",\"id\":");
+                stream.write(response.id);
+                stream.write_raw("}");
+                return out;
+            }
+
+            std::string to_binary_string(const json_rpc_response &response, const std::string &method) {
+                binary_rpc_response binary;
+                binary.method = method;
+                if (response.id.is_uint64() || response.id.is_int64()) {
+                    binary.id = response.id.as_uint64();
+                }
+                if (response.raw_result.valid()) {
+                    binary.result = response.raw_result;
+                } else if (response.result.valid()) {
+                    binary.json_result = response.result;
+                }
+                if (response.error.valid()) {
+                    binary_rpc_error error;
+                    error.code = response.error->code;
+                    error.message = response.error->message;
+                    if (response.error->data.valid()) {
+                        error.data = fc::json::to_string(*response.error->data);
+                    }
+                    binary.error = std::move(error);
+                }
+
+                auto data = fc::raw::pack(binary);
+                return std::string(data.begin(), data.end());
+            }
+
             struct msg_pack::impl final {
                 using handler_type = std::function<void (json_rpc_response &)>;
 
                 json_rpc_response response;
                 handler_type handler;
+
+                void send_result(fc::optional<fc::variant> result) {
+                    if (result.valid()) {
+                        response.result = fc::json::to_string(*result);
+                    }
+                    handler(response);
+                }
+
+                void send_json_result(std::string result) {
+                    response.result = std::move(result);
+                    handler(response);
+                }
             };
 
             msg_pack::msg_pack() {
@@ -94,14 +170,45 @@ namespace golos {
             void msg_pack::unsafe_result(fc::optional<fc::variant> result) {
                 // Pimpl can absent in case if msg_pack delegated its handlers to other msg_pack (see move constructor)
                 FC_ASSERT(valid(), "The msg_pack delegated its handlers");
-                pimpl->response.result = std::move(result);
-                pimpl->handler(pimpl->response);
+                pimpl->response.notification = true;
+                pimpl->send_result(std::move(result));
+            }
+
+            void msg_pack::unsafe_json_result(std::string result) {
+                // Pimpl can absent in case if msg_pack delegated its handlers to other msg_pack (see move constructor)
+                FC_ASSERT(valid(), "The msg_pack delegated its handlers");
+                pimpl->response.notification = true;
+                pimpl->send_json_result(std::move(result));
+            }
+
+            void msg_pack::raw_result(std::vector<char> result) {
+                // Pimpl can absent in case if msg_pack delegated its handlers to other msg_pack (see move constructor)
+                FC_ASSERT(valid(), "The msg_pack delegated its handlers");
+                pimpl->response.raw_result = std::move(result);
+                try {
+                    pimpl->handler(pimpl->response);
+                } catch (const websocketpp::exception &) {
+                    // Can't send data via socket -
+                    //    don't pass exception to upper level, because it doesn't have handler for exception
+                }
+            }
+
+            void msg_pack::json_result(std::string result) {
+                // Pimpl can absent in case if msg_pack delegated its handlers to other msg_pack (see move constructor)
+                FC_ASSERT(valid(), "The msg_pack delegated its handlers");
+                try {
+                    pimpl->send_json_result(std::move(result));
+                } catch (const websocketpp::exception &) {
+                    // Can't send data via socket -
+                    //    don't pass exception to upper level, because it doesn't have handler for exception
+                }
             }
 
             void msg_pack::result(fc::optional<fc::variant> result) {
                 // Pimpl can absent in case if msg_pack delegated its handlers to other msg_pack (see move constructor)
+                FC_ASSERT(valid(), "The msg_pack delegated its handlers");
                 try {
-                    unsafe_result(std::move(result));
+                    pimpl->send_result(std::move(result));
                 } catch (const websocketpp::exception &) {
                     // Can't send data via socket -
                     //    don't pass exception to upper level, because it doesn't have handler for exception
@@ -110,8 +217,8 @@ namespace golos {
 
             fc::optional<fc::variant> msg_pack::result() const {
                 // Pimpl can absent in case if msg_pack delegated its handlers to other msg_pack (see move constructor)
-                if (valid()) {
-                    return pimpl->response.result;
+                if (valid() && pimpl->response.result.valid()) {
+                    return fc::json::from_string(*pimpl->response.result);
                 }
                 return fc::optional<fc::variant>();
             }
@@ -148,6 +255,28 @@ namespace golos {
 
             class plugin::impl final {
             public:
+                struct api_limit final {
+                    uint32_t concurrency = 0;
+                    uint32_t queue_size = 0;
+
+                    std::mutex mutex;
+                    uint32_t running = 0;
+                    std::deque<std::function<void()>> queue;
+                    uint64_t rejected = 0;
+                };
+
+                // method of binary call, its id is binary_method_id() of name
+                struct binary_method final {
+                    std::string name;
+                    std::string api;
+                    std::string method;
+                    const api_method *call = nullptr;
+                    const api_binary_method *binary_call = nullptr;
+                };
+
+                // passes result of method to msg_pack
+                using call_type = std::function<void (msg_pack &)>;
+
                 impl() {
                 }
 
@@ -155,8 +284,12 @@ namespace golos {
                 }
 
                 void add_api_method(const string &api_name, const string &method_name,
-                                    const api_method &api/*, const api_method_signature& sig*/ ) {
+                                    const api_method &api/*, const api_method_signature& sig*/,
+                                    const api_binary_method &binary_api) {
                     _registered_apis[api_name][method_name] = api;
+                    if (binary_api) {
+                        _registered_binary_apis[api_name][method_name] = binary_api;
+                    }
                     // _method_sigs[ api_name ][ method_name ] = sig;
                     add_method_reindex(api_name, method_name);
                     std::stringstream canonical_name;
@@ -190,11 +323,9 @@ namespace golos {
                         return nullptr;
                     }
 
-                    std::vector<fc::variant> v;
-
-                    if (request["params"].is_array()) {
-                        v = request["params"].as<std::vector<fc::variant> >();
-                    }
+                    static const fc::variants empty_params;
+                    const auto &params = request["params"];
+                    const auto &v = params.is_array() ? params.get_array() : empty_params;
 
                     if (v.size() < 2 || v.size() > 3) {
                         func_args.error(JSON_RPC_INVALID_REQUEST, "A member \"params\" should be [\"api\", \"method\", \"args\"]");
@@ -207,10 +338,13 @@ namespace golos {
 
                     func_args.plugin = v[0].as_string();
                     func_args.method = v[1].as_string();
-                    fc::variant tmp = (v.size() == 3) ? v[2] : fc::json::from_string("[]");
 
                     try {
-                        func_args.args = tmp.as<std::vector<fc::variant>>();
+                        if (v.size() == 3) {
+                            func_args.args = v[2].get_array();
+                        } else {
+                            func_args.args = std::vector<fc::variant>();
+                        }
                     } catch (const fc::bad_cast_exception& e) {
                         func_args.error(JSON_RPC_INVALID_REQUEST, "A member \"args\" should be array", static_cast<const fc::exception&>(e));
                         return nullptr;
@@ -247,11 +381,111 @@ namespace golos {
                         return;
                     }
 
-                    try {
+                    dispatch(json_call(call), msg);
+                }
+
+                static call_type json_call(const api_method *call) {
+                    return [call](msg_pack &msg) {
                         auto result = (*call)(msg);
                         if (msg.valid()) {
-                            msg.result(std::move(result));
+                            msg.json_result(std::move(result));
+                        }
+                    };
+                }
+
+                static call_type binary_call(const api_binary_method *call) {
+                    return [call](msg_pack &msg) {
+                        auto result = (*call)(msg);
+                        if (msg.valid()) {
+                            msg.raw_result(std::move(result));
+                        }
+                    };
+                }
+
+                void rpc_binary(binary_rpc_request &request, msg_pack &msg) {
+                    msg.rpc_id(request.id);
+
+                    auto itr = _binary_methods.find(request.method_id);
+                    if (itr == _binary_methods.end()) {
+                        return msg.error(JSON_RPC_METHOD_NOT_FOUND, "Could not find method with id ${id}",
+                                fc::mutable_variant_object()("id", request.method_id));
+                    }
+
+                    const auto &method = itr->second;
+                    msg.plugin = method.api;
+                    msg.method = method.method;
+                    msg.args = std::move(request.args);
+
+                    // methods registered without binding to their return type pass result as JSON
+                    if (method.binary_call != nullptr) {
+                        dispatch(binary_call(method.binary_call), msg);
+                    } else {
+                        dispatch(json_call(method.call), msg);
+                    }
+                }
+
+                void dispatch(const call_type &call, msg_pack &msg) {
+                    auto limit_itr = _api_limits.find(msg.plugin);
+                    if (limit_itr != _api_limits.end()) {
+                        return call_limited_api(*limit_itr->second, call, msg);
+                    }
+                    call_api(call, msg);
+                }
+
+                void call_limited_api(api_limit &limit, const call_type &call, msg_pack &msg) {
+                    {
+                        std::unique_lock<std::mutex> lock(limit.mutex);
+                        if (limit.running >= limit.concurrency) {
+                            if (limit.queue.size() >= limit.queue_size) {
+                                ++limit.rejected;
+                                lock.unlock();
+                                return msg.error(SERVER_OVERLOADED, "Too many requests to API ${api}, try later",
+                                        fc::mutable_variant_object()("api", msg.plugin));
+                            }
+
+                            // call will be processed by a thread which releases the API
+                            auto deferred = std::make_shared<msg_pack>(std::move(msg));
+                            limit.queue.push_back([this, call, deferred]{
+                                call_guarded_api(call, *deferred);
+                            });
+                            return;
+                        }
+                        ++limit.running;
+                    }
+
+                    // any exception should be caught, otherwise the slot isn't released and queued calls are lost
+                    call_guarded_api(call, msg);
+
+                    for (;;) {
+                        std::function<void()> task;
+                        {
+                            std::unique_lock<std::mutex> lock(limit.mutex);
+                            if (limit.queue.empty()) {
+                                --limit.running;
+                                break;
+                            }
+                            task = std::move(limit.queue.front());
+                            limit.queue.pop_front();
                         }
+                        task();
+                    }
+                }
+
+                void call_guarded_api(const call_type &call, msg_pack &msg) {
+                    try {
+                        call_api(call, msg);
+                    } catch (const fc::exception& e) {
+                        msg.error(JSON_RPC_INTERNAL_ERROR, std::string("Internal error: ") + e.to_string(), e);
+                    } catch (const std::exception& e) {
+                        msg.error(JSON_RPC_INTERNAL_ERROR, std::string("Internal error: ") + e.what());
+                    } catch (...) {
+                        msg.error(JSON_RPC_INTERNAL_ERROR, "Unknown error");
+                    }
+                }
+
+                void call_api(const call_type &call, msg_pack &msg) {
+                    try {
+                        call(msg);
                     } catch (const golos::unsupported_operation& e) {
                         msg.error(SERVER_UNSUPPORTED_OPERATION, e);
 
@@ -343,36 +577,116 @@ namespace golos {
                     }
                 }
 
-                void rpc(vector<fc::variant> messages, response_handler_type response_handler) {
-                    auto responses = std::make_shared<vector<json_rpc_response>>();
+                void rpc(binary_rpc_request &request, msg_pack &msg) {
+                    fc::variant data = fc::mutable_variant_object()("id", request.id)("method_id", request.method_id);
+                    dump_rpc_time dump(data, _log_rpc_calls_slower_msec);
+
+                    try {
+                        rpc_binary(request, msg);
+
+                    } catch (const fc::exception& e) {
+                        msg.error(JSON_RPC_INTERNAL_ERROR, std::string("Internal error: ") + e.to_string(), e);
+                        dump.error("invalid request");
+                    } catch (const std::exception& e) {
+                        msg.error(JSON_RPC_INTERNAL_ERROR, std::string("Internal error: ") + e.what());
+                        dump.error(e.what());
+                    } catch (...) {
+                        msg.error(JSON_RPC_INTERNAL_ERROR, "Unknown error - processing binary rpc message failed");
+                        dump.error("unknown");
+                    }
+                }
+
+                struct batch_state final {
+                    batch_state(fc::variants m, response_handler_type h)
+                        : messages(std::move(m)), responses(messages.size()), handler(std::move(h)) {
+                    }
+
+                    std::mutex mutex;
+                    fc::variants messages;
+                    vector<std::string> responses;
+                    response_handler_type handler;
+                    std::size_t next = 0;
+                    std::size_t completed = 0;
+                };
+
+                using batch_ptr = std::shared_ptr<batch_state>;
 
-                    responses->reserve(messages.size());
+                void rpc(fc::variants messages, response_handler_type response_handler, const executor_type &executor) {
+                    auto batch = std::make_shared<batch_state>(std::move(messages), std::move(response_handler));
 
-                    std::function<void()> next_handler = [response_handler, responses]{
-                        response_handler(fc::json::to_string(*responses.get()));
+                    // members of batch are dispatched concurrently, but no more than _batch_concurrency at once
+                    std::vector<std::size_t> started;
+                    {
+                        std::unique_lock<std::mutex> lock(batch->mutex);
+                        for (; batch->next < batch->messages.size() && batch->next < _batch_concurrency; ++batch->next) {
+                            started.push_back(batch->next);
+                        }
+                    }
+                    for (auto i: started) {
+                        run_batch_member(batch, i, executor);
+                    }
+                }
+
+                void run_batch_member(const batch_ptr &batch, std::size_t i, const executor_type &executor) {
+                    auto task = [this, batch, i, executor]{
+                        msg_pack msg([this, batch, i, executor](json_rpc_response &response){
+                            batch->responses[i] = to_json_string(response);
+                            complete_batch_member(batch, executor);
+                        });
+
+                        this->rpc(batch->messages[i], msg);
                     };
 
-                    for (auto it = messages.rbegin(); messages.rend() != it; ++it) {
-                        auto v = *it;
+                    if (executor) {
+                        executor(std::move(task));
+                    } else {
+                        task();
+                    }
+                }
 
-                        next_handler = [next_handler, responses, v, this]{
-                            msg_pack msg([next_handler, responses](json_rpc_response &response){
-                                responses->push_back(response);
-                                next_handler();
-                            });
+                void complete_batch_member(const batch_ptr &batch, const executor_type &executor) {
+                    auto next = batch->messages.size();
+                    bool done = false;
+                    {
+                        std::unique_lock<std::mutex> lock(batch->mutex);
+                        ++batch->completed;
+                        done = (batch->completed == batch->messages.size());
+                        if (batch->next < batch->messages.size()) {
+                            next = batch->next++;
+                        }
+                    }
 
-                            this->rpc(v, msg);
-                        };
+                    if (next < batch->messages.size()) {
+                        run_batch_member(batch, next, executor);
                     }
 
-                    next_handler();
+                    if (done) {
+                        std::size_t size = 2;
+                        for (const auto &r: batch->responses) {
+                            size += r.size() + 1;
+                        }
+
+                        std::string out;
+                        out.reserve(size);
+                        out.push_back('[');
+                        for (auto &r: batch->responses) {
+                            if (out.size() > 1) {
+                                out.push_back(',');
+                            }
+                            out.append(r);
+                            std::string().swap(r);
+                        }
+                        out.push_back(']');
+                        batch->handler(out, false);
+                    }
                 }
 
-                void call(const string &message, response_handler_type response_handler) {
+                void call(const string &message, response_handler_type response_handler, const executor_type &executor) {
                     auto send_error = [response_handler](int32_t code, const std::string& msg, fc::optional<fc::variant> d = fc::optional<fc::variant>()) {
                         json_rpc_response response;
                         response.error = json_rpc_error(code, msg, d);
-                        response_handler(fc::json::to_string(response));
+                        auto out = to_json_string(response);
+                        response_handler(out, false);
                     };
 
                     try {
@@ -385,15 +699,16 @@ namespace golos {
                         }
 
                         if (v.is_array()) {
-                            vector<fc::variant> messages = v.as<vector<fc::variant>>();
+                            fc::variants messages = std::move(v.get_array());
 
                             if(messages.size() == 0) {
                                 return send_error(JSON_RPC_INVALID_REQUEST, "Array of requests must be non-empty");
                             }
-                            rpc(messages, response_handler);
+                            rpc(std::move(messages), response_handler, executor);
                         } else {
                             msg_pack msg([response_handler](json_rpc_response &response){
-                                    response_handler(fc::json::to_string(response));
+                                    auto out = to_json_string(response);
+                                    response_handler(out, response.notification);
                                     });
 
                             rpc(v, msg);
@@ -403,6 +718,56 @@ namespace golos {
                     }
                 }
 
+                void call_binary(const string &message, response_handler_type response_handler) {
+                    // name of method is echoed in response, so client can check that id addresses the expected method
+                    auto method_name = std::make_shared<std::string>();
+                    msg_pack msg([response_handler, method_name](json_rpc_response &response){
+                        auto out = to_binary_string(response, *method_name);
+                        response_handler(out, response.notification);
+                    });
+
+                    binary_rpc_request request;
+                    try {
+                        request = fc::raw::unpack<binary_rpc_request>(message.data(), message.size());
+                    } catch (const fc::exception& e) {
+                        return msg.error(JSON_RPC_PARSE_ERROR, "Invalid binary request", e);
+                    }
+
+                    auto itr = _binary_methods.find(request.method_id);
+                    if (itr != _binary_methods.end()) {
+                        *method_name = itr->second.name;
+                    }
+
+                    rpc(request, msg);
+                }
+
+                // ids of binary calls are hashes of names, so they don't change with the set of APIs
+                void index_binary_methods() {
+                    _binary_methods.clear();
+                    for (const auto &name: _methods) {
+                        binary_method m;
+                        m.name = name;
+                        auto pos = name.find('.');
+                        m.api = name.substr(0, pos);
+                        m.method = name.substr(pos + 1);
+                        m.call = &_registered_apis[m.api][m.method];
+
+                        auto api_itr = _registered_binary_apis.find(m.api);
+                        if (api_itr != _registered_binary_apis.end()) {
+                            auto method_itr = api_itr->second.find(m.method);
+                            if (method_itr != api_itr->second.end()) {
+                                m.binary_call = &method_itr->second;
+                            }
+                        }
+                        auto id = binary_method_id(name);
+                        auto existing = _binary_methods.find(id);
+                        FC_ASSERT(existing == _binary_methods.end(),
+                            "Binary id ${id} of method ${name} collides with method ${other}",
+                            ("id", id)("name", name)("other", existing->second.name));
+                        _binary_methods.emplace(id, std::move(m));
+                    }
+                }
+
                 void initialize() {
 
                 }
@@ -424,10 +789,34 @@ namespace golos {
                     return _method_reindex[method_name];                        
                 }
 
+                std::vector<api_limit_state> get_api_limits() {
+                    std::vector<api_limit_state> result;
+                    for (auto &l: _api_limits) {
+                        auto &limit = *l.second;
+                        std::unique_lock<std::mutex> lock(limit.mutex);
+
+                        api_limit_state state;
+                        state.api = l.first;
+                        state.concurrency = limit.concurrency;
+                        state.queue_size = limit.queue_size;
+                        state.running = limit.running;
+                        state.queued = limit.queue.size();
+                        state.rejected = limit.rejected;
+                        result.push_back(std::move(state));
+                    }
+                    return result;
+                }
+
+                // filled on initialization, so it is accessed without locking
+                std::map<std::string, std::unique_ptr<api_limit>> _api_limits;
+
                 map<string, api_description> _registered_apis;
+                map<string, map<string, api_binary_method>> _registered_binary_apis;
                 vector<string> _methods;
+                std::map<uint32_t, binary_method> _binary_methods;
                 map<string, map<string, api_method_signature> > _method_sigs;
                 uint64_t _log_rpc_calls_slower_msec = UINT64_MAX;
+                uint32_t _batch_concurrency = 8;
             private:
                 // This is a reindex which allows to get parent plugin by method
                 // unordered_map[method] -> plugin
@@ -448,6 +837,15 @@ namespace golos {
                 cfg.add_options() (
                     "log-rpc-calls-slower-msec", bpo::value<uint64_t>()->default_value(UINT64_MAX),
                     "Maximal milliseconds of RPC call or dump it as too slow. If not set, do not dump"
+                ) (
+                    "rpc-batch-concurrency", bpo::value<uint32_t>()->default_value(8),
+                    "Maximal number of calls from one batch request which are processed concurrently. "
+                    "1 processes calls of batch one by one"
+                ) (
+                    "rpc-api-limit", bpo::value<std::vector<std::string>>()->composing(),
+                    "Limits API as API:CONCURRENCY:QUEUE_SIZE, e.g. social_network:4:64. "
+                    "Calls above concurrency wait in the queue, calls above queue size are rejected. "
+                    "Can be specified multiple times"
                 );
             }
 
@@ -456,12 +854,43 @@ namespace golos {
                 pimpl = std::make_unique<impl>();
                 pimpl->initialize();
                 pimpl->_log_rpc_calls_slower_msec = options.at("log-rpc-calls-slower-msec").as<uint64_t>();
+                pimpl->_batch_concurrency = options.at("rpc-batch-concurrency").as<uint32_t>();
+                GOLOS_CHECK_OPTION(pimpl->_batch_concurrency > 0, "rpc-batch-concurrency should be positive");
+
+                if (options.count("rpc-api-limit")) {
+                    for (const auto &value: options.at("rpc-api-limit").as<std::vector<std::string>>()) {
+                        std::vector<std::string> parts;
+                        boost::split(parts, value, boost::is_any_of(":"));
+                        GOLOS_CHECK_OPTION(parts.size() == 3, "rpc-api-limit should be API:CONCURRENCY:QUEUE_SIZE");
+
+                        auto limit = std::make_unique<impl::api_limit>();
+                        limit->concurrency = boost::lexical_cast<uint32_t>(parts[1]);
+                        limit->queue_size = boost::lexical_cast<uint32_t>(parts[2]);
+                        GOLOS_CHECK_OPTION(limit->concurrency > 0, "Concurrency of rpc-api-limit should be positive");
+
+                        ilog("json_rpc: ${api} is limited by ${c} concurrent calls and ${q} queued calls",
+                            ("api", parts[0])("c", limit->concurrency)("q", limit->queue_size));
+                        pimpl->_api_limits[parts[0]] = std::move(limit);
+                    }
+                }
+
+                pimpl->add_api_method(name(), "get_api_limits", [this](msg_pack &) -> std::string {
+                    return to_json_string(pimpl->get_api_limits());
+                }, [this](msg_pack &) -> std::vector<char> {
+                    return fc::raw::pack(pimpl->get_api_limits());
+                });
+                pimpl->add_api_method(name(), "get_methods", [this](msg_pack &) -> std::string {
+                    return to_json_string(pimpl->_methods);
+                }, [this](msg_pack &) -> std::vector<char> {
+                    return fc::raw::pack(pimpl->_methods);
+                });
                 ilog("json_rpc plugin: plugin_initialize() end");
             }
 
             void plugin::plugin_startup() {
                 ilog("json_rpc plugin: plugin_startup() begin");
                 std::sort(pimpl->_methods.begin(), pimpl->_methods.end());
+                pimpl->index_binary_methods();
                 ilog("json_rpc plugin: plugin_startup() end");
             }
 
@@ -472,16 +901,20 @@ namespace golos {
             }
 
             void plugin::add_api_method(const string &api_name, const string &method_name,
-                                        const api_method &api/*, const api_method_signature& sig */) {
-                pimpl->add_api_method(api_name, method_name, api/*, sig*/ );
+                                        const api_method &api/*, const api_method_signature& sig */,
+                                        const api_binary_method &binary_api) {
+                pimpl->add_api_method(api_name, method_name, api/*, sig*/, binary_api);
+            }
+
+            void plugin::call(const string &message, response_handler_type response_handler, executor_type executor) {
+                pimpl->call(message, response_handler, executor);
             }
 
-            void plugin::call(const string &message, response_handler_type response_handler) {
-                pimpl->call(message, response_handler);
+            void plugin::call_binary(const string &message, response_handler_type response_handler) {
+                pimpl->call_binary(message, response_handler);
             }
         }
     }
 } // golos::plugins::json_rpc
 
 FC_REFLECT((golos::plugins::json_rpc::json_rpc_error), (code)(message)(data))
-FC_REFLECT((golos::plugins::json_rpc::json_rpc_response), (jsonrpc)(result)(error)(id))
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <golos/chain/database.hpp>
+#include <golos/chain/steem_objects.hpp>
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace golos { namespace plugins { namespace market_history {
+
+    using golos::chain::database;
+    using golos::chain::limit_order_object;
+    using golos::protocol::asset;
+    using golos::protocol::asset_symbol_type;
+    using golos::protocol::block_id_type;
+    using golos::protocol::price;
+    using golos::protocol::share_type;
+    using golos::protocol::signed_block;
+
+    /**
+     * Open orders of side with the same price, in the order of their ids
+     */
+    struct depth_price_level final {
+        std::vector<limit_order_object> orders;
+        share_type total;   ///< sum of for_sale of orders
+    };
+
+    using depth_price_level_ptr = std::shared_ptr<const depth_price_level>;
+
+    /**
+     * Open orders which sell base asset for quote asset, grouped by price.
+     * Levels are immutable, block copies only the levels it changes, and the side keeps pointers to them.
+     */
+    struct depth_side final {
+        // the same order as of by_price index of limit_order_index: the best price goes first
+        using levels_type = std::map<price, depth_price_level_ptr, std::greater<price>>;
+
+        levels_type levels;
+        share_type total;   ///< sum of for_sale of orders
+
+        /**
+         * Calls visit for orders from the best price, till it returns false
+         */
+        template <typename Visitor>
+        void for_each_order(Visitor&& visit) const {
+            for (const auto& l : levels) {
+                for (const auto& o : l.second->orders) {
+                    if (!visit(o)) {
+                        return;
+                    }
+                }
+            }
+        }
+    };
+
+    using depth_side_ptr = std::shared_ptr<const depth_side>;
+
+    /**
+     * Immutable copy of open orders after applying of block, sides which aren't changed by block are shared
+     *   with the book of the previous block.
+     */
+    struct depth_book final {
+        uint32_t block_num = 0;
+        block_id_type block_id;
+        std::map<std::pair<asset_symbol_type, asset_symbol_type>, depth_side_ptr> sides; ///< by (base, quote)
+
+        const depth_side* find(asset_symbol_type base, asset_symbol_type quote) const {
+            auto itr = sides.find(std::make_pair(base, quote));
+            return itr != sides.end() ? itr->second.get() : nullptr;
+        }
+    };
+
+    using depth_book_ptr = std::shared_ptr<const depth_book>;
+
+    /**
+     * Orders of side with the same price
+     */
+    struct depth_level {
+        price sell_price;
+        asset for_sale;         ///< 0 if there are no more orders with the price
+        uint32_t orders = 0;
+    };
+
+    /**
+     * Price levels changed by block. If reset is set, levels are absent and book should be requested again.
+     */
+    struct market_depth_diff {
+        uint32_t block_num = 0;
+        bool reset = false;
+        std::vector<depth_level> levels;
+    };
+
+    /**
+     * Keeps book of open orders, which is updated after each block by changes of limit_order_index
+     *   from the undo session of block, and is read by API threads without lock of database.
+     *
+     * Book is rebuilt from limit_order_index if block doesn't follow the previous one (fork switch)
+     *   or it is applied without undo session. Book is absent on reindex, API reads database then.
+     */
+    class market_depth_cache final {
+    public:
+        /**
+         * Should be called by the thread which applies block, when the undo session contains all changes of block.
+         * Fills diff if it isn't nullptr.
+         */
+        void update(const database& db, const signed_block& block, market_depth_diff* diff);
+
+        /**
+         * Returns nullptr if book isn't built yet
+         */
+        depth_book_ptr get() const {
+            return std::atomic_load(&_book);
+        }
+
+        void reset() {
+            std::atomic_store(&_book, depth_book_ptr());
+        }
+
+    private:
+        depth_book_ptr build(const database& db) const;
+
+        depth_book_ptr _book;
+    };
+
+} } } // golos::plugins::market_history
+
+FC_REFLECT((golos::plugins::market_history::depth_level), (sell_price)(for_sale)(orders))
+FC_REFLECT((golos::plugins::market_history::market_depth_diff), (block_num)(reset)(levels))
@@ -46,6 +46,7 @@ namespace golos {
             DEFINE_API_ARGS(get_open_orders,            json_rpc::msg_pack, std::vector<limit_order>)
             DEFINE_API_ARGS(get_orders,                 json_rpc::msg_pack, std::vector<limit_order>)
             DEFINE_API_ARGS(subscribe_to_market,        json_rpc::msg_pack, void_type)
+            DEFINE_API_ARGS(subscribe_to_market_depth,  json_rpc::msg_pack, void_type)
 
             class market_history_plugin : public appbase::plugin<market_history_plugin> {
             public:
@@ -83,6 +84,7 @@ namespace golos {
                     (get_open_orders)
                     (get_orders)
                     (subscribe_to_market)
+                    (subscribe_to_market_depth)
                 )
 
                 constexpr const static char *plugin_name = "market_history";
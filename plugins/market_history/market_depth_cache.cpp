@@ -0,0 +1,170 @@
+#include <golos/plugins/market_history/market_depth_cache.hpp>
+
+#include <algorithm>
+
+namespace golos { namespace plugins { namespace market_history {
+
+    using golos::chain::limit_order_index;
+    using golos::chain::by_price;
+
+    namespace {
+
+        using side_key = std::pair<asset_symbol_type, asset_symbol_type>;
+
+        side_key get_side_key(const limit_order_object& o) {
+            return std::make_pair(o.sell_price.base.symbol, o.sell_price.quote.symbol);
+        }
+
+        bool id_less(const limit_order_object& o, limit_order_object::id_type id) {
+            return o.id < id;
+        }
+
+    } // anonymous namespace
+
+    depth_book_ptr market_depth_cache::build(const database& db) const {
+        auto book = std::make_shared<depth_book>();
+        book->block_num = db.head_block_num();
+        book->block_id = db.head_block_id();
+
+        std::shared_ptr<depth_side> side;
+        std::shared_ptr<depth_price_level> level;
+        side_key key;
+        for (const auto& o : db.get_index<limit_order_index, by_price>()) {
+            if (!side || get_side_key(o) != key) {
+                key = get_side_key(o);
+                side = std::make_shared<depth_side>();
+                level.reset();
+                book->sides.emplace(key, side);
+            }
+            // orders go in the order of side and level, so each of them is added at the end
+            if (!level || level->orders.back().sell_price != o.sell_price) {
+                level = std::make_shared<depth_price_level>();
+                side->levels.emplace_hint(side->levels.end(), o.sell_price, level);
+            }
+            level->orders.push_back(o);
+            level->total += o.for_sale;
+            side->total += o.for_sale;
+        }
+        return book;
+    }
+
+    void market_depth_cache::update(const database& db, const signed_block& block, market_depth_diff* diff) {
+        if (db.is_reindexing()) {
+            reset();
+            return;
+        }
+
+        if (diff) {
+            diff->block_num = block.block_num();
+        }
+
+        auto prev = get();
+        const auto& stack = db.get_index<limit_order_index>().stack();
+        bool has_session = !stack.empty() && stack.back().revision == db.revision();
+        if (!prev || prev->block_id != block.previous || !has_session) {
+            std::atomic_store(&_book, build(db));
+            if (diff) {
+                diff->reset = true;
+            }
+            return;
+        }
+
+        const auto& undo = stack.back();
+        if (undo.new_ids.empty() && undo.old_values.empty() && undo.removed_values.empty()) {
+            auto book = std::make_shared<depth_book>(*prev);
+            book->block_num = db.head_block_num();
+            book->block_id = db.head_block_id();
+            std::atomic_store(&_book, depth_book_ptr(std::move(book)));
+            return;
+        }
+
+        // changed sides and levels are copied once per block, side shares pointers to its unchanged levels
+        std::map<side_key, std::shared_ptr<depth_side>> changed_sides;
+        std::map<std::pair<side_key, price>, std::shared_ptr<depth_price_level>> changed_levels;
+
+        auto get_side = [&](const side_key& key) -> depth_side& {
+            auto itr = changed_sides.find(key);
+            if (itr == changed_sides.end()) {
+                auto old = prev->find(key.first, key.second);
+                auto side = old ? std::make_shared<depth_side>(*old) : std::make_shared<depth_side>();
+                itr = changed_sides.emplace(key, std::move(side)).first;
+            }
+            return *itr->second;
+        };
+        auto get_level = [&](const limit_order_object& o) -> depth_price_level& {
+            auto key = std::make_pair(get_side_key(o), o.sell_price);
+            auto itr = changed_levels.find(key);
+            if (itr == changed_levels.end()) {
+                const auto& side = get_side(key.first);
+                auto old = side.levels.find(o.sell_price);
+                auto level = old != side.levels.end()
+                    ? std::make_shared<depth_price_level>(*old->second)
+                    : std::make_shared<depth_price_level>();
+                itr = changed_levels.emplace(key, std::move(level)).first;
+            }
+            return *itr->second;
+        };
+
+        auto add = [&](const limit_order_object& o) {
+            auto& level = get_level(o);
+            auto itr = std::lower_bound(level.orders.begin(), level.orders.end(), o.id, id_less);
+            level.orders.insert(itr, o);
+            level.total += o.for_sale;
+            get_side(get_side_key(o)).total += o.for_sale;
+        };
+        auto remove = [&](const limit_order_object& o) {
+            auto& level = get_level(o);
+            auto itr = std::lower_bound(level.orders.begin(), level.orders.end(), o.id, id_less);
+            if (itr != level.orders.end() && itr->id == o.id) {
+                level.orders.erase(itr);
+            }
+            level.total -= o.for_sale;
+            get_side(get_side_key(o)).total -= o.for_sale;
+        };
+
+        // undo session has values of objects at the start of block
+        for (const auto& item : undo.old_values) {
+            remove(item.second);
+            add(db.get<limit_order_object>(item.first));
+        }
+        for (const auto& item : undo.removed_values) {
+            remove(item.second);
+        }
+        for (const auto& id : undo.new_ids) {
+            add(db.get<limit_order_object>(id));
+        }
+
+        for (auto& item : changed_levels) {
+            const auto& l = *item.second;
+            if (diff) {
+                depth_level level;
+                level.sell_price = item.first.second;
+                level.for_sale = asset(l.total, item.first.second.base.symbol);
+                level.orders = l.orders.size();
+                diff->levels.push_back(level);
+            }
+
+            auto& side = *changed_sides[item.first.first];
+            if (l.orders.empty()) {
+                side.levels.erase(item.first.second);
+            } else {
+                side.levels[item.first.second] = std::move(item.second);
+            }
+        }
+
+        auto book = std::make_shared<depth_book>();
+        book->block_num = db.head_block_num();
+        book->block_id = db.head_block_id();
+        book->sides = prev->sides;
+        for (auto& item : changed_sides) {
+            if (item.second->levels.empty()) {
+                book->sides.erase(item.first);
+            } else {
+                book->sides[item.first] = std::move(item.second);
+            }
+        }
+
+        std::atomic_store(&_book, depth_book_ptr(std::move(book)));
+    }
+
+} } } // golos::plugins::market_history
@@ -1,5 +1,6 @@
 #include <golos/plugins/market_history/market_history_plugin.hpp>
 #include <golos/plugins/market_history/market_history_visitor.hpp>
+#include <golos/plugins/market_history/market_depth_cache.hpp>
 #include <golos/plugins/json_rpc/api_helper.hpp>
 
 #include <golos/chain/index.hpp>
@@ -29,6 +30,9 @@ namespace golos {
             using market_callback_info = callback_info<const callback_arg&>;
             using market_callback = market_callback_info::callback_t;
 
+            using depth_callback_info = callback_info<const market_depth_diff&>;
+            using depth_callback = depth_callback_info::callback_t;
+
             class market_history_plugin::market_history_plugin_impl {
             public:
                 market_history_plugin_impl(market_history_plugin &plugin)
@@ -51,6 +55,59 @@ namespace golos {
                     }
                 }
 
+                void on_block_changes(const signed_block& block) {
+                    try {
+                        bool notify = !depth_diff_signal.empty();
+                        market_depth_diff diff;
+                        _depth_cache.update(_db, block, notify ? &diff : nullptr);
+                        if (notify && (diff.reset || !diff.levels.empty())) {
+                            depth_diff_signal(diff);
+                        }
+                    } catch (const fc::exception& e) {
+                        // API reads database until the book is rebuilt on the next block
+                        _depth_cache.reset();
+                        edump((e.to_detail_string()));
+                    }
+                }
+
+                // book of the last applied block, or nullptr if it is disabled or not built yet
+                depth_book_ptr depth_book() const {
+                    return _depth_cache.get();
+                }
+
+                // calls f without lock of database if book is built, otherwise reads database under weak read lock
+                template <typename F>
+                auto with_depth_book(F&& f) const {
+                    auto book = depth_book();
+                    if (book) {
+                        return f(book);
+                    }
+                    return _db.with_weak_read_lock([&]() {
+                        return f(book);
+                    });
+                }
+
+                // calls visit for orders which sell base for quote, from the best price, till it returns false
+                template <typename Visitor>
+                void for_each_order(const depth_book_ptr& book, asset_symbol_type base, asset_symbol_type quote, Visitor&& visit) const {
+                    if (book) {
+                        auto side = book->find(base, quote);
+                        if (side) {
+                            side->for_each_order(visit);
+                        }
+                        return;
+                    }
+
+                    const auto& order_idx = _db.get_index<golos::chain::limit_order_index, golos::chain::by_price>();
+                    for (auto itr = order_idx.lower_bound(price::max(base, quote));
+                        itr != order_idx.end() &&
+                        itr->sell_price.base.symbol == base &&
+                        itr->sell_price.quote.symbol == quote &&
+                        visit(*itr); ++itr
+                    ) {
+                    }
+                }
+
                 symbol_type_pair get_symbol_type_pair(asset asset1, asset asset2, bool* pair_reversed = nullptr) const;
                 symbol_type_pair get_symbol_type_pair(const symbol_name_pair& pair, bool* pair_reversed = nullptr, bool allow_partial = false) const;
                 void reverse_price(double& price) const;
@@ -58,9 +115,9 @@ namespace golos {
                 market_ticker get_ticker(const symbol_name_pair& pair, uint32_t bucket = 86400, uint32_t bucket_count = 1) const;
                 market_ticker get_ticker_impl(const symbol_type_pair& pair, uint32_t bucket = 86400, uint32_t bucket_count = 1) const;
                 market_volume get_volume(const symbol_type_pair& pair, uint32_t bucket = 86400, uint32_t bucket_count = 1) const;
-                market_depth get_depth(const symbol_type_pair& pair) const;
-                order_book get_order_book(const symbol_type_pair& pair, uint32_t limit) const;
-                order_book_extended get_order_book_extended(const symbol_type_pair& pair, uint32_t limit) const;
+                market_depth get_depth(const depth_book_ptr& book, const symbol_type_pair& pair) const;
+                order_book get_order_book(const depth_book_ptr& book, const symbol_type_pair& pair, uint32_t limit) const;
+                order_book_extended get_order_book_extended(const depth_book_ptr& book, const symbol_type_pair& pair, uint32_t limit) const;
                 vector<market_trade> get_trade_history(const symbol_type_pair& pair, fc::optional<time_point_sec> start, fc::optional<time_point_sec> end, uint32_t limit) const;
                 vector<market_trade> get_recent_trades(const symbol_type_pair& pair, uint32_t limit) const;
                 vector<bucket_object> get_market_history(const symbol_type_pair& pair, uint32_t bucket_seconds, time_point_sec start, time_point_sec end) const;
@@ -70,6 +127,8 @@ namespace golos {
 
                 void subscribe_to_market(market_callback cb);
 
+                void subscribe_to_market_depth(depth_callback cb);
+
                 void update_market_histories(const golos::chain::operation_notification &o);
 
                 golos::chain::database &database() const {
@@ -85,6 +144,12 @@ namespace golos {
 
                 market_callback_info::cont active_market_callback;
                 market_callback_info::cont free_market_callback;
+
+                bool _depth_cache_enabled = true;
+                market_depth_cache _depth_cache;
+                boost::signals2::signal<void(const market_depth_diff&)> depth_diff_signal;
+                depth_callback_info::cont active_depth_callback;
+                depth_callback_info::cont free_depth_callback;
             };
 
             void market_history_plugin::market_history_plugin_impl::update_market_histories(const operation_notification &o) {
@@ -284,7 +349,8 @@ namespace golos {
                     result.percent_change2 = 0;
                 }
 
-                auto orders = get_order_book(pair, 1);
+                auto book = depth_book();
+                auto orders = get_order_book(book, pair, 1);
                 if (orders.bids.size()) {
                     result.highest_bid = orders.bids[0].price;
                 }
@@ -296,7 +362,7 @@ namespace golos {
                 result.asset1_volume = volume.asset1_volume;
                 result.asset2_volume = volume.asset2_volume;
 
-                auto depth = get_depth(pair);
+                auto depth = get_depth(book, pair);
                 result.asset1_depth = depth.asset1_depth;
                 result.asset2_depth = depth.asset2_depth;
 
@@ -325,109 +391,98 @@ namespace golos {
                 return result;
             }
 
-            market_depth market_history_plugin::market_history_plugin_impl::get_depth(const symbol_type_pair& pair) const {
+            market_depth market_history_plugin::market_history_plugin_impl::get_depth(const depth_book_ptr& book, const symbol_type_pair& pair) const {
                 market_depth result;
                 result.asset1_depth = asset(0, pair.first);
                 result.asset2_depth = asset(0, pair.second);
 
-                const auto& order_idx = _db.get_index<golos::chain::limit_order_index, golos::chain::by_price>();
-                auto itr = order_idx.lower_bound(price::max(pair.second, pair.first));
-
-                while (itr != order_idx.end() &&
-                       itr->sell_price.base.symbol == pair.second &&
-                       itr->sell_price.quote.symbol == pair.first) {
-                    result.asset2_depth += itr->amount_for_sale();
-                    ++itr;
+                if (book) {
+                    auto bids = book->find(pair.second, pair.first);
+                    if (bids) {
+                        result.asset2_depth.amount = bids->total;
+                    }
+                    auto asks = book->find(pair.first, pair.second);
+                    if (asks) {
+                        result.asset1_depth.amount = asks->total;
+                    }
+                    return result;
                 }
 
-                itr = order_idx.lower_bound(price::max(pair.first, pair.second));
-
-                while (itr != order_idx.end() &&
-                       itr->sell_price.base.symbol == pair.first &&
-                       itr->sell_price.quote.symbol == pair.second) {
-                    result.asset1_depth += itr->amount_for_sale();
-                    ++itr;
-                }
+                for_each_order(book, pair.second, pair.first, [&](const limit_order_object& o) {
+                    result.asset2_depth += o.amount_for_sale();
+                    return true;
+                });
+                for_each_order(book, pair.first, pair.second, [&](const limit_order_object& o) {
+                    result.asset1_depth += o.amount_for_sale();
+                    return true;
+                });
                 return result;
             }
 
-            order_book market_history_plugin::market_history_plugin_impl::get_order_book(const symbol_type_pair& pair, uint32_t limit) const {
-                const auto& order_idx = _db.get_index<golos::chain::limit_order_index, golos::chain::by_price>();
-                auto itr = order_idx.lower_bound(price::max(pair.second, pair.first));
-
+            order_book market_history_plugin::market_history_plugin_impl::get_order_book(const depth_book_ptr& book, const symbol_type_pair& pair, uint32_t limit) const {
                 order_book result;
 
-                while (itr != order_idx.end() &&
-                       itr->sell_price.base.symbol == pair.second &&
-                       itr->sell_price.quote.symbol == pair.first &&
-                       result.bids.size() < limit) {
+                for_each_order(book, pair.second, pair.first, [&](const limit_order_object& o) {
+                    if (result.bids.size() >= limit) {
+                        return false;
+                    }
                     order cur;
-                    cur.price = itr->sell_price.base.to_real() / itr->sell_price.quote.to_real();
-                    cur.asset1 = (asset(itr->for_sale, pair.second) * itr->sell_price).amount;
-                    cur.asset2 = itr->for_sale;
+                    cur.price = o.sell_price.base.to_real() / o.sell_price.quote.to_real();
+                    cur.asset1 = (asset(o.for_sale, pair.second) * o.sell_price).amount;
+                    cur.asset2 = o.for_sale;
                     result.bids.push_back(cur);
-                    ++itr;
-                }
-
-                itr = order_idx.lower_bound(price::max(pair.first, pair.second));
+                    return true;
+                });
 
-                while (itr != order_idx.end() &&
-                       itr->sell_price.base.symbol == pair.first &&
-                       itr->sell_price.quote.symbol == pair.second &&
-                       result.asks.size() < limit) {
+                for_each_order(book, pair.first, pair.second, [&](const limit_order_object& o) {
+                    if (result.asks.size() >= limit) {
+                        return false;
+                    }
                     order cur;
-                    cur.price = itr->sell_price.quote.to_real() / itr->sell_price.base.to_real();
-                    cur.asset1 = itr->for_sale;
-                    cur.asset2 = (asset(itr->for_sale, pair.first) * itr->sell_price).amount;
+                    cur.price = o.sell_price.quote.to_real() / o.sell_price.base.to_real();
+                    cur.asset1 = o.for_sale;
+                    cur.asset2 = (asset(o.for_sale, pair.first) * o.sell_price).amount;
                     result.asks.push_back(cur);
-                    ++itr;
-                }
+                    return true;
+                });
 
                 return result;
             }
 
-            order_book_extended market_history_plugin::market_history_plugin_impl::get_order_book_extended(const symbol_type_pair& pair, uint32_t limit) const {
+            order_book_extended market_history_plugin::market_history_plugin_impl::get_order_book_extended(const depth_book_ptr& book, const symbol_type_pair& pair, uint32_t limit) const {
                 order_book_extended result;
 
-                auto max_sell = price::max(pair.second, pair.first);
-                auto max_buy = price::max(pair.first, pair.second);
-                const auto& limit_price_idx = _db.get_index<golos::chain::limit_order_index, golos::chain::by_price>();
-                auto sell_itr = limit_price_idx.lower_bound(max_sell);
-                auto buy_itr = limit_price_idx.lower_bound(max_buy);
-                auto end = limit_price_idx.end();
-
-                while (sell_itr != end &&
-                       sell_itr->sell_price.base.symbol == pair.second &&
-                       sell_itr->sell_price.quote.symbol == pair.first &&
-                       result.bids.size() < limit) {
-                    auto itr = sell_itr;
+                for_each_order(book, pair.second, pair.first, [&](const limit_order_object& o) {
+                    if (result.bids.size() >= limit) {
+                        return false;
+                    }
                     order_extended cur;
-                    cur.orderid = itr->orderid;
-                    cur.order_price = itr->sell_price;
+                    cur.orderid = o.orderid;
+                    cur.order_price = o.sell_price;
                     cur.real_price = (cur.order_price).to_real();
-                    cur.asset2 = itr->for_sale;
-                    cur.asset1 = (asset(itr->for_sale, pair.second) * cur.order_price).amount;
-                    cur.created = itr->created;
-                    cur.seller = itr->seller;
+                    cur.asset2 = o.for_sale;
+                    cur.asset1 = (asset(o.for_sale, pair.second) * cur.order_price).amount;
+                    cur.created = o.created;
+                    cur.seller = o.seller;
                     result.bids.push_back(cur);
-                    ++sell_itr;
-                }
-                while (buy_itr != end &&
-                       buy_itr->sell_price.base.symbol == pair.first &&
-                       buy_itr->sell_price.quote.symbol == pair.second &&
-                       result.asks.size() < limit) {
-                    auto itr = buy_itr;
+                    return true;
+                });
+
+                for_each_order(book, pair.first, pair.second, [&](const limit_order_object& o) {
+                    if (result.asks.size() >= limit) {
+                        return false;
+                    }
                     order_extended cur;
-                    cur.orderid = itr->orderid;
-                    cur.order_price = itr->sell_price;
+                    cur.orderid = o.orderid;
+                    cur.order_price = o.sell_price;
                     cur.real_price = (~cur.order_price).to_real();
-                    cur.asset1 = itr->for_sale;
-                    cur.asset2 = (asset(itr->for_sale, pair.first) * cur.order_price).amount;
-                    cur.created = itr->created;
-                    cur.seller = itr->seller;
+                    cur.asset1 = o.for_sale;
+                    cur.asset2 = (asset(o.for_sale, pair.first) * cur.order_price).amount;
+                    cur.created = o.created;
+                    cur.seller = o.seller;
                     result.asks.push_back(cur);
-                    ++buy_itr;
-                }
+                    return true;
+                });
 
                 return result;
             }
@@ -602,6 +657,13 @@ namespace golos {
                 info_ptr->connect(_my.create_order_signal, free_market_callback, cb);
             }
 
+            void market_history_plugin::market_history_plugin_impl::subscribe_to_market_depth(depth_callback cb) {
+                auto info_ptr = std::make_shared<depth_callback_info>();
+                active_depth_callback.push_back(info_ptr);
+                info_ptr->it = std::prev(active_depth_callback.end());
+                info_ptr->connect(depth_diff_signal, free_depth_callback, cb);
+            }
+
             market_history_plugin::market_history_plugin() {
             }
 
@@ -618,7 +680,10 @@ namespace golos {
                          "Track market history by grouping orders into buckets of equal size measured in seconds specified as a JSON array of numbers")
                         ("market-history-buckets-per-size",
                          boost::program_options::value<uint32_t>()->default_value(5760),
-                         "How far back in time to track history for each bucket size, measured in the number of buckets (default: 5760)");
+                         "How far back in time to track history for each bucket size, measured in the number of buckets (default: 5760)")
+                        ("market-history-depth-cache",
+                         boost::program_options::value<bool>()->default_value(true),
+                         "Keep open orders of the last block in memory for order book APIs, they read database if it is disabled");
             }
 
             void market_history_plugin::plugin_initialize(const boost::program_options::variables_map &options) {
@@ -634,6 +699,15 @@ namespace golos {
                     golos::chain::add_plugin_index<bucket_index>(db);
                     golos::chain::add_plugin_index<order_history_index>(db);
 
+                    if (options.count("market-history-depth-cache")) {
+                        _my->_depth_cache_enabled = options.at("market-history-depth-cache").as<bool>();
+                    }
+                    if (_my->_depth_cache_enabled) {
+                        db.applied_block_changes.connect([&](const signed_block& b) {
+                            _my->on_block_changes(b);
+                        });
+                    }
+
                     if (options.count("market-history-bucket-size")) {
                         std::string buckets = options["market-history-bucket-size"].as<string>();
                         _my->_tracked_buckets = fc::json::from_string(buckets).as<flat_set<uint32_t>>();
@@ -690,6 +764,25 @@ namespace golos {
                 return {};
             }
 
+            DEFINE_API(market_history_plugin, subscribe_to_market_depth) {
+                PLUGIN_API_VALIDATE_ARGS();
+                GOLOS_ASSERT(_my->_depth_cache_enabled, golos::unsupported_operation,
+                    "Depth diffs aren't available, market-history-depth-cache is disabled");
+
+                msg_pack_transfer transfer(args);
+
+                auto& _db = _my->database();
+                _db.with_weak_read_lock([&]{
+                    _my->subscribe_to_market_depth([msg = transfer.msg()](const market_depth_diff& diff) {
+                        msg->unsafe_result(fc::variant(diff));
+                    });
+                });
+
+                transfer.complete();
+
+                return {};
+            }
+
             DEFINE_API(market_history_plugin, get_ticker) {
                 PLUGIN_API_VALIDATE_ARGS(
                     (symbol_name_pair, pair, symbol_name_pair("GOLOS", "GBG"))
@@ -803,14 +896,17 @@ namespace golos {
                     (symbol_name_pair, pair, symbol_name_pair("GOLOS", "GBG"))
                 );
                 auto &db = _my->database();
-                return db.with_weak_read_lock([&]() {
-                    bool reversed;
-                    auto res = _my->get_depth(_my->get_symbol_type_pair(pair, &reversed));
-                    if (reversed) {
-                        std::swap(res.asset1_depth, res.asset2_depth);
-                    }
-                    return res;
+                bool reversed;
+                auto type_pair = db.with_weak_read_lock([&]() {
+                    return _my->get_symbol_type_pair(pair, &reversed);
+                });
+                auto res = _my->with_depth_book([&](const depth_book_ptr& book) {
+                    return _my->get_depth(book, type_pair);
                 });
+                if (reversed) {
+                    std::swap(res.asset1_depth, res.asset2_depth);
+                }
+                return res;
             }
 
             DEFINE_API(market_history_plugin, get_order_book) {
@@ -821,22 +917,25 @@ namespace golos {
                 GOLOS_CHECK_LIMIT_PARAM(limit, 500);
 
                 auto &db = _my->database();
-                return db.with_weak_read_lock([&]() {
-                    bool reversed;
-                    auto res = _my->get_order_book(_my->get_symbol_type_pair(pair, &reversed), limit);
-                    if (reversed) {
-                        std::swap(res.bids, res.asks);
-                        for (auto& order : res.bids) {
-                            std::swap(order.asset1, order.asset2);
-                            _my->reverse_price(order.price);
-                        }
-                        for (auto& order : res.asks) {
-                            std::swap(order.asset1, order.asset2);
-                            _my->reverse_price(order.price);
-                        }
-                    }
-                    return res;
+                bool reversed;
+                auto type_pair = db.with_weak_read_lock([&]() {
+                    return _my->get_symbol_type_pair(pair, &reversed);
+                });
+                auto res = _my->with_depth_book([&](const depth_book_ptr& book) {
+                    return _my->get_order_book(book, type_pair, limit);
                 });
+                if (reversed) {
+                    std::swap(res.bids, res.asks);
+                    for (auto& order : res.bids) {
+                        std::swap(order.asset1, order.asset2);
+                        _my->reverse_price(order.price);
+                    }
+                    for (auto& order : res.asks) {
+                        std::swap(order.asset1, order.asset2);
+                        _my->reverse_price(order.price);
+                    }
+                }
+                return res;
             }
 
             DEFINE_API(market_history_plugin, get_order_book_extended) {
@@ -847,24 +946,27 @@ namespace golos {
                 GOLOS_CHECK_LIMIT_PARAM(limit, 1000);
 
                 auto &db = _my->database();
-                return db.with_weak_read_lock([&]() {
-                    bool reversed;
-                    auto res = _my->get_order_book_extended(_my->get_symbol_type_pair(pair, &reversed), limit);
-                    if (reversed) {
-                        std::swap(res.bids, res.asks);
-                        for (auto& order : res.bids) {
-                            std::swap(order.asset1, order.asset2);
-                            _my->reverse_price(order.real_price);
-                            order.order_price = ~order.order_price;
-                        }
-                        for (auto& order : res.asks) {
-                            std::swap(order.asset1, order.asset2);
-                            _my->reverse_price(order.real_price);
-                            order.order_price = ~order.order_price;
-                        }
-                    }
-                    return res;
+                bool reversed;
+                auto type_pair = db.with_weak_read_lock([&]() {
+                    return _my->get_symbol_type_pair(pair, &reversed);
                 });
+                auto res = _my->with_depth_book([&](const depth_book_ptr& book) {
+                    return _my->get_order_book_extended(book, type_pair, limit);
+                });
+                if (reversed) {
+                    std::swap(res.bids, res.asks);
+                    for (auto& order : res.bids) {
+                        std::swap(order.asset1, order.asset2);
+                        _my->reverse_price(order.real_price);
+                        order.order_price = ~order.order_price;
+                    }
+                    for (auto& order : res.asks) {
+                        std::swap(order.asset1, order.asset2);
+                        _my->reverse_price(order.real_price);
+                        order.order_price = ~order.order_price;
+                    }
+                }
+                return res;
             }
 
 
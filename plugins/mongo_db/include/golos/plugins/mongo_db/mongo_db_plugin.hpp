@@ -5,6 +5,7 @@
 #include <golos/plugins/json_rpc/utility.hpp>
 #include <golos/plugins/json_rpc/plugin.hpp>
 #include <golos/plugins/chain/plugin.hpp>
+#include <golos/plugins/mongo_db/mongo_db_writer.hpp>
 
 
 namespace golos {
@@ -33,6 +34,11 @@ namespace mongo_db {
 
         void plugin_shutdown() override;
 
+        /**
+         * Returns throughput and lag of the background writing
+         */
+        mongo_db_writer_stats get_writer_stats() const;
+
         constexpr const static char *plugin_name = "mongo_db";
 
         static const std::string& name() {
@@ -9,6 +9,7 @@
 
 #include <libraries/chain/include/golos/chain/operation_notification.hpp>
 
+#include <bsoncxx/document/value.hpp>
 #include <bsoncxx/builder/basic/document.hpp>
 #include <bsoncxx/builder/stream/document.hpp>
 #include <bsoncxx/builder/stream/array.hpp>
@@ -16,6 +17,7 @@
 
 #include <mongocxx/client.hpp>
 #include <mongocxx/instance.hpp>
+#include <mongocxx/pool.hpp>
 #include <mongocxx/uri.hpp>
 
 #include <appbase/application.hpp>
@@ -24,6 +26,7 @@
 #include <map>
 #include <mutex>
 #include <condition_variable>
+#include <deque>
 
 
 namespace golos {
@@ -39,31 +42,72 @@ namespace mongo_db {
 
     using bulk_ptr = std::unique_ptr<mongocxx::bulk_write>;
 
+    /**
+     * State of the background writing to MongoDB
+     */
+    struct mongo_db_writer_stats {
+        uint32_t last_queued_block = 0;     ///< last irreversible block which is passed to writers
+        uint32_t last_written_block = 0;    ///< last block which is written to MongoDB
+        uint32_t lag_blocks = 0;            ///< last_queued_block - last_written_block
+        uint32_t queue_size = 0;            ///< number of batches waiting for writing
+        uint64_t written_blocks = 0;
+        uint64_t written_documents = 0;
+        double documents_per_second = 0;    ///< average for the last period of logging
+    };
+
     class mongo_db_writer final {
     public:
         mongo_db_writer();
         ~mongo_db_writer();
 
         bool initialize(const std::string& uri_str, const bool write_raw, const std::vector<std::string>& op,
-            unsigned int store_history_dgp, unsigned int store_history_wso);
+            unsigned int store_history_dgp, unsigned int store_history_wso,
+            unsigned int write_threads, unsigned int write_queue_size);
 
         void on_block(const signed_block& block);
         void on_operation(const golos::chain::operation_notification& note);
 
+        /**
+         * Writes all queued batches and stops writer threads
+         */
+        void stop();
+
+        mongo_db_writer_stats get_stats() const;
+
     private:
         using operations = std::vector<operation>;
 
-        void write_blocks();
-        void write_raw_block(const signed_block& block, const operations&);
+        /**
+         * Documents of irreversible blocks. State documents are made by the chain thread, because they read
+         * objects of database. Raw blocks are formatted by writer threads, so several blocks are formatted in parallel.
+         * Batches are written to MongoDB in the order of seq.
+         */
+        struct write_batch {
+            uint64_t seq = 0;
+            uint32_t first_block = 0;
+            uint32_t last_block = 0;
+            std::vector<std::pair<signed_block, operations>> raw_blocks;
+            db_map docs;
+        };
+
+        // Table name, bulk write
+        using bulk_map = std::map<std::string, bulk_ptr>;
+        // Table name, indexes
+        using index_map = std::map<std::string, std::vector<bsoncxx::document::value>>;
+
+        void push_batch(write_batch&& batch);
+        void run_writer();
+        void format_batch(write_batch& batch, bulk_map& bulks, index_map& new_indexes, uint64_t& documents);
+        void write_batch_data(mongocxx::database& database, const write_batch& batch, bulk_map& bulks, index_map& new_indexes);
+
+        void write_raw_block(bulk_map& bulks, const signed_block& block, const operations&);
         void write_block_operations(state_writer& st_writer, const signed_block& block, const operations&);
-        void write_document(named_document const& named_doc);
-        void remove_document(named_document const& named_doc);
+        void write_document(bulk_map& bulks, index_map& new_indexes, named_document const& named_doc);
+        void remove_document(bulk_map& bulks, named_document const& named_doc);
 
         void format_block_info(const signed_block& block, document& doc);
         void format_transaction_info(const signed_transaction& tran, document& doc);
 
-        void write_data();
-
         uint64_t processed_blocks = 0;
 
         std::string db_name;
@@ -74,8 +118,6 @@ namespace mongo_db {
         std::map<uint32_t, operations> virtual_ops;
         std::map<uint32_t, dynamic_global_property_object> dgp_s;
         std::map<uint32_t, witness_schedule_object> wso_s;
-        // Table name, bulk write
-        std::map<std::string, bulk_ptr> formatted_blocks;
 
         bool write_raw_blocks;
         flat_set<std::string> write_operations;
@@ -84,14 +126,33 @@ namespace mongo_db {
 
         // Mongo connection members
         mongocxx::instance mongo_inst;
-        mongocxx::database mongo_database;
         mongocxx::uri uri;
-        mongocxx::client mongo_conn;
+        std::unique_ptr<mongocxx::pool> mongo_pool;
         mongocxx::options::bulk_write bulk_opts;
 
         std::unordered_map<std::string, std::string> indexes; // Prevent repeative create_index() calls. Only in current session 
 
+        // Writer threads
+        std::vector<std::thread> writer_threads;
+        mutable std::mutex writer_mutex;
+        std::condition_variable queue_cv;    // batch is queued or stopping
+        std::condition_variable space_cv;    // batch is written
+        std::condition_variable order_cv;    // next_write_seq is changed
+        std::deque<write_batch> write_queue;
+        unsigned int max_queue_size = 1;
+        uint32_t batches_in_work = 0;
+        uint64_t next_batch_seq = 0;
+        uint64_t next_write_seq = 0;
+        bool stopping = false;
+
+        mongo_db_writer_stats stats;
+        fc::time_point stats_period_start;
+        uint64_t stats_period_documents = 0;
+
         golos::chain::database& _db;
     };
 }}}
 
+FC_REFLECT(
+    (golos::plugins::mongo_db::mongo_db_writer_stats),
+    (last_queued_block)(last_written_block)(lag_blocks)(queue_size)(written_blocks)(written_documents)(documents_per_second))
@@ -18,8 +18,10 @@ namespace mongo_db {
         }
 
         bool initialize(const std::string& uri, const bool write_raw, const std::vector<std::string>& op,
-            unsigned int store_history_dgp, unsigned int store_history_wso) {
-            return writer.initialize(uri, write_raw, op, store_history_dgp, store_history_wso);
+            unsigned int store_history_dgp, unsigned int store_history_wso,
+            unsigned int write_threads, unsigned int write_queue_size) {
+            return writer.initialize(uri, write_raw, op, store_history_dgp, store_history_wso,
+                write_threads, write_queue_size);
         }
 
         ~mongo_db_plugin_impl() = default;
@@ -70,7 +72,13 @@ namespace mongo_db {
              "Mode of storing global_property_object history for each N block")
             ("mongodb-store-wso-history",
              boost::program_options::value<unsigned int>()->default_value(100),
-             "Mode of storing witness_schedule_object history for each N block");
+             "Mode of storing witness_schedule_object history for each N block")
+            ("mongodb-write-threads",
+             boost::program_options::value<unsigned int>()->default_value(2),
+             "Number of threads which format raw blocks and write documents into mongo")
+            ("mongodb-write-queue-size",
+             boost::program_options::value<unsigned int>()->default_value(64),
+             "Max number of batches of irreversible blocks waiting for writing, block applying waits when the queue is full");
     }
 
     void mongo_db_plugin::plugin_initialize(const boost::program_options::variables_map &options) {
@@ -94,6 +102,9 @@ namespace mongo_db {
                 store_history_wso = options.at("mongodb-store-wso-history").as<unsigned int>();
             }
 
+            auto write_threads = options.at("mongodb-write-threads").as<unsigned int>();
+            auto write_queue_size = options.at("mongodb-write-queue-size").as<unsigned int>();
+
             // First init mongo db
             if (options.count("mongodb-uri")) {
                 std::string uri_str = options.at("mongodb-uri").as<std::string>();
@@ -101,7 +112,8 @@ namespace mongo_db {
 
                 pimpl_ = std::make_unique<mongo_db_plugin_impl>(*this);
 
-                if (!pimpl_->initialize(uri_str, raw_blocks, write_operations, store_history_dgp, store_history_wso)) {
+                if (!pimpl_->initialize(uri_str, raw_blocks, write_operations, store_history_dgp, store_history_wso,
+                        write_threads, write_queue_size)) {
                     ilog("Cannot initialize MongoDB plugin. Plugin disabled.");
                     pimpl_.reset();
                     return;
@@ -125,6 +137,13 @@ namespace mongo_db {
         } FC_CAPTURE_AND_RETHROW()
     } 
 
+    mongo_db_writer_stats mongo_db_plugin::get_writer_stats() const {
+        if (!pimpl_) {
+            return mongo_db_writer_stats();
+        }
+        return pimpl_->writer.get_stats();
+    }
+
     void mongo_db_plugin::plugin_startup() {
         ilog("mongo_db plugin: plugin_startup() begin");
 
@@ -134,6 +153,10 @@ namespace mongo_db {
     void mongo_db_plugin::plugin_shutdown() {
         ilog("mongo_db plugin: plugin_shutdown() begin");
 
+        if (pimpl_) {
+            pimpl_->writer.stop();
+        }
+
         ilog("mongo_db plugin: plugin_shutdown() end");
     }
 
@@ -18,6 +18,8 @@
 #include <boost/multi_index/random_access_index.hpp>
 #include <boost/multi_index/sequenced_index.hpp>
 
+#include <algorithm>
+
 namespace golos {
 namespace plugins {
 namespace mongo_db {
@@ -35,19 +37,21 @@ namespace mongo_db {
     }
 
     mongo_db_writer::~mongo_db_writer() {
+        stop();
     }
 
     bool mongo_db_writer::initialize(const std::string& uri_str, const bool write_raw, const std::vector<std::string>& ops,
-        unsigned int store_history_dgp, unsigned int store_history_wso) {
+        unsigned int store_history_dgp, unsigned int store_history_wso,
+        unsigned int write_threads, unsigned int write_queue_size) {
         try {
             uri = mongocxx::uri {uri_str};
-            mongo_conn = mongocxx::client {uri};
+            mongo_pool = std::make_unique<mongocxx::pool>(uri);
             db_name = uri.database().empty() ? "Golos" : uri.database();
-            mongo_database = mongo_conn[db_name];
             bulk_opts.ordered(false);
             write_raw_blocks = write_raw;
             store_history_mode_dgp = store_history_dgp;
             store_history_mode_wso = store_history_wso;
+            max_queue_size = std::max(write_queue_size, 1u);
 
             for (auto& op : ops) {
                 if (!op.empty()) {
@@ -55,6 +59,13 @@ namespace mongo_db {
                 }
             }
 
+            stats_period_start = fc::time_point::now();
+            for (unsigned int i = 0; i < std::max(write_threads, 1u); ++i) {
+                writer_threads.emplace_back([this]() {
+                    run_writer();
+                });
+            }
+
             ilog("MongoDB writer initialized.");
 
             return true;
@@ -67,7 +78,30 @@ namespace mongo_db {
             wlog("Unknown exception in MongoDB writer");
             return false;
         }
-    }    
+    }
+
+    void mongo_db_writer::stop() {
+        {
+            std::lock_guard<std::mutex> lock(writer_mutex);
+            stopping = true;
+        }
+        queue_cv.notify_all();
+        space_cv.notify_all();
+        for (auto& thread : writer_threads) {
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+        writer_threads.clear();
+    }
+
+    mongo_db_writer_stats mongo_db_writer::get_stats() const {
+        std::lock_guard<std::mutex> lock(writer_mutex);
+        auto result = stats;
+        result.queue_size = write_queue.size() + batches_in_work;
+        result.lag_blocks = result.last_queued_block - std::min(result.last_written_block, result.last_queued_block);
+        return result;
+    }
 
     void mongo_db_writer::on_block(const signed_block& block) {
 
@@ -87,66 +121,62 @@ namespace mongo_db {
             last_irreversible_block_num = _db.last_non_undoable_block_num();
             if (last_irreversible_block_num >= blocks.begin()->first) {
 
-                db_map all_docs;
+                write_batch batch;
+                batch.first_block = blocks.begin()->first;
 
-                // Write all the blocks that has num less then last irreversible block
+                // Format all the blocks that has num less then last irreversible block
                 while (!blocks.empty() && blocks.begin()->first <= last_irreversible_block_num) {
                     auto head_iter = blocks.begin();
+                    auto block_num = head_iter->first;
 
                     try {
-                        if (write_raw_blocks) {
-                            write_raw_block(head_iter->second, virtual_ops[head_iter->first]);
-                        }
-
-                        state_writer st_writer(all_docs, head_iter->second);
+                        // State writer reads objects of database, so it works in this thread
+                        state_writer st_writer(batch.docs, head_iter->second);
 
                         if (store_history_mode_dgp != 0 && (head_iter->second.block_num() % store_history_mode_dgp == 0)) {
-                            st_writer.write_global_property_object(dgp_s.at(head_iter->first), true);
+                            st_writer.write_global_property_object(dgp_s.at(block_num), true);
                         }
-                        st_writer.write_global_property_object(dgp_s.at(head_iter->first), false);
+                        st_writer.write_global_property_object(dgp_s.at(block_num), false);
 
                         if (store_history_mode_wso != 0 && (head_iter->second.block_num() % store_history_mode_wso == 0)) {
-                            st_writer.write_witness_schedule_object(wso_s[head_iter->first], true);
+                            st_writer.write_witness_schedule_object(wso_s[block_num], true);
                         }
-                        st_writer.write_witness_schedule_object(wso_s[head_iter->first], false);
+                        st_writer.write_witness_schedule_object(wso_s[block_num], false);
 
-                        // Parsing all transactions. st_writer writes all results to all_docs
+                        // Parsing all transactions. st_writer writes all results to batch.docs
 
                         for (const auto& tran : head_iter->second.transactions) {
                             for (const auto& op : tran.operations) {
                                 op.visit(st_writer);
                             }
                         }
-                        
-                        write_block_operations(st_writer, head_iter->second, virtual_ops[head_iter->first]);
+
+                        write_block_operations(st_writer, head_iter->second, virtual_ops[block_num]);
+
+                        // Raw block doesn't depend on state, it is formatted by writer thread
+                        if (write_raw_blocks) {
+                            batch.raw_blocks.emplace_back(std::move(head_iter->second), std::move(virtual_ops[block_num]));
+                        }
                     }
                     catch (...) {
                         // If some block causes any problems lets remove it from buffer and move on
                         blocks.erase(head_iter);
-                        dgp_s.erase(head_iter->first);
-                        wso_s.erase(head_iter->first);
-                        virtual_ops.erase(head_iter->first);
+                        dgp_s.erase(block_num);
+                        wso_s.erase(block_num);
+                        virtual_ops.erase(block_num);
                         throw;
                     }
                     blocks.erase(head_iter);
-                    dgp_s.erase(head_iter->first);
-                    wso_s.erase(head_iter->first);
-                    virtual_ops.erase(head_iter->first);
-                }
+                    dgp_s.erase(block_num);
+                    wso_s.erase(block_num);
+                    virtual_ops.erase(block_num);
 
-                // End of blocks series. Writing all docs to bulk
-
-                for (auto& it : all_docs) {
-                    if (!it.is_removal) {
-                        write_document(it);
-                    } else {
-                        remove_document(it);
-                    }
+                    batch.last_block = block_num;
                 }
 
-                // Writing bulk to mongo
+                // End of blocks series. Writing docs in background
 
-                write_data();
+                push_batch(std::move(batch));
             }
 
             ++processed_blocks;
@@ -156,6 +186,151 @@ namespace mongo_db {
         }
     }
 
+    void mongo_db_writer::push_batch(write_batch&& batch) {
+        std::unique_lock<std::mutex> lock(writer_mutex);
+        // Applying of blocks waits only when writers are behind by the whole queue
+        space_cv.wait(lock, [&]() {
+            return stopping || write_queue.size() + batches_in_work < max_queue_size;
+        });
+        if (stopping) {
+            return;
+        }
+        batch.seq = next_batch_seq++;
+        stats.last_queued_block = batch.last_block;
+        write_queue.push_back(std::move(batch));
+        lock.unlock();
+        queue_cv.notify_one();
+    }
+
+    void mongo_db_writer::run_writer() {
+        auto client = mongo_pool->acquire();
+        auto database = (*client)[db_name];
+
+        while (true) {
+            write_batch batch;
+            {
+                std::unique_lock<std::mutex> lock(writer_mutex);
+                queue_cv.wait(lock, [&]() {
+                    return stopping || !write_queue.empty();
+                });
+                if (write_queue.empty()) {
+                    break;
+                }
+                batch = std::move(write_queue.front());
+                write_queue.pop_front();
+                ++batches_in_work;
+            }
+
+            // Formatting goes in parallel with other writers
+            bulk_map bulks;
+            index_map new_indexes;
+            uint64_t documents = 0;
+            try {
+                format_batch(batch, bulks, new_indexes, documents);
+            } catch (const fc::exception& e) {
+                wlog("Exception while formatting blocks ${f}..${l} for mongo: ${e}",
+                    ("f", batch.first_block)("l", batch.last_block)("e", e.to_detail_string()));
+                bulks.clear();
+            } catch (const std::exception& e) {
+                wlog("Unknown exception while formatting blocks ${f}..${l} for mongo: ${e}",
+                    ("f", batch.first_block)("l", batch.last_block)("e", e.what()));
+                bulks.clear();
+            } catch (...) {
+                wlog("Unknown exception while formatting blocks ${f}..${l} for mongo",
+                    ("f", batch.first_block)("l", batch.last_block));
+                bulks.clear();
+            }
+
+            // Writing goes in order of blocks
+            {
+                std::unique_lock<std::mutex> lock(writer_mutex);
+                order_cv.wait(lock, [&]() {
+                    return next_write_seq == batch.seq;
+                });
+            }
+
+            try {
+                write_batch_data(database, batch, bulks, new_indexes);
+            } catch (const fc::exception& e) {
+                // If we got some errors writing block into mongo just skip this block and move on
+                wlog("Exception while writing blocks ${f}..${l} to mongo: ${e}",
+                    ("f", batch.first_block)("l", batch.last_block)("e", e.to_detail_string()));
+            } catch (const std::exception& e) {
+                wlog("Unknown exception while writing blocks ${f}..${l} to mongo: ${e}",
+                    ("f", batch.first_block)("l", batch.last_block)("e", e.what()));
+            } catch (...) {
+                wlog("Unknown exception while writing blocks ${f}..${l} to mongo",
+                    ("f", batch.first_block)("l", batch.last_block));
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(writer_mutex);
+                ++next_write_seq;
+                --batches_in_work;
+
+                stats.last_written_block = batch.last_block;
+                stats.written_blocks += batch.last_block - batch.first_block + 1;
+                stats.written_documents += documents;
+                stats_period_documents += documents;
+
+                auto now = fc::time_point::now();
+                auto period = now - stats_period_start;
+                if (period >= fc::minutes(1)) {
+                    stats.documents_per_second = double(stats_period_documents) * 1000000 / period.count();
+                    stats_period_documents = 0;
+                    stats_period_start = now;
+                    ilog("MongoDB writer: block ${b}, behind LIB by ${l} blocks, ${d} documents/sec, ${q} batches in queue",
+                        ("b", stats.last_written_block)("l", stats.last_queued_block - stats.last_written_block)
+                        ("d", uint64_t(stats.documents_per_second))("q", write_queue.size() + batches_in_work));
+                }
+            }
+            order_cv.notify_all();
+            space_cv.notify_all();
+        }
+    }
+
+    void mongo_db_writer::format_batch(write_batch& batch, bulk_map& bulks, index_map& new_indexes, uint64_t& documents) {
+        for (const auto& raw : batch.raw_blocks) {
+            write_raw_block(bulks, raw.first, raw.second);
+            ++documents;
+        }
+        batch.raw_blocks.clear();
+
+        for (auto& it : batch.docs) {
+            if (!it.is_removal) {
+                write_document(bulks, new_indexes, it);
+            } else {
+                remove_document(bulks, it);
+            }
+            ++documents;
+        }
+    }
+
+    void mongo_db_writer::write_batch_data(
+        mongocxx::database& database, const write_batch& batch, bulk_map& bulks, index_map& new_indexes
+    ) {
+        // indexes are created in order of batches, so they are created only once
+        for (auto& idx : new_indexes) {
+            if (indexes.find(idx.first) == indexes.end()) {
+                for (auto& index_to_create : idx.second) {
+                    database[idx.first].create_index(index_to_create.view());
+                    indexes[idx.first] = "created";
+                }
+            }
+        }
+
+        // Writes are grouped by collections
+        for (auto& oper : bulks) {
+            const std::string& collection_name = oper.first;
+            mongocxx::collection _collection = database[collection_name];
+
+            auto& bulkp = oper.second;
+            if (!_collection.bulk_write(*bulkp)) {
+                wlog("Failed to write blocks to Mongo DB");
+            }
+        }
+    }
+
     void mongo_db_writer::on_operation(const golos::chain::operation_notification& note) {
         virtual_ops[note.block].push_back(note.op);
         // remove ops if there were forks and rollbacks
@@ -164,7 +339,7 @@ namespace mongo_db {
         virtual_ops.erase(itr, virtual_ops.end());
     }
 
-    void mongo_db_writer::write_raw_block(const signed_block& block, const operations& ops) {
+    void mongo_db_writer::write_raw_block(bulk_map& bulks, const signed_block& block, const operations& ops) {
 
         operation_writer op_writer;
         document block_doc;
@@ -219,24 +394,24 @@ namespace mongo_db {
         block_doc << transactions << transactions_array;
 
         static const std::string blocks = "blocks";
-        if (formatted_blocks.find(blocks) == formatted_blocks.end()) {
-            formatted_blocks[blocks] = std::make_unique<mongocxx::bulk_write>(bulk_opts);
+        if (bulks.find(blocks) == bulks.end()) {
+            bulks[blocks] = std::make_unique<mongocxx::bulk_write>(bulk_opts);
         }
 
         mongocxx::model::insert_one insert_msg{block_doc.view()};
-        formatted_blocks[blocks]->append(insert_msg);
+        bulks[blocks]->append(insert_msg);
     }
 
-    void mongo_db_writer::write_document(named_document const& named_doc) {
-        if (formatted_blocks.find(named_doc.collection_name) == formatted_blocks.end()) {
-            formatted_blocks[named_doc.collection_name] = std::make_unique<mongocxx::bulk_write>(bulk_opts);
+    void mongo_db_writer::write_document(bulk_map& bulks, index_map& new_indexes, named_document const& named_doc) {
+        if (bulks.find(named_doc.collection_name) == bulks.end()) {
+            bulks[named_doc.collection_name] = std::make_unique<mongocxx::bulk_write>(bulk_opts);
         }
 
         auto view = named_doc.doc.view();
         auto itr = view.find("$set");
         if (view.end() == itr) {
             mongocxx::model::insert_one msg{std::move(view)};
-            formatted_blocks[named_doc.collection_name]->append(msg);
+            bulks[named_doc.collection_name]->append(msg);
         } else {
             document filter;
 
@@ -244,20 +419,20 @@ namespace mongo_db {
 
             mongocxx::model::update_one msg{filter.view(), view};
             msg.upsert(true);
-            formatted_blocks[named_doc.collection_name]->append(msg);
+            bulks[named_doc.collection_name]->append(msg);
         }
 
-        if (indexes.find(named_doc.collection_name) == indexes.end()) {
+        if (!named_doc.indexes_to_create.empty() && new_indexes.find(named_doc.collection_name) == new_indexes.end()) {
+            auto& to_create = new_indexes[named_doc.collection_name];
             for (auto& index_to_create : named_doc.indexes_to_create) {
-                mongo_database[named_doc.collection_name].create_index(index_to_create.view());
-                indexes[named_doc.collection_name] = "created";
+                to_create.emplace_back(index_to_create.view());
             }
         }
     }
 
-    void mongo_db_writer::remove_document(named_document const& named_doc) {
-        if (formatted_blocks.find(named_doc.collection_name) == formatted_blocks.end()) {
-            formatted_blocks[named_doc.collection_name] = std::make_unique<mongocxx::bulk_write>(bulk_opts);
+    void mongo_db_writer::remove_document(bulk_map& bulks, named_document const& named_doc) {
+        if (bulks.find(named_doc.collection_name) == bulks.end()) {
+            bulks[named_doc.collection_name] = std::make_unique<mongocxx::bulk_write>(bulk_opts);
         }
 
         document filter;
@@ -267,7 +442,7 @@ namespace mongo_db {
         newval << "$set" << open_document << "removed" << true << close_document;
         auto v2 = newval.view();
         mongocxx::model::update_many msg{v1, v2};
-        formatted_blocks[named_doc.collection_name]->append(msg);
+        bulks[named_doc.collection_name]->append(msg);
     }
 
     void mongo_db_writer::write_block_operations(state_writer& st_writer, const signed_block& block, const operations& ops) {
@@ -291,28 +466,4 @@ namespace mongo_db {
             << "transaction_ref_block_num"  << static_cast<int32_t>(tran.ref_block_num)
             << "transaction_expiration"     << tran.expiration;
     }
-
-    void mongo_db_writer::write_data() {
-        auto iter = formatted_blocks.begin();
-        for (; iter != formatted_blocks.end(); ++iter) {
-
-            auto& oper = *iter;
-            try {
-                const std::string& collection_name = oper.first;
-                mongocxx::collection _collection = mongo_database[collection_name];
-
-                auto& bulkp = oper.second;
-                if (!_collection.bulk_write(*bulkp)) {
-                    wlog("Failed to write blocks to Mongo DB");
-                }
-            }
-            catch (const std::exception& e) {
-                wlog("Unknown exception while writing blocks to mongo: ${e}", ("e", e.what()));
-                // If we got some errors writing block into mongo just skip this block and move on
-                formatted_blocks.erase(iter);
-                throw;
-            }
-        }
-        formatted_blocks.clear();
-    }
 }}}
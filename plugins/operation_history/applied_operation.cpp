@@ -14,4 +14,14 @@ namespace golos { namespace plugins { namespace operation_history {
           op(fc::raw::unpack<protocol::operation>(op_obj.serialized_op)) {
     }
 
+    applied_operation::applied_operation(const stored_operation& op)
+        : trx_id(op.trx_id),
+          block(op.block),
+          trx_in_block(op.trx_in_block),
+          op_in_trx(op.op_in_trx),
+          virtual_op(op.virtual_op),
+          timestamp(op.timestamp),
+          op(fc::raw::unpack<protocol::operation>(op.serialized_op)) {
+    }
+
 } } } // golos::plugins::operation_history
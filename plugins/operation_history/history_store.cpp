@@ -0,0 +1,980 @@
+#include <golos/plugins/operation_history/history_store.hpp>
+
+#include <fc/crypto/sha256.hpp>
+#include <fc/io/raw.hpp>
+#include <fc/io/raw_variant.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/thread/shared_mutex.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace golos { namespace plugins { namespace operation_history {
+
+    namespace bfs = boost::filesystem;
+
+    namespace detail {
+        using read_lock = boost::shared_lock<boost::shared_mutex>;
+        using write_lock = boost::unique_lock<boost::shared_mutex>;
+
+        // location of record in segmented log: number of segment and offset in it
+        constexpr uint32_t segment_offset_bits = 40;
+        constexpr uint64_t segment_offset_mask = (uint64_t(1) << segment_offset_bits) - 1;
+        constexpr uint32_t max_segments = 256;  // locations fit 48 bits, the rest of posting is op tag and direction
+
+        constexpr uint64_t posting_location_mask = (uint64_t(1) << 48) - 1;
+
+        inline uint64_t make_posting(uint64_t location, uint8_t op_tag, uint8_t dir) {
+            return location | (uint64_t(op_tag) << 48) | (uint64_t(dir) << 56);
+        }
+
+        inline uint64_t posting_location(uint64_t posting) {
+            return posting & posting_location_mask;
+        }
+
+        inline uint8_t posting_op_tag(uint64_t posting) {
+            return uint8_t(posting >> 48);
+        }
+
+        inline uint8_t posting_dir(uint64_t posting) {
+            return uint8_t(posting >> 56);
+        }
+
+        inline uint64_t trx_key(const transaction_id_type& id) {
+            uint64_t result;
+            std::memcpy(&result, id.data(), sizeof(result));
+            return result;
+        }
+
+        inline void read_exact(int fd, char* data, std::size_t size, uint64_t pos) {
+            while (size > 0) {
+                auto n = ::pread(fd, data, size, pos);
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                FC_ASSERT(n > 0, "Failed to read history store", ("pos", pos)("errno", errno));
+                data += n;
+                pos += n;
+                size -= n;
+            }
+        }
+
+        inline void write_exact(int fd, const char* data, std::size_t size, uint64_t pos) {
+            while (size > 0) {
+                auto n = ::pwrite(fd, data, size, pos);
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                FC_ASSERT(n > 0, "Failed to write history store", ("pos", pos)("errno", errno));
+                data += n;
+                pos += n;
+                size -= n;
+            }
+        }
+
+        inline int open_file(const bfs::path& path) {
+            int fd = ::open(path.string().c_str(), O_RDWR | O_CREAT, 0644);
+            FC_ASSERT(fd >= 0, "Failed to open ${path}", ("path", path.string())("errno", errno));
+            return fd;
+        }
+
+        inline uint64_t file_size(int fd) {
+            struct stat st;
+            FC_ASSERT(::fstat(fd, &st) == 0, "Failed to get file size", ("errno", errno));
+            return st.st_size;
+        }
+
+        /**
+         * File of fixed-size entries.
+         */
+        template <typename T>
+        class fixed_file final {
+        public:
+            void open(const bfs::path& path) {
+                _fd = open_file(path);
+                _count = file_size(_fd) / sizeof(T);
+            }
+
+            void close() {
+                if (_fd >= 0) {
+                    ::close(_fd);
+                    _fd = -1;
+                }
+                _count = 0;
+            }
+
+            uint64_t size() const {
+                return _count;
+            }
+
+            T get(uint64_t i) const {
+                T result;
+                read_exact(_fd, reinterpret_cast<char*>(&result), sizeof(T), i * sizeof(T));
+                return result;
+            }
+
+            void push_back(const T& value) {
+                write_exact(_fd, reinterpret_cast<const char*>(&value), sizeof(T), _count * sizeof(T));
+                ++_count;
+            }
+
+            void resize(uint64_t count) {
+                FC_ASSERT(::ftruncate(_fd, count * sizeof(T)) == 0, "Failed to truncate file", ("errno", errno));
+                _count = count;
+            }
+
+            void sync() {
+                ::fdatasync(_fd);
+            }
+
+            /**
+             * Duplicate of descriptor, it can be synced without lock of store.
+             */
+            int dup_fd() const {
+                return ::dup(_fd);
+            }
+
+        private:
+            int _fd = -1;
+            uint64_t _count = 0;
+        };
+
+        /**
+         * Append-only log of records (32-bit size and data), which is split to segments of limited size.
+         */
+        class segmented_log final {
+        public:
+            void open(const bfs::path& dir, const std::string& prefix, uint64_t segment_size) {
+                _dir = dir;
+                _prefix = prefix;
+                _segment_size = segment_size;
+
+                for (uint32_t i = 0; i == 0 || bfs::exists(segment_path(i)); ++i) {
+                    _fds.push_back(open_file(segment_path(i)));
+                    _sizes.push_back(file_size(_fds.back()));
+                }
+            }
+
+            void close() {
+                for (auto fd : _fds) {
+                    ::close(fd);
+                }
+                _fds.clear();
+                _sizes.clear();
+            }
+
+            uint64_t end() const {
+                return make_location(_fds.size() - 1, _sizes.back());
+            }
+
+            /**
+             * Location of end of segment is the same as the beginning of the next segment.
+             */
+            uint64_t normalize(uint64_t location) const {
+                const auto segment = location >> segment_offset_bits;
+                const auto offset = location & segment_offset_mask;
+                if (segment + 1 < _fds.size() && offset == _sizes[segment]) {
+                    return make_location(segment + 1, 0);
+                }
+                return location;
+            }
+
+            uint64_t append(const std::vector<char>& data) {
+                const uint32_t record_size = data.size() + sizeof(uint32_t);
+                if (_sizes.back() > 0 && _sizes.back() + record_size > _segment_size) {
+                    FC_ASSERT(_fds.size() < max_segments, "Too many segments of history store, increase segment size");
+                    _fds.push_back(open_file(segment_path(_fds.size())));
+                    _sizes.push_back(0);
+                }
+
+                const auto location = end();
+                std::vector<char> record(record_size);
+                const uint32_t size = data.size();
+                std::memcpy(record.data(), &size, sizeof(size));
+                std::memcpy(record.data() + sizeof(size), data.data(), data.size());
+                write_exact(_fds.back(), record.data(), record.size(), _sizes.back());
+                _sizes.back() += record.size();
+                return location;
+            }
+
+            /**
+             * Reads record and returns location of next record.
+             */
+            uint64_t read(uint64_t location, std::vector<char>& data) const {
+                const auto segment = location >> segment_offset_bits;
+                const auto offset = location & segment_offset_mask;
+                FC_ASSERT(segment < _fds.size() && offset + sizeof(uint32_t) <= _sizes[segment],
+                    "Reading beyond end of history store", ("segment", segment)("offset", offset));
+
+                uint32_t size;
+                read_exact(_fds[segment], reinterpret_cast<char*>(&size), sizeof(size), offset);
+                FC_ASSERT(offset + sizeof(size) + size <= _sizes[segment],
+                    "Reading beyond end of history store", ("segment", segment)("offset", offset)("size", size));
+
+                data.resize(size);
+                read_exact(_fds[segment], data.data(), size, offset + sizeof(size));
+
+                auto next = offset + sizeof(size) + size;
+                if (next == _sizes[segment] && segment + 1 < _fds.size()) {
+                    return make_location(segment + 1, 0);
+                }
+                return make_location(segment, next);
+            }
+
+            void truncate(uint64_t location) {
+                const auto segment = location >> segment_offset_bits;
+                const auto offset = location & segment_offset_mask;
+                FC_ASSERT(segment < _fds.size(), "Truncating beyond end of history store", ("segment", segment));
+
+                while (_fds.size() > segment + 1) {
+                    ::close(_fds.back());
+                    bfs::remove(segment_path(_fds.size() - 1));
+                    _fds.pop_back();
+                    _sizes.pop_back();
+                }
+                FC_ASSERT(::ftruncate(_fds.back(), offset) == 0, "Failed to truncate history store", ("errno", errno));
+                _sizes.back() = offset;
+            }
+
+            /**
+             * Duplicates of descriptors of segments which were written after location.
+             */
+            std::vector<int> dup_fds(uint64_t location) const {
+                std::vector<int> result;
+                for (auto segment = location >> segment_offset_bits; segment < _fds.size(); ++segment) {
+                    result.push_back(::dup(_fds[segment]));
+                }
+                return result;
+            }
+
+            static uint64_t make_location(uint64_t segment, uint64_t offset) {
+                return (segment << segment_offset_bits) | offset;
+            }
+
+        private:
+            bfs::path segment_path(uint32_t i) const {
+                return _dir / (_prefix + "." + std::to_string(i) + ".log");
+            }
+
+            bfs::path _dir;
+            std::string _prefix;
+            uint64_t _segment_size = 0;
+            std::vector<int> _fds;
+            std::vector<uint64_t> _sizes;
+        };
+
+        struct operation_index_entry {
+            uint64_t id;
+            uint64_t location;
+        };
+
+        // positions after the end of block
+        struct block_index_entry {
+            uint64_t operations_count;
+            uint64_t operations_end;
+            uint64_t accounts_end;
+        };
+
+        /**
+         * Lookups of blocks from from_block (exclusive) to last_block. The full state has from_block 0,
+         * checkpoints contain only lookups added after the previous one.
+         */
+        struct store_state {
+            uint32_t from_block = 0;
+            uint32_t last_block = 0;
+            std::vector<std::pair<std::string, std::vector<uint64_t>>> postings;
+            std::vector<std::pair<uint64_t, uint32_t>> transactions;
+            std::vector<std::pair<uint32_t, std::vector<uint64_t>>> nft_tokens;
+        };
+
+        struct lookup_tables {
+            std::unordered_map<std::string, std::vector<uint64_t>> postings;
+            std::unordered_multimap<uint64_t, uint32_t> transactions;
+            std::unordered_map<uint32_t, std::vector<uint64_t>> nft_tokens;
+
+            void add_posting(const std::string& account, uint64_t posting) {
+                postings[account].push_back(posting);
+            }
+
+            void add_operation(const stored_operation& op) {
+                if (op.nft_token_id) {
+                    nft_tokens[op.nft_token_id].push_back(op.id);
+                }
+                if (op.trx_id == transaction_id_type()) {
+                    return;
+                }
+                // all operations of transaction have the same block, so only one lookup entry is needed
+                auto range = transactions.equal_range(trx_key(op.trx_id));
+                for (auto itr = range.first; itr != range.second; ++itr) {
+                    if (itr->second == op.block) {
+                        return;
+                    }
+                }
+                transactions.emplace(trx_key(op.trx_id), op.block);
+            }
+
+            /**
+             * Removes lookups of blocks after block_num, end is position after the end of block_num.
+             */
+            void truncate(uint32_t block_num, const block_index_entry& end, uint64_t last_id) {
+                for (auto itr = postings.begin(); itr != postings.end();) {
+                    auto& list = itr->second;
+                    while (!list.empty() && posting_location(list.back()) >= end.accounts_end) {
+                        list.pop_back();
+                    }
+                    if (list.empty()) {
+                        itr = postings.erase(itr);
+                    } else {
+                        ++itr;
+                    }
+                }
+
+                for (auto itr = transactions.begin(); itr != transactions.end();) {
+                    if (itr->second > block_num) {
+                        itr = transactions.erase(itr);
+                    } else {
+                        ++itr;
+                    }
+                }
+
+                for (auto itr = nft_tokens.begin(); itr != nft_tokens.end();) {
+                    auto& list = itr->second;
+                    while (!list.empty() && (!end.operations_count || list.back() > last_id)) {
+                        list.pop_back();
+                    }
+                    if (list.empty()) {
+                        itr = nft_tokens.erase(itr);
+                    } else {
+                        ++itr;
+                    }
+                }
+            }
+
+            void copy_to(store_state& state) const {
+                state.postings.assign(postings.begin(), postings.end());
+                state.transactions.assign(transactions.begin(), transactions.end());
+                state.nft_tokens.assign(nft_tokens.begin(), nft_tokens.end());
+            }
+
+            void move_to(store_state& state) {
+                state.postings.reserve(postings.size());
+                for (auto& p : postings) {
+                    state.postings.emplace_back(p.first, std::move(p.second));
+                }
+                state.transactions.assign(transactions.begin(), transactions.end());
+                state.nft_tokens.reserve(nft_tokens.size());
+                for (auto& t : nft_tokens) {
+                    state.nft_tokens.emplace_back(t.first, std::move(t.second));
+                }
+                clear();
+            }
+
+            /**
+             * Appends lookups of state, it should continue lookups of tables.
+             */
+            void merge(store_state& state) {
+                for (auto& p : state.postings) {
+                    auto& list = postings[p.first];
+                    list.insert(list.end(), p.second.begin(), p.second.end());
+                }
+                for (const auto& t : state.transactions) {
+                    transactions.emplace(t.first, t.second);
+                }
+                for (auto& t : state.nft_tokens) {
+                    auto& list = nft_tokens[t.first];
+                    list.insert(list.end(), t.second.begin(), t.second.end());
+                }
+            }
+
+            void clear() {
+                postings.clear();
+                transactions.clear();
+                nft_tokens.clear();
+            }
+        };
+
+        /**
+         * Checkpoint which is written by background thread: lookups and descriptors of files to sync before it.
+         */
+        struct checkpoint {
+            store_state state;
+            std::vector<int> fds;
+        };
+
+        // checkpoint record in file: size, checksum and packed state
+        struct checkpoint_header {
+            uint32_t size;
+            uint64_t checksum;
+        };
+
+        inline uint64_t checkpoint_checksum(const std::vector<char>& data) {
+            return fc::sha256::hash(data.data(), data.size())._hash[0];
+        }
+    }
+
+} } } // golos::plugins::operation_history
+
+FC_REFLECT((golos::plugins::operation_history::detail::store_state),
+    (from_block)(last_block)(postings)(transactions)(nft_tokens))
+
+namespace golos { namespace plugins { namespace operation_history {
+
+    using namespace detail;
+
+    struct history_store::impl final {
+        bfs::path dir;
+        bool opened = false;
+
+        segmented_log operations;
+        segmented_log accounts;
+        fixed_file<operation_index_entry> operations_index;
+        fixed_file<block_index_entry> blocks_index;
+
+        lookup_tables lookups;
+        lookup_tables pending;      // lookups after the last checkpoint, they are collected only for checkpoints
+
+        uint32_t current_block = 0;
+
+        uint32_t checkpoint_interval = 0;
+        uint32_t state_block = 0;   // last block of the saved state
+
+        mutable boost::shared_mutex mutex;
+
+        // checkpoints are written by background thread without lock of store
+        std::mutex checkpoint_mutex;
+        std::condition_variable checkpoint_cond;
+        std::deque<checkpoint> checkpoints;
+        bool checkpoint_writing = false;
+        bool checkpoint_stopped = false;
+        std::thread checkpoint_thread;
+
+        int checkpoints_fd = -1;
+        uint64_t checkpoints_size = 0;
+
+        bfs::path state_path() const {
+            return dir / "state.bin";
+        }
+
+        bfs::path checkpoints_path() const {
+            return dir / "checkpoints.log";
+        }
+
+        uint32_t last_block() const {
+            return blocks_index.size();
+        }
+
+        block_index_entry block_end(uint32_t block_num) const {
+            if (block_num == 0) {
+                return block_index_entry{0, 0, 0};
+            }
+            return blocks_index.get(block_num - 1);
+        }
+
+        void truncate(uint32_t block_num) {
+            auto end = block_end(block_num);
+            blocks_index.resize(block_num);
+            operations_index.resize(end.operations_count);
+            operations.truncate(end.operations_end);
+            accounts.truncate(end.accounts_end);
+        }
+
+        void add_posting(const stored_account_operation& op, uint64_t location) {
+            const std::string account(op.account);
+            auto& list = lookups.postings[account];
+            FC_ASSERT(list.size() == op.sequence,
+                "Wrong sequence of account history entry",
+                ("account", op.account)("sequence", op.sequence)("expected", list.size()));
+            list.push_back(make_posting(location, op.op_tag, op.dir));
+            if (checkpoint_interval) {
+                pending.add_posting(account, list.back());
+            }
+        }
+
+        void add_operation(const stored_operation& op) {
+            lookups.add_operation(op);
+            if (checkpoint_interval) {
+                pending.add_operation(op);
+            }
+        }
+
+        void rebuild_lookups() {
+            lookups.clear();
+            pending.clear();
+
+            ilog("Rebuilding lookup tables of history store...");
+            replay(0);
+        }
+
+        /**
+         * Adds to lookup tables records of blocks after from_block.
+         */
+        void replay(uint32_t from_block) {
+            const auto begin = block_end(from_block);
+
+            std::vector<char> data;
+            const auto accounts_end = accounts.end();
+            for (auto location = accounts.normalize(begin.accounts_end); location != accounts_end;) {
+                auto next = accounts.read(location, data);
+                add_posting(fc::raw::unpack<stored_account_operation>(data), location);
+                location = next;
+            }
+
+            const auto operations_end = operations.end();
+            for (auto location = operations.normalize(begin.operations_end); location != operations_end;) {
+                auto next = operations.read(location, data);
+                add_operation(fc::raw::unpack<stored_operation>(data));
+                location = next;
+            }
+        }
+
+        /**
+         * Loads the full state and checkpoints which continue it.
+         */
+        bool load_state() {
+            if (!bfs::exists(state_path())) {
+                return false;
+            }
+
+            store_state state;
+            try {
+                std::vector<char> data(bfs::file_size(state_path()));
+                int fd = open_file(state_path());
+                read_exact(fd, data.data(), data.size(), 0);
+                ::close(fd);
+                state = fc::raw::unpack<store_state>(data);
+            } catch (const fc::exception& e) {
+                wlog("Can't load state of history store: ${e}", ("e", e.to_detail_string()));
+                return false;
+            }
+            lookups.merge(state);
+            auto state_last_block = state.last_block;
+
+            // checkpoints are appended after the full state was saved, the last one can be written partially
+            const auto size = file_size(checkpoints_fd);
+            uint64_t pos = 0;
+            std::vector<char> data;
+            while (pos + sizeof(checkpoint_header) <= size) {
+                checkpoint_header header;
+                read_exact(checkpoints_fd, reinterpret_cast<char*>(&header), sizeof(header), pos);
+                if (pos + sizeof(header) + header.size > size) {
+                    break;
+                }
+                data.resize(header.size);
+                read_exact(checkpoints_fd, data.data(), data.size(), pos + sizeof(header));
+                if (checkpoint_checksum(data) != header.checksum) {
+                    break;
+                }
+
+                store_state delta;
+                try {
+                    delta = fc::raw::unpack<store_state>(data);
+                } catch (const fc::exception&) {
+                    break;
+                }
+                // checkpoints which were written before the full state are already in it
+                if (delta.last_block > state_last_block) {
+                    if (delta.from_block != state_last_block) {
+                        break;
+                    }
+                    lookups.merge(delta);
+                    state_last_block = delta.last_block;
+                }
+                pos += sizeof(header) + header.size;
+            }
+            // the rest of file doesn't continue the loaded state, new checkpoints are written instead of it
+            FC_ASSERT(::ftruncate(checkpoints_fd, pos) == 0, "Failed to truncate file", ("errno", errno));
+            checkpoints_size = pos;
+
+            // logs are synced before saving of state, so they can be shorter only if they were damaged
+            if (state_last_block > last_block()) {
+                return false;
+            }
+
+            // after an unclean shutdown only blocks after the last checkpoint are scanned
+            if (state_last_block < last_block()) {
+                ilog("Replaying history store from block ${block}", ("block", state_last_block));
+                replay(state_last_block);
+            }
+            state_block = state_last_block;
+            return true;
+        }
+
+        /**
+         * Saves all lookup tables and drops checkpoints, it is done on open, close and truncation of store.
+         */
+        void write_state() {
+            wait_checkpoints();
+
+            operations.sync();
+            accounts.sync();
+            operations_index.sync();
+            blocks_index.sync();
+
+            store_state state;
+            state.last_block = last_block();
+            lookups.copy_to(state);
+            auto data = fc::raw::pack(state);
+
+            auto tmp_path = state_path().string() + ".tmp";
+            int fd = open_file(tmp_path);
+            write_exact(fd, data.data(), data.size(), 0);
+            // file can be left by interrupted writing
+            FC_ASSERT(::ftruncate(fd, data.size()) == 0, "Failed to truncate file", ("errno", errno));
+            ::fdatasync(fd);
+            ::close(fd);
+            bfs::rename(tmp_path, state_path());
+
+            FC_ASSERT(::ftruncate(checkpoints_fd, 0) == 0, "Failed to truncate file", ("errno", errno));
+            checkpoints_size = 0;
+
+            pending.clear();
+            state_block = state.last_block;
+        }
+
+        /**
+         * Queues lookups added after the previous checkpoint, it takes time proportional only to them.
+         */
+        void queue_checkpoint() {
+            checkpoint cp;
+            cp.state.from_block = state_block;
+            cp.state.last_block = last_block();
+            pending.move_to(cp.state);
+
+            // files are synced up to the end of block, so checkpoint never refers beyond synced data
+            const auto begin = block_end(state_block);
+            cp.fds = operations.dup_fds(begin.operations_end);
+            auto fds = accounts.dup_fds(begin.accounts_end);
+            cp.fds.insert(cp.fds.end(), fds.begin(), fds.end());
+            cp.fds.push_back(operations_index.dup_fd());
+            cp.fds.push_back(blocks_index.dup_fd());
+
+            state_block = cp.state.last_block;
+
+            std::lock_guard<std::mutex> lock(checkpoint_mutex);
+            checkpoints.push_back(std::move(cp));
+            checkpoint_cond.notify_all();
+        }
+
+        void write_checkpoint(checkpoint& cp) {
+            for (auto fd : cp.fds) {
+                if (fd >= 0) {
+                    ::fdatasync(fd);
+                    ::close(fd);
+                }
+            }
+
+            auto data = fc::raw::pack(cp.state);
+            checkpoint_header header{uint32_t(data.size()), checkpoint_checksum(data)};
+            write_exact(checkpoints_fd, reinterpret_cast<const char*>(&header), sizeof(header), checkpoints_size);
+            write_exact(checkpoints_fd, data.data(), data.size(), checkpoints_size + sizeof(header));
+            ::fdatasync(checkpoints_fd);
+            checkpoints_size += sizeof(header) + data.size();
+        }
+
+        void run_checkpoints() {
+            std::unique_lock<std::mutex> lock(checkpoint_mutex);
+            while (true) {
+                checkpoint_cond.wait(lock, [&]() {
+                    return checkpoint_stopped || !checkpoints.empty();
+                });
+                if (checkpoints.empty()) {
+                    return;
+                }
+                auto cp = std::move(checkpoints.front());
+                checkpoints.pop_front();
+                checkpoint_writing = true;
+                lock.unlock();
+
+                try {
+                    write_checkpoint(cp);
+                } catch (const fc::exception& e) {
+                    // next checkpoints don't continue the saved ones, so after a crash the store is replayed from here
+                    elog("Can't write checkpoint of history store: ${e}", ("e", e.to_detail_string()));
+                }
+
+                lock.lock();
+                checkpoint_writing = false;
+                checkpoint_cond.notify_all();
+            }
+        }
+
+        void wait_checkpoints() {
+            std::unique_lock<std::mutex> lock(checkpoint_mutex);
+            checkpoint_cond.wait(lock, [&]() {
+                return checkpoints.empty() && !checkpoint_writing;
+            });
+        }
+
+        void start_checkpoints() {
+            checkpoint_stopped = false;
+            checkpoint_thread = std::thread([this]() {
+                run_checkpoints();
+            });
+        }
+
+        void stop_checkpoints() {
+            {
+                std::lock_guard<std::mutex> lock(checkpoint_mutex);
+                checkpoint_stopped = true;
+            }
+            checkpoint_cond.notify_all();
+
+            if (checkpoint_thread.joinable()) {
+                checkpoint_thread.join();
+            }
+        }
+    };
+
+    history_store::history_store()
+        : my(std::make_unique<impl>()) {
+    }
+
+    history_store::~history_store() {
+        close();
+    }
+
+    void history_store::open(const fc::path& dir, uint64_t segment_size, uint32_t checkpoint_interval) { try {
+        close();
+
+        write_lock lock(my->mutex);
+
+        my->dir = dir;
+        my->checkpoint_interval = checkpoint_interval;
+        my->state_block = 0;
+        bfs::create_directories(dir);
+
+        my->operations.open(dir, "operations", segment_size);
+        my->accounts.open(dir, "accounts", segment_size);
+        my->operations_index.open(my->dir / "operations.index");
+        my->blocks_index.open(my->dir / "blocks.index");
+        my->checkpoints_fd = open_file(my->checkpoints_path());
+
+        // removes data of a block which wasn't completely written
+        my->truncate(my->last_block());
+
+        if (!my->load_state()) {
+            my->rebuild_lookups();
+            my->write_state();
+        }
+        if (checkpoint_interval) {
+            my->start_checkpoints();
+        }
+        my->opened = true;
+
+        ilog("History store contains ${blocks} blocks, ${ops} operations, ${accounts} accounts",
+            ("blocks", my->last_block())("ops", my->operations_index.size())("accounts", my->lookups.postings.size()));
+    } FC_CAPTURE_AND_RETHROW((dir)) }
+
+    void history_store::close() {
+        write_lock lock(my->mutex);
+        if (!my->opened) {
+            return;
+        }
+
+        my->stop_checkpoints();
+        my->write_state();
+
+        my->operations.close();
+        my->accounts.close();
+        my->operations_index.close();
+        my->blocks_index.close();
+        ::close(my->checkpoints_fd);
+        my->checkpoints_fd = -1;
+        my->lookups.clear();
+        my->pending.clear();
+        my->opened = false;
+    }
+
+    bool history_store::is_open() const {
+        read_lock lock(my->mutex);
+        return my->opened;
+    }
+
+    uint32_t history_store::last_block() const {
+        read_lock lock(my->mutex);
+        return my->last_block();
+    }
+
+    void history_store::truncate(uint32_t block_num) { try {
+        write_lock lock(my->mutex);
+        if (block_num >= my->last_block()) {
+            return;
+        }
+
+        auto end = my->block_end(block_num);
+        const auto last_id = end.operations_count ? my->operations_index.get(end.operations_count - 1).id : 0;
+        my->truncate(block_num);
+        my->lookups.truncate(block_num, end, last_id);
+
+        if (my->state_block > block_num) {
+            // saved state contains removed blocks
+            my->write_state();
+        } else {
+            my->pending.truncate(block_num, end, last_id);
+        }
+    } FC_CAPTURE_AND_RETHROW((block_num)) }
+
+    void history_store::begin_block(uint32_t block_num) {
+        write_lock lock(my->mutex);
+        FC_ASSERT(block_num > my->last_block(), "Block is already in history store",
+            ("block_num", block_num)("last_block", my->last_block()));
+
+        // skipped blocks have no operations
+        block_index_entry entry{my->operations_index.size(), my->operations.end(), my->accounts.end()};
+        while (my->blocks_index.size() + 1 < block_num) {
+            my->blocks_index.push_back(entry);
+        }
+        my->current_block = block_num;
+    }
+
+    void history_store::append_operation(const stored_operation& op) {
+        write_lock lock(my->mutex);
+        FC_ASSERT(op.block == my->current_block, "Operation doesn't belong to the current block",
+            ("block", op.block)("current_block", my->current_block));
+
+        auto count = my->operations_index.size();
+        FC_ASSERT(count == 0 || my->operations_index.get(count - 1).id < op.id,
+            "Operations should be appended in order of ids", ("id", op.id));
+
+        auto location = my->operations.append(fc::raw::pack(op));
+        my->operations_index.push_back(operation_index_entry{op.id, location});
+        my->add_operation(op);
+    }
+
+    void history_store::append_account_operation(const stored_account_operation& op) {
+        write_lock lock(my->mutex);
+        auto location = my->accounts.append(fc::raw::pack(op));
+        my->add_posting(op, location);
+    }
+
+    void history_store::end_block(uint32_t block_num) {
+        write_lock lock(my->mutex);
+        FC_ASSERT(block_num == my->current_block, "Block wasn't begun",
+            ("block_num", block_num)("current_block", my->current_block));
+
+        my->blocks_index.push_back(
+            block_index_entry{my->operations_index.size(), my->operations.end(), my->accounts.end()});
+        my->current_block = 0;
+
+        if (my->checkpoint_interval && block_num >= my->state_block + my->checkpoint_interval) {
+            my->queue_checkpoint();
+        }
+    }
+
+    void history_store::wait_checkpoints() {
+        my->wait_checkpoints();
+    }
+
+    fc::optional<stored_operation> history_store::get_operation(uint64_t id) const {
+        read_lock lock(my->mutex);
+        fc::optional<stored_operation> result;
+
+        // ids are increasing, so index is searched by bisection
+        uint64_t lo = 0;
+        uint64_t hi = my->operations_index.size();
+        while (lo < hi) {
+            auto mid = lo + (hi - lo) / 2;
+            if (my->operations_index.get(mid).id < id) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        if (lo == my->operations_index.size()) {
+            return result;
+        }
+
+        auto entry = my->operations_index.get(lo);
+        if (entry.id != id) {
+            return result;
+        }
+
+        std::vector<char> data;
+        my->operations.read(entry.location, data);
+        result = fc::raw::unpack<stored_operation>(data);
+        return result;
+    }
+
+    std::vector<stored_operation> history_store::get_block_operations(uint32_t block_num) const {
+        read_lock lock(my->mutex);
+        std::vector<stored_operation> result;
+        if (block_num == 0 || block_num > my->last_block()) {
+            return result;
+        }
+
+        auto begin = my->block_end(block_num - 1).operations_count;
+        auto end = my->block_end(block_num).operations_count;
+        result.reserve(end - begin);
+
+        std::vector<char> data;
+        for (auto i = begin; i < end; ++i) {
+            my->operations.read(my->operations_index.get(i).location, data);
+            result.push_back(fc::raw::unpack<stored_operation>(data));
+        }
+        return result;
+    }
+
+    uint32_t history_store::account_history_size(const account_name_type& account) const {
+        read_lock lock(my->mutex);
+        auto itr = my->lookups.postings.find(std::string(account));
+        if (itr == my->lookups.postings.end()) {
+            return 0;
+        }
+        return itr->second.size();
+    }
+
+    std::vector<stored_account_operation> history_store::get_account_history(
+        const account_name_type& account, uint32_t from, uint32_t limit, const account_filter& filter
+    ) const {
+        read_lock lock(my->mutex);
+        std::vector<stored_account_operation> result;
+
+        auto itr = my->lookups.postings.find(std::string(account));
+        if (itr == my->lookups.postings.end() || !limit) {
+            return result;
+        }
+
+        const auto& list = itr->second;
+        std::vector<char> data;
+        for (int64_t seq = std::min<int64_t>(from, int64_t(list.size()) - 1); seq >= 0; --seq) {
+            auto posting = list[seq];
+            if (filter && !filter(posting_op_tag(posting), posting_dir(posting))) {
+                continue;
+            }
+            my->accounts.read(posting_location(posting), data);
+            result.push_back(fc::raw::unpack<stored_account_operation>(data));
+            if (result.size() >= limit) {
+                break;
+            }
+        }
+        return result;
+    }
+
+    std::vector<uint64_t> history_store::get_nft_token_operations(uint32_t token_id) const {
+        read_lock lock(my->mutex);
+        auto itr = my->lookups.nft_tokens.find(token_id);
+        if (itr == my->lookups.nft_tokens.end()) {
+            return {};
+        }
+        return itr->second;
+    }
+
+    std::vector<uint32_t> history_store::find_transaction_blocks(const transaction_id_type& id) const {
+        read_lock lock(my->mutex);
+        std::vector<uint32_t> result;
+        auto range = my->lookups.transactions.equal_range(trx_key(id));
+        for (auto itr = range.first; itr != range.second; ++itr) {
+            result.push_back(itr->second);
+        }
+        return result;
+    }
+
+} } } // golos::plugins::operation_history
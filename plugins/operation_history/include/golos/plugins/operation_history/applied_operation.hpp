@@ -3,6 +3,7 @@
 #include <golos/protocol/operations.hpp>
 #include <golos/chain/steem_object_types.hpp>
 #include <golos/plugins/operation_history/history_object.hpp>
+#include <golos/plugins/operation_history/history_store.hpp>
 
 namespace golos { namespace plugins { namespace operation_history {
 
@@ -11,6 +12,8 @@ namespace golos { namespace plugins { namespace operation_history {
 
         applied_operation(const operation_object&);
 
+        applied_operation(const stored_operation&);
+
         golos::protocol::transaction_id_type trx_id;
         uint32_t block = 0;
         uint32_t trx_in_block = 0;
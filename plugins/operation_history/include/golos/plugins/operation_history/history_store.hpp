@@ -0,0 +1,140 @@
+#pragma once
+
+#include <golos/protocol/types.hpp>
+
+#include <fc/filesystem.hpp>
+#include <fc/optional.hpp>
+
+#include <functional>
+#include <memory>
+
+namespace golos { namespace plugins { namespace operation_history {
+
+    using golos::protocol::account_name_type;
+    using golos::protocol::transaction_id_type;
+
+    /**
+     * Operation which is moved from operation_object to the history store.
+     */
+    struct stored_operation final {
+        uint64_t id = 0;            ///< id of operation_object, account history refers to it
+        transaction_id_type trx_id;
+        uint32_t block = 0;
+        uint32_t trx_in_block = 0;
+        uint16_t op_in_trx = 0;
+        uint32_t virtual_op = 0;
+        uint32_t nft_token_id = 0;
+        fc::time_point_sec timestamp;
+        std::vector<char> serialized_op;
+    };
+
+    /**
+     * Entry of account history which is moved from account_history_object to the history store.
+     */
+    struct stored_account_operation final {
+        account_name_type account;
+        uint32_t sequence = 0;
+        uint8_t op_tag = 0;
+        uint8_t dir = 0;
+        uint64_t op = 0;            ///< id of operation
+        std::string json_metadata;
+    };
+
+    /**
+     * Append-only on-disk storage of irreversible operations and account histories.
+     *
+     * Only the reversible tail of history is kept in shared memory, operations of irreversible blocks are moved
+     * to segmented log files of this store. Files are:
+     *  - operations.N.log, accounts.N.log - segments with records of operations and account history entries;
+     *  - operations.index - pairs of operation id and location of its record, sorted by id;
+     *  - blocks.index - positions in logs where each block ends, it allows to read and to truncate by block.
+     *
+     * Posting lists of accounts (locations of entries with op tags and directions), lists of NFT token operations
+     * and the transaction lookup table are kept in memory. They are saved to state.bin on open and close.
+     * Each checkpoint_interval blocks lookups added after the previous checkpoint are appended to checkpoints.log
+     * by background thread. After an unclean shutdown the saved state and checkpoints are loaded,
+     * and only blocks after the last checkpoint are scanned.
+     */
+    class history_store final {
+    public:
+        using account_filter = std::function<bool(uint8_t op_tag, uint8_t dir)>;
+
+        history_store();
+
+        ~history_store();
+
+        /**
+         * checkpoint_interval - number of blocks between savings of lookup tables, 0 - they are saved only on close.
+         */
+        void open(const fc::path& dir, uint64_t segment_size, uint32_t checkpoint_interval = 0);
+
+        void close();
+
+        bool is_open() const;
+
+        /**
+         * Returns number of last block moved to the store.
+         */
+        uint32_t last_block() const;
+
+        /**
+         * Removes data of blocks after block_num.
+         */
+        void truncate(uint32_t block_num);
+
+        /**
+         * Appending of a block: begin_block(), append_*(), end_block(). Blocks should go in increasing order.
+         */
+        void begin_block(uint32_t block_num);
+
+        void append_operation(const stored_operation& op);
+
+        void append_account_operation(const stored_account_operation& op);
+
+        void end_block(uint32_t block_num);
+
+        /**
+         * Waits until checkpoints queued by end_block() are written.
+         */
+        void wait_checkpoints();
+
+        fc::optional<stored_operation> get_operation(uint64_t id) const;
+
+        std::vector<stored_operation> get_block_operations(uint32_t block_num) const;
+
+        /**
+         * Returns number of account history entries in store, they have sequences from 0 to size - 1.
+         */
+        uint32_t account_history_size(const account_name_type& account) const;
+
+        /**
+         * Returns up to limit entries of account history with sequence <= from in descending order of sequences,
+         * entries are checked by filter before reading from disk.
+         */
+        std::vector<stored_account_operation> get_account_history(
+            const account_name_type& account, uint32_t from, uint32_t limit, const account_filter& filter) const;
+
+        /**
+         * Returns ids of operations with NFT token in ascending order.
+         */
+        std::vector<uint64_t> get_nft_token_operations(uint32_t token_id) const;
+
+        /**
+         * Returns blocks which can contain transaction, they should be checked by caller.
+         */
+        std::vector<uint32_t> find_transaction_blocks(const transaction_id_type& id) const;
+
+    private:
+        struct impl;
+        std::unique_ptr<impl> my;
+    };
+
+} } } // golos::plugins::operation_history
+
+FC_REFLECT(
+    (golos::plugins::operation_history::stored_operation),
+    (id)(trx_id)(block)(trx_in_block)(op_in_trx)(virtual_op)(nft_token_id)(timestamp)(serialized_op))
+
+FC_REFLECT(
+    (golos::plugins::operation_history::stored_account_operation),
+    (account)(sequence)(op_tag)(dir)(op)(json_metadata))
@@ -34,6 +34,7 @@
 #include <golos/plugins/json_rpc/plugin.hpp>
 #include <golos/plugins/operation_history/applied_operation.hpp>
 #include <golos/plugins/operation_history/history_object.hpp>
+#include <golos/plugins/operation_history/history_store.hpp>
 
 
 namespace golos { namespace plugins { namespace operation_history {
@@ -76,6 +77,17 @@ namespace golos { namespace plugins { namespace operation_history {
         void plugin_startup() override;
         void plugin_shutdown() override;
 
+        /**
+         * Returns store of irreversible history or nullptr if it is disabled.
+         */
+        history_store* get_history_store() const;
+
+        /**
+         * Registers a callback which is called for each block moved to the history store,
+         * plugins use it to move their parts of history of the block.
+         */
+        void on_block_moved_to_store(std::function<void(uint32_t)> callback);
+
         DECLARE_API(
             (get_block_with_virtual_ops)
 
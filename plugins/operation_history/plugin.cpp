@@ -9,6 +9,7 @@
 #include <golos/api/operation_history_extender.hpp>
 
 #include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
 
 #define STEEM_NAMESPACE_PREFIX "golos::protocol::"
 #define OPERATION_POSTFIX "_operation"
@@ -181,7 +182,98 @@ namespace golos { namespace plugins { namespace operation_history {
             }
         }
 
+        static stored_operation make_stored_operation(const operation_object& obj) {
+            stored_operation op;
+            op.id = obj.id._id;
+            op.trx_id = obj.trx_id;
+            op.block = obj.block;
+            op.trx_in_block = obj.trx_in_block;
+            op.op_in_trx = obj.op_in_trx;
+            op.virtual_op = obj.virtual_op;
+            op.nft_token_id = obj.nft_token_id;
+            op.timestamp = obj.timestamp;
+            op.serialized_op.assign(obj.serialized_op.begin(), obj.serialized_op.end());
+            return op;
+        }
+
+        bool is_in_store(uint32_t block_num) const {
+            return store.is_open() && block_num <= store.last_block();
+        }
+
+        void open_store() {
+            if (store.is_open()) {
+                return;
+            }
+            store.open(store_dir, store_segment_size, store_checkpoint_blocks);
+            // store can't contain reversible blocks, it also drops the whole store on replay
+            store.truncate(database.last_non_undoable_block_num());
+        }
+
+        // max number of operations moved to store on applying of one block, the whole block is moved anyway
+        static constexpr uint32_t store_batch_operations = 10000;
+
+        void move_to_store() {
+            open_store();
+
+            const auto last_block = store.last_block();
+            const auto lib = database.last_non_undoable_block_num();
+            if (lib <= last_block) {
+                return;
+            }
+
+            const auto& idx = database.get_index<operation_index>().indices().get<by_location>();
+            auto itr = idx.begin();
+
+            // popping of block restores operations which were already moved to store
+            while (itr != idx.end() && itr->block <= last_block) {
+                const auto& obj = *itr;
+                ++itr;
+                database.remove(obj);
+            }
+
+            // history of existing node is moved by parts, so applying of block isn't stalled by it
+            std::vector<const operation_object*> ops;
+            uint32_t moved = 0;
+            while (itr != idx.end() && itr->block <= lib) {
+                if (moved >= store_batch_operations) {
+                    return;
+                }
+
+                const auto block_num = itr->block;
+                ops.clear();
+                for (; itr != idx.end() && itr->block == block_num; ++itr) {
+                    ops.push_back(&*itr);
+                }
+                std::sort(ops.begin(), ops.end(), [](const operation_object* l, const operation_object* r) {
+                    return l->id < r->id;
+                });
+
+                store.begin_block(block_num);
+                for (auto op : ops) {
+                    store.append_operation(make_stored_operation(*op));
+                }
+                for (const auto& callback : store_callbacks) {
+                    callback(block_num);
+                }
+                store.end_block(block_num);
+
+                for (auto op : ops) {
+                    database.remove(*op);
+                }
+                moved += ops.size();
+            }
+
+            if (store.last_block() < lib) {
+                store.begin_block(lib);
+                store.end_block(lib);
+            }
+        }
+
         void on_operation(golos::chain::operation_notification& note) {
+            // replaying of blocks starts before plugin_startup()
+            if (store_enabled) {
+                open_store();
+            }
             if (filter_content) {
                 note.op.visit(operation_visitor_filter(database, note, ops_list, tracked_accounts, blacklist, start_block));
             } else {
@@ -199,9 +291,23 @@ namespace golos { namespace plugins { namespace operation_history {
             }
             result = annotated_signed_block(*sb);
 
+            result._virtual_operations = block_operations();
+            if (is_in_store(block_num)) {
+                for (const auto& stored : get_stored_block_operations(block_num)) {
+                    if (stored.virtual_op != 0) {
+                        block_operation op;
+                        op.trx_in_block = stored.trx_in_block;
+                        op.op_in_trx = stored.op_in_trx;
+                        op.virtual_op = stored.virtual_op;
+                        op.op = fc::raw::unpack<protocol::operation>(stored.serialized_op);
+                        (*result._virtual_operations).push_back(op);
+                    }
+                }
+                return result;
+            }
+
             const auto& idx = database.get_index<operation_index>().indices().get<by_location>();
             auto itr = idx.lower_bound(block_num);
-            result._virtual_operations = block_operations();
             for (; itr != idx.end() && itr->block == block_num; ++itr) {
                 if (itr->virtual_op != 0) {
                     block_operation op;
@@ -216,13 +322,32 @@ namespace golos { namespace plugins { namespace operation_history {
             return result;
         }
 
+        std::vector<stored_operation> get_stored_block_operations(uint32_t block_num) const {
+            auto ops = store.get_block_operations(block_num);
+            // store keeps operations in order of ids
+            std::sort(ops.begin(), ops.end(), [](const stored_operation& l, const stored_operation& r) {
+                return std::tie(l.trx_in_block, l.op_in_trx, l.virtual_op, l.id) <
+                    std::tie(r.trx_in_block, r.op_in_trx, r.virtual_op, r.id);
+            });
+            return ops;
+        }
+
         std::vector<applied_operation> get_ops_in_block(
             uint32_t block_num,
             bool only_virtual
         ) {
+            std::vector<applied_operation> result;
+            if (is_in_store(block_num)) {
+                for (const auto& stored : get_stored_block_operations(block_num)) {
+                    if (!only_virtual || stored.virtual_op != 0) {
+                        result.emplace_back(stored);
+                    }
+                }
+                return result;
+            }
+
             const auto& idx = database.get_index<operation_index>().indices().get<by_location>();
             auto itr = idx.lower_bound(block_num);
-            std::vector<applied_operation> result;
             for (; itr != idx.end() && itr->block == block_num; ++itr) {
                 applied_operation operation(*itr);
                 if (!only_virtual || operation.virtual_op != 0) {
@@ -238,26 +363,32 @@ namespace golos { namespace plugins { namespace operation_history {
             fc::mutable_variant_object res;
             const auto& idx = database.get_index<operation_index, by_nft_token_id>();
             for (auto token_id : query.token_ids) {
-                std::vector<applied_operation> vec;
-                uint32_t i = 0;
-                auto itr = idx.find(token_id);
-                if (query.reverse_sort) {
-                    auto ritr = boost::make_reverse_iterator(itr);
-                    for (; ritr != idx.rend() && ritr->nft_token_id == token_id && i < query.from; ++ritr) {
-                        ++i;
-                    }
-                    for (; ritr != idx.rend() && ritr->nft_token_id == token_id && vec.size() < query.limit; ++ritr) {
-                        applied_operation operation(*ritr);
-                        vec.push_back(std::move(operation));
+                // recent operations are in database, older ones are in the history store
+                std::vector<const operation_object*> recent_ops;
+                for (auto itr = idx.find(token_id); itr != idx.end() && itr->nft_token_id == token_id; ++itr) {
+                    if (!is_in_store(itr->block)) {
+                        recent_ops.push_back(&*itr);
                     }
-                } else {
-                    for (; itr != idx.end() && i < query.from && itr->nft_token_id == token_id; ++itr) {
-                        ++i;
-                    }
-                    for (; itr != idx.end() && itr->nft_token_id == token_id && vec.size() < query.limit; ++itr) {
-                        applied_operation operation(*itr);
-                        vec.push_back(std::move(operation));
+                }
+                std::vector<uint64_t> stored_ops;
+                if (store.is_open()) {
+                    stored_ops = store.get_nft_token_operations(token_id);
+                }
+
+                // i-th operation in order of descending timestamps
+                auto get_op = [&](std::size_t i) -> applied_operation {
+                    if (i < recent_ops.size()) {
+                        return applied_operation(*recent_ops[i]);
                     }
+                    auto stored = store.get_operation(stored_ops[stored_ops.size() - 1 - (i - recent_ops.size())]);
+                    FC_ASSERT(stored.valid(), "Operation is missing in history store");
+                    return applied_operation(*stored);
+                };
+
+                std::vector<applied_operation> vec;
+                const auto total = recent_ops.size() + stored_ops.size();
+                for (std::size_t i = query.from; i < total && vec.size() < query.limit; ++i) {
+                    vec.push_back(get_op(query.reverse_sort ? total - 1 - i : i));
                 }
                 res[std::to_string(token_id)] = std::move(vec);
             }
@@ -276,6 +407,22 @@ namespace golos { namespace plugins { namespace operation_history {
                 result.transaction_num = itr->trx_in_block;
                 return result;
             }
+            if (store.is_open()) {
+                for (auto block_num : store.find_transaction_blocks(id)) {
+                    auto blk = database.fetch_block_by_number(block_num);
+                    if (!blk.valid()) {
+                        continue;
+                    }
+                    for (uint32_t trx_num = 0; trx_num < blk->transactions.size(); ++trx_num) {
+                        if (blk->transactions[trx_num].id() == id) {
+                            annotated_signed_transaction result = blk->transactions[trx_num];
+                            result.block_num = block_num;
+                            result.transaction_num = trx_num;
+                            return result;
+                        }
+                    }
+                }
+            }
             GOLOS_THROW_MISSING_OBJECT("transaction", id);
         }
 
@@ -286,6 +433,13 @@ namespace golos { namespace plugins { namespace operation_history {
         fc::flat_set<std::string> ops_list;
         fc::flat_set<std::string> tracked_accounts;
         golos::chain::database& database;
+
+        bool store_enabled = false;
+        fc::path store_dir;
+        uint64_t store_segment_size = 0;
+        uint32_t store_checkpoint_blocks = 0;
+        history_store store;
+        std::vector<std::function<void(uint32_t)>> store_callbacks;
     };
 
     DEFINE_API(plugin, get_block_with_virtual_ops) {
@@ -345,6 +499,23 @@ namespace golos { namespace plugins { namespace operation_history {
             "history-blocks",
             boost::program_options::value<uint32_t>(),
             "Defines depth of history for recording stats."
+        ) (
+            "history-store",
+            boost::program_options::value<bool>()->default_value(false),
+            "Moves operations and account history of irreversible blocks from shared memory to the history store."
+        ) (
+            "history-store-dir",
+            boost::program_options::value<boost::filesystem::path>()->default_value("history"),
+            "Directory of the history store, relative paths are relative to data-dir."
+        ) (
+            "history-store-segment-size",
+            boost::program_options::value<uint64_t>()->default_value(1024),
+            "Size of segment files of the history store in MB."
+        ) (
+            "history-store-checkpoint-blocks",
+            boost::program_options::value<uint32_t>()->default_value(10000),
+            "Number of blocks between checkpoints of lookup tables of the history store, they are written in background. "
+            "After an unclean shutdown only blocks after the last checkpoint are scanned. 0 - save only on shutdown."
         );
     }
 
@@ -411,6 +582,34 @@ namespace golos { namespace plugins { namespace operation_history {
         }
         ilog("operation_history: history-blocks ${s}", ("s", pimpl->history_blocks));
 
+        pimpl->store_enabled = options.at("history-store").as<bool>();
+        if (pimpl->store_enabled) {
+            GOLOS_CHECK_OPTION(!options.count("history-blocks"),
+                "history-blocks and history-store can't be specified together");
+
+            auto dir = options.at("history-store-dir").as<boost::filesystem::path>();
+            if (dir.is_relative()) {
+                pimpl->store_dir = appbase::app().data_dir() / dir;
+            } else {
+                pimpl->store_dir = dir;
+            }
+
+            auto segment_size = options.at("history-store-segment-size").as<uint64_t>();
+            GOLOS_CHECK_OPTION(segment_size > 0, "history-store-segment-size should be positive");
+            pimpl->store_segment_size = segment_size * 1024 * 1024;
+            pimpl->store_checkpoint_blocks = options.at("history-store-checkpoint-blocks").as<uint32_t>();
+
+            pimpl->database.applied_block.connect([&](const signed_block& block){
+                pimpl->move_to_store();
+            });
+        }
+        ilog("operation_history: history-store ${s}", ("s", pimpl->store_enabled));
+
+        // irreversible history of the store isn't in snapshots, so it can't be continued after loading of snapshot
+        if (!pimpl->store_enabled) {
+            golos::chain::add_snapshot_index<operation_index>(pimpl->database);
+        }
+
         if (options.count("track-account") > 0) {
             auto accounts = options.at("track-account").as<std::vector<std::string>>();
             for (auto& a : accounts) {
@@ -440,10 +639,22 @@ namespace golos { namespace plugins { namespace operation_history {
 
     void plugin::plugin_startup() {
         ilog("operation_history plugin: plugin_startup() begin");
+        if (pimpl->store_enabled) {
+            pimpl->open_store();
+        }
         ilog("operation_history plugin: plugin_startup() end");
     }
 
     void plugin::plugin_shutdown() {
+        pimpl->store.close();
+    }
+
+    history_store* plugin::get_history_store() const {
+        return pimpl->store_enabled ? &pimpl->store : nullptr;
+    }
+
+    void plugin::on_block_moved_to_store(std::function<void(uint32_t)> callback) {
+        pimpl->store_callbacks.push_back(std::move(callback));
     }
 
 } } } // golos::plugins::operation_history
@@ -226,9 +226,31 @@ namespace golos {
                     } FC_CAPTURE_AND_RETHROW((blockchain_synopsis)(remaining_item_count)(limit))
                 }
 
+                /**
+                 * Builds block_message from packed block as is, its layout is the packed block followed by its id
+                 */
+                static message make_block_message(const golos::chain::block_view &view, const block_id_type &block_id) {
+                    message result;
+                    result.msg_type = block_message::type;
+                    result.data.reserve(view.size() + sizeof(block_id));
+                    result.data.insert(result.data.end(), view.data(), view.data() + view.size());
+                    auto packed_id = fc::raw::pack(block_id);
+                    result.data.insert(result.data.end(), packed_id.begin(), packed_id.end());
+                    result.size = (uint32_t)result.data.size();
+                    return result;
+                }
+
                 message p2p_plugin_impl::get_item(const item_id &id) {
                     try {
                         if (id.item_type == network::block_message_type) {
+                            // irreversible blocks are served from block_log bytes without the database lock,
+                            //   only the header is unpacked to check that the block is on our chain
+                            auto view = chain.db().get_block_log().read_block_view(
+                                block_header::num_from_id(id.item_hash));
+                            if (view.valid() && view.id() == id.item_hash) {
+                                return make_block_message(view, id.item_hash);
+                            }
+
                             return chain.db().with_weak_read_lock([&]() {
                                 auto opt_block = chain.db().fetch_block_by_id(id.item_hash);
                                 if (!opt_block)
@@ -499,6 +521,11 @@ namespace golos {
             }
 
             void p2p_plugin::plugin_startup() {
+                if (my->chain.is_read_only()) {
+                    ilog("P2P is disabled on read-only node");
+                    return;
+                }
+
                 my->p2p_thread.async([this] {
                     my->node.reset(new golos::network::node(my->user_agent));
                     my->node->load_configuration(app().data_dir() / "p2p");
@@ -537,6 +564,9 @@ namespace golos {
 
             void p2p_plugin::plugin_shutdown() {
                 ilog("Shutting down P2P Plugin");
+                if (!my->node) {
+                    return;
+                }
                 my->node->close();
                 my->p2p_thread.quit();
                 my->node.reset();
@@ -544,12 +574,16 @@ namespace golos {
 
             void p2p_plugin::broadcast_block(const protocol::signed_block &block) {
                 ulog("Broadcasting block #${n}", ("n", block.block_num()));
-                my->node->broadcast(block_message(block));
+                if (my->node) {
+                    my->node->broadcast(block_message(block));
+                }
             }
 
             void p2p_plugin::broadcast_transaction(const protocol::signed_transaction &tx) {
                 ulog("Broadcasting tx #${n}", ("id", tx.id()));
-                my->node->broadcast(trx_message(tx));
+                if (my->node) {
+                    my->node->broadcast(trx_message(tx));
+                }
             }
 
             void p2p_plugin::set_block_production(bool producing_blocks) {
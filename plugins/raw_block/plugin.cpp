@@ -29,6 +29,17 @@ get_raw_block_r plugin::plugin_impl::get_raw_block(uint32_t block_num) {
     get_raw_block_r result;
     const auto &db = database();
 
+    // irreversible blocks are taken from block_log as is, without unpacking and packing of them
+    auto view = db.get_block_log().read_block_view(block_num);
+    if (view.valid()) {
+        auto header = view.header();
+        result.raw_block = fc::base64_encode(std::string(view.data(), view.size()));
+        result.block_id = header.id();
+        result.previous = header.previous;
+        result.timestamp = header.timestamp;
+        return result;
+    }
+
     auto block = db.fetch_block_by_number(block_num);
     if (!block.valid()) {
         return result;
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <appbase/application.hpp>
+#include <golos/plugins/chain/plugin.hpp>
+#include <golos/plugins/state_replication/state_delta.hpp>
+
+#include <boost/program_options.hpp>
+
+namespace golos { namespace plugins { namespace state_replication {
+
+    namespace bpo = boost::program_options;
+
+    /**
+     * Replicates state of the primary node to read-only followers.
+     *
+     * The primary node appends changes of each applied block to a file, they are taken from the undo session of block.
+     * A follower starts from a copy of the shared memory of the primary, doesn't receive blocks and doesn't run
+     * evaluators, it only applies changes from the file. Each record is applied in its own undo session, so when
+     * the primary switches to other fork, the follower undoes records till the parent of the new block.
+     *
+     * Only registered indexes are replicated. All core indexes are registered by the plugin, other plugins
+     * can register their indexes by register_index(). Follower doesn't start if a not registered index has objects.
+     * Follower is a read-only node: it doesn't accept blocks and transactions, p2p and block production are disabled.
+     */
+    class plugin final : public appbase::plugin<plugin> {
+    public:
+        APPBASE_PLUGIN_REQUIRES((chain::plugin))
+
+        plugin();
+
+        ~plugin();
+
+        static const std::string& name();
+
+        void set_program_options(bpo::options_description& cli, bpo::options_description& cfg) override;
+
+        void plugin_initialize(const bpo::variables_map& options) override;
+
+        void plugin_startup() override;
+
+        void plugin_shutdown() override;
+
+        /**
+         * Registers index for replication, should be called on initialization of plugin.
+         */
+        template <typename MultiIndexType>
+        void register_index() {
+            add_replicator(std::make_unique<index_replicator_impl<MultiIndexType>>());
+        }
+
+    private:
+        void add_replicator(std::unique_ptr<index_replicator> replicator);
+
+        struct impl;
+
+        std::unique_ptr<impl> my;
+    };
+
+} } } // golos::plugins::state_replication
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <golos/chain/database.hpp>
+#include <golos/chain/object_pack.hpp>
+#include <golos/chain/snapshot.hpp>
+
+namespace golos { namespace plugins { namespace state_replication {
+
+    using golos::chain::database;
+    using golos::protocol::block_id_type;
+
+    /**
+     * Created or modified object, it is stored with its id as in snapshots, because not all objects reflect id
+     */
+    struct object_delta {
+        int64_t id = 0;
+        std::vector<char> data;     ///< reflected fields packed by object_pack
+    };
+
+    /**
+     * Changes of one index made by block
+     */
+    struct index_delta {
+        uint16_t type_id = 0;
+        int64_t next_id = 0;                    ///< id of the next created object after block
+        std::vector<object_delta> objects;      ///< created and modified objects
+        std::vector<int64_t> removed;           ///< ids of removed objects
+    };
+
+    /**
+     * Changes of the replicated indexes made by block
+     */
+    struct state_delta {
+        uint32_t block_num = 0;
+        block_id_type block_id;
+        block_id_type previous;
+        uint32_t last_irreversible_block_num = 0;
+        std::vector<index_delta> indexes;
+    };
+
+    class index_replicator {
+    public:
+        virtual ~index_replicator() = default;
+
+        virtual uint16_t type_id() const = 0;
+
+        /**
+         * Collects changes from the head undo session of index, returns false if index isn't changed.
+         * Write access to the database is required to get the next id of index (see get_next_id()).
+         */
+        virtual bool collect(database& db, index_delta& delta) const = 0;
+
+        virtual void apply(database& db, const index_delta& delta) const = 0;
+    };
+
+    /**
+     * Replicates objects of index by their reflected fields, all fields except id should be reflected.
+     */
+    template <typename MultiIndexType>
+    class index_replicator_impl final : public index_replicator {
+    public:
+        using object_type = typename MultiIndexType::value_type;
+        using id_type = typename object_type::id_type;
+
+        uint16_t type_id() const override {
+            return object_type::type_id;
+        }
+
+        bool collect(database& db, index_delta& delta) const override {
+            const auto& stack = db.get_index<MultiIndexType>().stack();
+            // blocks applied without undo session (on reindex) can't be replicated
+            if (stack.empty() || stack.back().revision != db.revision()) {
+                return false;
+            }
+
+            const auto& undo = stack.back();
+            if (undo.new_ids.empty() && undo.old_values.empty() && undo.removed_values.empty()) {
+                return false;
+            }
+
+            delta.type_id = type_id();
+            delta.objects.reserve(undo.new_ids.size() + undo.old_values.size());
+            auto add = [&](const id_type& id) {
+                delta.objects.push_back({id._id, golos::chain::object_pack::pack_object(db.get<object_type>(id))});
+            };
+            for (const auto& id : undo.new_ids) {
+                add(id);
+            }
+            for (const auto& item : undo.old_values) {
+                add(item.first);
+            }
+            delta.removed.reserve(undo.removed_values.size());
+            for (const auto& item : undo.removed_values) {
+                delta.removed.push_back(item.first._id);
+            }
+            // objects created and removed by block aren't in delta, but they advance the next id
+            delta.next_id = golos::chain::get_next_id(db.get_mutable_index<MultiIndexType>());
+            return true;
+        }
+
+        void apply(database& db, const index_delta& delta) const override {
+            // removing goes first, because new objects can have the same unique keys
+            for (const auto& id : delta.removed) {
+                const auto* obj = db.find<object_type>(id_type(id));
+                if (obj) {
+                    db.remove(*obj);
+                }
+            }
+
+            auto& index = db.get_mutable_index<MultiIndexType>();
+            for (const auto& object : delta.objects) {
+                auto id = id_type(object.id);
+                const auto* obj = db.find<object_type>(id);
+                if (obj) {
+                    db.modify(*obj, [&](object_type& o) {
+                        golos::chain::object_pack::unpack_object(object.data, o);
+                    });
+                } else {
+                    // chainbase assigns the next id before constructor, so it is replaced as on loading of snapshot
+                    index.emplace([&](object_type& o) {
+                        golos::chain::object_pack::unpack_object(object.data, o);
+                        o.id = id;
+                    });
+                }
+            }
+
+            if (golos::chain::get_next_id(index) != delta.next_id) {
+                golos::chain::set_next_id(index, delta.next_id);
+            }
+        }
+    };
+
+    /**
+     * Adds replicators of all core indexes
+     */
+    void add_core_replicators(std::vector<std::unique_ptr<index_replicator>>& replicators);
+
+} } } // golos::plugins::state_replication
+
+FC_REFLECT((golos::plugins::state_replication::object_delta), (id)(data))
+FC_REFLECT((golos::plugins::state_replication::index_delta), (type_id)(next_id)(objects)(removed))
+FC_REFLECT((golos::plugins::state_replication::state_delta),
+    (block_num)(block_id)(previous)(last_irreversible_block_num)(indexes))
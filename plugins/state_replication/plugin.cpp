@@ -0,0 +1,444 @@
+#include <golos/plugins/state_replication/plugin.hpp>
+#include <golos/chain/account_object.hpp>
+#include <golos/chain/block_summary_object.hpp>
+#include <golos/chain/comment_bill.hpp>
+#include <golos/chain/comment_object.hpp>
+#include <golos/chain/event_objects.hpp>
+#include <golos/chain/global_property_object.hpp>
+#include <golos/chain/nft_objects.hpp>
+#include <golos/chain/paid_subscription_objects.hpp>
+#include <golos/chain/proposal_object.hpp>
+#include <golos/chain/steem_objects.hpp>
+#include <golos/chain/transaction_object.hpp>
+#include <golos/chain/witness_objects.hpp>
+#include <golos/chain/worker_objects.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include <atomic>
+#include <deque>
+#include <thread>
+
+namespace golos { namespace plugins { namespace state_replication {
+
+    namespace bfs = boost::filesystem;
+
+    namespace {
+        // size of record which ends file, the next records are in the new file with the same name
+        const uint32_t end_of_file_marker = 0;
+
+        template <typename MultiIndexType>
+        void add_replicator(std::vector<std::unique_ptr<index_replicator>>& replicators) {
+            replicators.push_back(std::make_unique<index_replicator_impl<MultiIndexType>>());
+        }
+    }
+
+    void add_core_replicators(std::vector<std::unique_ptr<index_replicator>>& replicators) {
+        using namespace golos::chain;
+
+        // the same indexes as added by add_core_index(), all fields of their objects are reflected for snapshots
+        add_replicator<dynamic_global_property_index>(replicators);
+        add_replicator<account_index>(replicators);
+        add_replicator<account_authority_index>(replicators);
+        add_replicator<account_freeze_index>(replicators);
+        add_replicator<account_bandwidth_index>(replicators);
+        add_replicator<witness_index>(replicators);
+        add_replicator<transaction_index>(replicators);
+        add_replicator<block_summary_index>(replicators);
+        add_replicator<witness_schedule_index>(replicators);
+        add_replicator<comment_index>(replicators);
+        add_replicator<comment_app_index>(replicators);
+        add_replicator<comment_bill_index>(replicators);
+        add_replicator<comment_extras_index>(replicators);
+        add_replicator<comment_vote_index>(replicators);
+        add_replicator<witness_vote_index>(replicators);
+        add_replicator<limit_order_index>(replicators);
+        add_replicator<feed_history_index>(replicators);
+        add_replicator<convert_request_index>(replicators);
+        add_replicator<liquidity_reward_balance_index>(replicators);
+        add_replicator<hardfork_property_index>(replicators);
+        add_replicator<withdraw_vesting_route_index>(replicators);
+        add_replicator<owner_authority_history_index>(replicators);
+        add_replicator<account_recovery_request_index>(replicators);
+        add_replicator<change_recovery_account_request_index>(replicators);
+        add_replicator<escrow_index>(replicators);
+        add_replicator<savings_withdraw_index>(replicators);
+        add_replicator<decline_voting_rights_request_index>(replicators);
+        add_replicator<vesting_delegation_index>(replicators);
+        add_replicator<vesting_delegation_expiration_index>(replicators);
+        add_replicator<account_metadata_index>(replicators);
+        add_replicator<proposal_index>(replicators);
+        add_replicator<required_approval_index>(replicators);
+        add_replicator<worker_request_index>(replicators);
+        add_replicator<worker_request_vote_index>(replicators);
+        add_replicator<donate_index>(replicators);
+        add_replicator<invite_index>(replicators);
+        add_replicator<asset_index>(replicators);
+        add_replicator<market_pair_index>(replicators);
+        add_replicator<fix_me_index>(replicators);
+        add_replicator<account_balance_index>(replicators);
+        add_replicator<event_index>(replicators);
+        add_replicator<account_blocking_index>(replicators);
+        add_replicator<paid_subscription_index>(replicators);
+        add_replicator<paid_subscriber_index>(replicators);
+        add_replicator<nft_collection_index>(replicators);
+        add_replicator<nft_index>(replicators);
+        add_replicator<nft_order_index>(replicators);
+        add_replicator<nft_bet_index>(replicators);
+    }
+
+    struct plugin::impl final {
+        impl()
+                : chain_plugin(appbase::app().get_plugin<chain::plugin>()),
+                  db(chain_plugin.db()) {
+        }
+
+        ~impl() {
+            stop_follower();
+        }
+
+        void register_core_indexes(plugin& self);
+
+        // primary
+
+        void on_applied_block(const signed_block& block);
+
+        void write_record(const std::vector<char>& data);
+
+        void rotate_file();
+
+        // follower
+
+        void start_follower();
+
+        void stop_follower();
+
+        void follow();
+
+        bool read_record(bfs::ifstream& in, state_delta& delta);
+
+        void apply_record(const state_delta& delta);
+
+        chain::plugin& chain_plugin;
+        golos::chain::database& db;
+
+        std::vector<std::unique_ptr<index_replicator>> replicators;
+        std::map<uint16_t, const index_replicator*> replicators_by_type;
+
+        bfs::path primary_file;
+        bfs::ofstream out;
+        uint64_t max_file_size = 0;     // 0 if file isn't rotated
+        uint64_t file_size = 0;
+        uint32_t first_written_block = 0;
+        // records of reversible blocks, they are copied to the new file on rotation
+        std::deque<std::pair<uint32_t, std::vector<char>>> reversible_records;
+
+        bfs::path follow_file;
+        std::thread follower;
+        std::atomic<bool> stopped{false};
+        uint32_t undo_depth = 0; // number of applied records which can be undone
+    };
+
+    void plugin::impl::register_core_indexes(plugin& self) {
+        std::vector<std::unique_ptr<index_replicator>> core;
+        add_core_replicators(core);
+        for (auto& r : core) {
+            self.add_replicator(std::move(r));
+        }
+    }
+
+    void plugin::impl::on_applied_block(const signed_block& block) {
+        if (db.is_reindexing()) {
+            return;
+        }
+
+        state_delta delta;
+        delta.block_num = block.block_num();
+        delta.block_id = block.id();
+        delta.previous = block.previous;
+        delta.last_irreversible_block_num = db.last_non_undoable_block_num();
+
+        for (const auto& r : replicators) {
+            index_delta index;
+            if (r->collect(db, index)) {
+                delta.indexes.push_back(std::move(index));
+            }
+        }
+
+        auto data = fc::raw::pack(delta);
+        write_record(data);
+        out.flush();
+
+        if (!max_file_size) {
+            return;
+        }
+
+        // records of blocks which are replaced by this one (fork switch) and of irreversible blocks aren't needed
+        while (!reversible_records.empty() && reversible_records.back().first >= delta.block_num) {
+            reversible_records.pop_back();
+        }
+        while (!reversible_records.empty() && reversible_records.front().first <= delta.last_irreversible_block_num) {
+            reversible_records.pop_front();
+        }
+        reversible_records.emplace_back(delta.block_num, std::move(data));
+
+        if (!first_written_block) {
+            first_written_block = delta.block_num;
+        }
+        // records of reversible blocks written before restart aren't kept, so file is rotated when they are irreversible
+        if (file_size >= max_file_size && first_written_block <= delta.last_irreversible_block_num + 1) {
+            rotate_file();
+        }
+    }
+
+    void plugin::impl::write_record(const std::vector<char>& data) {
+        uint32_t size = data.size();
+        out.write((const char*)&size, sizeof(size));
+        out.write(data.data(), data.size());
+        file_size += sizeof(size) + size;
+    }
+
+    /**
+     * New file starts with records after the last irreversible block, so a restarted follower finds records
+     * after its state. Follower which reads the old file reaches the end marker and reopens file by name,
+     * the old file is removed by replacing, so its data is available to the opened stream.
+     */
+    void plugin::impl::rotate_file() {
+        out.write((const char*)&end_of_file_marker, sizeof(end_of_file_marker));
+        out.close();
+
+        auto tmp_file = primary_file;
+        tmp_file += ".tmp";
+        out.open(tmp_file, std::ios::out | std::ios::binary | std::ios::trunc);
+        file_size = 0;
+        for (const auto& r : reversible_records) {
+            write_record(r.second);
+        }
+        out.close();
+
+        bfs::rename(tmp_file, primary_file);
+        out.open(primary_file, std::ios::out | std::ios::binary | std::ios::app);
+
+        ilog("Rotated state replication file ${f}, it starts with ${n} records of reversible blocks",
+            ("f", primary_file.string())("n", reversible_records.size()));
+    }
+
+    void plugin::impl::start_follower() {
+        // objects of other indexes would be left as they are in the copied state
+        for (auto itr = db.index_list_begin(), end = db.index_list_end(); itr != end; ++itr) {
+            GOLOS_CHECK_VALUE(replicators_by_type.count((*itr)->type_id()) || !(*itr)->size(),
+                "Index ${name} with ${n} objects isn't replicated, disable plugin which uses it on follower node",
+                ("name", (*itr)->name())("n", (*itr)->size()));
+        }
+
+        db.with_strong_write_lock([&]() {
+            // records after the last irreversible block are applied again
+            db.undo_all();
+        });
+
+        GOLOS_CHECK_VALUE(db.revision() == db.head_block_num(),
+            "Revision of state ${rev} doesn't match its head block ${head}, copy state of the primary node again",
+            ("rev", db.revision())("head", db.head_block_num()));
+
+        stopped = false;
+        follower = std::thread([this]() {
+            follow();
+        });
+    }
+
+    void plugin::impl::stop_follower() {
+        stopped = true;
+        if (follower.joinable()) {
+            follower.join();
+        }
+    }
+
+    void plugin::impl::follow() {
+        ilog("Following state changes from ${f} since block ${n}", ("f", follow_file.string())("n", db.head_block_num()));
+
+        bfs::ifstream in;
+        while (!stopped) {
+            try {
+                if (!in.is_open()) {
+                    if (!bfs::exists(follow_file)) {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                        continue;
+                    }
+                    in.open(follow_file, std::ios::in | std::ios::binary);
+                }
+
+                state_delta delta;
+                if (!read_record(in, delta)) {
+                    if (in.is_open()) {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                    }
+                    continue;
+                }
+
+                db.with_strong_write_lock([&]() {
+                    apply_record(delta);
+                    chain_plugin.snapshots().publish(db);
+                });
+            } catch (const fc::exception& e) {
+                elog("Failed to apply state changes: ${e}", ("e", e.to_detail_string()));
+                appbase::app().quit();
+                return;
+            }
+        }
+    }
+
+    // returns false if record isn't written yet, or closes stream at the end marker of rotated file
+    bool plugin::impl::read_record(bfs::ifstream& in, state_delta& delta) {
+        // the primary can be writing the record now, so wait until all its bytes are available.
+        // Size is taken from the opened stream, because the file with the same name can be already the new one.
+        in.clear();
+        auto pos = in.tellg();
+        in.seekg(0, std::ios::end);
+        auto available = uint64_t(in.tellg() - pos);
+        in.seekg(pos);
+
+        uint32_t size = 0;
+        if (available < sizeof(size)) {
+            return false;
+        }
+        in.read((char*)&size, sizeof(size));
+        if (size == end_of_file_marker) {
+            in.close();
+            return false;
+        }
+        if (available < sizeof(size) + size) {
+            in.seekg(pos);
+            return false;
+        }
+
+        std::vector<char> data(size);
+        in.read(data.data(), size);
+        fc::raw::unpack(data, delta);
+        return true;
+    }
+
+    void plugin::impl::apply_record(const state_delta& delta) {
+        // the primary switched to other fork or the record is applied again after restart
+        while (db.head_block_num() >= delta.block_num ||
+            (db.head_block_num() + 1 == delta.block_num && db.head_block_id() != delta.previous)
+        ) {
+            if (!undo_depth) {
+                GOLOS_CHECK_VALUE(db.head_block_num() >= delta.block_num,
+                    "Record of block ${n} doesn't follow the irreversible head ${id}, copy state of the primary node again",
+                    ("n", delta.block_num)("id", db.head_block_id()));
+                return;
+            }
+            db.undo();
+            --undo_depth;
+        }
+
+        GOLOS_CHECK_VALUE(db.head_block_num() + 1 == delta.block_num,
+            "Records of blocks ${from}..${to} are missing, copy state of the primary node again",
+            ("from", db.head_block_num() + 1)("to", delta.block_num - 1));
+
+        auto session = db.start_undo_session();
+        for (const auto& index : delta.indexes) {
+            auto itr = replicators_by_type.find(index.type_id);
+            GOLOS_CHECK_VALUE(itr != replicators_by_type.end(),
+                "Index of objects with type ${t} isn't registered", ("t", index.type_id));
+            itr->second->apply(db, index);
+        }
+        session.push();
+        ++undo_depth;
+
+        // revision of record session is its block number, sessions of irreversible blocks aren't needed anymore
+        auto head = db.head_block_num();
+        auto lib = std::min(delta.last_irreversible_block_num, head);
+        if (head - lib < undo_depth) {
+            db.commit(lib);
+            undo_depth = head - lib;
+        }
+    }
+
+    plugin::plugin() {
+    }
+
+    plugin::~plugin() {
+    }
+
+    const std::string& plugin::name() {
+        static std::string name = "state_replication";
+        return name;
+    }
+
+    void plugin::set_program_options(bpo::options_description& cli, bpo::options_description& cfg) {
+        cfg.add_options()
+            (
+                "state-replication-file", bpo::value<bfs::path>(),
+                "File to which changes of state are appended after each applied block (primary node)."
+            ) (
+                "state-replication-file-size", bpo::value<uint64_t>()->default_value(1024),
+                "Size of the file of state changes in MB, after which it is replaced by a file with records after "
+                "the last irreversible block (0 - file isn't rotated)."
+            ) (
+                "state-replication-follow", bpo::value<bfs::path>(),
+                "File from which changes of state are applied instead of blocks (read-only follower node)."
+            );
+    }
+
+    void plugin::plugin_initialize(const bpo::variables_map& options) {
+        ilog("Intializing state replication plugin");
+
+        my = std::make_unique<impl>();
+        my->register_core_indexes(*this);
+
+        auto path = [](bfs::path p) {
+            return p.is_relative() ? appbase::app().data_dir() / p : p;
+        };
+
+        if (options.count("state-replication-file")) {
+            my->primary_file = path(options.at("state-replication-file").as<bfs::path>());
+        }
+        my->max_file_size = options.at("state-replication-file-size").as<uint64_t>() * 1024 * 1024;
+        if (options.count("state-replication-follow")) {
+            my->follow_file = path(options.at("state-replication-follow").as<bfs::path>());
+        }
+
+        GOLOS_CHECK_OPTION(my->primary_file.empty() || my->follow_file.empty(),
+            "Node can't be both primary and follower of state replication");
+
+        if (!my->follow_file.empty()) {
+            // state of follower doesn't match the block log, which isn't extended
+            my->db.set_init_block_log(false);
+            // state is changed only by records, blocks aren't received from p2p and aren't produced
+            my->chain_plugin.set_read_only(true);
+        }
+    }
+
+    void plugin::plugin_startup() {
+        ilog("Starting state replication plugin");
+
+        if (!my->primary_file.empty()) {
+            my->out.open(my->primary_file, std::ios::out | std::ios::binary | std::ios::app);
+            if (bfs::exists(my->primary_file)) {
+                my->file_size = bfs::file_size(my->primary_file);
+            }
+            my->db.applied_block_changes.connect([&](const signed_block& b) {
+                my->on_applied_block(b);
+            });
+        } else if (!my->follow_file.empty()) {
+            my->start_follower();
+        }
+    }
+
+    void plugin::plugin_shutdown() {
+        ilog("Shutting down state replication plugin");
+
+        my->stop_follower();
+        if (my->out.is_open()) {
+            my->out.close();
+        }
+    }
+
+    void plugin::add_replicator(std::unique_ptr<index_replicator> replicator) {
+        my->replicators_by_type[replicator->type_id()] = replicator.get();
+        my->replicators.push_back(std::move(replicator));
+    }
+
+} } } // golos::plugins::state_replication
@@ -59,6 +59,9 @@ struct runtime_bucket_object {
     uint32_t total_pow = 0;                               ///< POW submitte
     uint32_t num_pow_witnesses = 0;                       /// < The current count of how many pending POW witnesses
                                                           /// there are, determines the difficulty of doing pow
+    uint32_t signature_cache_hits = 0;                    ///< Public keys found in the signature cache
+    uint32_t signature_cache_misses = 0;                  ///< Public keys recovered from signatures
+    uint32_t signature_cache_size = 0;                    ///< Current count of keys in the signature cache
 };
 
 } } } // golos::plugins::statsd
@@ -2,11 +2,14 @@
 
 #include <appbase/application.hpp>
 
+#include <cstdio>
+
 #include <golos/chain/account_object.hpp>
 #include <golos/chain/comment_object.hpp>
 #include <golos/chain/index.hpp>
 #include <golos/chain/operation_notification.hpp>
 #include <golos/protocol/block.hpp>
+#include <golos/protocol/signature_cache.hpp>
 #include <golos/chain/database.hpp>
 #include <fc/io/json.hpp>
 #include <boost/program_options.hpp>
@@ -51,6 +54,8 @@ public:
 
     void post_operation(const operation_notification &o);
 
+    void on_block_profile(const block_apply_profile &p);
+
     golos::chain::database &database_;
 
     std::shared_ptr<statistics_sender> stat_sender;
@@ -201,6 +206,11 @@ struct operation_process {
 };
 
 void plugin::plugin_impl::on_block(const signed_block &b) {
+    auto cache_stats = signature_cache::instance().get_stats();
+    stat_sender->current_bucket.signature_cache_hits = cache_stats.hits;
+    stat_sender->current_bucket.signature_cache_misses = cache_stats.misses;
+    stat_sender->current_bucket.signature_cache_size = cache_stats.size;
+
     if (b.block_num() == 1) {
         stat_sender->current_bucket.seconds = 0;
         stat_sender->current_bucket.blocks = 1;
@@ -233,6 +243,22 @@ void plugin::plugin_impl::on_block(const signed_block &b) {
     stat_sender->current_bucket.bandwidth += trx_size;
 }
 
+std::string format_timing(const std::string& name, uint64_t us) {
+    char ms[32];
+    snprintf(ms, sizeof(ms), "%.3f", double(us) / 1000);
+    return name + ":" + ms + "|ms";
+}
+
+void plugin::plugin_impl::on_block_profile(const block_apply_profile &p) {
+    stat_sender->push(format_timing("block_apply", p.time_us));
+    for (const auto& step : p.steps) {
+        stat_sender->push(format_timing("block_apply." + step.first, step.second));
+    }
+    for (const auto& evaluator : p.evaluators) {
+        stat_sender->push(format_timing("evaluator." + evaluator.first, evaluator.second));
+    }
+}
+
 void plugin::plugin_impl::pre_operation(const operation_notification &o) {
     auto &db = database();
 
@@ -325,6 +351,10 @@ void plugin::plugin_initialize(const boost::program_options::variables_map& opti
             _my->on_block(b);
         });
 
+        db.applied_block_profile.connect([&](const block_apply_profile &p) {
+            _my->on_block_profile(p);
+        });
+
         db.pre_apply_operation.connect([&](operation_notification &o) {
             _my->pre_operation(o);
         });
@@ -407,6 +437,9 @@ std::vector < std::string > get_as_string (const runtime_bucket_object & b) {
     result.push_back("limit_orders_cancelled:" + std::to_string(b.limit_orders_cancelled));
     result.push_back("total_pow:" + std::to_string(b.total_pow));
     result.push_back("num_pow_witnesses:" + std::to_string(b.num_pow_witnesses));
+    result.push_back("signature_cache_hits:" + std::to_string(b.signature_cache_hits));
+    result.push_back("signature_cache_misses:" + std::to_string(b.signature_cache_misses));
+    result.push_back("signature_cache_size:" + std::to_string(b.signature_cache_size));
     return result;
 }
 
@@ -456,6 +489,9 @@ std::vector < std::string > calculate_delta_with (const runtime_bucket_object &
     increment_counter( result, "limit_orders_cancelled", (b.limit_orders_cancelled - a.limit_orders_cancelled) );
     increment_counter( result, "total_pow", (b.total_pow - a.total_pow) );
     increment_counter( result, "num_pow_witnesses", (b.num_pow_witnesses - a.num_pow_witnesses), "g" );
+    increment_counter( result, "signature_cache_hits", (b.signature_cache_hits - a.signature_cache_hits) );
+    increment_counter( result, "signature_cache_misses", (b.signature_cache_misses - a.signature_cache_misses) );
+    increment_counter( result, "signature_cache_size", b.signature_cache_size, "g" );
     return result;
 }
 
@@ -504,6 +540,9 @@ void runtime_bucket_object::operator=(const runtime_bucket_object & b) {
     limit_orders_cancelled = b.limit_orders_cancelled;
     total_pow = b.total_pow;
     num_pow_witnesses = b.num_pow_witnesses;
+    signature_cache_hits = b.signature_cache_hits;
+    signature_cache_misses = b.signature_cache_misses;
+    signature_cache_size = b.signature_cache_size;
 }
 
 } } } // golos::plugins::statsd
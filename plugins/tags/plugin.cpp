@@ -1,5 +1,6 @@
 #include <boost/program_options/options_description.hpp>
 #include <golos/plugins/tags/plugin.hpp>
+#include <golos/plugins/follow/feed_reader.hpp>
 #include <golos/plugins/tags/tags_object.hpp>
 #include <golos/plugins/json_rpc/api_helper.hpp>
 #include <golos/chain/index.hpp>
@@ -60,9 +61,21 @@ namespace golos { namespace plugins { namespace tags {
 
         bool filter_query(discussion_query& query) const;
 
+        template<typename Fill>
+        void add_unordered_discussion(
+            std::vector<discussion>& result,
+            std::set<comment_object::id_type>& id_set,
+            bool& can_add,
+            const discussion_query& query,
+            comment_object::id_type comment_id,
+            Fill&& fill
+        ) const;
+
         template<typename DatabaseIndex, typename DiscussionIndex, typename Fill>
         std::vector<discussion> select_unordered_discussions(discussion_query&, Fill&&) const;
 
+        std::vector<discussion> select_feed_discussions(discussion_query&) const;
+
         template<typename Iterator, typename Order, typename Select, typename Exit>
         void select_discussions(
             std::set<comment_object::id_type>& id_set,
@@ -315,6 +328,59 @@ namespace golos { namespace plugins { namespace tags {
         return true;
     }
 
+    template<typename Fill>
+    void tags_plugin::impl::add_unordered_discussion(
+        std::vector<discussion>& result,
+        std::set<comment_object::id_type>& id_set,
+        bool& can_add,
+        const discussion_query& query,
+        comment_object::id_type comment_id,
+        Fill&& fill
+    ) const {
+        if (id_set.count(comment_id)) {
+            return;
+        }
+        id_set.insert(comment_id);
+
+        if (query.has_start_comment() && !can_add) {
+            can_add = (query.is_good_start(comment_id));
+            if (!can_add) {
+                return;
+            }
+        }
+
+        auto& db = database();
+        const auto* comment = db.find(comment_id);
+        if (!comment) {
+            return;
+        }
+
+        if ((query.parent_author && *query.parent_author != comment->parent_author) ||
+            (query.parent_permlink && db.make_hashlink(*query.parent_permlink) != comment->parent_hashlink)
+        ) {
+            return;
+        }
+
+        discussion d = create_discussion(*comment);
+        if (!query.is_good_tags(d, tags_number, tag_max_length) || !query.is_good_category(d)) {
+            return;
+        }
+        if (!query.is_good_app(d.app)) {
+            return;
+        }
+        if (!!query.prefs && query.prefs->filter_special && d.is_special()) {
+            return;
+        }
+
+        fill_discussion(d, query);
+        if (!!d.bad && d.bad->to_remove) {
+            return;
+        }
+
+        fill(d);
+        result.push_back(std::move(d));
+    }
+
     template<
         typename DatabaseIndex,
         typename DiscussionIndex,
@@ -345,47 +411,42 @@ namespace golos { namespace plugins { namespace tags {
         for (; query.select_authors.end() != aitr && result.size() < query.limit; ++aitr) {
             auto itr = idx.lower_bound(*aitr);
             for (; itr != etr && itr->account == *aitr && result.size() < query.limit; ++itr) {
-                if (id_set.count(itr->comment)) {
-                    continue;
-                }
-                id_set.insert(itr->comment);
-
-                if (query.has_start_comment() && !can_add) {
-                    can_add = (query.is_good_start(itr->comment));
-                    if (!can_add) {
-                        continue;
-                    }
-                }
+                add_unordered_discussion(result, id_set, can_add, query, itr->comment, [&](discussion& d) {
+                    fill(d, *itr);
+                });
+            }
+        }
+        return result;
+    }
 
-                const auto* comment = db.find(itr->comment);
-                if (!comment) {
-                    continue;
-                }
+    std::vector<discussion> tags_plugin::impl::select_feed_discussions(discussion_query& query) const {
+        std::vector<discussion> result;
 
-                if ((query.parent_author && *query.parent_author != comment->parent_author) ||
-                    (query.parent_permlink && db.make_hashlink(*query.parent_permlink) != comment->parent_hashlink)
-                ) {
-                    continue;
-                }
+        if (!filter_start_comment(query) || !filter_query(query)) {
+            return result;
+        }
 
-                discussion d = create_discussion(*comment);
-                if (!query.is_good_tags(d, tags_number, tag_max_length) || !query.is_good_category(d)) {
-                    continue;
-                }
-                if (!query.is_good_app(d.app)) {
-                    continue;
-                }
-                if (!!query.prefs && query.prefs->filter_special && d.is_special()) {
-                    continue;
-                }
+        auto& db = database();
+        bool can_add = !query.has_start_comment();
 
-                fill_discussion(d, query);
-                if (!!d.bad && d.bad->to_remove) {
-                    continue;
-                }
+        result.reserve(query.limit);
 
-                fill(d, *itr);
-                result.push_back(std::move(d));
+        std::set<comment_object::id_type> id_set;
+        auto aitr = query.select_authors.begin();
+        for (; query.select_authors.end() != aitr && result.size() < query.limit; ++aitr) {
+            // feed is merged with blogs of authors which aren't fanned out to feeds
+            follow::feed_reader reader(db, *aitr);
+            follow::feed_reader::entry e;
+            while (result.size() < query.limit && reader.next(e)) {
+                add_unordered_discussion(result, id_set, can_add, query, e.comment, [&](discussion& d) {
+                    auto reblogs = follow::get_feed_reblogs(db, e);
+                    if (!reblogs.reblogged_by.empty()) {
+                        d.first_reblogged_by = reblogs.reblogged_by.front();
+                        d.first_reblogged_on = reblogs.first_reblogged_on;
+                        d.reblogged_by = std::move(reblogs.reblogged_by);
+                        d.reblog_entries = std::move(reblogs.entries);
+                    }
+                });
             }
         }
         return result;
@@ -604,23 +665,7 @@ namespace golos { namespace plugins { namespace tags {
                 "Node is not running the follow plugin");
 
         return db.with_weak_read_lock([&]() {
-            return pimpl->select_unordered_discussions<follow::feed_index, follow::by_feed>(
-                query,
-                [&](discussion& d, const follow::feed_object& f) {
-                    d.reblogged_by.assign(f.reblogged_by.begin(), f.reblogged_by.end());
-                    d.first_reblogged_by = f.first_reblogged_by;
-                    d.first_reblogged_on = f.first_reblogged_on;
-                    for (const auto& a : f.reblogged_by) {
-                        const auto& blog_idx = db.get_index<follow::blog_index>().indices().get<follow::by_comment>();
-                        auto blog_itr = blog_idx.find(std::make_tuple(f.comment, a));
-                        d.reblog_entries.emplace_back(
-                            a,
-                            to_string(blog_itr->reblog_title),
-                            to_string(blog_itr->reblog_body),
-                            to_string(blog_itr->reblog_json_metadata)
-                        );
-                    }
-                });
+            return pimpl->select_feed_discussions(query);
         });
     }
 
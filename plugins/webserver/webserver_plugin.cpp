@@ -20,6 +20,7 @@
 #include <websocketpp/logger/stub.hpp>
 #include <websocketpp/logger/syslog.hpp>
 
+#include <algorithm>
 #include <thread>
 #include <memory>
 #include <iostream>
@@ -93,6 +94,13 @@ namespace golos {
 
                 void handle_http_message(websocket_server_type *, connection_hdl);
 
+                // calls of batch requests are dispatched to the thread pool
+                plugins::json_rpc::plugin::executor_type batch_executor() {
+                    return [this](std::function<void ()> task) {
+                        thread_pool_ios.post(std::move(task));
+                    };
+                }
+
                 shared_ptr<std::thread> http_thread;
                 asio::io_service http_ios;
                 optional<tcp::endpoint> http_endpoint;
@@ -107,6 +115,10 @@ namespace golos {
 
                 plugins::json_rpc::plugin *api;
                 boost::signals2::connection chain_sync_con;
+
+                // notifications to connection which doesn't read them are dropped, so subscriptions of it are removed,
+                //   and connection is closed if responses to calls can't be buffered
+                size_t ws_max_buffered_size = 0;
             };
 
             void webserver_plugin::webserver_plugin_impl::start_webserver() {
@@ -196,16 +208,34 @@ namespace golos {
             ) {
                 auto con = server->get_con_from_hdl(hdl);
                 thread_pool_ios.post([con, msg, this]() {
+                    // response has the same opcode as request
+                    auto opcode = msg->get_opcode();
+                    auto send_response = [con, opcode, this](std::string &data, bool is_notification){
+                        if (ws_max_buffered_size && con->get_buffered_amount() > ws_max_buffered_size) {
+                            if (is_notification) {
+                                throw websocketpp::exception("Connection doesn't read notifications");
+                            }
+                            // client waits for response to call, so it is notified by closing instead of dropping
+                            websocketpp::lib::error_code ec;
+                            con->close(websocketpp::close::status::try_again_later, "Too many unsent responses", ec);
+                            return;
+                        }
+                        // response buffer is moved to the message without copying
+                        auto response = con->get_message(opcode, 0);
+                        response->get_raw_payload().swap(data);
+                        auto ec = con->send(response);
+                        if (ec) {
+                            throw websocketpp::exception(ec);
+                        }
+                    };
+
                     try {
-                        if (msg->get_opcode() == websocketpp::frame::opcode::text) {
-                            api->call(msg->get_payload(), [con](const std::string &data){
-                                auto ec = con->send(data);
-                                if (ec) {
-                                    throw websocketpp::exception(ec);
-                                }
-                            });
+                        if (opcode == websocketpp::frame::opcode::text) {
+                            api->call(msg->get_payload(), send_response, batch_executor());
+                        } else if (opcode == websocketpp::frame::opcode::binary) {
+                            api->call_binary(msg->get_payload(), send_response);
                         } else {
-                            con->send("error: string payload expected");
+                            con->send("error: string or binary payload expected");
                         }
                     } catch (const fc::exception &e) {
                         con->send("error calling API " + e.to_string());
@@ -221,13 +251,13 @@ namespace golos {
                     auto body = con->get_request_body();
 
                     try {
-                        api->call(body, [con](const std::string &data){
+                        api->call(body, [con](std::string &data, bool){
                             // this lambda can be called from any thread in application
                             //   for example, when task was delegated ( see msg_pack(msg_pack&&) )
                             con->set_body(data);
                             con->set_status(websocketpp::http::status_code::ok);
                             con->send_http_response();
-                        });
+                        }, batch_executor());
                     } catch (fc::exception &e) {
                         // this case happens if exception was thrown on parsing request
                         edump((e));
@@ -259,8 +289,15 @@ namespace golos {
                         "Local websocket endpoint for webserver requests.")
                     ("rpc-endpoint", boost::program_options::value<string>(),
                         "Local http and websocket endpoint for webserver requests. Deprectaed in favor of webserver-http-endpoint and webserver-ws-endpoint")
-                    ("webserver-thread-pool-size", boost::program_options::value<thread_pool_size_t>()->default_value(256),
-                        "Number of threads used to handle queries. Default: 256.");
+                    ("webserver-thread-pool-size",
+                        boost::program_options::value<thread_pool_size_t>()->default_value(
+                            std::max(thread_pool_size_t(2), thread_pool_size_t(std::thread::hardware_concurrency()))),
+                        "Number of threads used to handle queries. Default: number of CPU cores. "
+                        "Use rpc-api-limit to keep heavy APIs from occupying all threads.")
+                    ("webserver-ws-max-buffered-size", boost::program_options::value<size_t>()->default_value(32 * 1024 * 1024),
+                        "Maximum size in bytes of responses which are waiting to be sent to websocket connection. "
+                        "Notifications above it are dropped and subscriptions of connection are removed, "
+                        "connection is closed if response to call is above it. 0 = unlimited.");
             }
 
             void webserver_plugin::plugin_initialize(const boost::program_options::variables_map &options) {
@@ -268,6 +305,7 @@ namespace golos {
                 FC_ASSERT(thread_pool_size > 0, "webserver-thread-pool-size must be greater than 0");
                 ilog("configured with ${tps} thread pool size", ("tps", thread_pool_size));
                 my.reset(new webserver_plugin_impl(thread_pool_size));
+                my->ws_max_buffered_size = options.at("webserver-ws-max-buffered-size").as<size_t>();
 
                 if (options.count("webserver-http-endpoint")) {
                     auto http_endpoint = options.at("webserver-http-endpoint").as<string>();
@@ -183,7 +183,9 @@ namespace golos {
                     //Start NTP time client
                     golos::time::now();
 
-                    if (!pimpl->_witnesses.empty()) {
+                    if (pimpl->chain().is_read_only()) {
+                        elog("Block production is disabled on read-only node.");
+                    } else if (!pimpl->_witnesses.empty()) {
                         ilog("Launching block production for ${n} witnesses.", ("n", pimpl->_witnesses.size()));
                         pimpl->p2p().set_block_production(true);
                         if (pimpl->_production_enabled) {
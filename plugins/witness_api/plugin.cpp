@@ -11,7 +11,9 @@ using namespace golos::chain;
 
 struct plugin::witness_plugin_impl {
 public:
-    witness_plugin_impl() : database(appbase::app().get_plugin<chain::plugin>().db()) {
+    witness_plugin_impl()
+        : chain_plugin(appbase::app().get_plugin<chain::plugin>()),
+          database(chain_plugin.db()) {
     }
 
     ~witness_plugin_impl() = default;
@@ -24,12 +26,23 @@ public:
     uint64_t get_witness_count() const;
     std::set<account_name_type> lookup_witness_accounts(const std::string &lower_bound_name, uint32_t limit) const;
 
+    template <typename T>
+    std::shared_ptr<const T> get_snapshot_part() const {
+        auto snapshot = chain_plugin.get_snapshot();
+        return snapshot ? snapshot->get<T>() : nullptr;
+    }
+
+    chain::plugin& chain_plugin;
     golos::chain::database& database;
 };
 
 
 DEFINE_API(plugin, get_current_median_history_price) {
     PLUGIN_API_VALIDATE_ARGS();
+    auto feed = my->get_snapshot_part<feed_history_api_object>();
+    if (feed) {
+        return feed->current_median_history;
+    }
     return my->database.with_weak_read_lock([&]() {
         return my->database.get_feed_history().current_median_history;
     });
@@ -37,6 +50,10 @@ DEFINE_API(plugin, get_current_median_history_price) {
 
 DEFINE_API(plugin, get_feed_history) {
     PLUGIN_API_VALIDATE_ARGS();
+    auto feed = my->get_snapshot_part<feed_history_api_object>();
+    if (feed) {
+        return *feed;
+    }
     return my->database.with_weak_read_lock([&]() {
         return feed_history_api_object(my->database.get_feed_history());
     });
@@ -82,6 +99,10 @@ DEFINE_API(plugin, get_active_witnesses) {
 
 DEFINE_API(plugin, get_witness_schedule) {
     PLUGIN_API_VALIDATE_ARGS();
+    auto wso = my->get_snapshot_part<witness_schedule_object>();
+    if (wso) {
+        return *wso;
+    }
     return my->database.with_weak_read_lock([&]() {
         return my->database.get(witness_schedule_object::id_type());
     });
@@ -276,6 +297,13 @@ void plugin::plugin_initialize(const boost::program_options::variables_map &opti
     try {
         my = std::make_unique<witness_plugin_impl>();
 
+        my->chain_plugin.add_snapshot_part<feed_history_api_object>([](const golos::chain::database& db) {
+            return feed_history_api_object(db.get_feed_history());
+        });
+        my->chain_plugin.add_snapshot_part<witness_schedule_object>([](const golos::chain::database& db) {
+            return db.get_witness_schedule_object();
+        });
+
         JSON_RPC_REGISTER_API(name());
     } FC_CAPTURE_AND_RETHROW()
 
@@ -34,6 +34,7 @@
 #include <golos/plugins/nft_api/nft_api.hpp>
 #include <golos/plugins/cryptor/cryptor.hpp>
 #include <golos/plugins/exchange/exchange.hpp>
+#include <golos/plugins/state_replication/plugin.hpp>
 #ifdef MONGODB_PLUGIN_BUILT
     #include <golos/plugins/mongo_db/mongo_db_plugin.hpp>
 #endif
@@ -100,6 +101,7 @@ namespace golos {
             appbase::app().register_plugin<golos::plugins::nft_api::nft_api_plugin>();
             appbase::app().register_plugin<golos::plugins::cryptor::cryptor>();
             appbase::app().register_plugin<golos::plugins::exchange::exchange>();
+            appbase::app().register_plugin<golos::plugins::state_replication::plugin>();
             #ifdef MONGODB_PLUGIN_BUILT
                 appbase::app().register_plugin<golos::plugins::mongo_db::mongo_db_plugin>();
             #endif
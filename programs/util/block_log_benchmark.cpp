@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <random>
+#include <thread>
+
+#include <boost/program_options.hpp>
+
+#include <fc/filesystem.hpp>
+#include <fc/time.hpp>
+
+#include <golos/chain/block_log.hpp>
+
+namespace bpo = boost::program_options;
+
+using golos::chain::block_log;
+using golos::protocol::signed_block;
+using golos::protocol::signed_transaction;
+using golos::protocol::transfer_operation;
+
+struct latency_stat final {
+    std::vector<int64_t> usec;
+
+    void print(const std::string& title) {
+        std::sort(usec.begin(), usec.end());
+        auto at = [&](double q) {
+            return usec.empty() ? 0 : usec[std::min(usec.size() - 1, size_t(usec.size() * q))];
+        };
+        std::cout << title << ": " << usec.size() << " calls, "
+            << "p50 " << at(0.5) << ", p99 " << at(0.99) << ", p99.9 " << at(0.999)
+            << ", max " << at(1) << " usec" << std::endl;
+    }
+};
+
+signed_block make_block(const signed_block* prev, uint32_t tx_count, uint32_t memo_size) {
+    signed_block block;
+    if (prev) {
+        block.previous = prev->id();
+        block.timestamp = prev->timestamp + STEEMIT_BLOCK_INTERVAL;
+    }
+    block.witness = "bench";
+    for (uint32_t i = 0; i < tx_count; ++i) {
+        transfer_operation op;
+        op.from = "alice";
+        op.to = "bob";
+        op.memo = std::string(memo_size, 'a' + i % 26);
+        signed_transaction tx;
+        tx.ref_block_num = i;
+        tx.operations.push_back(op);
+        block.transactions.push_back(tx);
+    }
+    return block;
+}
+
+int unsafe_main(int argc, char** argv) {
+    uint32_t block_count = 100000;
+    uint32_t tx_count = 20;
+    uint32_t memo_size = 100;
+    uint32_t readers = 4;
+    uint32_t flush_interval = 20;
+    std::string dir = ".";
+
+    bpo::options_description cli("block_log_benchmark appends blocks to a new block log, while reader threads\n"
+        "read random blocks from it, and measures latency of appends and reads, which shows stalls of readers\n"
+        "caused by growth of the files. At the end it measures reconstruction of the index.\n"
+        "\n"
+        "Example of usage:\n"
+        "block_log_benchmark -b 200000 -r 8\n"
+        "\n"
+        "Command line options");
+
+    cli.add_options()
+        ("blocks,b", bpo::value<uint32_t>(&block_count)->default_value(block_count), "Number of blocks.")
+        ("transactions,t", bpo::value<uint32_t>(&tx_count)->default_value(tx_count), "Transactions in block.")
+        ("memo,m", bpo::value<uint32_t>(&memo_size)->default_value(memo_size), "Size of memo of transaction.")
+        ("readers,r", bpo::value<uint32_t>(&readers)->default_value(readers), "Number of reader threads.")
+        ("flush,f", bpo::value<uint32_t>(&flush_interval)->default_value(flush_interval),
+            "Flush block log each N blocks, 0 - never.")
+        ("dir,d", bpo::value<std::string>(&dir)->default_value(dir), "Directory for temporary block log.")
+        ("help,h", "Print this help message and exit.")
+        ;
+
+    bpo::variables_map vmap;
+    bpo::store(bpo::parse_command_line(argc, argv, cli), vmap);
+    bpo::notify(vmap);
+    if (vmap.count("help") > 0 || block_count == 0) {
+        cli.print(std::cerr);
+        return 0;
+    }
+
+    fc::temp_directory temp_dir(dir);
+    auto path = temp_dir.path() / "block_log";
+
+    block_log log;
+    log.open(path);
+
+    std::atomic<uint32_t> head_num{0};
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> missing{0};
+    std::vector<latency_stat> read_stats(readers);
+    std::vector<std::thread> threads;
+    for (uint32_t r = 0; r < readers; ++r) {
+        threads.emplace_back([&, r]() {
+            std::mt19937 rnd(r);
+            while (!done) {
+                auto head = head_num.load();
+                if (!head) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                auto num = std::uniform_int_distribution<uint32_t>(1, head)(rnd);
+                auto start = fc::time_point::now();
+                auto view = log.read_block_view(num);
+                if (!view.valid()) {
+                    ++missing;
+                }
+                read_stats[r].usec.push_back((fc::time_point::now() - start).count());
+            }
+        });
+    }
+
+    latency_stat append_stat;
+    latency_stat flush_stat;
+    signed_block prev;
+    auto start = fc::time_point::now();
+    for (uint32_t i = 0; i < block_count; ++i) {
+        auto block = make_block(i ? &prev : nullptr, tx_count, memo_size);
+
+        auto append_start = fc::time_point::now();
+        log.append(block);
+        append_stat.usec.push_back((fc::time_point::now() - append_start).count());
+
+        if (flush_interval && (i + 1) % flush_interval == 0) {
+            auto flush_start = fc::time_point::now();
+            log.flush();
+            flush_stat.usec.push_back((fc::time_point::now() - flush_start).count());
+        }
+
+        head_num = block.block_num();
+        prev = std::move(block);
+    }
+    auto seconds = double((fc::time_point::now() - start).count()) / 1000000;
+
+    done = true;
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    std::cout << block_count << " blocks appended in " << seconds << " sec, "
+        << (seconds > 0 ? block_count / seconds : 0) << " blocks/sec, "
+        << fc::file_size(path) << " bytes" << std::endl;
+    append_stat.print("append");
+    flush_stat.print("flush ");
+    latency_stat all_reads;
+    for (auto& s : read_stats) {
+        all_reads.usec.insert(all_reads.usec.end(), s.usec.begin(), s.usec.end());
+    }
+    all_reads.print("read  ");
+    if (missing) {
+        std::cout << missing << " appended blocks weren't found by readers" << std::endl;
+    }
+
+    log.close();
+    fc::remove(fc::path(path.string() + ".index"));
+    start = fc::time_point::now();
+    log.open(path);
+    seconds = double((fc::time_point::now() - start).count()) / 1000000;
+    FC_ASSERT(log.head().valid() && log.head()->block_num() == block_count);
+    std::cout << "index reconstructed in " << seconds << " sec" << std::endl;
+
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    try {
+        return unsafe_main(argc, argv);
+    } catch (const fc::exception& e) {
+        std::cerr << e.to_detail_string() << std::endl;
+        return -1;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return -1;
+    }
+}
@@ -0,0 +1,93 @@
+#include <iostream>
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include <golos/chain/block_log.hpp>
+#include <golos/chain/compressed_block_log.hpp>
+
+namespace bfs = boost::filesystem;
+namespace bpo = boost::program_options;
+
+int unsafe_main(int argc, char** argv) {
+    bfs::path input;
+    bfs::path output;
+    uint32_t keep_blocks = 0;
+    uint32_t blocks_per_chunk = golos::chain::compressed_block_log::default_blocks_per_chunk;
+
+    bpo::options_description cli("compress_block_log moves old blocks of block_log to the compressed block log.\n"
+        "\n"
+        "It writes <output>.z, <output>.z.index and <output> with the rest of blocks.\n"
+        "Replace block_log files in the data directory of the stopped node with the output files.\n"
+        "\n"
+        "Example of usage:\n"
+        "compress_block_log -i /data/blockchain/block_log -o /tmp/blockchain/block_log -k 100000\n"
+        "\n"
+        "Command line options");
+
+    cli.add_options()
+        ("input,i", bpo::value<bfs::path>(&input), "Path to source block_log.")
+        ("output,o", bpo::value<bfs::path>(&output), "Path to output block_log, it shouldn't exist.")
+        ("keep-blocks,k", bpo::value<uint32_t>(&keep_blocks)->default_value(keep_blocks),
+            "Number of last blocks which are left uncompressed.")
+        ("blocks-per-chunk,c", bpo::value<uint32_t>(&blocks_per_chunk)->default_value(blocks_per_chunk),
+            "Number of blocks which are compressed together.")
+        ("help,h", "Print this help message and exit.")
+        ;
+
+    bpo::variables_map vmap;
+    bpo::store(bpo::parse_command_line(argc, argv, cli), vmap);
+    bpo::notify(vmap);
+    if (vmap.count("help") > 0 || vmap.count("input") == 0 || vmap.count("output") == 0) {
+        cli.print(std::cerr);
+        return 0;
+    }
+
+    if (!bfs::is_regular_file(input)) {
+        std::cerr << input.string() << " is not a file." << std::endl;
+        return -1;
+    }
+
+    if (bfs::exists(output) || bfs::exists(golos::chain::compressed_block_log::archive_path(output))) {
+        std::cerr << output.string() << " already exists." << std::endl;
+        return -2;
+    }
+
+    golos::chain::block_log source;
+    source.open(input);
+
+    if (!source.head().valid()) {
+        std::cerr << "Block log is empty." << std::endl;
+        return -3;
+    }
+
+    const auto head_block_num = source.head()->block_num();
+    if (head_block_num <= keep_blocks) {
+        std::cerr << "Block log contains only " << head_block_num << " blocks, nothing to compress." << std::endl;
+        return -4;
+    }
+    const auto last_block_num = head_block_num - keep_blocks;
+
+    std::cout << "Compressing blocks 1.." << last_block_num << "..." << std::endl;
+    golos::chain::compressed_block_log::write(source, last_block_num, output, blocks_per_chunk);
+
+    std::cout << "Copying blocks " << last_block_num + 1 << ".." << head_block_num << "..." << std::endl;
+    golos::chain::block_log target;
+    target.open(output);
+    for (auto block_num = last_block_num + 1; block_num <= head_block_num; ++block_num) {
+        target.append(*source.read_block_by_num(block_num));
+    }
+    target.close();
+
+    std::cout << "Done." << std::endl;
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    try {
+        return unsafe_main(argc, argv);
+    } catch (const fc::exception& e) {
+        std::cerr << e.to_detail_string() << std::endl;
+        return -1;
+    }
+}
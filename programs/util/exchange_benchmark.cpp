@@ -0,0 +1,201 @@
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+#include <boost/program_options.hpp>
+
+#include <fc/time.hpp>
+
+#include <golos/plugins/exchange/exchange_router.hpp>
+
+namespace bpo = boost::program_options;
+
+using namespace golos::protocol;
+using namespace golos::plugins::exchange;
+
+/**
+ * Order books of synthetic assets. Each asset is traded with GOLOS and with few random assets,
+ * prices of pairs follow random values of assets with spread, so there are many chains of similar price.
+ */
+ex_graph_ptr make_graph(uint32_t asset_count, uint32_t links, uint32_t orders, std::mt19937& rnd) {
+    auto graph = std::make_shared<ex_graph>();
+    graph->assets[STEEM_SYMBOL] = asset_info("GOLOS");
+
+    std::vector<asset_symbol_type> symbols = {STEEM_SYMBOL};
+    std::vector<double> values = {1};
+    std::uniform_real_distribution<double> value(0.5, 2);
+    for (uint32_t i = 0; i < asset_count; ++i) {
+        std::ostringstream name;
+        name << "A" << std::setw(5) << std::setfill('0') << i;
+        auto symbol = asset::from_string("0.000 " + name.str()).symbol;
+        graph->assets[symbol] = asset_info(name.str());
+        symbols.push_back(symbol);
+        values.push_back(value(rnd));
+    }
+
+    std::uniform_int_distribution<uint32_t> other(1, asset_count);
+    std::uniform_int_distribution<int64_t> for_sale(1000, 1000000);
+    std::uniform_real_distribution<double> spread(0.001, 0.01);
+
+    auto add_pair = [&](size_t base, size_t quote) {
+        if (base == quote || graph->find(symbols[base], symbols[quote])) {
+            return;
+        }
+        double worse = 1;
+        for (uint32_t i = 0; i < orders; ++i) {
+            worse += spread(rnd);
+            int64_t base_amount = 1000000;
+            auto quote_amount = int64_t(base_amount * values[base] / values[quote] * worse);
+            graph->add_order(price(asset(base_amount, symbols[base]), asset(quote_amount, symbols[quote])),
+                for_sale(rnd));
+        }
+    };
+
+    for (size_t i = 1; i < symbols.size(); ++i) {
+        add_pair(0, i);
+        add_pair(i, 0);
+        for (uint32_t l = 0; l < links; ++l) {
+            auto j = other(rnd);
+            add_pair(i, j);
+            add_pair(j, i);
+        }
+    }
+
+    graph->index();
+    return graph;
+}
+
+struct bench_stat final {
+    std::vector<int64_t> usec;
+    uint32_t timeouts = 0;
+    uint32_t cached = 0;
+    uint64_t chains = 0;
+
+    void print(const std::string& title) {
+        std::sort(usec.begin(), usec.end());
+        int64_t total = 0;
+        for (auto u : usec) {
+            total += u;
+        }
+        auto at = [&](double q) {
+            return usec.empty() ? 0 : usec[std::min(usec.size() - 1, size_t(usec.size() * q))];
+        };
+        std::cout << title << ": " << usec.size() << " queries, "
+            << "avg " << (usec.empty() ? 0 : total / int64_t(usec.size())) << " usec, "
+            << "p50 " << at(0.5) << ", p99 " << at(0.99) << ", max " << at(1) << " usec, "
+            << chains << " chains, " << cached << " cached, " << timeouts << " timeouts" << std::endl;
+    }
+};
+
+void run(const exchange_router& router, const ex_graph& graph, const std::vector<exchange_query>& queries,
+    bench_stat& stat
+) {
+    for (const auto& query : queries) {
+        ex_stat timer;
+        auto start = fc::time_point::now();
+        auto found = router.find(query, graph, timer);
+        stat.usec.push_back((fc::time_point::now() - start).count());
+        stat.chains += found.chains.size();
+        stat.cached += found.cached;
+        stat.timeouts += found.timeout;
+    }
+}
+
+int unsafe_main(int argc, char** argv) {
+    uint32_t asset_count = 300;
+    uint32_t links = 4;
+    uint32_t orders = 5;
+    uint32_t query_count = 1000;
+    uint32_t seed = 1;
+    ex_router_options options;
+
+    bpo::options_description cli("exchange_benchmark measures latency of search of exchange chains "
+        "on order books of synthetic assets.\n"
+        "\n"
+        "Example of usage:\n"
+        "exchange_benchmark -a 500 -l 6 -q 2000\n"
+        "\n"
+        "Command line options");
+
+    cli.add_options()
+        ("assets,a", bpo::value<uint32_t>(&asset_count)->default_value(asset_count), "Number of assets.")
+        ("links,l", bpo::value<uint32_t>(&links)->default_value(links), "Number of pairs of asset besides GOLOS.")
+        ("orders,o", bpo::value<uint32_t>(&orders)->default_value(orders), "Number of orders in pair.")
+        ("queries,q", bpo::value<uint32_t>(&query_count)->default_value(query_count), "Number of queries.")
+        ("seed,s", bpo::value<uint32_t>(&seed)->default_value(seed), "Seed of random generator.")
+        ("max-hops", bpo::value<uint16_t>(&options.max_hops)->default_value(options.max_hops),
+            "Max number of steps in chain.")
+        ("max-chains", bpo::value<uint16_t>(&options.max_chains)->default_value(options.max_chains),
+            "Number of the best chains.")
+        ("timeout", bpo::value<uint32_t>(&options.timeout)->default_value(options.timeout),
+            "Max time of query in milliseconds.")
+        ("help,h", "Print this help message and exit.")
+        ;
+
+    bpo::variables_map vmap;
+    bpo::store(bpo::parse_command_line(argc, argv, cli), vmap);
+    bpo::notify(vmap);
+    if (vmap.count("help") > 0 || asset_count < 2 || orders == 0 || options.max_hops == 0 || options.max_chains == 0) {
+        cli.print(std::cerr);
+        return 0;
+    }
+
+    std::mt19937 rnd(seed);
+    auto graph = make_graph(asset_count, links, orders, rnd);
+    std::cout << graph->assets.size() << " assets, " << graph->pairs.size() << " pairs" << std::endl;
+
+    std::vector<asset_symbol_type> symbols;
+    for (const auto& a : graph->assets) {
+        symbols.push_back(a.first);
+    }
+    std::uniform_int_distribution<size_t> symbol(0, symbols.size() - 1);
+    std::uniform_int_distribution<int64_t> amount(1, 100000);
+    std::vector<exchange_query> queries;
+    while (queries.size() < query_count) {
+        exchange_query query;
+        query.amount = asset(amount(rnd), symbols[symbol(rnd)]);
+        query.sym2 = symbols[symbol(rnd)];
+        query.direction = rnd() % 2 ? exchange_direction::buy : exchange_direction::sell;
+        if (query.amount.symbol != query.sym2) {
+            queries.push_back(query);
+        }
+    }
+
+    auto no_cache = options;
+    no_cache.cache_size = 0;
+    exchange_router uncached_router(no_cache);
+    bench_stat uncached;
+    run(uncached_router, *graph, queries, uncached);
+    uncached.print("search  ");
+
+    options.cache_size = std::max<uint32_t>(options.cache_size, query_count);
+    exchange_router router(options);
+    router.set_graph(graph);
+    bench_stat first;
+    run(router, *graph, queries, first);
+    first.print("cold    ");
+
+    // other amounts of the same buckets
+    for (auto& query : queries) {
+        query.amount.amount.value |= query.amount.amount.value >> 1;
+    }
+    bench_stat second;
+    run(router, *graph, queries, second);
+    second.print("cached  ");
+
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    try {
+        return unsafe_main(argc, argv);
+    } catch (const fc::exception& e) {
+        std::cerr << e.to_detail_string() << std::endl;
+        return -1;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return -1;
+    }
+}
@@ -0,0 +1,189 @@
+#include <iostream>
+
+#include <boost/program_options.hpp>
+
+#include <websocketpp/config/asio_no_tls_client.hpp>
+#include <websocketpp/client.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/time.hpp>
+
+#include <golos/api/block_objects.hpp>
+#include <golos/plugins/json_rpc/binary_rpc.hpp>
+
+namespace bpo = boost::program_options;
+
+using golos::api::timed_signed_block;
+using golos::plugins::json_rpc::binary_rpc_request;
+using golos::plugins::json_rpc::binary_rpc_response;
+
+using ws_client = websocketpp::client<websocketpp::config::asio_client>;
+using websocketpp::connection_hdl;
+
+/**
+ * Calls database_api.get_block for count blocks through one websocket connection,
+ * keeps window calls in flight and unpacks each result to timed_signed_block, as a client of API does.
+ */
+class get_block_benchmark final {
+public:
+    get_block_benchmark(std::string server, bool binary, uint32_t from, uint32_t count, uint32_t window)
+        : _server(std::move(server)), _binary(binary), _from(from), _count(count), _window(window) {
+        _client.clear_access_channels(websocketpp::log::alevel::all);
+        _client.clear_error_channels(websocketpp::log::elevel::all);
+        _client.init_asio();
+        _client.set_open_handler([this](connection_hdl hdl) {
+            _hdl = hdl;
+            start();
+        });
+        _client.set_message_handler([this](connection_hdl, ws_client::message_ptr msg) {
+            on_message(msg);
+        });
+    }
+
+    void run() {
+        websocketpp::lib::error_code ec;
+        auto con = _client.get_connection(_server, ec);
+        FC_ASSERT(!ec, "Can't connect to ${s}: ${e}", ("s", _server)("e", ec.message()));
+        _client.connect(con);
+        _client.run();
+    }
+
+    void print(std::ostream& out) const {
+        auto seconds = double((_end - _start).count()) / 1000000.0;
+        out << (_binary ? "binary" : "json  ") << ": "
+            << _completed << " blocks in " << seconds << " sec, "
+            << (seconds > 0 ? _completed / seconds : 0) << " blocks/sec, "
+            << _bytes << " bytes received, "
+            << _transactions << " transactions" << std::endl;
+    }
+
+private:
+    void send_text(const std::string& data) {
+        _client.send(_hdl, data, websocketpp::frame::opcode::text);
+    }
+
+    void start() {
+        _start = fc::time_point::now();
+        for (uint32_t i = 0; i < _window && _sent < _count; ++i) {
+            send_next();
+        }
+    }
+
+    void send_next() {
+        auto id = _sent++;
+        if (_binary) {
+            binary_rpc_request request;
+            request.id = id;
+            request.method_id = _get_block_id;
+            request.args = {fc::variant(_from + id)};
+            auto data = fc::raw::pack(request);
+            _client.send(_hdl, data.data(), data.size(), websocketpp::frame::opcode::binary);
+        } else {
+            send_text(std::string("{\"id\":") + std::to_string(id) + ",\"jsonrpc\":\"2.0\",\"method\":\"call\","
+                "\"params\":[\"database_api\",\"get_block\",[" + std::to_string(_from + id) + "]]}");
+        }
+    }
+
+    void on_message(ws_client::message_ptr msg) {
+        const auto& payload = msg->get_payload();
+
+        _bytes += payload.size();
+        fc::optional<timed_signed_block> block;
+        if (_binary) {
+            auto response = fc::raw::unpack<binary_rpc_response>(payload.data(), payload.size());
+            FC_ASSERT(response.method == "database_api.get_block", "Server has no database_api.get_block");
+            FC_ASSERT(!response.error.valid(), "Error: ${e}", ("e", response.error->message));
+            FC_ASSERT(response.result.valid(), "Server passed JSON result to binary call");
+            block = fc::raw::unpack<fc::optional<timed_signed_block>>(*response.result);
+        } else {
+            auto response = fc::json::from_string(payload);
+            FC_ASSERT(!response.get_object().contains("error"), "Error: ${e}", ("e", response["error"]));
+            block = response["result"].as<fc::optional<timed_signed_block>>();
+        }
+        if (block.valid()) {
+            _transactions += block->transactions.size();
+        }
+
+        if (++_completed == _count) {
+            _end = fc::time_point::now();
+            _client.close(_hdl, websocketpp::close::status::normal, "");
+        } else if (_sent < _count) {
+            send_next();
+        }
+    }
+
+    ws_client _client;
+    connection_hdl _hdl;
+
+    const std::string _server;
+    const bool _binary;
+    const uint32_t _from;
+    const uint32_t _count;
+    const uint32_t _window;
+
+    const uint32_t _get_block_id = golos::plugins::json_rpc::binary_method_id("database_api.get_block");
+
+    uint32_t _sent = 0;
+    uint32_t _completed = 0;
+    uint64_t _bytes = 0;
+    uint64_t _transactions = 0;
+    fc::time_point _start;
+    fc::time_point _end;
+};
+
+int unsafe_main(int argc, char** argv) {
+    std::string server = "ws://127.0.0.1:8091";
+    std::string mode = "both";
+    uint32_t from = 1;
+    uint32_t count = 10000;
+    uint32_t window = 16;
+
+    bpo::options_description cli("rpc_benchmark compares throughput of database_api.get_block "
+        "through JSON-RPC and binary calls of websocket endpoint.\n"
+        "\n"
+        "Example of usage:\n"
+        "rpc_benchmark -s ws://127.0.0.1:8091 -f 20000000 -c 10000\n"
+        "\n"
+        "Command line options");
+
+    cli.add_options()
+        ("server,s", bpo::value<std::string>(&server)->default_value(server), "Websocket endpoint of node.")
+        ("from,f", bpo::value<uint32_t>(&from)->default_value(from), "Number of the first block.")
+        ("count,c", bpo::value<uint32_t>(&count)->default_value(count), "Number of blocks.")
+        ("window,w", bpo::value<uint32_t>(&window)->default_value(window), "Number of calls in flight.")
+        ("mode,m", bpo::value<std::string>(&mode)->default_value(mode), "json, binary or both.")
+        ("help,h", "Print this help message and exit.")
+        ;
+
+    bpo::variables_map vmap;
+    bpo::store(bpo::parse_command_line(argc, argv, cli), vmap);
+    bpo::notify(vmap);
+    if (vmap.count("help") > 0 || count == 0 || window == 0 ||
+        (mode != "json" && mode != "binary" && mode != "both")
+    ) {
+        cli.print(std::cerr);
+        return 0;
+    }
+
+    for (auto binary : {false, true}) {
+        if (mode != "both" && binary != (mode == "binary")) {
+            continue;
+        }
+        get_block_benchmark benchmark(server, binary, from, count, window);
+        benchmark.run();
+        benchmark.print(std::cout);
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    try {
+        return unsafe_main(argc, argv);
+    } catch (const fc::exception& e) {
+        std::cerr << e.to_detail_string() << std::endl;
+        return -1;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return -1;
+    }
+}
@@ -286,4 +286,54 @@ BOOST_AUTO_TEST_CASE(clear_votes_older_n_smaller_cashout) {
 
 BOOST_AUTO_TEST_SUITE_END() // clear_votes
 
+BOOST_AUTO_TEST_SUITE(state_snapshots)
+
+struct supply_part {
+    golos::protocol::asset supply;
+};
+
+BOOST_AUTO_TEST_CASE(snapshots_of_last_blocks) {
+    BOOST_TEST_MESSAGE("Testing: snapshots_of_last_blocks");
+    initialize({
+        {"state-snapshot-depth", "3"},
+    });
+
+    ch_plugin->add_snapshot_part<supply_part>([](const golos::chain::database& db) {
+        return supply_part{db.get_dynamic_global_properties().current_supply};
+    });
+    generate_blocks(5);
+
+    BOOST_TEST_MESSAGE("--- head snapshot is consistent with state");
+    auto head = ch_plugin->get_snapshot();
+    BOOST_REQUIRE(head);
+    BOOST_CHECK_EQUAL(head->block_num, db->head_block_num());
+    BOOST_CHECK_EQUAL(head->block_id, db->head_block_id());
+    BOOST_REQUIRE(head->get<supply_part>());
+    BOOST_CHECK_EQUAL(head->get<supply_part>()->supply, db->get_dynamic_global_properties().current_supply);
+    BOOST_CHECK(!head->get<golos::protocol::asset>());
+
+    BOOST_TEST_MESSAGE("--- only last 3 blocks are kept");
+    auto head_num = db->head_block_num();
+    BOOST_CHECK(ch_plugin->get_snapshot(head_num - 2));
+    BOOST_CHECK(!ch_plugin->get_snapshot(head_num - 3));
+    BOOST_CHECK(!ch_plugin->get_snapshot(head_num + 1));
+
+    BOOST_TEST_MESSAGE("--- snapshot is kept by reader after it is removed");
+    auto old = ch_plugin->get_snapshot(head_num - 2);
+    generate_blocks(3);
+    BOOST_CHECK(!ch_plugin->get_snapshot(head_num - 2));
+    BOOST_CHECK_EQUAL(old->block_num, head_num - 2);
+
+    BOOST_TEST_MESSAGE("--- snapshot of popped block is replaced");
+    auto popped = ch_plugin->get_snapshot();
+    db->pop_block();
+    generate_block(0, STEEMIT_INIT_PRIVATE_KEY, 1);
+    auto replaced = ch_plugin->get_snapshot(popped->block_num);
+    BOOST_REQUIRE(replaced);
+    BOOST_CHECK_EQUAL(replaced->block_id, db->head_block_id());
+    BOOST_CHECK(replaced->block_id != popped->block_id);
+}
+
+BOOST_AUTO_TEST_SUITE_END() // state_snapshots
+
 BOOST_AUTO_TEST_SUITE_END()
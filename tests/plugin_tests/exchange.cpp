@@ -0,0 +1,252 @@
+#include <boost/test/unit_test.hpp>
+
+#include "database_fixture.hpp"
+
+#include <golos/plugins/exchange/exchange_router.hpp>
+
+using namespace golos::protocol;
+using namespace golos::chain;
+
+using golos::plugins::exchange::asset_info;
+using golos::plugins::exchange::ex_graph;
+using golos::plugins::exchange::ex_result;
+using golos::plugins::exchange::ex_router_options;
+using golos::plugins::exchange::ex_stat;
+using golos::plugins::exchange::exchange_direction;
+using golos::plugins::exchange::exchange_query;
+using golos::plugins::exchange::exchange_router;
+
+// GOLOS -> GBG: directly 1.0, through AAA 2.0 * 0.75 = 1.5, through BBB 1.0 * 1.2 = 1.2
+std::shared_ptr<ex_graph> make_graph() {
+    auto graph = std::make_shared<ex_graph>();
+    graph->assets[STEEM_SYMBOL] = asset_info("GOLOS");
+    graph->assets[SBD_SYMBOL] = asset_info("GBG");
+    graph->assets[ASSET("0.000 AAA").symbol] = asset_info("AAA");
+    graph->assets[ASSET("0.000 BBB").symbol] = asset_info("BBB");
+
+    graph->add_order(price(ASSET("10.000 GBG"), ASSET("10.000 GOLOS")), 10000);
+    graph->add_order(price(ASSET("20.000 AAA"), ASSET("10.000 GOLOS")), 20000);
+    graph->add_order(price(ASSET("7.500 GBG"), ASSET("10.000 AAA")), 7500);
+    graph->add_order(price(ASSET("10.000 BBB"), ASSET("10.000 GOLOS")), 10000);
+    graph->add_order(price(ASSET("12.000 GBG"), ASSET("10.000 BBB")), 12000);
+    graph->index();
+    return graph;
+}
+
+// the same as make_graph(), but AAA -> GBG has only 0.300 GBG for sale
+std::shared_ptr<ex_graph> make_thin_graph() {
+    auto graph = std::make_shared<ex_graph>();
+    graph->assets[STEEM_SYMBOL] = asset_info("GOLOS");
+    graph->assets[SBD_SYMBOL] = asset_info("GBG");
+    graph->assets[ASSET("0.000 AAA").symbol] = asset_info("AAA");
+    graph->assets[ASSET("0.000 BBB").symbol] = asset_info("BBB");
+
+    graph->add_order(price(ASSET("10.000 GBG"), ASSET("10.000 GOLOS")), 10000);
+    graph->add_order(price(ASSET("20.000 AAA"), ASSET("10.000 GOLOS")), 20000);
+    graph->add_order(price(ASSET("7.500 GBG"), ASSET("10.000 AAA")), 300);
+    graph->add_order(price(ASSET("10.000 BBB"), ASSET("10.000 GOLOS")), 10000);
+    graph->add_order(price(ASSET("12.000 GBG"), ASSET("10.000 BBB")), 12000);
+    graph->index();
+    return graph;
+}
+
+exchange_query make_query(asset amount, asset_symbol_type sym2, exchange_direction direction) {
+    exchange_query query;
+    query.amount = amount;
+    query.sym2 = sym2;
+    query.direction = direction;
+    return query;
+}
+
+BOOST_AUTO_TEST_SUITE(exchange_router_tests)
+
+    BOOST_AUTO_TEST_CASE(exchange_router_search) { try {
+        BOOST_TEST_MESSAGE("Testing: exchange_router_search");
+
+        auto graph = make_graph();
+        ex_stat stat;
+
+        BOOST_TEST_MESSAGE("--- sell");
+        exchange_router router;
+        auto query = make_query(ASSET("1.000 GOLOS"), SBD_SYMBOL, exchange_direction::sell);
+        auto found = router.find(query, *graph, stat);
+        BOOST_CHECK(!found.timeout);
+        BOOST_CHECK(!found.cached);
+        BOOST_REQUIRE_EQUAL(found.chains.size(), 3u);
+        BOOST_CHECK_EQUAL(found.chains[0].res(), ASSET("1.500 GBG"));
+        BOOST_CHECK_EQUAL(found.chains[0].size(), 2u);
+        BOOST_CHECK_EQUAL(found.chains[1].res(), ASSET("1.200 GBG"));
+        BOOST_CHECK_EQUAL(found.chains[2].res(), ASSET("1.000 GBG"));
+        BOOST_CHECK_EQUAL(found.chains[2].size(), 1u);
+
+        BOOST_TEST_MESSAGE("--- buy");
+        query = make_query(ASSET("1.500 GBG"), STEEM_SYMBOL, exchange_direction::buy);
+        found = router.find(query, *graph, stat);
+        BOOST_REQUIRE_EQUAL(found.chains.size(), 3u);
+        BOOST_CHECK_EQUAL(found.chains[0].res(), ASSET("1.000 GOLOS"));
+        BOOST_CHECK_EQUAL(found.chains[0].param(), ASSET("1.500 GBG"));
+
+        BOOST_TEST_MESSAGE("--- hidden asset");
+        query = make_query(ASSET("1.000 GOLOS"), SBD_SYMBOL, exchange_direction::sell);
+        query.hidden_assets.insert("AAA");
+        found = router.find(query, *graph, stat);
+        BOOST_REQUIRE_EQUAL(found.chains.size(), 2u);
+        BOOST_CHECK_EQUAL(found.chains[0].res(), ASSET("1.200 GBG"));
+    } FC_LOG_AND_RETHROW() }
+
+    BOOST_AUTO_TEST_CASE(exchange_router_pruning) { try {
+        BOOST_TEST_MESSAGE("Testing: exchange_router_pruning");
+
+        auto graph = make_graph();
+        ex_stat stat;
+        auto query = make_query(ASSET("1.000 GOLOS"), SBD_SYMBOL, exchange_direction::sell);
+
+        BOOST_TEST_MESSAGE("--- the worse chains are dropped, but direct one is kept");
+        ex_router_options options;
+        options.max_chains = 1;
+        exchange_router router(options);
+        auto found = router.find(query, *graph, stat);
+        BOOST_REQUIRE_EQUAL(found.chains.size(), 2u);
+        BOOST_CHECK_EQUAL(found.chains[0].res(), ASSET("1.500 GBG"));
+        BOOST_CHECK_EQUAL(found.chains[1].res(), ASSET("1.000 GBG"));
+
+        BOOST_TEST_MESSAGE("--- limit of steps");
+        options = ex_router_options();
+        options.max_hops = 1;
+        exchange_router router1(options);
+        found = router1.find(query, *graph, stat);
+        BOOST_REQUIRE_EQUAL(found.chains.size(), 1u);
+        BOOST_CHECK_EQUAL(found.chains[0].res(), ASSET("1.000 GBG"));
+    } FC_LOG_AND_RETHROW() }
+
+    BOOST_AUTO_TEST_CASE(exchange_router_partial) { try {
+        BOOST_TEST_MESSAGE("Testing: exchange_router_partial");
+
+        auto graph = make_thin_graph();
+        ex_stat stat;
+        auto query = make_query(ASSET("1.500 GBG"), STEEM_SYMBOL, exchange_direction::buy);
+
+        BOOST_TEST_MESSAGE("--- buy: partial chain pays less, but goes after complete ones");
+        exchange_router router;
+        auto found = router.find(query, *graph, stat);
+        BOOST_REQUIRE_EQUAL(found.chains.size(), 3u);
+        BOOST_CHECK(!found.chains[0].has_remain);
+        BOOST_CHECK_EQUAL(found.chains[0].res(), ASSET("1.250 GOLOS"));
+        BOOST_CHECK(!found.chains[1].has_remain);
+        BOOST_CHECK_EQUAL(found.chains[1].res(), ASSET("1.500 GOLOS"));
+        BOOST_CHECK(found.chains[2].has_remain);
+        BOOST_CHECK_EQUAL(found.chains[2].res(), ASSET("0.200 GOLOS"));
+
+        BOOST_TEST_MESSAGE("--- buy: partial chain doesn't prune complete ones");
+        ex_router_options options;
+        options.max_chains = 1;
+        exchange_router router1(options);
+        found = router1.find(query, *graph, stat);
+        BOOST_REQUIRE_EQUAL(found.chains.size(), 2u);
+        BOOST_CHECK(!found.chains[0].has_remain);
+        BOOST_CHECK_EQUAL(found.chains[0].res(), ASSET("1.250 GOLOS"));
+        BOOST_CHECK_EQUAL(found.chains[1].res(), ASSET("1.500 GOLOS"));
+        BOOST_CHECK_EQUAL(found.chains[1].size(), 1u);
+
+        BOOST_TEST_MESSAGE("--- sell: partial chain with the better price goes after complete ones");
+        query = make_query(ASSET("1.000 GOLOS"), SBD_SYMBOL, exchange_direction::sell);
+        found = router.find(query, *graph, stat);
+        BOOST_REQUIRE_EQUAL(found.chains.size(), 3u);
+        BOOST_CHECK_EQUAL(found.chains[0].res(), ASSET("1.200 GBG"));
+        BOOST_CHECK_EQUAL(found.chains[1].res(), ASSET("1.000 GBG"));
+        BOOST_CHECK(found.chains[2].has_remain);
+        BOOST_CHECK_EQUAL(found.chains[2].res(), ASSET("0.300 GBG"));
+    } FC_LOG_AND_RETHROW() }
+
+    BOOST_AUTO_TEST_CASE(exchange_router_cache) { try {
+        BOOST_TEST_MESSAGE("Testing: exchange_router_cache");
+
+        exchange_router router;
+        router.set_graph(make_graph());
+        auto graph = router.graph();
+        ex_stat stat;
+
+        auto query = make_query(ASSET("1.000 GOLOS"), SBD_SYMBOL, exchange_direction::sell);
+        auto found = router.find(query, *graph, stat);
+        BOOST_CHECK(!found.cached);
+
+        BOOST_TEST_MESSAGE("--- the same bucket of amount");
+        query.amount = ASSET("1.023 GOLOS");
+        found = router.find(query, *graph, stat);
+        BOOST_CHECK(found.cached);
+        BOOST_REQUIRE_EQUAL(found.chains.size(), 3u);
+        BOOST_CHECK_EQUAL(found.chains[0].res(), ASSET("1.534 GBG"));
+
+        BOOST_TEST_MESSAGE("--- other bucket");
+        query.amount = ASSET("1.024 GOLOS");
+        found = router.find(query, *graph, stat);
+        BOOST_CHECK(!found.cached);
+
+        BOOST_TEST_MESSAGE("--- new graph drops cache");
+        router.set_graph(make_graph());
+        found = router.find(query, *router.graph(), stat);
+        BOOST_CHECK(!found.cached);
+    } FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_FIXTURE_TEST_SUITE(exchange_router_db, clean_database_fixture)
+
+    BOOST_AUTO_TEST_CASE(exchange_router_update) { try {
+        BOOST_TEST_MESSAGE("Testing: exchange_router_update");
+
+        exchange_router router;
+        boost::signals2::scoped_connection conn = db->applied_block_changes.connect([&](const signed_block& b) {
+            router.update(*db, b);
+        });
+
+        ACTORS_OLD((alice));
+        fund("alice", ASSET("10.000 GBG"));
+        generate_block();
+
+        BOOST_TEST_MESSAGE("--- the first block builds graph");
+        BOOST_REQUIRE(router.graph());
+        BOOST_CHECK(router.graph()->block_id == db->head_block_id());
+        BOOST_CHECK(router.graph()->pairs.empty());
+
+        ex_stat stat;
+        auto query = make_query(ASSET("1.000 GOLOS"), SBD_SYMBOL, exchange_direction::sell);
+        auto found = router.find(query, *router.graph(), stat);
+        BOOST_CHECK(found.chains.empty());
+
+        BOOST_TEST_MESSAGE("--- created order");
+        signed_transaction tx;
+        limit_order_create_operation op;
+        op.owner = "alice";
+        op.orderid = 1;
+        op.amount_to_sell = ASSET("1.000 GBG");
+        op.min_to_receive = ASSET("2.000 GOLOS");
+        op.expiration = db->head_block_time() + fc::days(1);
+        push_tx_with_ops(tx, alice_private_key, op);
+        generate_block();
+
+        auto orders = router.graph()->find(SBD_SYMBOL, STEEM_SYMBOL);
+        BOOST_REQUIRE(orders);
+        BOOST_REQUIRE_EQUAL(orders->size(), 1u);
+        BOOST_CHECK_EQUAL(orders->front().for_sale.value, 1000);
+
+        BOOST_TEST_MESSAGE("--- changed pair drops cached paths");
+        found = router.find(query, *router.graph(), stat);
+        BOOST_CHECK(!found.cached);
+        BOOST_REQUIRE_EQUAL(found.chains.size(), 1u);
+        BOOST_CHECK_EQUAL(found.chains[0].res(), ASSET("0.500 GBG"));
+
+        BOOST_TEST_MESSAGE("--- canceled order");
+        limit_order_cancel_operation cop;
+        cop.owner = "alice";
+        cop.orderid = 1;
+        push_tx_with_ops(tx, alice_private_key, cop);
+        generate_block();
+
+        BOOST_CHECK(!router.graph()->find(SBD_SYMBOL, STEEM_SYMBOL));
+        found = router.find(query, *router.graph(), stat);
+        BOOST_CHECK(!found.cached);
+        BOOST_CHECK(found.chains.empty());
+    } FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -9,6 +9,8 @@
 
 #include <golos/plugins/follow/plugin.hpp>
 #include <golos/plugins/follow/follow_operations.hpp>
+#include <golos/plugins/follow/feed_reader.hpp>
+#include <golos/plugins/tags/plugin.hpp>
 
 using boost::container::flat_set;
 
@@ -27,6 +29,9 @@ using golos::chain::account_id_type;
 
 using golos::chain::account_name_set;
 
+using golos::plugins::tags::discussion_query;
+using golos::plugins::tags::tags_plugin;
+
 using namespace golos::plugins::follow;
 
 
@@ -193,3 +198,267 @@ BOOST_AUTO_TEST_CASE(reblog_apply) {
 }
 
 BOOST_AUTO_TEST_SUITE_END()
+
+// posts and reblogs of accounts with more than 1 follower aren't fanned out to feeds
+struct follow_feed_fixture : public golos::chain::clean_database_fixture_wrap {
+    follow_feed_fixture() : golos::chain::clean_database_fixture_wrap(true, [&]() {
+        initialize<golos::plugins::follow::plugin, tags_plugin>({{"follow-feed-fanout-threshold", "1"}});
+        open_database();
+        startup();
+    }) {
+    }
+
+    void push_follow_op(const std::string& account, const fc::ecc::private_key& key, follow_plugin_operation op) {
+        custom_binary_operation cop;
+        cop.required_posting_auths.insert(account);
+        cop.id = "follow";
+        boost::container::vector<follow_plugin_operation> vec;
+        vec.push_back(op);
+        cop.data = fc::raw::pack(vec);
+        signed_transaction tx;
+        GOLOS_CHECK_NO_THROW(push_tx_with_ops(tx, key, cop));
+    }
+
+    void follow(const std::string& follower, const fc::ecc::private_key& key, const std::string& following,
+        bool blog = true
+    ) {
+        follow_operation op;
+        op.follower = follower;
+        op.following = following;
+        if (blog) {
+            op.what = {"blog"};
+        }
+        push_follow_op(follower, key, op);
+    }
+
+    void reblog(const std::string& account, const fc::ecc::private_key& key,
+        const std::string& author, const std::string& permlink
+    ) {
+        reblog_operation op;
+        op.account = account;
+        op.author = author;
+        op.permlink = permlink;
+        push_follow_op(account, key, op);
+    }
+
+    void post(const std::string& author, const fc::ecc::private_key& key, const std::string& permlink) {
+        comment_operation op;
+        op.author = author;
+        op.permlink = permlink;
+        op.parent_permlink = "test";
+        op.title = permlink;
+        op.body = "body";
+        signed_transaction tx;
+        GOLOS_CHECK_NO_THROW(push_tx_with_ops(tx, key, op));
+    }
+
+    void wait_root_interval() {
+        generate_blocks(db->head_block_time() + STEEMIT_MIN_ROOT_COMMENT_INTERVAL + fc::seconds(STEEMIT_BLOCK_INTERVAL), true);
+    }
+
+    bool in_feed_objects(const std::string& account, const std::string& author, const std::string& permlink) {
+        const auto& idx = db->get_index<feed_index, by_comment>();
+        const auto& comment = db->get_comment_by_perm(author, permlink);
+        return idx.find(std::make_tuple(comment.id, account_name_type(account))) != idx.end();
+    }
+
+    bool is_feed_from_blog(const std::string& account) {
+        return db->get<follow_count_object, by_account>(account).feed_from_blog;
+    }
+
+    std::vector<comment_feed_entry> get_feed(const std::string& account, uint32_t limit,
+        const comment_feed_entry* start = nullptr
+    ) {
+        msg_pack mp;
+        if (start) {
+            mp.args = std::vector<fc::variant>({fc::variant(account), fc::variant(0), fc::variant(limit),
+                fc::variant(std::set<std::string>()), fc::variant(start->feed_time), fc::variant(start->comment_id)});
+        } else {
+            mp.args = std::vector<fc::variant>({fc::variant(account), fc::variant(0), fc::variant(limit)});
+        }
+        return find_plugin<golos::plugins::follow::plugin>()->get_feed(mp);
+    }
+
+    std::vector<feed_entry> get_feed_entries(const std::string& account, uint32_t limit) {
+        msg_pack mp;
+        mp.args = std::vector<fc::variant>({fc::variant(account), fc::variant(0), fc::variant(limit)});
+        return find_plugin<golos::plugins::follow::plugin>()->get_feed_entries(mp);
+    }
+
+    std::vector<std::string> permlinks(const std::vector<comment_feed_entry>& feed) {
+        std::vector<std::string> result;
+        for (const auto& e : feed) {
+            result.push_back(e.comment.permlink);
+        }
+        return result;
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(follow_feed, follow_feed_fixture)
+
+BOOST_AUTO_TEST_CASE(feed_fanout_threshold) {
+    BOOST_TEST_MESSAGE("Testing: feed_fanout_threshold");
+
+    ACTORS_OLD((alice)(bob)(carol));
+    generate_block();
+
+    BOOST_TEST_MESSAGE("--- author with 1 follower is fanned out");
+    follow("alice", alice_private_key, "bob");
+    post("bob", bob_private_key, "bob1");
+    generate_block();
+    BOOST_CHECK(in_feed_objects("alice", "bob", "bob1"));
+    BOOST_CHECK(!is_feed_from_blog("bob"));
+
+    BOOST_TEST_MESSAGE("--- author crosses threshold");
+    follow("carol", carol_private_key, "bob");
+    wait_root_interval();
+    post("bob", bob_private_key, "bob2");
+    generate_block();
+    BOOST_CHECK(!in_feed_objects("alice", "bob", "bob2"));
+    BOOST_CHECK(!in_feed_objects("carol", "bob", "bob2"));
+    BOOST_CHECK(is_feed_from_blog("bob"));
+
+    BOOST_TEST_MESSAGE("--- feed merges blog, fanned out post is returned once");
+    std::vector<std::string> expected = {"bob2", "bob1"};
+    auto feed = get_feed("alice", 100);
+    BOOST_CHECK(permlinks(feed) == expected);
+    BOOST_REQUIRE_EQUAL(feed.size(), 2u);
+    BOOST_CHECK(feed[0].reblog_by.empty());
+
+    BOOST_TEST_MESSAGE("--- flag is sticky when author loses followers");
+    follow("carol", carol_private_key, "bob", false);
+    wait_root_interval();
+    post("bob", bob_private_key, "bob3");
+    generate_block();
+    BOOST_CHECK(is_feed_from_blog("bob"));
+    BOOST_CHECK(in_feed_objects("alice", "bob", "bob3"));
+
+    expected = {"bob3", "bob2", "bob1"};
+    BOOST_CHECK(permlinks(get_feed("alice", 100)) == expected);
+
+    BOOST_TEST_MESSAGE("--- feed of not follower doesn't read blog");
+    BOOST_CHECK(get_feed("carol", 100).empty());
+}
+
+BOOST_AUTO_TEST_CASE(feed_reader_reblogs) {
+    BOOST_TEST_MESSAGE("Testing: feed_reader_reblogs");
+
+    ACTORS_OLD((alice)(bob)(carol)(dave)(eve)(frank));
+    generate_block();
+
+    // bob and eve have 2 followers, dave has 1
+    follow("alice", alice_private_key, "bob");
+    follow("carol", carol_private_key, "bob");
+    follow("alice", alice_private_key, "eve");
+    follow("carol", carol_private_key, "eve");
+    follow("alice", alice_private_key, "dave");
+    post("frank", frank_private_key, "frank1");
+    post("dave", dave_private_key, "dave1");
+    generate_block();
+    BOOST_CHECK(in_feed_objects("alice", "dave", "dave1"));
+
+    reblog("bob", bob_private_key, "frank", "frank1");
+    reblog("bob", bob_private_key, "dave", "dave1");
+    generate_block();
+    reblog("eve", eve_private_key, "frank", "frank1");
+    generate_block();
+    BOOST_CHECK(is_feed_from_blog("bob"));
+    BOOST_CHECK(is_feed_from_blog("eve"));
+    BOOST_CHECK(!in_feed_objects("alice", "frank", "frank1"));
+
+    BOOST_TEST_MESSAGE("--- repeated reblog is returned once with the newest reblog");
+    BOOST_TEST_MESSAGE("--- reblog of fanned out post is returned once as feed entry");
+    auto feed = get_feed("alice", 100);
+    std::vector<std::string> expected = {"frank1", "dave1"};
+    BOOST_CHECK(permlinks(feed) == expected);
+    BOOST_REQUIRE_EQUAL(feed.size(), 2u);
+    BOOST_REQUIRE_EQUAL(feed[0].reblog_by.size(), 1u);
+    BOOST_CHECK_EQUAL(feed[0].reblog_by[0], "eve");
+    BOOST_REQUIRE_EQUAL(feed[0].reblog_entries.size(), 1u);
+    BOOST_CHECK_EQUAL(feed[0].reblog_entries[0].author, "eve");
+    BOOST_CHECK(feed[0].reblog_on == feed[0].feed_time);
+    BOOST_CHECK(feed[1].reblog_by.empty());
+
+    BOOST_TEST_MESSAGE("--- get_feed_entries returns the same entries");
+    auto entries = get_feed_entries("alice", 100);
+    BOOST_REQUIRE_EQUAL(entries.size(), feed.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        BOOST_CHECK_EQUAL(entries[i].permlink, feed[i].comment.permlink);
+        BOOST_CHECK(entries[i].reblog_by == feed[i].reblog_by);
+        BOOST_CHECK(entries[i].feed_time == feed[i].feed_time);
+        BOOST_CHECK(entries[i].comment_id == feed[i].comment_id);
+    }
+
+    BOOST_TEST_MESSAGE("--- get_discussions_by_feed returns the same posts and reblogs");
+    discussion_query query;
+    query.select_authors = {"alice"};
+    query.limit = 100;
+    msg_pack mp;
+    mp.args = std::vector<fc::variant>({fc::variant(query)});
+    auto discussions = find_plugin<tags_plugin>()->get_discussions_by_feed(mp);
+    BOOST_REQUIRE_EQUAL(discussions.size(), feed.size());
+    for (size_t i = 0; i < discussions.size(); ++i) {
+        BOOST_CHECK_EQUAL(discussions[i].permlink, feed[i].comment.permlink);
+        BOOST_CHECK_EQUAL(discussions[i].reblogged_by.size(), feed[i].reblog_by.size());
+    }
+    BOOST_REQUIRE(discussions[0].first_reblogged_by);
+    BOOST_CHECK_EQUAL(*discussions[0].first_reblogged_by, "eve");
+    BOOST_CHECK(!discussions[1].first_reblogged_by);
+}
+
+BOOST_AUTO_TEST_CASE(feed_reader_paging) {
+    BOOST_TEST_MESSAGE("Testing: feed_reader_paging");
+
+    ACTORS_OLD((alice)(bob)(carol)(dave));
+    generate_block();
+
+    // bob is read from blog, dave is fanned out
+    follow("alice", alice_private_key, "bob");
+    follow("carol", carol_private_key, "bob");
+    follow("alice", alice_private_key, "dave");
+    generate_block();
+
+    // posts of the same block have equal times
+    for (int i = 0; i < 4; ++i) {
+        post("bob", bob_private_key, "bob" + std::to_string(i));
+        post("dave", dave_private_key, "dave" + std::to_string(i));
+        generate_block();
+        wait_root_interval();
+    }
+    BOOST_CHECK(in_feed_objects("alice", "dave", "dave0"));
+    BOOST_CHECK(!in_feed_objects("alice", "bob", "bob0"));
+
+    auto full = get_feed("alice", 100);
+    BOOST_REQUIRE_EQUAL(full.size(), 8u);
+    for (size_t i = 1; i < full.size(); ++i) {
+        BOOST_CHECK(std::tie(full[i - 1].feed_time, full[i - 1].comment_id) >
+            std::tie(full[i].feed_time, full[i].comment_id));
+    }
+
+    BOOST_TEST_MESSAGE("--- pages started from the last entry give the whole feed");
+    for (uint32_t limit = 2; limit <= 4; ++limit) {
+        std::vector<comment_feed_entry> paged;
+        auto page = get_feed("alice", limit);
+        paged = page;
+        while (page.size() == limit) {
+            auto last = page.back();
+            page = get_feed("alice", limit, &last);
+            BOOST_REQUIRE(!page.empty());
+            BOOST_CHECK_EQUAL(page.front().comment.permlink, last.comment.permlink);
+            paged.insert(paged.end(), page.begin() + 1, page.end());
+        }
+        BOOST_CHECK(permlinks(paged) == permlinks(full));
+    }
+
+    BOOST_TEST_MESSAGE("--- new posts don't shift pages");
+    auto first_page = get_feed("alice", 3);
+    post("dave", dave_private_key, "dave4");
+    post("bob", bob_private_key, "bob4");
+    generate_block();
+    auto next_page = get_feed("alice", 3, &first_page.back());
+    BOOST_REQUIRE_EQUAL(next_page.size(), 3u);
+    BOOST_CHECK_EQUAL(next_page[0].comment.permlink, full[2].comment.permlink);
+    BOOST_CHECK_EQUAL(next_page[1].comment.permlink, full[3].comment.permlink);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
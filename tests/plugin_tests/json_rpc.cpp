@@ -6,6 +6,8 @@
 #include <golos/chain/comment_object.hpp>
 #include <golos/protocol/steem_operations.hpp>
 
+#include <set>
+
 #include <golos/plugins/json_rpc/plugin.hpp>
 
 #include "database_fixture.hpp"
@@ -20,6 +22,7 @@ namespace test_plugin {
     using golos::plugins::json_rpc::msg_pack;
 
     DEFINE_API_ARGS(throw_exception, msg_pack, std::string)
+    DEFINE_API_ARGS(echo,            msg_pack, std::vector<std::string>)
 
     class testing_api final : public appbase::plugin<testing_api> {
     public:
@@ -47,7 +50,7 @@ namespace test_plugin {
 
         void plugin_shutdown() override { }
 
-        DECLARE_API((throw_exception))
+        DECLARE_API((throw_exception)(echo))
     };
 
     DEFINE_API(testing_api, throw_exception) {
@@ -82,14 +85,38 @@ namespace test_plugin {
 
         throw "Internal error";
     }
+
+    DEFINE_API(testing_api, echo) {
+        std::vector<std::string> result;
+        for (const auto& arg: *args.args) {
+            result.push_back(arg.as_string());
+        }
+        return result;
+    }
 } // namespace test_plugin
 
+using golos::plugins::json_rpc::binary_rpc_request;
+using golos::plugins::json_rpc::binary_rpc_response;
+
 fc::variant call(json_rpc_plugin& plugin, const std::string& request) {
     fc::variant response;
-    plugin.call(request, [&](const std::string& str) {response = fc::json::from_string(str);});
+    plugin.call(request, [&](const std::string& str, bool) {response = fc::json::from_string(str);});
+    return response;
+}
+
+binary_rpc_response call_binary(json_rpc_plugin& plugin, const std::string& request) {
+    binary_rpc_response response;
+    plugin.call_binary(request, [&](const std::string& str, bool) {
+        response = fc::raw::unpack<binary_rpc_response>(str.data(), str.size());
+    });
     return response;
 }
 
+binary_rpc_response call_binary(json_rpc_plugin& plugin, const binary_rpc_request& request) {
+    auto data = fc::raw::pack(request);
+    return call_binary(plugin, std::string(data.begin(), data.end()));
+}
+
 void check_error_response(const fc::variant& response, const fc::variant& id, int32_t code, const std::string& error_name = std::string()) {
     BOOST_CHECK_EQUAL(response["jsonrpc"].get_string(), "2.0");
     BOOST_CHECK_EQUAL(response["id"].get_type(), id.get_type());
@@ -289,6 +316,116 @@ BOOST_FIXTURE_TEST_SUITE(json_rpc, database_fixture)
                 check_error_response(response, fc::variant(1u), JSON_RPC_INTERNAL_ERROR);
             });
 
+            BOOST_TEST_MESSAGE("--- binary calls address methods by hash of name");
+            auto methods = call(rpc_plugin, "{\"id\":1, \"jsonrpc\":\"2.0\",\"method\":\"call\",\"params\":["
+                    "\"json_rpc\",\"get_methods\",[]]}")["result"].as<std::vector<std::string>>();
+            auto method_id = [&](const std::string& name) -> uint32_t {
+                BOOST_REQUIRE(std::find(methods.begin(), methods.end(), name) != methods.end());
+                return golos::plugins::json_rpc::binary_method_id(name);
+            };
+            std::set<uint32_t> method_ids;
+            for (const auto& name: methods) {
+                method_ids.insert(method_id(name));
+            }
+            BOOST_CHECK_EQUAL(method_ids.size(), methods.size());
+
+            BOOST_TEST_MESSAGE("--- invalid binary request");
+            GOLOS_CHECK_NO_THROW({
+                auto response = call_binary(rpc_plugin, std::string("\x01"));
+                BOOST_REQUIRE(response.error.valid());
+                BOOST_CHECK_EQUAL(response.error->code, JSON_RPC_PARSE_ERROR);
+            });
+
+            BOOST_TEST_MESSAGE("--- missing method id");
+            GOLOS_CHECK_NO_THROW({
+                binary_rpc_request request;
+                request.id = 2;
+                request.method_id = 0;
+                while (method_ids.count(request.method_id)) {
+                    ++request.method_id;
+                }
+                auto response = call_binary(rpc_plugin, request);
+                BOOST_CHECK_EQUAL(response.id, 2u);
+                BOOST_CHECK_EQUAL(response.method, "");
+                BOOST_REQUIRE(response.error.valid());
+                BOOST_CHECK_EQUAL(response.error->code, JSON_RPC_METHOD_NOT_FOUND);
+            });
+
+            BOOST_TEST_MESSAGE("--- result is packed by fc::raw from return type of method");
+            GOLOS_CHECK_NO_THROW({
+                binary_rpc_request request;
+                request.id = 3;
+                request.method_id = method_id("testing_api.echo");
+                request.args = {fc::variant("alice"), fc::variant("bob")};
+                auto response = call_binary(rpc_plugin, request);
+                BOOST_CHECK_EQUAL(response.id, 3u);
+                BOOST_CHECK_EQUAL(response.method, "testing_api.echo");
+                BOOST_CHECK(!response.error.valid());
+                BOOST_CHECK(!response.json_result.valid());
+                BOOST_REQUIRE(response.result.valid());
+                auto result = fc::raw::unpack<std::vector<std::string>>(*response.result);
+                BOOST_CHECK(result == std::vector<std::string>({"alice", "bob"}));
+            });
+
+            BOOST_TEST_MESSAGE("--- binary call returns the same error codes as JSON-RPC");
+            GOLOS_CHECK_NO_THROW({
+                binary_rpc_request request;
+                request.id = 4;
+                request.method_id = method_id("testing_api.throw_exception");
+                request.args = {fc::variant("invalid_parameter")};
+                auto response = call_binary(rpc_plugin, request);
+                BOOST_CHECK_EQUAL(response.id, 4u);
+                BOOST_CHECK_EQUAL(response.method, "testing_api.throw_exception");
+                BOOST_CHECK(!response.result.valid());
+                BOOST_REQUIRE(response.error.valid());
+                BOOST_CHECK_EQUAL(response.error->code, SERVER_INVALID_PARAMETER);
+                BOOST_REQUIRE(response.error->data.valid());
+                BOOST_CHECK_EQUAL(fc::json::from_string(*response.error->data)["name"].as_string(), "invalid_parameter");
+            });
+        }
+        FC_LOG_AND_RETHROW()
+    }
+
+    BOOST_AUTO_TEST_CASE(json_stream_test) {
+        try {
+            using golos::plugins::json_rpc::to_json_string;
+
+            auto check = [](const auto& value) {
+                BOOST_CHECK_EQUAL(to_json_string(value), fc::json::to_string(fc::variant(value)));
+            };
+
+            transfer_operation op;
+            op.from = "alice";
+            op.to = "bob";
+            op.amount = asset(100, STEEM_SYMBOL);
+            op.memo = "quote \" and\nnew line";
+
+            signed_transaction trx;
+            trx.ref_block_num = 65535;
+            trx.expiration = fc::time_point_sec(1000);
+            trx.operations.push_back(op);
+
+            BOOST_TEST_MESSAGE("--- operations and transactions");
+            check(op);
+            check(trx);
+            check(std::vector<signed_transaction>{trx, trx});
+
+            BOOST_TEST_MESSAGE("--- containers");
+            check(std::map<uint32_t, std::string>{{1, "a"}, {2, "b"}});
+            check(fc::flat_set<std::string>{"a", "b"});
+            check(std::make_pair(uint64_t(0xFFFFFFFFFFull), int32_t(-1)));
+            check(std::vector<char>{'a', 'b'});
+
+            BOOST_TEST_MESSAGE("--- optional members are skipped");
+            chain_properties_update_operation props;
+            props.owner = "alice";
+            check(props);
+            check(fc::optional<asset>());
+            check(fc::optional<asset>(op.amount));
+
+            BOOST_TEST_MESSAGE("--- reflected types with own to_variant()");
+            check(golos::protocol::hardfork_version(0, 19));
+            check(public_key_type());
         }
         FC_LOG_AND_RETHROW()
     }
@@ -0,0 +1,148 @@
+#include <boost/test/unit_test.hpp>
+
+#include "database_fixture.hpp"
+
+#include <golos/plugins/market_history/market_depth_cache.hpp>
+
+using namespace golos::protocol;
+using namespace golos::chain;
+
+using golos::plugins::market_history::market_depth_cache;
+using golos::plugins::market_history::market_depth_diff;
+
+// book should contain the same orders as limit_order_index
+void check_book(const database& db, const market_depth_cache& cache) {
+    auto book = cache.get();
+    BOOST_REQUIRE(book);
+    BOOST_CHECK_EQUAL(book->block_num, db.head_block_num());
+    BOOST_CHECK(book->block_id == db.head_block_id());
+
+    std::vector<std::pair<int64_t, int64_t>> expected;
+    for (const auto& o : db.get_index<limit_order_index, by_price>()) {
+        expected.emplace_back(o.id._id, o.for_sale.value);
+    }
+
+    std::vector<std::pair<int64_t, int64_t>> actual;
+    for (const auto& s : book->sides) {
+        int64_t total = 0;
+        for (const auto& l : s.second->levels) {
+            BOOST_CHECK(!l.second->orders.empty());
+            int64_t level_total = 0;
+            for (const auto& o : l.second->orders) {
+                BOOST_CHECK(o.sell_price == l.first);
+                actual.emplace_back(o.id._id, o.for_sale.value);
+                level_total += o.for_sale.value;
+            }
+            BOOST_CHECK_EQUAL(level_total, l.second->total.value);
+            total += level_total;
+        }
+        BOOST_CHECK_EQUAL(total, s.second->total.value);
+    }
+
+    std::sort(expected.begin(), expected.end());
+    std::sort(actual.begin(), actual.end());
+    BOOST_CHECK(expected == actual);
+}
+
+BOOST_FIXTURE_TEST_SUITE(market_depth, clean_database_fixture)
+
+    BOOST_AUTO_TEST_CASE(market_depth_cache_test) { try {
+        BOOST_TEST_MESSAGE("Testing: market_depth_cache_test");
+
+        market_depth_cache cache;
+        market_depth_diff diff;
+        boost::signals2::scoped_connection conn = db->applied_block_changes.connect([&](const signed_block& b) {
+            diff = market_depth_diff();
+            cache.update(*db, b, &diff);
+        });
+
+        ACTORS_OLD((alice)(bob));
+        fund("alice", ASSET("10.000 GBG"));
+        fund("bob", ASSET("10.000 GOLOS"));
+        generate_block();
+
+        BOOST_TEST_MESSAGE("--- the first block builds book");
+        BOOST_CHECK(diff.reset);
+        check_book(*db, cache);
+
+        BOOST_TEST_MESSAGE("--- created order");
+        signed_transaction tx;
+        limit_order_create_operation op;
+        op.owner = "alice";
+        op.orderid = 1;
+        op.amount_to_sell = ASSET("1.000 GBG");
+        op.min_to_receive = ASSET("2.000 GOLOS");
+        op.expiration = db->head_block_time() + fc::days(1);
+        push_tx_with_ops(tx, alice_private_key, op);
+        generate_block();
+
+        BOOST_CHECK(!diff.reset);
+        check_book(*db, cache);
+        BOOST_REQUIRE_EQUAL(diff.levels.size(), 1u);
+        BOOST_CHECK_EQUAL(diff.levels[0].for_sale, ASSET("1.000 GBG"));
+        BOOST_CHECK_EQUAL(diff.levels[0].orders, 1);
+
+        BOOST_TEST_MESSAGE("--- order with other price doesn't copy other levels of side");
+        auto prev_book = cache.get();
+        op.orderid = 2;
+        op.min_to_receive = ASSET("4.000 GOLOS");
+        push_tx_with_ops(tx, alice_private_key, op);
+        generate_block();
+
+        check_book(*db, cache);
+        BOOST_REQUIRE_EQUAL(diff.levels.size(), 1u);
+        BOOST_CHECK(diff.levels[0].sell_price == op.amount_to_sell / op.min_to_receive);
+        auto prev_side = prev_book->sides.begin()->second;
+        auto side = cache.get()->sides.begin()->second;
+        BOOST_CHECK_NE(prev_side.get(), side.get());
+        BOOST_REQUIRE_EQUAL(prev_side->levels.size(), 1u);
+        BOOST_REQUIRE_EQUAL(side->levels.size(), 2u);
+        BOOST_CHECK_EQUAL(side->levels.begin()->second.get(), prev_side->levels.begin()->second.get());
+
+        limit_order_cancel_operation cop;
+        cop.owner = "alice";
+        cop.orderid = 2;
+        push_tx_with_ops(tx, alice_private_key, cop);
+        generate_block();
+
+        check_book(*db, cache);
+        BOOST_CHECK_EQUAL(cache.get()->sides.begin()->second->levels.size(), 1u);
+        BOOST_REQUIRE_EQUAL(diff.levels.size(), 1u);
+        BOOST_CHECK_EQUAL(diff.levels[0].orders, 0);
+
+        BOOST_TEST_MESSAGE("--- partially filled order");
+        op.owner = "bob";
+        op.amount_to_sell = ASSET("1.500 GOLOS");
+        op.min_to_receive = ASSET("0.750 GBG");
+        push_tx_with_ops(tx, bob_private_key, op);
+        generate_block();
+
+        BOOST_CHECK(!diff.reset);
+        check_book(*db, cache);
+        auto book = cache.get();
+        BOOST_REQUIRE_EQUAL(book->sides.size(), 1u);
+        BOOST_CHECK_EQUAL(book->sides.begin()->second->total.value, ASSET("0.250 GBG").amount.value);
+
+        BOOST_TEST_MESSAGE("--- canceled order");
+        cop.owner = "alice";
+        cop.orderid = 1;
+        push_tx_with_ops(tx, alice_private_key, cop);
+        generate_block();
+
+        check_book(*db, cache);
+        BOOST_CHECK(cache.get()->sides.empty());
+        BOOST_REQUIRE_EQUAL(diff.levels.size(), 1u);
+        BOOST_CHECK_EQUAL(diff.levels[0].for_sale, ASSET("0.000 GBG"));
+        BOOST_CHECK_EQUAL(diff.levels[0].orders, 0);
+
+        BOOST_TEST_MESSAGE("--- the previous book is kept by reader");
+        BOOST_REQUIRE_EQUAL(book->sides.size(), 1u);
+
+        BOOST_TEST_MESSAGE("--- block of other fork rebuilds book");
+        db->pop_block();
+        generate_block();
+        BOOST_CHECK(diff.reset);
+        check_book(*db, cache);
+    } FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -2,6 +2,9 @@
 
 #include "database_fixture.hpp"
 
+#include <golos/plugins/operation_history/history_store.hpp>
+#include <graphene/utilities/tempdir.hpp>
+
 #include <string>
 #include <cstdint>
 
@@ -151,3 +154,136 @@ BOOST_AUTO_TEST_CASE(short_operation_history_blocks) {
 }
 
 BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(history_store_tests)
+
+BOOST_AUTO_TEST_CASE(history_store_append_and_truncate) {
+    using namespace golos::plugins::operation_history;
+
+    BOOST_TEST_MESSAGE("Testing: history_store_append_and_truncate");
+    fc::temp_directory data_dir(golos::utilities::temp_directory_path());
+
+    auto make_op = [](uint64_t id, uint32_t block, uint32_t nft_token_id) {
+        stored_operation op;
+        op.id = id;
+        op.block = block;
+        op.nft_token_id = nft_token_id;
+        op.serialized_op = fc::raw::pack(golos::protocol::operation(account_create_operation()));
+        return op;
+    };
+    auto make_entry = [](const std::string& account, uint32_t sequence, uint64_t op) {
+        stored_account_operation entry;
+        entry.account = account;
+        entry.sequence = sequence;
+        entry.dir = 1;
+        entry.op = op;
+        return entry;
+    };
+
+    {
+        history_store store;
+        store.open(data_dir.path(), 64);   // small segments to check switching between them
+
+        store.begin_block(1);
+        store.append_operation(make_op(1, 1, 0));
+        store.append_account_operation(make_entry("alice", 0, 1));
+        store.end_block(1);
+
+        // block 2 is skipped
+        store.begin_block(3);
+        store.append_operation(make_op(2, 3, 7));
+        store.append_operation(make_op(3, 3, 0));
+        store.append_account_operation(make_entry("alice", 1, 2));
+        store.append_account_operation(make_entry("bob", 0, 3));
+        store.end_block(3);
+
+        BOOST_CHECK_EQUAL(store.last_block(), 3);
+        BOOST_CHECK_EQUAL(store.get_block_operations(2).size(), 0);
+        BOOST_CHECK_EQUAL(store.get_block_operations(3).size(), 2);
+        BOOST_CHECK_EQUAL(store.account_history_size("alice"), 2);
+        BOOST_CHECK_EQUAL(store.get_nft_token_operations(7).size(), 1);
+        BOOST_CHECK(!store.get_operation(4).valid());
+        BOOST_REQUIRE(store.get_operation(2).valid());
+        BOOST_CHECK_EQUAL(store.get_operation(2)->block, 3);
+    }
+
+    {
+        history_store store;
+        store.open(data_dir.path(), 64);
+        BOOST_CHECK_EQUAL(store.last_block(), 3);
+
+        auto alice = store.get_account_history("alice", uint32_t(-1), 10, history_store::account_filter());
+        BOOST_REQUIRE_EQUAL(alice.size(), 2);
+        BOOST_CHECK_EQUAL(alice[0].sequence, 1);
+        BOOST_CHECK_EQUAL(alice[1].op, 1);
+
+        store.truncate(2);
+        BOOST_CHECK_EQUAL(store.last_block(), 2);
+        BOOST_CHECK_EQUAL(store.account_history_size("alice"), 1);
+        BOOST_CHECK_EQUAL(store.account_history_size("bob"), 0);
+        BOOST_CHECK_EQUAL(store.get_nft_token_operations(7).size(), 0);
+        BOOST_CHECK(!store.get_operation(2).valid());
+        BOOST_CHECK(store.get_operation(1).valid());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(history_store_checkpoint) {
+    using namespace golos::plugins::operation_history;
+
+    BOOST_TEST_MESSAGE("Testing: history_store_checkpoint");
+    fc::temp_directory data_dir(golos::utilities::temp_directory_path());
+    fc::temp_directory crash_dir(golos::utilities::temp_directory_path());
+
+    auto append_block = [](history_store& store, uint32_t block) {
+        stored_operation op;
+        op.id = block;
+        op.block = block;
+        op.trx_id = fc::ripemd160::hash(std::to_string(block));
+        op.nft_token_id = 7;
+        op.serialized_op = fc::raw::pack(golos::protocol::operation(account_create_operation()));
+
+        stored_account_operation entry;
+        entry.account = "alice";
+        entry.sequence = block - 1;
+        entry.op = block;
+
+        store.begin_block(block);
+        store.append_operation(op);
+        store.append_account_operation(entry);
+        store.end_block(block);
+    };
+
+    {
+        history_store store;
+        store.open(data_dir.path(), 64, 2);
+        for (uint32_t block = 1; block <= 5; ++block) {
+            append_block(store, block);
+        }
+
+        BOOST_TEST_MESSAGE("--- files of open store are copied as after an unclean shutdown");
+        store.wait_checkpoints();
+        for (fc::directory_iterator itr(data_dir.path()); itr != fc::directory_iterator(); ++itr) {
+            fc::copy(*itr, crash_dir.path() / (*itr).filename());
+        }
+    }
+
+    BOOST_TEST_MESSAGE("--- lookups of the last checkpoint are loaded, blocks after it are replayed");
+    history_store store;
+    store.open(crash_dir.path(), 64, 2);
+    BOOST_CHECK_EQUAL(store.last_block(), 5);
+    BOOST_CHECK_EQUAL(store.account_history_size("alice"), 5);
+    BOOST_CHECK_EQUAL(store.get_nft_token_operations(7).size(), 5);
+    auto blocks = store.find_transaction_blocks(fc::ripemd160::hash(std::to_string(5)));
+    BOOST_REQUIRE_EQUAL(blocks.size(), 1);
+    BOOST_CHECK_EQUAL(blocks[0], 5);
+
+    BOOST_TEST_MESSAGE("--- truncated store is reopened");
+    store.truncate(1);
+    store.close();
+    store.open(crash_dir.path(), 64, 2);
+    BOOST_CHECK_EQUAL(store.account_history_size("alice"), 1);
+    BOOST_CHECK_EQUAL(store.get_nft_token_operations(7).size(), 1);
+    BOOST_CHECK(store.find_transaction_blocks(fc::ripemd160::hash(std::to_string(5))).empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,272 @@
+#include <boost/test/unit_test.hpp>
+
+#include "database_fixture.hpp"
+
+#include <golos/plugins/state_replication/state_delta.hpp>
+#include <golos/chain/comment_object.hpp>
+#include <golos/chain/worker_objects.hpp>
+
+using namespace golos::protocol;
+using namespace golos::chain;
+
+using golos::plugins::state_replication::add_core_replicators;
+using golos::plugins::state_replication::index_delta;
+using golos::plugins::state_replication::index_replicator;
+using golos::plugins::state_replication::state_delta;
+
+// objects with their ids, not all objects reflect id
+using packed_index = std::vector<std::pair<int64_t, std::vector<char>>>;
+
+template <typename MultiIndexType>
+packed_index pack_index(const database& db) {
+    packed_index result;
+    for (const auto& o : db.get_index<MultiIndexType>().indices()) {
+        result.emplace_back(o.id._id, object_pack::pack_object(o));
+    }
+    return result;
+}
+
+template <typename MultiIndexType>
+int64_t next_id(database& db) {
+    return get_next_id(db.get_mutable_index<MultiIndexType>());
+}
+
+// objects of indexes which are changed by blocks of test
+struct state_dump {
+    packed_index props;
+    packed_index accounts;
+    packed_index comments;
+    packed_index votes;
+    packed_index orders;
+    packed_index transactions;
+    packed_index pairs;
+    packed_index worker_requests;
+    packed_index worker_votes;
+    std::vector<int64_t> next_ids;
+
+    explicit state_dump(database& db)
+        : props(pack_index<dynamic_global_property_index>(db)),
+          accounts(pack_index<account_index>(db)),
+          comments(pack_index<comment_index>(db)),
+          votes(pack_index<comment_vote_index>(db)),
+          orders(pack_index<limit_order_index>(db)),
+          transactions(pack_index<transaction_index>(db)),
+          pairs(pack_index<market_pair_index>(db)),
+          worker_requests(pack_index<worker_request_index>(db)),
+          worker_votes(pack_index<worker_request_vote_index>(db)),
+          next_ids({
+              next_id<comment_index>(db),
+              next_id<limit_order_index>(db),
+              next_id<market_pair_index>(db),
+              next_id<worker_request_vote_index>(db)}) {
+    }
+
+    void check_equal(const state_dump& other) const {
+        BOOST_CHECK(props == other.props);
+        BOOST_CHECK(accounts == other.accounts);
+        BOOST_CHECK(comments == other.comments);
+        BOOST_CHECK(votes == other.votes);
+        BOOST_CHECK(orders == other.orders);
+        BOOST_CHECK(transactions == other.transactions);
+        BOOST_CHECK(pairs == other.pairs);
+        BOOST_CHECK(worker_requests == other.worker_requests);
+        BOOST_CHECK(worker_votes == other.worker_votes);
+        BOOST_CHECK(next_ids == other.next_ids);
+    }
+};
+
+struct state_replication_fixture : public clean_database_fixture {
+    std::vector<std::unique_ptr<index_replicator>> replicators;
+
+    state_replication_fixture() {
+        add_core_replicators(replicators);
+    }
+
+    // what the primary writes after applying of block
+    state_delta collect(const signed_block& block) {
+        state_delta delta;
+        delta.block_num = block.block_num();
+        delta.block_id = block.id();
+        delta.previous = block.previous;
+        for (const auto& r : replicators) {
+            index_delta index;
+            if (r->collect(*db, index)) {
+                delta.indexes.push_back(std::move(index));
+            }
+        }
+        return fc::raw::unpack<state_delta>(fc::raw::pack(delta));
+    }
+
+    // what the follower does with record
+    void apply(const state_delta& delta) {
+        auto session = db->start_undo_session();
+        for (const auto& index : delta.indexes) {
+            auto itr = std::find_if(replicators.begin(), replicators.end(), [&](const auto& r) {
+                return r->type_id() == index.type_id;
+            });
+            BOOST_REQUIRE(itr != replicators.end());
+            (*itr)->apply(*db, index);
+        }
+        session.push();
+    }
+
+    /**
+     * Generates block, then pops it and applies its record instead,
+     * state after the record should be the same as after the block.
+     */
+    state_delta check_replicated_block() {
+        state_delta delta;
+        boost::signals2::scoped_connection conn = db->applied_block_changes.connect([&](const signed_block& b) {
+            delta = collect(b);
+        });
+        generate_block();
+        conn.disconnect();
+
+        state_dump primary(*db);
+        auto head_id = db->head_block_id();
+
+        db->pop_block();
+        db->clear_pending();
+        BOOST_CHECK_EQUAL(db->head_block_num() + 1, delta.block_num);
+
+        apply(delta);
+        BOOST_CHECK_EQUAL(db->head_block_num(), delta.block_num);
+        BOOST_CHECK(db->head_block_id() == head_id);
+        state_dump follower(*db);
+        primary.check_equal(follower);
+        return delta;
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(state_replication, state_replication_fixture)
+
+    BOOST_AUTO_TEST_CASE(state_replication_follower) { try {
+        BOOST_TEST_MESSAGE("Testing: state_replication_follower");
+
+        ACTORS_OLD((alice)(bob));
+        fund("alice", ASSET("10.000 GBG"));
+        vest("bob", ASSET("10.000 GOLOS"));
+        generate_block();
+
+        BOOST_TEST_MESSAGE("--- block with post, vote and order");
+        signed_transaction tx;
+        comment_operation cop;
+        cop.author = "alice";
+        cop.permlink = "post";
+        cop.parent_permlink = "test";
+        cop.title = "post";
+        cop.body = "body";
+        push_tx_with_ops(tx, alice_private_key, cop);
+
+        vote_operation vop;
+        vop.voter = "bob";
+        vop.author = "alice";
+        vop.permlink = "post";
+        vop.weight = STEEMIT_100_PERCENT;
+        push_tx_with_ops(tx, bob_private_key, vop);
+
+        limit_order_create_operation lop;
+        lop.owner = "alice";
+        lop.orderid = 1;
+        lop.amount_to_sell = ASSET("1.000 GBG");
+        lop.min_to_receive = ASSET("2.000 GOLOS");
+        lop.expiration = db->head_block_time() + fc::days(1);
+        push_tx_with_ops(tx, alice_private_key, lop);
+
+        auto delta = check_replicated_block();
+        auto has_index = [&](uint16_t type_id) {
+            return std::any_of(delta.indexes.begin(), delta.indexes.end(), [&](const auto& i) {
+                return i.type_id == type_id;
+            });
+        };
+        BOOST_CHECK(has_index(comment_object::type_id));
+        BOOST_CHECK(has_index(comment_vote_object::type_id));
+        BOOST_CHECK(has_index(limit_order_object::type_id));
+        BOOST_CHECK(db->find<comment_object, by_permlink>(std::make_tuple("alice", std::string("post"))));
+
+        BOOST_TEST_MESSAGE("--- block with removed order");
+        limit_order_cancel_operation cancel;
+        cancel.owner = "alice";
+        cancel.orderid = 1;
+        push_tx_with_ops(tx, alice_private_key, cancel);
+
+        delta = check_replicated_block();
+        BOOST_CHECK(db->get_index<limit_order_index>().indices().empty());
+
+        BOOST_TEST_MESSAGE("--- record is undone when the primary switches to other fork");
+        auto head = db->head_block_num();
+        db->undo();
+        BOOST_CHECK_EQUAL(db->head_block_num(), head - 1);
+        BOOST_CHECK_EQUAL(db->get_index<limit_order_index>().indices().size(), 1u);
+    } FC_LOG_AND_RETHROW() }
+
+    BOOST_AUTO_TEST_CASE(state_replication_object_ids) { try {
+        BOOST_TEST_MESSAGE("Testing: state_replication_object_ids");
+
+        ACTORS_OLD((alice)(bob));
+        fund("alice", ASSET("10.000 GBG"));
+        fund("bob", ASSET("100.000 GBG"));
+        fund("bob", ASSET("10.000 GOLOS"));
+        generate_block();
+
+        BOOST_TEST_MESSAGE("--- block with market pair and worker request");
+        signed_transaction tx;
+        limit_order_create_operation lop;
+        lop.owner = "alice";
+        lop.orderid = 1;
+        lop.amount_to_sell = ASSET("1.000 GBG");
+        lop.min_to_receive = ASSET("2.000 GOLOS");
+        lop.expiration = db->head_block_time() + fc::days(1);
+        push_tx_with_ops(tx, alice_private_key, lop);
+
+        comment_create("bob", bob_private_key, "bob-request", "", "bob-request");
+        worker_request_operation wop;
+        wop.author = "bob";
+        wop.permlink = "bob-request";
+        wop.worker = "alice";
+        wop.required_amount_min = ASSET_GOLOS(6000);
+        wop.required_amount_max = ASSET_GOLOS(60000);
+        wop.duration = fc::days(5).to_seconds();
+        push_tx_with_ops(tx, bob_private_key, wop);
+
+        check_replicated_block();
+        BOOST_REQUIRE_EQUAL(db->get_index<market_pair_index>().indices().size(), 1u);
+
+        BOOST_TEST_MESSAGE("--- block which modifies existing market pair and creates worker vote");
+        lop.orderid = 2;
+        push_tx_with_ops(tx, alice_private_key, lop);
+
+        worker_request_vote_operation vop;
+        vop.voter = "alice";
+        vop.author = "bob";
+        vop.permlink = "bob-request";
+        vop.vote_percent = STEEMIT_100_PERCENT;
+        push_tx_with_ops(tx, alice_private_key, vop);
+
+        auto pair_id = db->get_index<market_pair_index>().indices().begin()->id;
+        check_replicated_block();
+        BOOST_REQUIRE_EQUAL(db->get_index<market_pair_index>().indices().size(), 1u);
+        BOOST_CHECK(db->get_index<market_pair_index>().indices().begin()->id == pair_id);
+        BOOST_CHECK_EQUAL(db->get_index<market_pair_index>().indices().begin()->base_depth, ASSET("2.000 GBG"));
+        BOOST_REQUIRE_EQUAL(db->get_index<worker_request_vote_index>().indices().size(), 1u);
+
+        BOOST_TEST_MESSAGE("--- block which modifies worker vote, creates and removes order in the same block");
+        vop.vote_percent = -STEEMIT_100_PERCENT;
+        push_tx_with_ops(tx, alice_private_key, vop);
+
+        // pending transactions are applied, so the next id is taken before the order
+        auto order_next_id = next_id<limit_order_index>(*db);
+        lop.owner = "bob";
+        lop.orderid = 1;
+        lop.amount_to_sell = ASSET("2.000 GOLOS");
+        lop.min_to_receive = ASSET("1.000 GBG");
+        push_tx_with_ops(tx, bob_private_key, lop);
+
+        check_replicated_block();
+        BOOST_CHECK_EQUAL(db->get_index<limit_order_index>().indices().size(), 1u);
+        BOOST_CHECK_EQUAL(next_id<limit_order_index>(*db), order_next_id + 1);
+        BOOST_CHECK_EQUAL(db->get_index<worker_request_vote_index>().indices().begin()->vote_percent,
+            -STEEMIT_100_PERCENT);
+    } FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_SUITE_END()
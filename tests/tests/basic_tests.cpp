@@ -26,6 +26,7 @@
 #include <boost/test/unit_test_monitor.hpp>
 
 #include <golos/chain/database.hpp>
+#include <golos/protocol/signature_cache.hpp>
 
 #include <fc/crypto/digest.hpp>
 #include "database_fixture.hpp"
@@ -319,4 +320,46 @@ BOOST_FIXTURE_TEST_SUITE(basic_tests, clean_database_fixture_wrap)
         BOOST_CHECK(block.calculate_merkle_root() == c(dO));
     }
 
+    BOOST_AUTO_TEST_CASE(signature_cache_test) {
+        BOOST_TEST_MESSAGE("Testing: signature_cache_test");
+
+        auto& cache = signature_cache::instance();
+        auto capacity = cache.capacity();
+        cache.set_capacity(0);
+        // 2 entries per shard, so both signatures are kept even if they are in the same shard
+        cache.set_capacity(32);
+
+        auto alice_key = generate_private_key("alice");
+        auto bob_key = generate_private_key("bob");
+
+        signed_transaction tx;
+        tx.operations.push_back(transfer_operation());
+        tx.sign(alice_key, STEEMIT_CHAIN_ID);
+        tx.sign(bob_key, STEEMIT_CHAIN_ID);
+
+        auto before = cache.get_stats();
+        auto keys = tx.get_signature_keys(STEEMIT_CHAIN_ID);
+        BOOST_CHECK_EQUAL(keys.size(), 2);
+        BOOST_CHECK(keys.count(alice_key.get_public_key()));
+        BOOST_CHECK(keys.count(bob_key.get_public_key()));
+
+        auto after_miss = cache.get_stats();
+        BOOST_CHECK_EQUAL(after_miss.misses - before.misses, 2);
+        BOOST_CHECK_EQUAL(after_miss.hits - before.hits, 0);
+        BOOST_CHECK_EQUAL(after_miss.size, 2);
+
+        BOOST_CHECK(tx.get_signature_keys(STEEMIT_CHAIN_ID) == keys);
+
+        auto after_hit = cache.get_stats();
+        BOOST_CHECK_EQUAL(after_hit.misses - after_miss.misses, 0);
+        BOOST_CHECK_EQUAL(after_hit.hits - after_miss.hits, 2);
+        BOOST_CHECK_EQUAL(after_hit.size, 2);
+
+        // same signature twice is still detected
+        tx.signatures.push_back(tx.signatures.front());
+        STEEMIT_REQUIRE_THROW(tx.get_signature_keys(STEEMIT_CHAIN_ID), tx_duplicate_sig);
+
+        cache.set_capacity(capacity);
+    }
+
 BOOST_AUTO_TEST_SUITE_END()
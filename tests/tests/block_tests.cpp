@@ -27,7 +27,11 @@
 
 #include <golos/protocol/exceptions.hpp>
 
+#include <golos/chain/compressed_block_log.hpp>
 #include <golos/chain/database.hpp>
+#include <golos/chain/database_exceptions.hpp>
+#include <golos/chain/index.hpp>
+#include <golos/chain/snapshot.hpp>
 #include <golos/chain/steem_objects.hpp>
 
 #include <golos/plugins/account_history/history_object.hpp>
@@ -37,6 +41,10 @@
 
 #include <fc/crypto/digest.hpp>
 
+#include <atomic>
+#include <fstream>
+#include <thread>
+
 #include "database_fixture.hpp"
 
 using namespace golos;
@@ -343,6 +351,54 @@ BOOST_AUTO_TEST_SUITE(block_tests)
         }
     }
 
+    BOOST_AUTO_TEST_CASE(recent_transactions_without_bodies) {
+        try {
+            BOOST_TEST_MESSAGE("Testing: recent_transactions_without_bodies");
+
+            fc::temp_directory dir1(golos::utilities::temp_directory_path());
+            database db1;
+            db1._log_hardforks = false;
+            db1.open(dir1.path(), dir1.path(), INITIAL_TEST_SUPPLY, TEST_SHARED_MEM_SIZE, chainbase::database::read_write);
+
+            auto skip_sigs = database::skip_transaction_signatures |
+                             database::skip_authority_check;
+
+            auto init_account_priv_key = STEEMIT_INIT_PRIVATE_KEY;
+
+            auto make_transfer = [&](int64_t amount) {
+                signed_transaction trx;
+                transfer_operation t;
+                t.from = STEEMIT_INIT_MINER_NAME;
+                t.to = STEEMIT_NULL_ACCOUNT;
+                t.amount = asset(amount, STEEM_SYMBOL);
+                trx.operations.push_back(t);
+                trx.set_expiration(db1.head_block_time() + STEEMIT_MAX_TIME_UNTIL_EXPIRATION);
+                trx.sign(init_account_priv_key, db1.get_chain_id());
+                return trx;
+            };
+
+            BOOST_TEST_MESSAGE("--- Body is stored by default");
+            auto trx1 = make_transfer(1);
+            PUSH_TX(db1, trx1, skip_sigs);
+            BOOST_CHECK(db1.get_recent_transaction(trx1.id()).id() == trx1.id());
+
+            BOOST_TEST_MESSAGE("--- Only id is stored");
+            db1.set_store_recent_transactions(false);
+            auto trx2 = make_transfer(2);
+            PUSH_TX(db1, trx2, skip_sigs);
+            BOOST_CHECK(db1.is_known_transaction(trx2.id()));
+            STEEMIT_CHECK_THROW(db1.get_recent_transaction(trx2.id()), fc::exception);
+            STEEMIT_CHECK_THROW(PUSH_TX(db1, trx2, skip_sigs), fc::exception);
+
+            db1.generate_block(db1.get_slot_time(1), db1.get_scheduled_witness(1), init_account_priv_key, skip_sigs);
+            BOOST_CHECK(db1.is_known_transaction(trx2.id()));
+            STEEMIT_CHECK_THROW(PUSH_TX(db1, trx2, skip_sigs), fc::exception);
+        } catch (fc::exception& e) {
+            edump((e.to_detail_string()));
+            throw;
+        }
+    }
+
     BOOST_AUTO_TEST_CASE(tapos) {
         try {
             BOOST_TEST_MESSAGE("Testing: tapos");
@@ -776,5 +832,328 @@ BOOST_AUTO_TEST_SUITE(block_tests)
         FC_LOG_AND_RETHROW()
     }
 
+    BOOST_AUTO_TEST_CASE(compressed_block_log_read) {
+        try {
+            BOOST_TEST_MESSAGE("Testing: compressed_block_log_read");
+
+            fc::temp_directory data_dir(golos::utilities::temp_directory_path());
+            auto source_path = data_dir.path() / "source" / "block_log";
+            auto target_path = data_dir.path() / "target" / "block_log";
+            fc::create_directories(source_path.parent_path());
+            fc::create_directories(target_path.parent_path());
+
+            std::vector<signed_block> blocks;
+            block_log source;
+            source.open(source_path);
+            for (uint32_t i = 0; i < 10; ++i) {
+                signed_block b;
+                b.witness = "alice";
+                b.previous = blocks.empty() ? block_id_type() : blocks.back().id();
+                b.timestamp = fc::time_point_sec(STEEMIT_TESTING_GENESIS_TIMESTAMP + i * STEEMIT_BLOCK_INTERVAL);
+                source.append(b);
+                blocks.push_back(b);
+            }
+
+            BOOST_TEST_MESSAGE("--- Move blocks 1..7 to compressed log");
+            compressed_block_log::write(source, 7, target_path, 3);
+
+            block_log target;
+            target.open(target_path);
+            BOOST_CHECK_EQUAL(target.archived_block_num(), 7);
+            BOOST_CHECK_EQUAL(target.head()->block_num(), 7);
+            for (uint32_t block_num = 8; block_num <= 10; ++block_num) {
+                target.append(*source.read_block_by_num(block_num));
+            }
+            target.close();
+
+            BOOST_TEST_MESSAGE("--- Read blocks from reopened log");
+            target.open(target_path);
+            BOOST_CHECK_EQUAL(target.archived_block_num(), 7);
+            BOOST_CHECK_EQUAL(target.head()->id(), blocks.back().id());
+            for (uint32_t block_num = 1; block_num <= 10; ++block_num) {
+                auto block = target.read_block_by_num(block_num);
+                BOOST_REQUIRE(block.valid());
+                BOOST_CHECK_EQUAL(block->id(), blocks[block_num - 1].id());
+            }
+            BOOST_CHECK(!target.read_block_by_num(11).valid());
+            BOOST_CHECK_EQUAL(target.get_block_pos(7), block_log::npos);
+            BOOST_CHECK_EQUAL(target.get_block_pos(8), 0);
+
+            BOOST_TEST_MESSAGE("--- Chunks are read in parallel with a cache of one chunk");
+            target.set_archive_cache_size(1);
+            std::atomic<uint32_t> wrong_blocks{0};
+            std::vector<std::thread> readers;
+            for (uint32_t t = 0; t < 4; ++t) {
+                readers.emplace_back([&, t]() {
+                    for (uint32_t n = 0; n < 70; ++n) {
+                        auto block_num = (n + t) % 7 + 1;
+                        if (target.read_block_view(block_num).id() != blocks[block_num - 1].id()) {
+                            ++wrong_blocks;
+                        }
+                    }
+                });
+            }
+            for (auto& r : readers) {
+                r.join();
+            }
+            BOOST_CHECK_EQUAL(wrong_blocks.load(), 0);
+
+            BOOST_TEST_MESSAGE("--- Append after compressed blocks");
+            signed_block b;
+            b.witness = "bob";
+            b.previous = blocks.back().id();
+            target.append(b);
+            BOOST_CHECK_EQUAL(target.read_block_by_num(11)->id(), b.id());
+        }
+        FC_LOG_AND_RETHROW()
+    }
+
+    BOOST_AUTO_TEST_CASE(block_log_view) {
+        try {
+            BOOST_TEST_MESSAGE("Testing: block_log_view");
+
+            fc::temp_directory data_dir(golos::utilities::temp_directory_path());
+            auto path = data_dir.path() / "block_log";
+
+            std::vector<signed_block> blocks;
+            block_view first_view;
+            {
+                block_log log;
+                log.open(path);
+                for (uint32_t i = 0; i < 5; ++i) {
+                    signed_block b;
+                    b.witness = "alice";
+                    b.previous = blocks.empty() ? block_id_type() : blocks.back().id();
+                    log.append(b);
+                    blocks.push_back(b);
+
+                    auto view = log.read_block_view(b.block_num());
+                    BOOST_REQUIRE(view.valid());
+                    BOOST_CHECK_EQUAL(view.id(), b.id());
+                    BOOST_CHECK(std::vector<char>(view.data(), view.data() + view.size()) == fc::raw::pack(b));
+                }
+                log.flush();
+                BOOST_CHECK(!log.read_block_view(6).valid());
+                first_view = log.read_block_view(1);
+            }
+
+            BOOST_TEST_MESSAGE("--- View is valid after close of block log");
+            BOOST_CHECK_EQUAL(first_view.id(), blocks.front().id());
+            BOOST_CHECK_EQUAL(first_view.unpack().witness, "alice");
+
+            block_log log;
+            log.open(path);
+            BOOST_CHECK_EQUAL(log.head()->id(), blocks.back().id());
+            for (const auto& b : blocks) {
+                BOOST_CHECK_EQUAL(log.read_block_view(b.block_num()).block_num(), b.block_num());
+            }
+        }
+        FC_LOG_AND_RETHROW()
+    }
+
+    BOOST_FIXTURE_TEST_CASE(block_apply_profile, clean_database_fixture_wrap) {
+        try {
+            BOOST_TEST_MESSAGE("Testing: block_apply_profile");
+
+            ACTORS((alice))
+            generate_block();
+
+            BOOST_TEST_MESSAGE("--- Disabled profiler does not collect timings");
+            BOOST_CHECK_EQUAL(db->profiler().get_stats().blocks, 0);
+
+            db->profiler().enable(true);
+
+            transfer(STEEMIT_INIT_MINER_NAME, "alice", ASSET("1.000 GOLOS"));
+            generate_block();
+
+            auto last = db->profiler().last_block();
+            BOOST_CHECK_EQUAL(last.block_num, db->head_block_num());
+            BOOST_CHECK(std::count_if(last.evaluators.begin(), last.evaluators.end(), [](const auto& e) {
+                return e.first == "transfer_operation";
+            }) == 1);
+
+            generate_blocks(2);
+
+            auto stats = db->profiler().get_stats();
+            BOOST_CHECK_EQUAL(stats.blocks, 3);
+            BOOST_CHECK_EQUAL(stats.block.count, 3);
+            BOOST_CHECK_EQUAL(stats.steps.at("process_funds").count, 3);
+            BOOST_CHECK_EQUAL(stats.evaluators.at("transfer_operation").count, 1);
+            BOOST_CHECK_EQUAL(stats.slow_blocks, 0);
+
+            BOOST_TEST_MESSAGE("--- Reset drops timings");
+            db->profiler().reset();
+            BOOST_CHECK_EQUAL(db->profiler().get_stats().blocks, 0);
+            db->profiler().enable(false);
+        }
+        FC_LOG_AND_RETHROW()
+    }
+
+    BOOST_AUTO_TEST_CASE(state_snapshot) {
+        try {
+            BOOST_TEST_MESSAGE("Testing: state_snapshot");
+
+            fc::temp_directory data_dir(golos::utilities::temp_directory_path());
+            fc::temp_directory snapshot_dir(golos::utilities::temp_directory_path());
+            auto snapshot_path = snapshot_dir.path() / "snapshot";
+            auto init_account_priv_key = STEEMIT_INIT_PRIVATE_KEY;
+
+            {
+                database db;
+                db._log_hardforks = false;
+                db.open(data_dir.path(), data_dir.path(), INITIAL_TEST_SUPPLY, TEST_SHARED_MEM_SIZE, chainbase::database::read_write);
+                for (uint32_t i = 0; i < 100; ++i) {
+                    db.generate_block(db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing);
+                }
+
+                // gap in ids: next id of index is greater than the number of its objects
+                for (uint32_t i = 1; i <= 3; ++i) {
+                    const auto& req = db.create<convert_request_object>([&](auto& o) {
+                        o.owner = STEEMIT_INIT_MINER_NAME;
+                        o.requestid = i;
+                        o.amount = ASSET("1.000 GBG");
+                        o.conversion_date = fc::time_point_sec::maximum();
+                    });
+                    if (i < 3) {
+                        db.remove(req);
+                    }
+                }
+                db.close();
+            }
+
+            BOOST_TEST_MESSAGE("--- Snapshot is written at the last irreversible block");
+            block_id_type head_block_id;
+            size_t account_count = 0;
+            asset balance;
+            {
+                database db;
+                db._log_hardforks = false;
+                db.open(data_dir.path(), data_dir.path(), INITIAL_TEST_SUPPLY, TEST_SHARED_MEM_SIZE, chainbase::database::read_write);
+                head_block_id = db.head_block_id();
+                account_count = db.get_index<account_index>().indices().size();
+                balance = db.get_account(STEEMIT_INIT_MINER_NAME).balance;
+
+                db.set_snapshot_threads(2);
+                db.with_strong_write_lock([&]() {
+                    db.write_snapshot(snapshot_path);
+                });
+                db.close();
+            }
+
+            BOOST_TEST_MESSAGE("--- Snapshot is loaded into the wiped state");
+            database db;
+            db._log_hardforks = false;
+            db.wipe(data_dir.path(), data_dir.path(), false);
+            db.set_snapshot_threads(2);
+            db.set_snapshot_to_load(snapshot_path);
+            db.open(data_dir.path(), data_dir.path(), INITIAL_TEST_SUPPLY, TEST_SHARED_MEM_SIZE, chainbase::database::read_write);
+            BOOST_CHECK_EQUAL(db.head_block_id(), head_block_id);
+            BOOST_CHECK_EQUAL(db.revision(), db.head_block_num());
+            BOOST_CHECK_EQUAL(db.get_index<account_index>().indices().size(), account_count);
+            BOOST_CHECK_EQUAL(db.get_account(STEEMIT_INIT_MINER_NAME).balance, balance);
+
+            BOOST_TEST_MESSAGE("--- Next ids of indexes are restored");
+            BOOST_REQUIRE_EQUAL(db.get_index<convert_request_index>().indices().size(), 1u);
+            BOOST_CHECK_EQUAL(db.get_index<convert_request_index>().indices().begin()->id._id, 2);
+            BOOST_CHECK_EQUAL(snapshot_index_impl<convert_request_index>().next_id(db), 3);
+            BOOST_CHECK_EQUAL(db.get_index<account_index>().indices().size(), account_count);
+            BOOST_CHECK_EQUAL(snapshot_index_impl<account_index>().next_id(db), int64_t(account_count));
+
+            BOOST_TEST_MESSAGE("--- Loaded state is written to the same snapshot");
+            auto snapshot_path2 = snapshot_dir.path() / "snapshot2";
+            db.with_strong_write_lock([&]() {
+                db.write_snapshot(snapshot_path2);
+            });
+            auto read_file = [](const fc::path& path) {
+                std::ifstream in(path.string(), std::ios::in | std::ios::binary);
+                return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+            };
+            BOOST_CHECK(read_file(snapshot_path) == read_file(snapshot_path2));
+
+            BOOST_TEST_MESSAGE("--- Blocks are applied to the loaded state");
+            auto head_block_num = db.head_block_num();
+            for (uint32_t i = 0; i < 10; ++i) {
+                db.generate_block(db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing);
+            }
+            BOOST_CHECK_EQUAL(db.head_block_num(), head_block_num + 10);
+
+            BOOST_TEST_MESSAGE("--- Snapshot isn't loaded into not empty state");
+            db.close();
+            db.set_snapshot_to_load(snapshot_path);
+            STEEMIT_CHECK_THROW(
+                db.open(data_dir.path(), data_dir.path(), INITIAL_TEST_SUPPLY, TEST_SHARED_MEM_SIZE, chainbase::database::read_write),
+                golos::chain::snapshot_exception);
+
+            BOOST_TEST_MESSAGE("--- Snapshot isn't loaded when plugin index isn't stored in snapshots");
+            fc::temp_directory plugin_data_dir(golos::utilities::temp_directory_path());
+            database plugin_db;
+            plugin_db._log_hardforks = false;
+            add_plugin_index<golos::plugins::account_history::account_history_index>(plugin_db);
+            plugin_db.set_snapshot_to_load(snapshot_path);
+            STEEMIT_CHECK_THROW(
+                plugin_db.open(plugin_data_dir.path(), plugin_data_dir.path(), INITIAL_TEST_SUPPLY, TEST_SHARED_MEM_SIZE,
+                    chainbase::database::read_write),
+                golos::chain::snapshot_exception);
+        }
+        FC_LOG_AND_RETHROW()
+    }
+
+    BOOST_AUTO_TEST_CASE(plugin_index_snapshot) {
+        try {
+            BOOST_TEST_MESSAGE("Testing: plugin_index_snapshot");
+
+            using golos::plugins::account_history::account_history_index;
+            using golos::plugins::account_history::account_history_object;
+
+            fc::temp_directory data_dir(golos::utilities::temp_directory_path());
+            fc::temp_directory snapshot_dir(golos::utilities::temp_directory_path());
+            auto snapshot_path = snapshot_dir.path() / "snapshot";
+
+            auto open_db = [&](database& db) {
+                db._log_hardforks = false;
+                add_plugin_index<account_history_index>(db);
+                add_snapshot_index<account_history_index>(db);
+                db.open(data_dir.path(), data_dir.path(), INITIAL_TEST_SUPPLY, TEST_SHARED_MEM_SIZE, chainbase::database::read_write);
+            };
+
+            {
+                database db;
+                open_db(db);
+                db.create<account_history_object>([&](auto& o) {
+                    o.account = STEEMIT_INIT_MINER_NAME;
+                    o.block = 1;
+                    o.sequence = 5;
+                    o.op_tag = 3;
+                    o.dir = golos::plugins::account_history::receiver;
+                    from_string(o.json_metadata, "{\"a\":1}");
+                    o.op = golos::plugins::operation_history::operation_id_type(7);
+                });
+                db.with_strong_write_lock([&]() {
+                    db.write_snapshot(snapshot_path);
+                });
+                db.close();
+            }
+
+            BOOST_TEST_MESSAGE("--- Objects of registered plugin index are loaded from snapshot");
+            database db;
+            db._log_hardforks = false;
+            db.wipe(data_dir.path(), data_dir.path(), false);
+            db.set_snapshot_to_load(snapshot_path);
+            open_db(db);
+
+            const auto& idx = db.get_index<account_history_index>().indices();
+            BOOST_REQUIRE_EQUAL(idx.size(), 1u);
+            const auto& o = *idx.begin();
+            BOOST_CHECK_EQUAL(o.account, STEEMIT_INIT_MINER_NAME);
+            BOOST_CHECK_EQUAL(o.block, 1);
+            BOOST_CHECK_EQUAL(o.sequence, 5);
+            BOOST_CHECK_EQUAL(o.op_tag, 3);
+            BOOST_CHECK(o.dir == golos::plugins::account_history::receiver);
+            BOOST_CHECK_EQUAL(to_string(o.json_metadata), "{\"a\":1}");
+            BOOST_CHECK_EQUAL(o.op._id, 7);
+        }
+        FC_LOG_AND_RETHROW()
+    }
+
 BOOST_AUTO_TEST_SUITE_END()
 #endif
@@ -300,6 +300,79 @@ BOOST_FIXTURE_TEST_SUITE(hf27_tests, hf27_database_fixture)
         validate_database();
     } FC_LOG_AND_RETHROW() }
 
+    BOOST_AUTO_TEST_CASE(account_idleness_index) { try {
+        BOOST_TEST_MESSAGE("Testing: account_idleness_index");
+
+        create200accs();
+
+        _db.set_hardfork(STEEMIT_HARDFORK_0_27);
+        generate_blocks(40);
+        validate_database();
+
+        BOOST_TEST_MESSAGE("-- Marking some of accounts as idle, in reverse order of by_proved index");
+
+        // the sweep before index by deadline visited not frozen accounts in order of by_proved
+        std::vector<std::string> proved_order;
+        const auto& proved_idx = _db.get_index<account_index, by_proved>();
+        for (auto itr = proved_idx.begin(); itr != proved_idx.end() && !itr->frozen; ++itr) {
+            if (std::string(itr->name).find("created") == 0) {
+                proved_order.push_back(itr->name);
+            }
+        }
+        BOOST_REQUIRE_GT(proved_order.size(), 2);
+
+        const auto idleness_time = _db.get_witness_schedule_object().median_props.account_idleness_time;
+        const fc::time_point_sec old_time = _db.head_block_time() - fc::seconds(idleness_time);
+        std::vector<std::string> idle;
+        for (size_t i = 0; i < proved_order.size(); i += 3) {
+            idle.push_back(proved_order[i]);
+        }
+
+        // returning of delegation changes effective vesting shares, so result of sweep depends on order
+        const auto& delegatee = _db.get_account(proved_order[1]);
+        const auto received = delegatee.received_vesting_shares;
+        for (size_t i = 0; i < idle.size(); ++i) {
+            vest(idle[i], ASSET("1000.000 GOLOS"));
+            const auto& acc = _db.get_account(idle[i]);
+            auto delegated = asset(acc.vesting_shares.amount / 10, VESTS_SYMBOL);
+            _db.create<vesting_delegation_object>([&](auto& o) {
+                o.delegator = acc.name;
+                o.delegatee = delegatee.name;
+                o.vesting_shares = delegated;
+            });
+            _db.modify(acc, [&](auto& a) {
+                a.delegated_vesting_shares += delegated;
+                a.last_active_operation = old_time - fc::seconds(idle.size() - i);
+            });
+            _db.modify(delegatee, [&](auto& a) {
+                a.received_vesting_shares += delegated;
+            });
+        }
+
+        BOOST_TEST_MESSAGE("-- Running the sweep");
+
+        std::vector<std::string> visited;
+        boost::signals2::scoped_connection conn = _db.post_apply_operation.connect([&](const operation_notification& note) {
+            if (note.op.which() == operation::tag<return_vesting_delegation_operation>::value) {
+                visited.push_back(note.op.get<return_vesting_delegation_operation>().account);
+            }
+        });
+
+        auto gb = GOLOS_ACCOUNT_IDLENESS_CHECK_INTERVAL - _db.head_block_num() % GOLOS_ACCOUNT_IDLENESS_CHECK_INTERVAL;
+        generate_blocks(gb);
+        conn.disconnect();
+
+        BOOST_TEST_MESSAGE("-- Checking accounts are visited in order of by_proved");
+
+        BOOST_CHECK(visited == idle);
+        for (const auto& name : idle) {
+            BOOST_CHECK_EQUAL(_db.get_account(name).delegated_vesting_shares.amount, 0);
+        }
+        BOOST_CHECK_EQUAL(_db.get_account(proved_order[1]).received_vesting_shares, received);
+
+        validate_database();
+    } FC_LOG_AND_RETHROW() }
+
     BOOST_AUTO_TEST_CASE(comment_negrep_payout) { try {
         BOOST_TEST_MESSAGE("Testing: comment_negrep_payout");
 
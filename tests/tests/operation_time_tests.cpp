@@ -3003,5 +3003,90 @@ BOOST_FIXTURE_TEST_SUITE(operation_time_tests, clean_database_fixture_wrap)
         FC_LOG_AND_RETHROW()
     }
 
+    BOOST_AUTO_TEST_CASE(comment_cashout_heavy_block) {
+        try {
+            BOOST_TEST_MESSAGE("Testing: comment_cashout_heavy_block");
+
+            const uint32_t author_count = 10;
+            const uint32_t voter_count = 20;
+
+            auto make_name = [](const char* prefix, uint32_t i) {
+                return std::string(prefix) + std::to_string(i);
+            };
+
+            std::vector<std::string> names;
+            for (uint32_t i = 0; i < author_count; ++i) {
+                names.push_back(make_name("author", i));
+            }
+            for (uint32_t i = 0; i < voter_count; ++i) {
+                names.push_back(make_name("voter", i));
+            }
+            for (const auto& name : names) {
+                account_create(name, generate_private_key(name).get_public_key());
+                fund(name, 10000);
+                vest(name, 10000);
+            }
+
+            set_price_feed(price(ASSET("1.000 GOLOS"), ASSET("1.000 GBG")));
+            generate_block();
+
+            BOOST_TEST_MESSAGE("--- Creating posts with the same cashout time");
+            for (uint32_t i = 0; i < author_count; ++i) {
+                auto author = make_name("author", i);
+                comment_create(author, generate_private_key(author), "post", "", "test");
+            }
+            generate_block();
+
+            for (uint32_t i = 0; i < author_count; ++i) {
+                for (uint32_t j = 0; j < voter_count; ++j) {
+                    auto voter = make_name("voter", j);
+                    make_vote(voter, generate_private_key(voter), make_name("author", i), "post");
+                }
+                generate_block();
+            }
+
+            const auto& post = db->get_comment_by_perm(make_name("author", 0), std::string("post"));
+            generate_blocks(post.cashout_time - STEEMIT_BLOCK_INTERVAL, true);
+
+            auto get_state = [&]() {
+                std::vector<std::tuple<asset, share_type, share_type>> state;
+                for (const auto& name : names) {
+                    const auto& acc = db->get_account(name);
+                    state.emplace_back(acc.vesting_shares, acc.curation_rewards, acc.posting_rewards);
+                }
+                const auto& gpo = db->get_dynamic_global_properties();
+                state.emplace_back(gpo.total_vesting_shares, gpo.total_reward_fund_steem.amount, gpo.total_vesting_fund_steem.amount);
+                return state;
+            };
+
+            BOOST_TEST_MESSAGE("--- Paying posts in the apply thread");
+            db->set_cashout_threads(0);
+            auto start = fc::time_point::now();
+            generate_block();
+            auto sequential_time = fc::time_point::now() - start;
+
+            BOOST_REQUIRE(post.cashout_time == fc::time_point_sec::maximum());
+            BOOST_REQUIRE(db->get_account(make_name("author", 0)).posting_rewards > 0);
+            auto sequential_state = get_state();
+            auto block = db->fetch_block_by_number(db->head_block_num());
+            BOOST_REQUIRE(block.valid());
+
+            BOOST_TEST_MESSAGE("--- Paying posts of the same block with prepared curation infos");
+            db->pop_block();
+            BOOST_REQUIRE(post.cashout_time <= block->timestamp);
+            db->set_cashout_threads(4);
+            start = fc::time_point::now();
+            db->push_block(*block, default_skip | database::skip_witness_signature);
+            auto parallel_time = fc::time_point::now() - start;
+
+            BOOST_CHECK(sequential_state == get_state());
+            BOOST_TEST_MESSAGE("--- Cashout block is applied in " << sequential_time.count() << " us sequentially, in "
+                << parallel_time.count() << " us with 4 cashout threads");
+
+            validate_database();
+        }
+        FC_LOG_AND_RETHROW()
+    }
+
  BOOST_AUTO_TEST_SUITE_END()
 #endif